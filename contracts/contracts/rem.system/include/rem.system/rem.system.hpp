@@ -68,6 +68,7 @@ namespace eosiosystem {
    static constexpr int64_t  min_activated_stake   = 150'000'000'0000;
    static constexpr int64_t  min_pervote_daily_pay = 100'0000;
    static constexpr uint32_t refund_delay_sec      = 3 * seconds_per_day;
+   static constexpr uint32_t guardians_migration_batch = 50; // voters evaluated per distribution while the guardians table is rebuilt
 
    static constexpr int64_t  inflation_precision           = 100;     // 2 decimals
    static constexpr int64_t  default_annual_rate           = 0;       // 5% annual rate
@@ -248,6 +249,22 @@ namespace eosiosystem {
                                                 (stake_lock_period)(stake_unlock_period)(reassertion_period) )
    };
 
+   /**
+    * Defines global state of the per-stake (Guardian) reward accounting
+    */
+   struct [[eosio::table("globalguard"), eosio::contract("rem.system")]] eosio_global_guardian_state {
+      double       reward_per_stake = 0; ///< per-stake reward distributed to a single unit of Guardian stake so far
+
+      // the guardians table is (re)built from the voters table in batches, see migrate_guardians
+      bool         migrated = false; ///< `total_guardians_stake` is the sum of the guardians table
+      name         last_voter; ///< voters up to this one have been evaluated by the rebuild
+      int64_t      guardian_stake_threshold = 0; ///< `eosio_global_rem_state` parameters the guardians table was built with
+      microseconds reassertion_period;
+
+      EOSLIB_SERIALIZE( eosio_global_guardian_state, (reward_per_stake)(migrated)(last_voter)
+                                                     (guardian_stake_threshold)(reassertion_period) )
+   };
+
    /**
     * Defines new global state parameters to producer schedule rotation
     */
@@ -415,6 +432,27 @@ namespace eosiosystem {
     */
    typedef eosio::multi_index< "userres"_n, user_resources >      user_resources_table;
 
+   /**
+    * Guardian info, an account whose per-stake rewards are accounted in `total_guardians_stake`
+    *
+    * @details Rewards are not paid into the voter rows on every distribution. Instead
+    * `eosio_global_guardian_state::reward_per_stake` grows and the difference to `reward_per_stake_index`
+    * is settled into `voter_info::pending_perstake_reward` when the voter row is touched, the Guardian claims
+    * its rewards or the Guardian status expires.
+    */
+   struct [[eosio::table, eosio::contract("rem.system")]] guardian_info {
+      name          owner;
+      int64_t       stake = 0; ///< stake accounted in `eosio_global_state::total_guardians_stake`
+      double        reward_per_stake_index = 0; ///< `eosio_global_guardian_state::reward_per_stake` at the last settlement
+      time_point    expiration; ///< Guardian status is lost unless the vote is reasserted before this time
+
+      uint64_t primary_key()const { return owner.value; }
+      uint64_t by_expiration()const { return expiration.elapsed.count(); }
+
+      // explicit serialization macro is not necessary, used here only to improve compilation time
+      EOSLIB_SERIALIZE( guardian_info, (owner)(stake)(reward_per_stake_index)(expiration) )
+   };
+
    /**
     * Voters table
     *
@@ -424,6 +462,15 @@ namespace eosiosystem {
                                indexed_by<"bystake"_n, const_mem_fun<voter_info, double, &voter_info::by_stake> >
                              > voters_table;
 
+   /**
+    * Guardians table
+    *
+    * @details The guardians table stores the `guardian_info` of all accounts which currently hold Guardian status.
+    */
+   typedef eosio::multi_index< "guardians"_n, guardian_info,
+                               indexed_by<"byexpiration"_n, const_mem_fun<guardian_info, uint64_t, &guardian_info::by_expiration> >
+                             > guardians_table;
+
 
    /**
     * Defines producer info table added in version 1.0
@@ -455,6 +502,8 @@ namespace eosiosystem {
 
    typedef eosio::singleton< "globalrem"_n, eosio_global_rem_state > global_rem_state_singleton;
 
+   typedef eosio::singleton< "globalguard"_n, eosio_global_guardian_state > global_guardian_state_singleton;
+
 
    /**
     * `rex_pool` structure underlying the rex pool table.
@@ -627,6 +676,7 @@ namespace eosiosystem {
 
       private:
          voters_table            _voters;
+         guardians_table         _guardians;
          producers_table         _producers;
          producers_table2        _producers2;
          global_state_singleton  _global;
@@ -634,11 +684,13 @@ namespace eosiosystem {
          global_state3_singleton _global3;
          global_state4_singleton _global4;
          global_rem_state_singleton _globalrem;
+         global_guardian_state_singleton _globalguard;
          eosio_global_state      _gstate;
          eosio_global_state2     _gstate2;
          eosio_global_state3     _gstate3;
          eosio_global_state4     _gstate4;
          eosio_global_rem_state  _gremstate;
+         eosio_global_guardian_state _gguardstate;
          rex_pool_table          _rexpool;
          rex_fund_table          _rexfunds;
          rex_balance_table       _rexbalance;
@@ -1523,6 +1575,12 @@ namespace eosiosystem {
          void update_standby();
 
          int64_t share_perstake_reward_between_guardians(int64_t amount);
+         int64_t share_perstake_reward_between_voters(int64_t amount);
+         void migrate_guardians( uint32_t max_steps );
+         // settles pending per-stake reward of `voter` and updates its Guardian status after its stake or vote changed
+         void update_guardian( const voter_info& voter );
+         void expire_guardians();
+         int64_t accrued_perstake_reward( const guardian_info& guardian ) const;
 
          void claim_perstake( const name& voter );
          void claim_pervote( const name& prod );
@@ -177,6 +177,7 @@ namespace eosiosystem {
       }
 
       check( 0 <= voter_itr->staked, "stake for voting cannot be negative" );
+      update_guardian( *voter_itr );
 
       if( voter == "b1"_n ) {
          validate_b1_vesting( voter_itr->staked );
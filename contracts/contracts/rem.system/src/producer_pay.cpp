@@ -85,6 +85,31 @@ namespace eosiosystem {
    }
 
    int64_t system_contract::share_perstake_reward_between_guardians(int64_t amount)
+   {
+      // rows built with other parameters have wrong Guardian status or expiration, rebuild the table
+      if ( _gguardstate.migrated && ( _gguardstate.guardian_stake_threshold != _gremstate.guardian_stake_threshold ||
+                                      _gguardstate.reassertion_period != _gremstate.reassertion_period ) ) {
+         _gguardstate.migrated   = false;
+         _gguardstate.last_voter = name{};
+      }
+      if ( !_gguardstate.migrated ) {
+         migrate_guardians( guardians_migration_batch );
+      }
+      // until the guardians table is complete its stake can't be used as the total
+      if ( !_gguardstate.migrated ) {
+         return share_perstake_reward_between_voters( amount );
+      }
+
+      expire_guardians();
+      if (_gstate.total_guardians_stake <= 0) {
+         return 0;
+      }
+      // each Guardian's share is settled lazily, see update_guardian
+      _gguardstate.reward_per_stake += double(amount) / double(_gstate.total_guardians_stake);
+      return amount;
+   }
+
+   int64_t system_contract::share_perstake_reward_between_voters(int64_t amount)
    {
       using namespace eosio;
       int64_t total_reward_distributed = 0;
@@ -113,6 +138,105 @@ namespace eosiosystem {
       return total_reward_distributed;
    }
 
+   void system_contract::migrate_guardians( uint32_t max_steps )
+   {
+      auto it = _voters.upper_bound( _gguardstate.last_voter.value );
+      for (; it != _voters.end() && max_steps > 0; ++it, --max_steps) {
+         _gguardstate.last_voter = it->owner;
+         update_guardian( *it );
+      }
+      if ( it != _voters.end() ) {
+         return;
+      }
+
+      _gstate.total_guardians_stake = 0;
+      for (const auto& g: _guardians) {
+         _gstate.total_guardians_stake += g.stake;
+      }
+      _gguardstate.migrated                 = true;
+      _gguardstate.last_voter               = name{};
+      _gguardstate.guardian_stake_threshold = _gremstate.guardian_stake_threshold;
+      _gguardstate.reassertion_period       = _gremstate.reassertion_period;
+      expire_guardians();
+   }
+
+   int64_t system_contract::accrued_perstake_reward( const guardian_info& guardian ) const
+   {
+      return int64_t( guardian.stake * ( _gguardstate.reward_per_stake - guardian.reward_per_stake_index ) );
+   }
+
+   void system_contract::expire_guardians()
+   {
+      using namespace eosio;
+
+      // rows are only expired against a complete `total_guardians_stake`, see migrate_guardians
+      if ( !_gguardstate.migrated ) {
+         return;
+      }
+
+      const auto ct = current_time_point();
+      auto idx = _guardians.get_index<"byexpiration"_n>();
+      for (auto it = idx.begin(); it != idx.end() && it->expiration <= ct; it = idx.begin()) {
+         const int64_t reward = accrued_perstake_reward( *it );
+         if ( reward > 0 ) {
+            _voters.modify( _voters.get( it->owner.value ), same_payer, [&](auto& v) {
+               v.pending_perstake_reward += reward;
+            });
+         }
+         _gstate.total_guardians_stake -= it->stake;
+         idx.erase( it );
+      }
+   }
+
+   void system_contract::update_guardian( const voter_info& voter )
+   {
+      using namespace eosio;
+
+      expire_guardians();
+
+      auto guardian = _guardians.find( voter.owner.value );
+      if ( guardian != _guardians.end() ) {
+         const int64_t reward = accrued_perstake_reward( *guardian );
+         if ( reward > 0 ) {
+            _voters.modify( voter, same_payer, [&](auto& v) {
+               v.pending_perstake_reward += reward;
+            });
+         }
+         if ( _gguardstate.migrated ) {
+            _gstate.total_guardians_stake -= guardian->stake;
+         }
+      }
+
+      // voters the rebuild has not reached yet are evaluated by migrate_guardians
+      if ( !_gguardstate.migrated && _gguardstate.last_voter < voter.owner ) {
+         if ( guardian != _guardians.end() ) {
+            _guardians.modify( guardian, same_payer, [&](auto& g) {
+               g.reward_per_stake_index = _gguardstate.reward_per_stake;
+            });
+         }
+         return;
+      }
+
+      if ( voter.staked >= _gremstate.guardian_stake_threshold && vote_is_reasserted( voter.last_reassertion_time ) ) {
+         auto update = [&](auto& g) {
+            g.owner                  = voter.owner;
+            g.stake                  = voter.staked;
+            g.reward_per_stake_index = _gguardstate.reward_per_stake;
+            g.expiration             = voter.last_reassertion_time + _gremstate.reassertion_period;
+         };
+         if ( guardian == _guardians.end() ) {
+            _guardians.emplace( get_self(), update );
+         } else {
+            _guardians.modify( guardian, same_payer, update );
+         }
+         if ( _gguardstate.migrated ) {
+            _gstate.total_guardians_stake += voter.staked;
+         }
+      } else if ( guardian != _guardians.end() ) {
+         _guardians.erase( guardian );
+      }
+   }
+
    void system_contract::onblock( ignore<block_header> ) {
       using namespace eosio;
 
@@ -270,6 +394,7 @@ namespace eosiosystem {
       const auto ct = current_time_point();
       check( ct - voter.last_claim_time > microseconds(useconds_per_day), "already claimed rewards within past day" );
 
+      update_guardian( voter );
       _gstate.perstake_bucket -= voter.pending_perstake_reward;
 
       if ( voter.pending_perstake_reward > 0 ) {
@@ -21,6 +21,7 @@ namespace eosiosystem {
    system_contract::system_contract( name s, name code, datastream<const char*> ds )
    :native(s,code,ds),
     _voters(get_self(), get_self().value),
+    _guardians(get_self(), get_self().value),
     _producers(get_self(), get_self().value),
     _producers2(get_self(), get_self().value),
     _global(get_self(), get_self().value),
@@ -28,6 +29,7 @@ namespace eosiosystem {
     _global3(get_self(), get_self().value),
     _global4(get_self(), get_self().value),
     _globalrem(get_self(), get_self().value),
+    _globalguard(get_self(), get_self().value),
     _rotation(get_self(), get_self().value),
     _rexpool(get_self(), get_self().value),
     _rexfunds(get_self(), get_self().value),
@@ -40,6 +42,7 @@ namespace eosiosystem {
       _gstate3 = _global3.exists() ? _global3.get() : eosio_global_state3{};
       _gstate4 = _global4.exists() ? _global4.get() : get_default_inflation_parameters();
       _gremstate = _globalrem.exists() ? _globalrem.get() : get_default_rem_parameters();
+      _gguardstate = _globalguard.exists() ? _globalguard.get() : eosio_global_guardian_state{};
 
       _grotation = _rotation.get_or_create(_self, rotation_state{
          .last_rotation_time      = time_point{},
@@ -95,6 +98,7 @@ namespace eosiosystem {
       _global3.set( _gstate3, get_self() );
       _global4.set( _gstate4, get_self() );
       _globalrem.set( _gremstate, get_self() );
+      _globalguard.set( _gguardstate, get_self() );
       _rotation.set( _grotation, get_self() );
    }
 
@@ -1122,6 +1122,7 @@ namespace eosiosystem {
             _voters.modify( vitr, same_payer, [&]( auto& vinfo ) {
                vinfo.staked += delta_stake;
             });
+            update_guardian( *vitr );
          }
       }
    }
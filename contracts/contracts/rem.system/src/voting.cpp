@@ -254,6 +254,7 @@ namespace eosiosystem {
          av.proxy     = proxy;
          av.last_reassertion_time = current_time_point();
       });
+      update_guardian( *voter );
    }
 
    void system_contract::regproxy( const name& proxy, bool isproxy ) {
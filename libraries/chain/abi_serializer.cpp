@@ -393,6 +393,121 @@ namespace eosio { namespace chain {
       return _binary_to_variant(type, binary, ctx);
    }
 
+   namespace {
+      /// packed size of built-in types with a fixed size encoding
+      const map<std::string_view, size_t, std::less<>>& fixed_size_built_in_types() {
+         static const map<std::string_view, size_t, std::less<>> sizes = {
+            {"bool", 1}, {"int8", 1}, {"uint8", 1}, {"int16", 2}, {"uint16", 2},
+            {"int32", 4}, {"uint32", 4}, {"int64", 8}, {"uint64", 8}, {"int128", 16}, {"uint128", 16},
+            {"float32", 4}, {"float64", 8}, {"float128", 16},
+            {"time_point", 8}, {"time_point_sec", 4}, {"block_timestamp_type", 4},
+            {"name", 8}, {"checksum160", 20}, {"checksum256", 32}, {"checksum512", 64},
+            {"symbol", 8}, {"symbol_code", 8}, {"asset", 16}, {"extended_asset", 24}
+         };
+         return sizes;
+      }
+   }
+
+   void abi_serializer::_skip_binary( const std::string_view& type, fc::datastream<const char*>& stream,
+                                      impl::binary_to_variant_context& ctx )const
+   {
+      auto h = ctx.enter_scope();
+      auto rtype = resolve_type(type);
+      if( is_array(rtype) ) {
+         fc::unsigned_int size;
+         try {
+            fc::raw::unpack(stream, size);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack size of array '${p}'", ("p", ctx.get_path_string()) )
+         auto ftype = fundamental_type(rtype);
+         for( decltype(size.value) i = 0; i < size; ++i ) {
+            _skip_binary(ftype, stream, ctx);
+         }
+         return;
+      }
+      if( is_optional(rtype) ) {
+         char flag;
+         try {
+            fc::raw::unpack(stream, flag);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack presence flag of optional '${p}'", ("p", ctx.get_path_string()) )
+         if( flag ) _skip_binary(fundamental_type(rtype), stream, ctx);
+         return;
+      }
+
+      auto btype = built_in_types.find(rtype);
+      if( btype != built_in_types.end() ) {
+         const auto& fixed_sizes = fixed_size_built_in_types();
+         auto fixed = fixed_sizes.find(rtype);
+         size_t skip = 0;
+         if( fixed != fixed_sizes.end() ) {
+            skip = fixed->second;
+         } else if( rtype == "bytes" || rtype == "string" ) {
+            fc::unsigned_int size;
+            try {
+               fc::raw::unpack(stream, size);
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack length of '${p}'", ("p", ctx.get_path_string()) )
+            skip = size.value;
+         } else {
+            // no length prefix to skip by (e.g. public_key, varuint32), unpack it instead
+            try {
+               btype->second.first(stream, false, false);
+            } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack built-in type '${type}' while processing '${p}'",
+                                      ("type", impl::limit_size(rtype))("p", ctx.get_path_string()) )
+            return;
+         }
+         EOS_ASSERT( stream.remaining() >= skip, unpack_exception, "Stream unexpectedly ended while processing '${p}'",
+                     ("p", ctx.get_path_string()) );
+         stream.skip(skip);
+         return;
+      }
+
+      auto v_itr = variants.find(rtype);
+      if( v_itr != variants.end() ) {
+         fc::unsigned_int select;
+         try {
+            fc::raw::unpack(stream, select);
+         } EOS_RETHROW_EXCEPTIONS( unpack_exception, "Unable to unpack tag of variant '${p}'", ("p", ctx.get_path_string()) )
+         EOS_ASSERT( (size_t)select < v_itr->second.types.size(), unpack_exception,
+                     "Unpacked invalid tag (${select}) for variant '${p}'", ("select", select.value)("p",ctx.get_path_string()) );
+         _skip_binary(v_itr->second.types[select], stream, ctx);
+         return;
+      }
+
+      _skip_struct_binary(rtype, stream, nullptr, nullptr, ctx);
+   }
+
+   void abi_serializer::_skip_struct_binary( const std::string_view& type, fc::datastream<const char*>& stream, const char* start,
+                                             vector<field_range>* ranges, impl::binary_to_variant_context& ctx )const
+   {
+      auto h = ctx.enter_scope();
+      auto s_itr = structs.find(type);
+      EOS_ASSERT( s_itr != structs.end(), invalid_type_inside_abi, "Unknown type ${type}", ("type",ctx.maybe_shorten(type)) );
+      const auto& st = s_itr->second;
+      if( st.base != type_name() ) {
+         _skip_struct_binary(resolve_type(st.base), stream, start, ranges, ctx);
+      }
+      for( const auto& field : st.fields ) {
+         bool extension = ends_with(field.type, "$");
+         if( !stream.remaining() ) {
+            if( extension ) continue;
+            EOS_THROW( unpack_exception, "Stream unexpectedly ended; unable to unpack field '${f}' of struct '${p}'",
+                       ("f", ctx.maybe_shorten(field.name))("p", ctx.get_path_string()) );
+         }
+         const char* begin = stream.pos();
+         _skip_binary(extension ? _remove_bin_extension(field.type) : field.type, stream, ctx);
+         if( ranges ) ranges->push_back( field_range{ field.name, size_t(begin - start), size_t(stream.pos() - start) } );
+      }
+   }
+
+   vector<abi_serializer::field_range> abi_serializer::get_field_ranges( const std::string_view& type, const char* binary, size_t size,
+                                                                         const fc::microseconds& max_serialization_time )const
+   {
+      impl::binary_to_variant_context ctx(*this, max_serialization_time, type);
+      fc::datastream<const char*> ds( binary, size );
+      vector<field_range> ranges;
+      _skip_struct_binary(resolve_type(type), ds, binary, &ranges, ctx);
+      return ranges;
+   }
+
    void abi_serializer::_variant_to_binary( const std::string_view& type, const fc::variant& var, fc::datastream<char *>& ds, impl::variant_to_binary_context& ctx )const
    { try {
       auto h = ctx.enter_scope();
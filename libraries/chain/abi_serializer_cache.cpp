@@ -0,0 +1,59 @@
+#include <eosio/chain/abi_serializer_cache.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace eosio { namespace chain {
+
+abi_serializer_cache::abi_serializer_cache( size_t max_entries )
+: _max_entries( std::max<size_t>( max_entries, 1 ) )
+{
+}
+
+abi_serializer_cache::entry_ptr abi_serializer_cache::get( account_name account, const char* raw_abi, size_t raw_abi_size,
+                                                           const fc::microseconds& max_serialization_time ) {
+   {
+      std::lock_guard<std::mutex> g( _mtx );
+      auto itr = _cache.find( account );
+      if( itr != _cache.end() && itr->second.raw_abi.size() == raw_abi_size &&
+          (raw_abi_size == 0 || memcmp( itr->second.raw_abi.data(), raw_abi, raw_abi_size ) == 0) ) {
+         itr->second.last_used = ++_use_counter;
+         return itr->second.abi;
+      }
+   }
+
+   // construct outside of the lock, parsing and validating the abi is the expensive part
+   auto e = std::make_shared<entry>();
+   if( raw_abi_size > 4 ) { // 4 == packsize of empty abi, see abi_serializer::is_empty_abi
+      fc::datastream<const char*> ds( raw_abi, raw_abi_size );
+      fc::raw::unpack( ds, e->abi );
+      e->serializer.set_abi( e->abi, max_serialization_time );
+   }
+   entry_ptr result = std::move( e );
+
+   std::lock_guard<std::mutex> g( _mtx );
+   auto itr = _cache.find( account );
+   if( itr == _cache.end() && _cache.size() >= _max_entries ) {
+      auto lru = std::min_element( _cache.begin(), _cache.end(), []( const auto& a, const auto& b ) {
+         return a.second.last_used < b.second.last_used;
+      } );
+      _cache.erase( lru );
+   }
+   auto& c = _cache[account];
+   c.raw_abi.assign( raw_abi, raw_abi + raw_abi_size );
+   c.abi = result;
+   c.last_used = ++_use_counter;
+   return result;
+}
+
+void abi_serializer_cache::clear() {
+   std::lock_guard<std::mutex> g( _mtx );
+   _cache.clear();
+}
+
+size_t abi_serializer_cache::size()const {
+   std::lock_guard<std::mutex> g( _mtx );
+   return _cache.size();
+}
+
+} } // eosio::chain
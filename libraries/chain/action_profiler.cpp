@@ -0,0 +1,56 @@
+#include <eosio/chain/action_profiler.hpp>
+
+#include <algorithm>
+
+namespace eosio { namespace chain {
+
+void action_profiler::record( account_name receiver, account_name account, action_name action,
+                              std::chrono::nanoseconds elapsed, const host_function_times& host_functions ) {
+   auto key = std::make_tuple( receiver, account, action );
+   const bool overflow = _actions.size() >= _max_actions && !_actions.count( key );
+   if( overflow )
+      key = {};
+   auto& stats = _actions[key];
+   // the overflow entry keeps empty names, it aggregates every untracked action
+   if( stats.executions == 0 && !overflow ) {
+      stats.receiver = receiver;
+      stats.account = account;
+      stats.action = action;
+   }
+   ++stats.executions;
+   stats.time_ns += elapsed.count();
+   for( const auto& f : host_functions ) {
+      auto& host_stats = stats.host_functions[f.first];
+      host_stats.calls += f.second.calls;
+      host_stats.time_ns += f.second.time_ns;
+   }
+}
+
+vector<action_profiler::action_stats> action_profiler::get_actions( uint32_t limit )const {
+   vector<action_stats> result;
+   result.reserve( _actions.size() );
+   for( const auto& a : _actions )
+      result.push_back( a.second );
+   std::sort( result.begin(), result.end(), []( const auto& a, const auto& b ) {
+      return a.time_ns > b.time_ns;
+   });
+   if( result.size() > limit )
+      result.resize( limit );
+   return result;
+}
+
+void action_profiler::write_folded_stacks( std::ostream& out )const {
+   for( const auto& a : _actions ) {
+      const action_stats& stats = a.second;
+      const std::string stack = stats.receiver.empty() ? std::string( "other" )
+                                : stats.receiver.to_string() + ";" + stats.account.to_string() + "::" + stats.action.to_string();
+      uint64_t host_ns = 0;
+      for( const auto& f : stats.host_functions ) {
+         out << stack << ";" << f.first << " " << f.second.time_ns << "\n";
+         host_ns += f.second.time_ns;
+      }
+      out << stack << ";self " << (stats.time_ns > host_ns ? stats.time_ns - host_ns : 0) << "\n";
+   }
+}
+
+} } // namespace eosio::chain
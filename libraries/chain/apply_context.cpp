@@ -52,6 +52,11 @@ apply_context::apply_context(controller& con, transaction_context& trx_ctx, uint
 void apply_context::exec_one()
 {
    auto start = fc::time_point::now();
+   profiler = control.get_action_profiler();
+   if( profiler ) {
+      _host_function_times.clear();
+      _profile_start = std::chrono::steady_clock::now();
+   }
 
    action_receipt r;
    r.receiver         = receiver;
@@ -162,6 +167,11 @@ void apply_context::finalize_trace( action_trace& trace, const fc::time_point& s
    _pending_console_output.clear();
 
    trace.elapsed = fc::time_point::now() - start;
+
+   if( profiler ) {
+      profiler->record( receiver, trace.act.account, trace.act.name, std::chrono::steady_clock::now() - _profile_start, _host_function_times );
+      profiler = nullptr;
+   }
 }
 
 void apply_context::exec()
@@ -1,10 +1,17 @@
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fstream>
 #include <fc/bitutil.hpp>
 #include <fc/io/cfile.hpp>
 #include <fc/io/raw.hpp>
 
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+
+#include <cstring>
+
 
 #define LOG_READ  (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
@@ -22,6 +29,8 @@
 
 namespace eosio { namespace chain {
 
+   namespace bio = boost::iostreams;
+
    const uint32_t block_log::min_supported_version = 1;
 
    /**
@@ -47,6 +56,16 @@ namespace eosio { namespace chain {
             bool                     genesis_written_to_block_log = false;
             uint32_t                 version = 0;
             uint32_t                 first_block_num = 0;
+            uint32_t                 pack_size = 0;
+            std::unique_ptr<block_log_packs> packs;   // blocks preceding blocks.log, if archived
+            std::mutex               mtx;             // guards the files, blocks may be read on other threads
+
+            struct pack_job {
+               uint32_t                                         last_block = 0; // last block of the trimmed copy
+               std::future<block_log_packs::compressed_pack>    result;
+            };
+            fc::optional<named_thread_pool> pack_thread;
+            fc::optional<pack_job>          packing;
 
             inline void check_open_files() {
                if( !open_files ) {
@@ -74,6 +93,16 @@ namespace eosio { namespace chain {
 
             uint64_t append(const signed_block_ptr& b);
 
+            signed_block_ptr read_block(uint64_t file_pos);
+            void             read_block_header(block_header& bh, uint64_t file_pos);
+            signed_block_ptr read_block_by_num(uint32_t block_num);
+            block_id_type    read_block_id_by_num(uint32_t block_num);
+            uint64_t         get_block_pos(uint32_t block_num);
+            signed_block_ptr read_head();
+
+            /// waits for the packing in progress, if any, and drops its files
+            void abandon_packing();
+
             template <typename ChainContext, typename Lambda>
             static fc::optional<ChainContext> extract_chain_context( const fc::path& data_dir, Lambda&& lambda );
       };
@@ -181,8 +210,9 @@ namespace eosio { namespace chain {
       };
    }
 
-   block_log::block_log(const fc::path& data_dir)
+   block_log::block_log(const fc::path& data_dir, uint32_t pack_size)
    :my(new detail::block_log_impl()) {
+      my->pack_size = pack_size;
       open(data_dir);
    }
 
@@ -192,6 +222,9 @@ namespace eosio { namespace chain {
 
    block_log::~block_log() {
       if (my) {
+         try {
+            complete_packing();
+         } FC_LOG_AND_DROP()
          flush();
          my->close();
          my.reset();
@@ -250,7 +283,7 @@ namespace eosio { namespace chain {
             my->first_block_num = 1;
          }
 
-         my->head = read_head();
+         my->head = my->read_head();
          if( my->head ) {
             my->head_id = my->head->id();
          } else {
@@ -284,10 +317,259 @@ namespace eosio { namespace chain {
          fc::remove_all( my->index_file.get_file_path() );
          my->reopen();
       }
+
+      my->packs.reset();
+      if (block_log_packs::exists(data_dir)) {
+         EOS_ASSERT( log_size, block_log_exception, "Block log packs in '${blocks_dir}' have no blocks.log", ("blocks_dir", data_dir) );
+         my->packs = std::make_unique<block_log_packs>(data_dir);
+         EOS_ASSERT( my->packs->end_block_num() >= my->first_block_num, block_log_exception,
+                     "Block log packs end at block ${end} but blocks.log starts at block ${first}",
+                     ("end", my->packs->end_block_num() - 1)("first", my->first_block_num) );
+         ilog("Block log packs hold blocks ${first} through ${last}",
+              ("first", my->packs->first_block_num())("last", my->packs->end_block_num() - 1));
+      }
    }
 
    uint64_t block_log::append(const signed_block_ptr& b) {
-      return my->append(b);
+      uint64_t pos;
+      {
+         std::lock_guard<std::mutex> g(my->mtx);
+         pos = my->append(b);
+      }
+      if (my->pack_size)
+         pack_blocks(my->pack_size);
+      return pos;
+   }
+
+   namespace detail {
+      static fc::path packing_dir( const fc::path& data_dir ) { return data_dir / "packs-tmp"; }
+
+      /// appends blocks `first` through `last` of a block log starting at `log_first_block_num` to `out_block` and
+      /// `out_index`, `end_pos` is the end of block `last` in `in_block`
+      static void copy_blocks( fc::cfile& in_block, fc::cfile& in_index, uint32_t log_first_block_num,
+                               uint32_t first, uint32_t last, uint64_t end_pos, fc::cfile& out_block, fc::cfile& out_index ) {
+         vector<uint64_t> positions(last - first + 1);
+         in_index.seek(sizeof(uint64_t) * (first - log_first_block_num));
+         in_index.read((char*)positions.data(), sizeof(uint64_t) * positions.size());
+
+         out_block.seek_end(0);
+         out_index.seek_end(0);
+         vector<char> buffer;
+         for (size_t i = 0; i < positions.size(); ++i) {
+            const uint64_t next = i + 1 < positions.size() ? positions[i + 1] : end_pos;
+            buffer.resize(next - positions[i] - sizeof(uint64_t));
+            in_block.seek(positions[i]);
+            in_block.read(buffer.data(), buffer.size());
+            const uint64_t pos = out_block.tellp();
+            out_block.write(buffer.data(), buffer.size());
+            out_block.write((char*)&pos, sizeof(pos));
+            out_index.write((char*)&pos, sizeof(pos));
+         }
+      }
+
+      /// runs on the packing thread: compresses the `blocks_per_pack` blocks starting at `first_block` and writes a
+      /// copy of blocks.log holding the blocks following them up to `last_block`, which ends at `end_pos`
+      static block_log_packs::compressed_pack prepare_pack( const fc::path& data_dir, uint32_t log_first_block_num,
+                                                            uint32_t first_block, uint32_t blocks_per_pack,
+                                                            uint32_t last_block, uint64_t end_pos, const chain_id_type& chain_id ) {
+         // blocks.log is only appended to while packing, the blocks up to `end_pos` don't change
+         fc::cfile block_file, index_file;
+         block_file.set_file_path( data_dir / "blocks.log" );
+         index_file.set_file_path( data_dir / "blocks.index" );
+         block_file.open( "rb" );
+         index_file.open( "rb" );
+
+         vector<signed_block_ptr> blocks;
+         blocks.reserve(blocks_per_pack);
+         for (uint32_t n = first_block; n < first_block + blocks_per_pack; ++n) {
+            uint64_t pos = 0;
+            index_file.seek(sizeof(uint64_t) * (n - log_first_block_num));
+            index_file.read((char*)&pos, sizeof(pos));
+            block_file.seek(pos);
+            auto b = std::make_shared<signed_block>();
+            auto ds = block_file.create_datastream();
+            fc::raw::unpack(ds, *b);
+            EOS_ASSERT( b->block_num() == n, block_log_exception,
+                        "Wrong block was read from block log.", ("returned", b->block_num())("expected", n) );
+            blocks.emplace_back(std::move(b));
+         }
+         auto pack = block_log_packs::compress_pack(blocks);
+
+         const auto temp_dir = packing_dir(data_dir);
+         fc::remove_all(temp_dir);
+         fc::create_directories(temp_dir);
+         fc::cfile new_block_file, new_index_file;
+         new_block_file.set_file_path( temp_dir / "blocks.log" );
+         new_index_file.set_file_path( temp_dir / "blocks.index" );
+         new_block_file.open( LOG_WRITE_C );
+         new_index_file.open( LOG_WRITE_C );
+
+         static_assert( block_log::max_supported_version == 3,
+                        "Code was written to support version 3 format, need to update this code for latest format." );
+         const uint32_t version = block_log::max_supported_version;
+         const uint32_t new_first_block = first_block + blocks_per_pack;
+         new_block_file.write((char*)&version, sizeof(version));
+         new_block_file.write((char*)&new_first_block, sizeof(new_first_block));
+         new_block_file << chain_id;
+         auto totem = block_log::npos;
+         new_block_file.write((char*)&totem, sizeof(totem));
+
+         copy_blocks(block_file, index_file, log_first_block_num, new_first_block, last_block, end_pos, new_block_file, new_index_file);
+         new_block_file.flush();
+         new_index_file.flush();
+         return pack;
+      }
+   }
+
+   void block_log::pack_blocks(uint32_t blocks_per_pack) {
+      if (my->packing) {
+         // appending never waits for the packing thread
+         if (my->packing->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return;
+         complete_packing();
+      }
+
+      const auto data_dir = my->block_file.get_file_path().parent_path();
+      const uint32_t first_unpacked = my->packs ? my->packs->end_block_num() : my->first_block_num;
+      if (my->packs)
+         blocks_per_pack = my->packs->blocks_per_pack();
+      // blocks.log keeps at least one full pack of the most recent blocks uncompressed
+      if (!my->head || my->head->block_num() < first_unpacked + 2 * blocks_per_pack - 1)
+         return;
+
+      if (!my->packs) {
+         flush();
+         block_log_packs::create(data_dir, first_unpacked, blocks_per_pack);
+         my->packs = std::make_unique<block_log_packs>(data_dir);
+      }
+      if (!my->pack_thread)
+         my->pack_thread.emplace( "blklog", 1 );
+
+      const uint32_t log_first_block_num = my->first_block_num;
+      const uint32_t last_block = my->head->block_num();
+      uint64_t end_pos = 0;
+      {
+         std::lock_guard<std::mutex> g(my->mtx);
+         my->block_file.seek_end(0);
+         end_pos = my->block_file.tellp();
+      }
+      const auto chain_id = extract_chain_id(data_dir);
+
+      my->packing.emplace();
+      my->packing->last_block = last_block;
+      my->packing->result = async_thread_pool( my->pack_thread->get_executor(), [=]() {
+         return detail::prepare_pack(data_dir, log_first_block_num, first_unpacked, blocks_per_pack, last_block, end_pos, chain_id);
+      });
+   }
+
+   void block_log::complete_packing() {
+      if (!my->packing)
+         return;
+      auto result = std::move(my->packing->result);
+      const uint32_t last_block = my->packing->last_block;
+      my->packing.reset();
+      const auto pack = result.get();
+
+      const auto data_dir = my->block_file.get_file_path().parent_path();
+      const auto temp_dir = detail::packing_dir(data_dir);
+      {
+         std::lock_guard<std::mutex> g(my->mtx);
+         {
+            fc::cfile new_block_file, new_index_file;
+            new_block_file.set_file_path( temp_dir / "blocks.log" );
+            new_index_file.set_file_path( temp_dir / "blocks.index" );
+            new_block_file.open( LOG_RW_C );
+            new_index_file.open( LOG_RW_C );
+            // blocks appended while packing
+            const uint32_t head_num = my->head->block_num();
+            if (head_num > last_block) {
+               my->check_open_files();
+               my->block_file.seek_end(0);
+               const uint64_t end_pos = my->block_file.tellp();
+               detail::copy_blocks(my->block_file, my->index_file, my->first_block_num, last_block + 1, head_num, end_pos,
+                                   new_block_file, new_index_file);
+            }
+            new_block_file.flush();
+            new_index_file.flush();
+         }
+
+         // a crash before blocks.log is replaced leaves the packed blocks in both files, which open() accepts
+         my->packs->append_pack(pack);
+         my->close();
+         fc::rename(temp_dir / "blocks.log", data_dir / "blocks.log");
+         fc::rename(temp_dir / "blocks.index", data_dir / "blocks.index");
+         my->reopen();
+         my->first_block_num = my->packs->end_block_num();
+      }
+      fc::remove_all(temp_dir);
+   }
+
+   void detail::block_log_impl::abandon_packing() {
+      if (!packing)
+         return;
+      packing->result.wait();
+      packing.reset();
+      fc::remove_all(packing_dir(block_file.get_file_path().parent_path()));
+   }
+
+   void block_log::pack_blocklog(const fc::path& block_dir, uint32_t blocks_per_pack) {
+      EOS_ASSERT( blocks_per_pack > 0, block_log_exception, "Blocks per pack must be greater than 0" );
+      uint32_t end_block_num = 0;
+      {
+         block_log log(block_dir);
+         EOS_ASSERT( log.head(), block_log_exception, "No blocks found in block log" );
+         const uint32_t head_num = log.head()->block_num();
+         if (!log.my->packs) {
+            block_log_packs::create(block_dir, log.my->first_block_num, blocks_per_pack);
+            log.my->packs = std::make_unique<block_log_packs>(block_dir);
+         }
+         auto& packs = *log.my->packs;
+         // the head block stays in blocks.log
+         while (packs.end_block_num() + packs.blocks_per_pack() <= head_num) {
+            vector<signed_block_ptr> blocks;
+            blocks.reserve(packs.blocks_per_pack());
+            for (uint32_t n = packs.end_block_num(); n < packs.end_block_num() + packs.blocks_per_pack(); ++n) {
+               blocks.emplace_back(log.read_block_by_num(n));
+            }
+            packs.append_pack(blocks);
+            ilog("Packed blocks ${first} through ${last}", ("first", blocks.front()->block_num())("last", blocks.back()->block_num()));
+         }
+         end_block_num = packs.end_block_num();
+      }
+      block_log::trim_blocklog_front(block_dir, block_dir / "packs-tmp", end_block_num);
+      fc::remove_all(block_dir / "packs-tmp");
+   }
+
+   void block_log::unpack_blocklog(const fc::path& block_dir) {
+      EOS_ASSERT( block_log_packs::exists(block_dir), block_log_not_found,
+                  "Block log packs not found in '${blocks_dir}'", ("blocks_dir", block_dir) );
+      const auto temp_dir = block_dir / "unpack-tmp";
+      fc::remove_all(temp_dir);
+      fc::create_directories(temp_dir);
+      {
+         block_log log(block_dir);
+         EOS_ASSERT( log.head(), block_log_exception, "No blocks found in block log" );
+         const uint32_t first_block_num = log.first_block_num();
+         const uint32_t head_num = log.head()->block_num();
+
+         block_log unpacked(temp_dir);
+         uint32_t n = first_block_num;
+         auto gs = block_log_packs::extract_genesis_state(block_dir);
+         if (gs) {
+            unpacked.reset(*gs, log.read_block_by_num(n++));
+         } else {
+            unpacked.reset(block_log_packs::extract_chain_id(block_dir), first_block_num);
+         }
+         for (; n <= head_num; ++n) {
+            unpacked.append(log.read_block_by_num(n));
+            if (n % 100000 == 0)
+               ilog("Unpacked block ${n}", ("n", n));
+         }
+      }
+      fc::rename(temp_dir / "blocks.log", block_dir / "blocks.log");
+      fc::rename(temp_dir / "blocks.index", block_dir / "blocks.index");
+      block_log_packs::remove(block_dir);
+      fc::remove_all(temp_dir);
    }
 
    uint64_t detail::block_log_impl::append(const signed_block_ptr& b) {
@@ -333,6 +615,8 @@ namespace eosio { namespace chain {
 
       fc::remove_all( block_file.get_file_path() );
       fc::remove_all( index_file.get_file_path() );
+      packs.reset();
+      block_log_packs::remove( block_file.get_file_path().parent_path() );
 
       reopen();
 
@@ -370,12 +654,16 @@ namespace eosio { namespace chain {
    }
 
    void block_log::reset( const genesis_state& gs, const signed_block_ptr& first_block ) {
+      my->abandon_packing();
+      std::lock_guard<std::mutex> g(my->mtx);
       my->reset(gs, first_block, 1);
    }
 
    void block_log::reset( const chain_id_type& chain_id, uint32_t first_block_num ) {
       EOS_ASSERT( first_block_num > 1, block_log_exception,
                   "Block log version ${ver} needs to be created with a genesis state if starting from block number 1." );
+      my->abandon_packing();
+      std::lock_guard<std::mutex> g(my->mtx);
       my->reset(chain_id, signed_block_ptr(), first_block_num);
    }
 
@@ -389,28 +677,60 @@ namespace eosio { namespace chain {
    }
 
    signed_block_ptr block_log::read_block(uint64_t pos)const {
-      my->check_open_files();
+      std::lock_guard<std::mutex> g(my->mtx);
+      return my->read_block(pos);
+   }
+
+   void block_log::read_block_header(block_header& bh, uint64_t pos)const {
+      std::lock_guard<std::mutex> g(my->mtx);
+      my->read_block_header(bh, pos);
+   }
+
+   signed_block_ptr block_log::read_block_by_num(uint32_t block_num)const {
+      std::lock_guard<std::mutex> g(my->mtx);
+      return my->read_block_by_num(block_num);
+   }
+
+   block_id_type block_log::read_block_id_by_num(uint32_t block_num)const {
+      std::lock_guard<std::mutex> g(my->mtx);
+      return my->read_block_id_by_num(block_num);
+   }
+
+   uint64_t block_log::get_block_pos(uint32_t block_num) const {
+      std::lock_guard<std::mutex> g(my->mtx);
+      return my->get_block_pos(block_num);
+   }
+
+   signed_block_ptr block_log::read_head()const {
+      std::lock_guard<std::mutex> g(my->mtx);
+      return my->read_head();
+   }
+
+   signed_block_ptr detail::block_log_impl::read_block(uint64_t pos) {
+      check_open_files();
 
-      my->block_file.seek(pos);
+      block_file.seek(pos);
       signed_block_ptr result = std::make_shared<signed_block>();
-      auto ds = my->block_file.create_datastream();
+      auto ds = block_file.create_datastream();
       fc::raw::unpack(ds, *result);
       return result;
    }
 
-   void block_log::read_block_header(block_header& bh, uint64_t pos)const {
-      my->check_open_files();
+   void detail::block_log_impl::read_block_header(block_header& bh, uint64_t pos) {
+      check_open_files();
 
-      my->block_file.seek(pos);
-      auto ds = my->block_file.create_datastream();
+      block_file.seek(pos);
+      auto ds = block_file.create_datastream();
       fc::raw::unpack(ds, bh);
    }
 
-   signed_block_ptr block_log::read_block_by_num(uint32_t block_num)const {
+   signed_block_ptr detail::block_log_impl::read_block_by_num(uint32_t block_num) {
       try {
+         if (packs && block_num < packs->end_block_num())
+            return packs->read_block_by_num(block_num);
          signed_block_ptr b;
          uint64_t pos = get_block_pos(block_num);
-         if (pos != npos) {
+         if (pos != block_log::npos) {
             b = read_block(pos);
             EOS_ASSERT(b->block_num() == block_num, reversible_blocks_exception,
                       "Wrong block was read from block log.", ("returned", b->block_num())("expected", block_num));
@@ -419,10 +739,14 @@ namespace eosio { namespace chain {
       } FC_LOG_AND_RETHROW()
    }
 
-   block_id_type block_log::read_block_id_by_num(uint32_t block_num)const {
+   block_id_type detail::block_log_impl::read_block_id_by_num(uint32_t block_num) {
       try {
+         if (packs && block_num < packs->end_block_num()) {
+            auto b = packs->read_block_by_num(block_num);
+            return b ? b->id() : block_id_type();
+         }
          uint64_t pos = get_block_pos(block_num);
-         if (pos != npos) {
+         if (pos != block_log::npos) {
             block_header bh;
             read_block_header(bh, pos);
             EOS_ASSERT(bh.block_num() == block_num, reversible_blocks_exception,
@@ -433,29 +757,29 @@ namespace eosio { namespace chain {
       } FC_LOG_AND_RETHROW()
    }
 
-   uint64_t block_log::get_block_pos(uint32_t block_num) const {
-      my->check_open_files();
-      if (!(my->head && block_num <= block_header::num_from_id(my->head_id) && block_num >= my->first_block_num))
-         return npos;
-      my->index_file.seek(sizeof(uint64_t) * (block_num - my->first_block_num));
+   uint64_t detail::block_log_impl::get_block_pos(uint32_t block_num) {
+      check_open_files();
+      if (!(head && block_num <= block_header::num_from_id(head_id) && block_num >= first_block_num))
+         return block_log::npos;
+      index_file.seek(sizeof(uint64_t) * (block_num - first_block_num));
       uint64_t pos;
-      my->index_file.read((char*)&pos, sizeof(pos));
+      index_file.read((char*)&pos, sizeof(pos));
       return pos;
    }
 
-   signed_block_ptr block_log::read_head()const {
-      my->check_open_files();
+   signed_block_ptr detail::block_log_impl::read_head() {
+      check_open_files();
 
       uint64_t pos;
 
       // Check that the file is not empty
-      my->block_file.seek_end(0);
-      if (my->block_file.tellp() <= sizeof(pos))
+      block_file.seek_end(0);
+      if (block_file.tellp() <= sizeof(pos))
          return {};
 
-      my->block_file.seek_end(-sizeof(pos));
-      my->block_file.read((char*)&pos, sizeof(pos));
-      if (pos != npos) {
+      block_file.seek_end(-sizeof(pos));
+      block_file.read((char*)&pos, sizeof(pos));
+      if (pos != block_log::npos) {
          return read_block(pos);
       } else {
          return {};
@@ -471,7 +795,7 @@ namespace eosio { namespace chain {
    }
 
    uint32_t block_log::first_block_num() const {
-      return my->first_block_num;
+      return my->packs ? my->packs->first_block_num() : my->first_block_num;
    }
 
    void block_log::construct_index() {
@@ -519,6 +843,9 @@ namespace eosio { namespace chain {
       ilog("Recovering Block Log...");
       EOS_ASSERT( fc::is_directory(data_dir) && fc::is_regular_file(data_dir / "blocks.log"), block_log_not_found,
                  "Block log not found in '${blocks_dir}'", ("blocks_dir", data_dir)          );
+      EOS_ASSERT( !block_log_packs::exists(data_dir), block_log_exception,
+                  "Block log in '${blocks_dir}' is packed, unpack it with eosio-blocklog --unpack-blocklog before repairing it",
+                  ("blocks_dir", data_dir) );
 
       auto now = fc::time_point::now();
 
@@ -724,6 +1051,9 @@ namespace eosio { namespace chain {
    }
 
    fc::optional<genesis_state> block_log::extract_genesis_state( const fc::path& data_dir ) {
+      // blocks.log no longer starts with the genesis state once its first blocks are packed
+      if (block_log_packs::exists(data_dir))
+         return block_log_packs::extract_genesis_state(data_dir);
       return detail::block_log_impl::extract_chain_context<genesis_state>(data_dir, [](std::fstream& block_stream, uint32_t version, uint32_t first_block_num ) -> fc::optional<genesis_state> {
          if (contains_genesis_state(version, first_block_num)) {
             genesis_state gs;
@@ -737,6 +1067,8 @@ namespace eosio { namespace chain {
    }
 
    chain_id_type block_log::extract_chain_id( const fc::path& data_dir ) {
+      if (block_log_packs::exists(data_dir))
+         return block_log_packs::extract_chain_id(data_dir);
       return *(detail::block_log_impl::extract_chain_context<chain_id_type>(data_dir, [](std::fstream& block_stream, uint32_t version, uint32_t first_block_num ) -> fc::optional<chain_id_type> {
          // supported versions either contain a genesis state, or else the chain id only
          if (contains_genesis_state(version, first_block_num)) {
@@ -1065,6 +1397,292 @@ namespace eosio { namespace chain {
       return true;
    }
 
+   const uint32_t block_log_packs::version = 1;
+
+   namespace detail {
+      static fc::path packs_file_name( const fc::path& data_dir ) { return data_dir / "blocks.packs"; }
+      static fc::path packs_index_file_name( const fc::path& data_dir ) { return data_dir / "blocks.packs.index"; }
+
+      struct pack_header {
+         uint32_t num_blocks = 0;
+         uint64_t compressed_size = 0;
+      };
+      constexpr uint64_t pack_header_size = sizeof(pack_header::num_blocks) + sizeof(pack_header::compressed_size);
+
+      static vector<char> zlib_compress( const vector<char>& data ) {
+         vector<char> out;
+         bio::filtering_ostream comp;
+         comp.push(bio::zlib_compressor(bio::zlib::default_compression));
+         comp.push(bio::back_inserter(out));
+         bio::write(comp, data.data(), data.size());
+         bio::close(comp);
+         return out;
+      }
+
+      static vector<char> zlib_decompress( const vector<char>& data ) {
+         vector<char> out;
+         bio::filtering_ostream decomp;
+         decomp.push(bio::zlib_decompressor());
+         decomp.push(bio::back_inserter(out));
+         bio::write(decomp, data.data(), data.size());
+         bio::close(decomp);
+         return out;
+      }
+
+      /// reads the archive header, leaving the file positioned at the chain context
+      static void read_packs_header( fc::cfile& file, uint32_t& first_block_num, uint32_t& blocks_per_pack ) {
+         uint32_t version = 0;
+         file.seek(0);
+         file.read((char*)&version, sizeof(version));
+         EOS_ASSERT( version == block_log_packs::version, block_log_unsupported_version,
+                     "Unsupported version of block log packs. Version is ${version} while code supports version ${supported}",
+                     ("version", version)("supported", block_log_packs::version) );
+         file.read((char*)&first_block_num, sizeof(first_block_num));
+         file.read((char*)&blocks_per_pack, sizeof(blocks_per_pack));
+         EOS_ASSERT( first_block_num > 0 && blocks_per_pack > 0, block_log_exception,
+                     "Block log packs ${file} are malformed", ("file", file.get_file_path().generic_string()) );
+      }
+   }
+
+   block_log_packs::block_log_packs(const fc::path& data_dir) {
+      _pack_file.set_file_path( detail::packs_file_name(data_dir) );
+      _index_file.set_file_path( detail::packs_index_file_name(data_dir) );
+      EOS_ASSERT( fc::is_regular_file(_pack_file.get_file_path()), block_log_not_found,
+                  "Block log packs not found in '${blocks_dir}'", ("blocks_dir", data_dir) );
+
+      _pack_file.open( LOG_RW_C );
+      detail::read_packs_header(_pack_file, _first_block_num, _blocks_per_pack);
+      auto ds = _pack_file.create_datastream();
+      if( block_log::contains_genesis_state(block_log::max_supported_version, _first_block_num) ) {
+         genesis_state gs;
+         fc::raw::unpack(ds, gs);
+      } else {
+         chain_id_type chain_id;
+         fc::raw::unpack(ds, chain_id);
+      }
+      _first_pack_pos = _pack_file.tellp();
+
+      if( !fc::exists(_index_file.get_file_path()) || fc::file_size(_index_file.get_file_path()) % sizeof(uint64_t) != 0 ) {
+         construct_index();
+      }
+      _index_file.open( LOG_RW_C );
+      _num_packs = fc::file_size(_index_file.get_file_path()) / sizeof(uint64_t);
+
+      // drop a pack that was not completely written, it is appended again from blocks.log
+      uint64_t end_of_packs = _first_pack_pos;
+      if( _num_packs > 0 ) {
+         uint64_t pos = 0;
+         _index_file.seek_end(-sizeof(pos));
+         _index_file.read((char*)&pos, sizeof(pos));
+         detail::pack_header header;
+         _pack_file.seek(pos);
+         _pack_file.read((char*)&header.num_blocks, sizeof(header.num_blocks));
+         _pack_file.read((char*)&header.compressed_size, sizeof(header.compressed_size));
+         end_of_packs = pos + detail::pack_header_size + header.compressed_size;
+      }
+      const auto file_size = fc::file_size(_pack_file.get_file_path());
+      EOS_ASSERT( end_of_packs <= file_size, block_log_exception,
+                  "Block log packs index ${index} refers past the end of ${file}",
+                  ("index", _index_file.get_file_path().generic_string())("file", _pack_file.get_file_path().generic_string()) );
+      if( end_of_packs < file_size ) {
+         ilog("Dropping incomplete pack at the end of ${file}", ("file", _pack_file.get_file_path().generic_string()));
+         _pack_file.close();
+         boost::filesystem::resize_file( _pack_file.get_file_path(), end_of_packs );
+         _pack_file.open( LOG_RW_C );
+      }
+   }
+
+   block_log_packs::~block_log_packs() {
+      if( _pack_file.is_open() )
+         _pack_file.close();
+      if( _index_file.is_open() )
+         _index_file.close();
+   }
+
+   void block_log_packs::create(const fc::path& data_dir, uint32_t first_block_num, uint32_t blocks_per_pack) {
+      EOS_ASSERT( blocks_per_pack > 0, block_log_exception, "Blocks per pack must be greater than 0" );
+      remove(data_dir);
+
+      fc::cfile file;
+      file.set_file_path( detail::packs_file_name(data_dir) );
+      file.open( LOG_WRITE_C );
+      file.write((char*)&version, sizeof(version));
+      file.write((char*)&first_block_num, sizeof(first_block_num));
+      file.write((char*)&blocks_per_pack, sizeof(blocks_per_pack));
+      if( block_log::contains_genesis_state(block_log::max_supported_version, first_block_num) ) {
+         auto gs = block_log::extract_genesis_state(data_dir);
+         EOS_ASSERT( gs, block_log_exception, "Block log packs starting at block 1 need the genesis state of blocks.log" );
+         auto data = fc::raw::pack(*gs);
+         file.write(data.data(), data.size());
+      } else {
+         auto data = fc::raw::pack(block_log::extract_chain_id(data_dir));
+         file.write(data.data(), data.size());
+      }
+      file.flush();
+      file.close();
+
+      file.set_file_path( detail::packs_index_file_name(data_dir) );
+      file.open( LOG_WRITE_C );
+      file.close();
+   }
+
+   bool block_log_packs::exists(const fc::path& data_dir) {
+      return fc::is_regular_file( detail::packs_file_name(data_dir) );
+   }
+
+   void block_log_packs::remove(const fc::path& data_dir) {
+      fc::remove_all( detail::packs_file_name(data_dir) );
+      fc::remove_all( detail::packs_index_file_name(data_dir) );
+   }
+
+   fc::optional<genesis_state> block_log_packs::extract_genesis_state( const fc::path& data_dir ) {
+      fc::cfile file;
+      file.set_file_path( detail::packs_file_name(data_dir) );
+      file.open( "rb" );
+      uint32_t first_block_num = 0, blocks_per_pack = 0;
+      detail::read_packs_header(file, first_block_num, blocks_per_pack);
+      if( !block_log::contains_genesis_state(block_log::max_supported_version, first_block_num) )
+         return {};
+      genesis_state gs;
+      auto ds = file.create_datastream();
+      fc::raw::unpack(ds, gs);
+      return gs;
+   }
+
+   chain_id_type block_log_packs::extract_chain_id( const fc::path& data_dir ) {
+      auto gs = extract_genesis_state(data_dir);
+      if( gs )
+         return gs->compute_chain_id();
+      fc::cfile file;
+      file.set_file_path( detail::packs_file_name(data_dir) );
+      file.open( "rb" );
+      uint32_t first_block_num = 0, blocks_per_pack = 0;
+      detail::read_packs_header(file, first_block_num, blocks_per_pack);
+      chain_id_type chain_id;
+      auto ds = file.create_datastream();
+      fc::raw::unpack(ds, chain_id);
+      return chain_id;
+   }
+
+   block_log_packs::compressed_pack block_log_packs::compress_pack(const vector<signed_block_ptr>& blocks) {
+      EOS_ASSERT( !blocks.empty(), block_log_append_fail, "Pack holds no blocks" );
+      const uint64_t table_size = sizeof(uint32_t) * blocks.size();
+      vector<char> payload(table_size);
+      for( size_t i = 0; i < blocks.size(); ++i ) {
+         EOS_ASSERT( blocks[i]->block_num() == blocks.front()->block_num() + i, block_log_append_fail,
+                     "Blocks of a pack must be consecutive" );
+         const uint32_t offset = payload.size() - table_size;
+         memcpy(payload.data() + sizeof(uint32_t) * i, &offset, sizeof(offset));
+         auto data = fc::raw::pack(*blocks[i]);
+         payload.insert(payload.end(), data.begin(), data.end());
+      }
+
+      compressed_pack result;
+      result.first_block_num = blocks.front()->block_num();
+      result.num_blocks = blocks.size();
+      result.data = detail::zlib_compress(payload);
+      return result;
+   }
+
+   void block_log_packs::append_pack(const compressed_pack& pack) {
+      try {
+         std::lock_guard<std::mutex> g(_mtx);
+         EOS_ASSERT( pack.num_blocks == _blocks_per_pack, block_log_append_fail,
+                     "Pack of ${n} blocks does not hold ${expected} blocks", ("n", pack.num_blocks)("expected", _blocks_per_pack) );
+         EOS_ASSERT( pack.first_block_num == end_block_num(), block_log_append_fail,
+                     "Pack starting at block ${n} does not follow the last archived block ${last}",
+                     ("n", pack.first_block_num)("last", end_block_num() - 1) );
+
+         detail::pack_header header;
+         header.num_blocks = pack.num_blocks;
+         header.compressed_size = pack.data.size();
+
+         // the pack is indexed only once it is completely written
+         _pack_file.seek_end(0);
+         uint64_t pos = _pack_file.tellp();
+         _pack_file.write((char*)&header.num_blocks, sizeof(header.num_blocks));
+         _pack_file.write((char*)&header.compressed_size, sizeof(header.compressed_size));
+         _pack_file.write(pack.data.data(), pack.data.size());
+         _pack_file.flush();
+         _index_file.seek_end(0);
+         _index_file.write((char*)&pos, sizeof(pos));
+         _index_file.flush();
+         ++_num_packs;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
+   signed_block_ptr block_log_packs::read_block_by_num(uint32_t block_num)const {
+      std::lock_guard<std::mutex> g(_mtx);
+      if( block_num < _first_block_num || block_num >= end_block_num() )
+         return {};
+
+      const uint32_t index = block_num - _first_block_num;
+      load_pack(index / _blocks_per_pack);
+
+      const uint32_t num_blocks = _blocks_per_pack;
+      const uint64_t table_size = sizeof(uint32_t) * num_blocks;
+      uint32_t offset = 0;
+      memcpy(&offset, _cached_payload.data() + sizeof(uint32_t) * (index % _blocks_per_pack), sizeof(offset));
+      EOS_ASSERT( table_size + offset < _cached_payload.size(), block_log_exception,
+                  "Block ${n} is out of its pack in ${file}", ("n", block_num)("file", _pack_file.get_file_path().generic_string()) );
+
+      signed_block_ptr result = std::make_shared<signed_block>();
+      fc::datastream<const char*> ds(_cached_payload.data() + table_size + offset, _cached_payload.size() - table_size - offset);
+      fc::raw::unpack(ds, *result);
+      EOS_ASSERT( result->block_num() == block_num, block_log_exception,
+                  "Wrong block was read from block log packs.", ("returned", result->block_num())("expected", block_num) );
+      return result;
+   }
+
+   void block_log_packs::load_pack(uint32_t pack)const {
+      if( pack == _cached_pack )
+         return;
+
+      uint64_t pos = 0;
+      _index_file.seek(sizeof(uint64_t) * pack);
+      _index_file.read((char*)&pos, sizeof(pos));
+
+      detail::pack_header header;
+      _pack_file.seek(pos);
+      _pack_file.read((char*)&header.num_blocks, sizeof(header.num_blocks));
+      _pack_file.read((char*)&header.compressed_size, sizeof(header.compressed_size));
+      EOS_ASSERT( header.num_blocks == _blocks_per_pack, block_log_exception,
+                  "Pack ${pack} of ${file} holds ${n} blocks instead of ${expected}",
+                  ("pack", pack)("file", _pack_file.get_file_path().generic_string())("n", header.num_blocks)("expected", _blocks_per_pack) );
+      vector<char> compressed(header.compressed_size);
+      _pack_file.read(compressed.data(), compressed.size());
+
+      _cached_pack = std::numeric_limits<uint32_t>::max();
+      _cached_payload = detail::zlib_decompress(compressed);
+      EOS_ASSERT( _cached_payload.size() >= sizeof(uint32_t) * _blocks_per_pack, block_log_exception,
+                  "Pack ${pack} of ${file} is malformed", ("pack", pack)("file", _pack_file.get_file_path().generic_string()) );
+      _cached_pack = pack;
+   }
+
+   void block_log_packs::construct_index() {
+      ilog("Reconstructing Block Log Packs Index...");
+      fc::cfile index;
+      index.set_file_path( _index_file.get_file_path() );
+      fc::remove_all( index.get_file_path() );
+      index.open( LOG_WRITE_C );
+
+      const auto file_size = fc::file_size(_pack_file.get_file_path());
+      uint64_t pos = _first_pack_pos;
+      while( pos + detail::pack_header_size <= file_size ) {
+         detail::pack_header header;
+         _pack_file.seek(pos);
+         _pack_file.read((char*)&header.num_blocks, sizeof(header.num_blocks));
+         _pack_file.read((char*)&header.compressed_size, sizeof(header.compressed_size));
+         if( header.num_blocks != _blocks_per_pack || pos + detail::pack_header_size + header.compressed_size > file_size )
+            break;
+         index.write((char*)&pos, sizeof(pos));
+         pos += detail::pack_header_size + header.compressed_size;
+      }
+      index.flush();
+      index.close();
+   }
+
    trim_data::trim_data(fc::path block_dir) {
 
       // code should follow logic in block_log::repair_log
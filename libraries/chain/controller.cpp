@@ -1,5 +1,6 @@
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/transaction_context.hpp>
+#include <eosio/chain/action_profiler.hpp>
 
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/fork_database.hpp>
@@ -32,6 +33,9 @@
 #include <fc/scoped_exit.hpp>
 #include <fc/variant_object.hpp>
 
+#include <boost/asio/io_context_strand.hpp>
+
+#include <deque>
 #include <new>
 
 namespace eosio { namespace chain {
@@ -241,10 +245,12 @@ struct controller_impl {
    db_read_mode                   read_mode = db_read_mode::SPECULATIVE;
    bool                           in_trx_requiring_checks = false; ///< if true, checks that are normally skipped on replay (e.g. auth checks) cannot be skipped
    optional<fc::microseconds>     subjective_cpu_leeway;
+   std::unique_ptr<action_profiler> profiler;
    bool                           trusted_producer_light_validation = false;
    uint32_t                       snapshot_head_block = 0;
-   named_thread_pool              thread_pool;
+   mutable named_thread_pool      thread_pool; // also used by the const snapshot writing
    platform_timer                 timer;
+   abi_serializer_cache           abi_cache;
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
    vm::wasm_allocator                 wasm_alloc;
 #endif
@@ -305,9 +311,9 @@ struct controller_impl {
     reversible_blocks( cfg.blocks_dir/config::reversible_blocks_dir_name,
         cfg.read_only ? database::read_only : database::read_write,
         cfg.reversible_cache_size, false, cfg.db_map_mode, cfg.db_hugepage_paths ),
-    blog( cfg.blocks_dir ),
+    blog( cfg.blocks_dir, cfg.blocks_log_pack_size ),
     fork_db( cfg.state_dir ),
-    wasmif( cfg.wasm_runtime, cfg.eosvmoc_tierup, db, cfg.state_dir, cfg.eosvmoc_config ),
+    wasmif( cfg.wasm_runtime, cfg.eosvmoc_tierup, db, cfg.state_dir, cfg.eosvmoc_config, cfg.wasm_instantiation_cache_size ),
     resource_limits( db ),
     authorization( s, db ),
     protocol_features( std::move(pfs) ),
@@ -482,13 +488,7 @@ struct controller_impl {
          ilog( "existing block log, attempting to replay from ${s} to ${n} blocks",
                ("s", start_block_num)("n", blog_head->block_num()) );
          try {
-            while( auto next = blog.read_block_by_num( head->block_num + 1 ) ) {
-               replay_push_block( next, controller::block_status::irreversible );
-               if( next->block_num() % 500 == 0 ) {
-                  ilog( "${n} of ${head}", ("n", next->block_num())("head", blog_head->block_num()) );
-                  if( shutdown() ) break;
-               }
-            }
+            replay_irreversible_blocks( blog_head->block_num(), shutdown );
          } catch(  const database_guard_exception& e ) {
             except_ptr = std::current_exception();
          }
@@ -536,6 +536,90 @@ struct controller_impl {
       }
    }
 
+   /// block of the block log prepared for application by the replay pipeline
+   struct replay_block {
+      block_state_ptr              bsp;
+      vector<recover_keys_future>  trx_metas;
+   };
+
+   /**
+    *  Applies the blocks of the block log following head up to `last_block_num`.
+    *
+    *  Reading and unpacking the blocks, building their block states and creating the transaction metadata, including
+    *  key recovery when auth checks are enforced, run ahead on the thread pool for up to conf.replay_look_ahead_blocks
+    *  blocks. Block states chain on each other, so they are built in block order on a strand. The main thread only
+    *  applies the prepared blocks.
+    */
+   void replay_irreversible_blocks( uint32_t last_block_num, const std::function<bool()>& shutdown ) {
+      const bool skip_auth_checks = !conf.force_all_checks;
+      const uint32_t look_ahead = std::max<uint32_t>( conf.replay_look_ahead_blocks, 1 );
+
+      boost::asio::io_context::strand strand( thread_pool.get_executor() );
+      block_state_ptr prev = head; // only accessed on strand
+      uint32_t next_block_num = head->block_num + 1;
+      std::deque<std::future<replay_block>> pipeline;
+
+      // the prepare tasks read the block log and refer to prev, they have to be done before leaving
+      auto wait_for_pipeline = fc::make_scoped_exit( [&pipeline]() {
+         for( auto& f : pipeline ) f.wait();
+      } );
+
+      auto fill_pipeline = [&]() {
+         for( ; pipeline.size() < look_ahead && next_block_num <= last_block_num; ++next_block_num ) {
+            auto task = std::make_shared<std::packaged_task<replay_block()>>(
+                  [this, &prev, block_num = next_block_num, skip_auth_checks]() {
+               replay_block rb;
+               auto b = blog.read_block_by_num( block_num );
+               if( !b ) return rb;
+               rb.bsp = create_replay_block_state( *prev, b );
+               prev = rb.bsp;
+               rb.trx_metas.reserve( b->transactions.size() );
+               vector<packed_transaction_ptr> trxs_to_recover;
+               for( const auto& receipt : b->transactions ) {
+                  if( !receipt.trx.contains<packed_transaction>() ) continue;
+                  const auto& pt = receipt.trx.get<packed_transaction>();
+                  if( skip_auth_checks ) {
+                     rb.trx_metas.emplace_back( async_thread_pool( thread_pool.get_executor(), [b, &pt]() {
+                        return transaction_metadata::create_no_recover_keys( pt, transaction_metadata::trx_type::input );
+                     } ) );
+                  } else {
+                     trxs_to_recover.emplace_back( std::make_shared<packed_transaction>( pt ) );
+                  }
+               }
+               if( !trxs_to_recover.empty() ) {
+                  rb.trx_metas = transaction_metadata::start_recover_keys(
+                        std::move( trxs_to_recover ), thread_pool.get_executor(), conf.thread_pool_size, chain_id, microseconds::maximum() );
+               }
+               return rb;
+            } );
+            pipeline.emplace_back( task->get_future() );
+            boost::asio::post( strand, [task]() { (*task)(); } );
+         }
+      };
+
+      fill_pipeline();
+      while( !pipeline.empty() ) {
+         auto rb = pipeline.front().get();
+         pipeline.pop_front();
+         if( !rb.bsp ) break;
+         fill_pipeline();
+
+         vector<transaction_metadata_ptr> trx_metas;
+         trx_metas.reserve( rb.trx_metas.size() );
+         for( auto& f : rb.trx_metas ) {
+            trx_metas.emplace_back( f.get() );
+         }
+         rb.bsp->set_trxs_metas( std::move( trx_metas ), !skip_auth_checks );
+
+         const auto block_num = rb.bsp->block_num;
+         replay_push_block( rb.bsp->block, controller::block_status::irreversible, rb.bsp );
+         if( block_num % 500 == 0 ) {
+            ilog( "${n} of ${head}", ("n", block_num)("head", last_block_num) );
+            if( shutdown() ) break;
+         }
+      }
+   }
+
    void startup(std::function<bool()> shutdown, const snapshot_reader_ptr& snapshot) {
       EOS_ASSERT( snapshot, snapshot_exception, "No snapshot reader provided" );
       ilog( "Starting initialization from snapshot, this may take a significant amount of time" );
@@ -758,6 +842,9 @@ struct controller_impl {
             maybe_switch_forks( pending_head, controller::block_status::complete, forked_branch_callback{}, trx_meta_cache_lookup{} );
          }
       }
+
+      // don't run the interpreter for the hottest contracts while they tier up
+      wasmif.precompile_accounts();
    }
 
    ~controller_impl() {
@@ -786,29 +873,40 @@ struct controller_impl {
    }
 
    void add_contract_tables_to_snapshot( const snapshot_writer_ptr& snapshot ) const {
-      snapshot->write_section("contract_tables", [this]( auto& section ) {
-         index_utils<table_id_multi_index>::walk(db, [this, &section]( const table_id_object& table_row ){
-            // add a row for the table
-            section.add_row(table_row, db);
-
-            // followed by a size row and then N data rows for each type of table
-            contract_database_index_set::walk_indices([this, &section, &table_row]( auto utils ) {
-               using utils_t = decltype(utils);
-               using value_t = typename decltype(utils)::index_t::value_type;
-               using by_table_id = object_to_table_id_tag_t<value_t>;
-
-               auto tid_key = boost::make_tuple(table_row.id);
-               auto next_tid_key = boost::make_tuple(table_id_object::id_type(table_row.id._id + 1));
-
-               unsigned_int size = utils_t::template size_range<by_table_id>(db, tid_key, next_tid_key);
-               section.add_row(size, db);
-
-               utils_t::template walk_range<by_table_id>(db, tid_key, next_tid_key, [this, &section]( const auto &row ) {
-                  section.add_row(row, db);
+      // split the tables into parts which can be serialized concurrently, each walking a range of table ids
+      static constexpr size_t tables_per_part = 256;
+      std::vector<snapshot_writer::section_function> parts;
+      const auto& tables = db.get_index<table_id_multi_index, by_id>();
+      for( auto itr = tables.begin(); itr != tables.end(); ) {
+         const auto begin_id = itr->id;
+         for( size_t n = 0; n < tables_per_part && itr != tables.end(); ++n ) ++itr;
+         const auto end_id = itr != tables.end() ? itr->id : table_id_object::id_type(std::numeric_limits<int64_t>::max());
+
+         parts.emplace_back([this, begin_id, end_id]( auto& section ) {
+            index_utils<table_id_multi_index>::walk_range<by_id>(db, begin_id, end_id, [this, &section]( const table_id_object& table_row ){
+               // add a row for the table
+               section.add_row(table_row, db);
+
+               // followed by a size row and then N data rows for each type of table
+               contract_database_index_set::walk_indices([this, &section, &table_row]( auto utils ) {
+                  using utils_t = decltype(utils);
+                  using value_t = typename decltype(utils)::index_t::value_type;
+                  using by_table_id = object_to_table_id_tag_t<value_t>;
+
+                  auto tid_key = boost::make_tuple(table_row.id);
+                  auto next_tid_key = boost::make_tuple(table_id_object::id_type(table_row.id._id + 1));
+
+                  unsigned_int size = utils_t::template size_range<by_table_id>(db, tid_key, next_tid_key);
+                  section.add_row(size, db);
+
+                  utils_t::template walk_range<by_table_id>(db, tid_key, next_tid_key, [this, &section]( const auto &row ) {
+                     section.add_row(row, db);
+                  });
                });
             });
          });
-      });
+      }
+      snapshot->write_section_parts("contract_tables", std::move(parts));
    }
 
    void read_contract_tables_from_snapshot( const snapshot_reader_ptr& snapshot ) {
@@ -840,7 +938,16 @@ struct controller_impl {
       });
    }
 
-   void add_to_snapshot( const snapshot_writer_ptr& snapshot ) const {
+   void add_to_snapshot( const snapshot_writer_ptr& output ) const {
+      // serialize the sections concurrently when the output takes pre-serialized sections, nothing modifies the
+      // database until the parallel writer is finalized
+      snapshot_writer_ptr snapshot = output;
+      std::shared_ptr<parallel_snapshot_writer> parallel_writer;
+      if( output->supports_buffered_sections() && conf.thread_pool_size > 1 ) {
+         parallel_writer = std::make_shared<parallel_snapshot_writer>( output, thread_pool.get_executor(), 4 * conf.thread_pool_size );
+         snapshot = parallel_writer;
+      }
+
       snapshot->write_section<chain_snapshot_header>([this]( auto &section ){
          section.add_row(chain_snapshot_header(), db);
       });
@@ -873,6 +980,10 @@ struct controller_impl {
 
       authorization.add_to_snapshot(snapshot);
       resource_limits.add_to_snapshot(snapshot);
+
+      if( parallel_writer ) {
+         parallel_writer->finalize();
+      }
    }
 
    static fc::optional<genesis_state> extract_legacy_genesis_state( snapshot_reader& snapshot, uint32_t version ) {
@@ -1854,12 +1965,21 @@ struct controller_impl {
          const bool existing_trxs_metas = !bsp->trxs_metas().empty();
          const bool pub_keys_recovered = bsp->is_pub_keys_recovered();
          const bool skip_auth_checks = self.skip_auth_check();
+         // pre-validated with the checks of a fully validated block, see create_block_state_future()
+         auto prevalidated_trx_metas = bsp->extract_trxs_metas_futures();
          std::vector<std::tuple<transaction_metadata_ptr, recover_keys_future>> trx_metas;
          bool use_bsp_cached = false;
          if( pub_keys_recovered || (skip_auth_checks && existing_trxs_metas) ) {
             use_bsp_cached = true;
+         } else if( s == controller::block_status::complete && !skip_auth_checks && !prevalidated_trx_metas.empty() ) {
+            trx_metas.reserve( prevalidated_trx_metas.size() );
+            for( auto& f : prevalidated_trx_metas ) {
+               trx_metas.emplace_back( transaction_metadata_ptr{}, std::move( f ) );
+            }
          } else {
             trx_metas.reserve( b->transactions.size() );
+            vector<packed_transaction_ptr> trxs_to_recover;
+            vector<size_t> trxs_to_recover_idx;
             for( const auto& receipt : b->transactions ) {
                if( receipt.trx.contains<packed_transaction>()) {
                   const auto& pt = receipt.trx.get<packed_transaction>();
@@ -1871,13 +1991,18 @@ struct controller_impl {
                            transaction_metadata::create_no_recover_keys( pt, transaction_metadata::trx_type::input ),
                            recover_keys_future{} );
                   } else {
-                     auto ptrx = std::make_shared<packed_transaction>( pt );
-                     auto fut = transaction_metadata::start_recover_keys(
-                           std::move( ptrx ), thread_pool.get_executor(), chain_id, microseconds::maximum() );
-                     trx_metas.emplace_back( transaction_metadata_ptr{}, std::move( fut ) );
+                     trxs_to_recover_idx.push_back( trx_metas.size() );
+                     trxs_to_recover.emplace_back( std::make_shared<packed_transaction>( pt ) );
+                     trx_metas.emplace_back( transaction_metadata_ptr{}, recover_keys_future{} );
                   }
                }
             }
+            if( !trxs_to_recover.empty() ) {
+               auto futs = transaction_metadata::start_recover_keys(
+                     std::move( trxs_to_recover ), thread_pool.get_executor(), conf.thread_pool_size, chain_id, microseconds::maximum() );
+               for( size_t i = 0; i < futs.size(); ++i )
+                  std::get<1>( trx_metas[trxs_to_recover_idx[i]] ) = std::move( futs[i] );
+            }
          }
 
          transaction_trace_ptr trace;
@@ -1963,14 +2088,17 @@ struct controller_impl {
       EOS_ASSERT( prev, unlinkable_block_exception,
                   "unlinkable block ${id}", ("id", id)("previous", b->previous) );
 
-      return async_thread_pool( thread_pool.get_executor(), [b, prev, control=this]() {
+      // same condition as light_validation_allowed() for a complete block, no keys are needed then
+      const bool light_validation = conf.block_validation_mode == validation_mode::LIGHT || conf.trusted_producers.count( b->producer );
+
+      return async_thread_pool( thread_pool.get_executor(), [b, prev, control=this, light_validation]() {
          const bool skip_validate_signee = false;
 
          auto trx_mroot = calculate_trx_merkle( b->transactions );
          EOS_ASSERT( b->transaction_mroot == trx_mroot, block_validate_exception,
                      "invalid block transaction merkle root ${b} != ${c}", ("b", b->transaction_mroot)("c", trx_mroot) );
 
-         return std::make_shared<block_state>(
+         auto bsp = std::make_shared<block_state>(
                         *prev,
                         move( b ),
                         control->protocol_features.get_protocol_feature_set(),
@@ -1980,9 +2108,49 @@ struct controller_impl {
                         { control->check_protocol_features( timestamp, cur_features, new_features ); },
                         skip_validate_signee
          );
+         if( !light_validation )
+            bsp->set_trxs_metas_futures( control->start_prevalidate_transactions( *b ) );
+         return bsp;
       } );
    }
 
+   /// Queues the key recovery of every packed transaction of `b` on the thread pool, in block order. The checks
+   /// that need no chain state are done first, a transaction failing them gets a future holding the exception
+   /// that applying the block would throw.
+   vector<recover_keys_future> start_prevalidate_transactions( const signed_block& b ) {
+      vector<recover_keys_future> trx_metas;
+      vector<packed_transaction_ptr> trxs_to_recover;
+      vector<size_t> trxs_to_recover_idx;
+      trx_metas.reserve( b.transactions.size() );
+      for( const auto& receipt : b.transactions ) {
+         if( !receipt.trx.contains<packed_transaction>() ) continue;
+         const auto& pt = receipt.trx.get<packed_transaction>();
+         try {
+            // as init_for_input_trx() and validate_expiration()
+            pt.get_unprunable_size();
+            pt.get_prunable_size();
+            const transaction& trx = pt.get_transaction();
+            EOS_ASSERT( time_point(trx.expiration) >= b.timestamp.to_time_point(),
+                        expired_tx_exception,
+                        "transaction has expired, "
+                        "expiration is ${trx.expiration} and pending block time is ${pending_block_time}",
+                        ("trx.expiration",trx.expiration)("pending_block_time",b.timestamp.to_time_point()) );
+            trxs_to_recover_idx.push_back( trx_metas.size() );
+            trxs_to_recover.emplace_back( std::make_shared<packed_transaction>( pt ) );
+            trx_metas.emplace_back();
+         } catch( ... ) {
+            std::promise<transaction_metadata_ptr> failed;
+            failed.set_exception( std::current_exception() );
+            trx_metas.emplace_back( failed.get_future() );
+         }
+      }
+      auto recovered = transaction_metadata::start_recover_keys(
+            std::move( trxs_to_recover ), thread_pool.get_executor(), conf.thread_pool_size, chain_id, microseconds::maximum() );
+      for( size_t i = 0; i < recovered.size(); ++i )
+         trx_metas[trxs_to_recover_idx[i]] = std::move( recovered[i] );
+      return trx_metas;
+   }
+
    void push_block( std::future<block_state_ptr>& block_state_future,
                     const forked_branch_callback& forked_branch_cb, const trx_meta_cache_lookup& trx_lookup )
    {
@@ -2015,7 +2183,23 @@ struct controller_impl {
       } FC_LOG_AND_RETHROW( )
    }
 
-   void replay_push_block( const signed_block_ptr& b, controller::block_status s ) {
+   block_state_ptr create_replay_block_state( const block_header_state& prev, const signed_block_ptr& b ) {
+      const bool skip_validate_signee = !conf.force_all_checks;
+
+      return std::make_shared<block_state>(
+                     prev,
+                     b,
+                     protocol_features.get_protocol_feature_set(),
+                     [this]( block_timestamp_type timestamp,
+                             const flat_set<digest_type>& cur_features,
+                             const vector<digest_type>& new_features )
+                     { check_protocol_features( timestamp, cur_features, new_features ); },
+                     skip_validate_signee
+      );
+   }
+
+   /// `bsp` is the block state of `b` prepared by the replay pipeline, it is built on top of head when not provided
+   void replay_push_block( const signed_block_ptr& b, controller::block_status s, block_state_ptr bsp = block_state_ptr() ) {
       self.validate_db_available_size();
       self.validate_reversible_available_size();
 
@@ -2026,18 +2210,13 @@ struct controller_impl {
          EOS_ASSERT( (s == controller::block_status::irreversible || s == controller::block_status::validated),
                      block_validate_exception, "invalid block status for replay" );
          emit( self.pre_accepted_block, b );
-         const bool skip_validate_signee = !conf.force_all_checks;
 
-         auto bsp = std::make_shared<block_state>(
-                        *head,
-                        b,
-                        protocol_features.get_protocol_feature_set(),
-                        [this]( block_timestamp_type timestamp,
-                                const flat_set<digest_type>& cur_features,
-                                const vector<digest_type>& new_features )
-                        { check_protocol_features( timestamp, cur_features, new_features ); },
-                        skip_validate_signee
-         );
+         if( bsp ) {
+            EOS_ASSERT( bsp->header.previous == head->id, block_validate_exception,
+                        "replayed block ${id} does not link to head ${head}", ("id", bsp->id)("head", head->id) );
+         } else {
+            bsp = create_replay_block_state( *head, b );
+         }
 
          if( s != controller::block_status::irreversible ) {
             fork_db.add( bsp, true );
@@ -3070,6 +3249,16 @@ wasm_interface& controller::get_wasm_interface() {
    return my->wasmif;
 }
 
+const wasm_interface& controller::get_wasm_interface()const {
+   return my->wasmif;
+}
+
+abi_serializer_cache::entry_ptr controller::get_cached_abi( account_name n, const fc::microseconds& max_serialization_time )const {
+   const auto* a = my->db.find<account_object, by_name>( n );
+   if( !a ) return {};
+   return my->abi_cache.get( n, a->abi.data(), a->abi.size(), max_serialization_time );
+}
+
 const account_object& controller::get_account( account_name name )const
 { try {
    return my->db.get<account_object, by_name>(name);
@@ -3194,6 +3383,17 @@ uint32_t controller::get_greylist_limit()const {
    return my->conf.greylist_limit;
 }
 
+void controller::set_action_profiling( bool enabled ) {
+   if( !enabled )
+      my->profiler.reset();
+   else if( !my->profiler )
+      my->profiler = std::make_unique<action_profiler>();
+}
+
+action_profiler* controller::get_action_profiler()const {
+   return my->profiler.get();
+}
+
 void controller::add_resource_greylist(const account_name &name) {
    my->conf.resource_greylist.insert(name);
 }
@@ -190,6 +190,10 @@ void apply_rem_setcode(apply_context& context) {
       a.last_code_update = context.control.pending_block_time();
    });
 
+   if( code_size > 0 ) {
+      context.control.get_wasm_interface().code_updated(act.account, code_hash, act.vmtype, act.vmversion);
+   }
+
    if (new_size != old_size) {
       context.add_ram_usage( act.account, new_size - old_size );
    }
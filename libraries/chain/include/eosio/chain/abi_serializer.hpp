@@ -55,6 +55,19 @@ struct abi_serializer {
    fc::variant binary_to_variant( const std::string_view& type, const bytes& binary, const fc::microseconds& max_serialization_time, bool short_path = false )const;
    fc::variant binary_to_variant( const std::string_view& type, fc::datastream<const char*>& binary, const fc::microseconds& max_serialization_time, bool short_path = false )const;
 
+   /// byte range [begin, end) of a top level field within the packed representation of a struct
+   struct field_range {
+      field_name name;
+      size_t     begin = 0;
+      size_t     end   = 0;
+   };
+
+   /**
+    * Locates the top level fields of struct `type` within `binary` by skipping over the packed data
+    * rather than converting it to variants. Binary extensions absent from `binary` are not reported.
+    */
+   vector<field_range> get_field_ranges( const std::string_view& type, const char* binary, size_t size, const fc::microseconds& max_serialization_time )const;
+
    bytes       variant_to_binary( const std::string_view& type, const fc::variant& var, const fc::microseconds& max_serialization_time, bool short_path = false )const;
    void        variant_to_binary( const std::string_view& type, const fc::variant& var, fc::datastream<char*>& ds, const fc::microseconds& max_serialization_time, bool short_path = false )const;
 
@@ -105,6 +118,10 @@ private:
    void        _binary_to_variant( const std::string_view& type, fc::datastream<const char*>& stream,
                                    fc::mutable_variant_object& obj, impl::binary_to_variant_context& ctx )const;
 
+   void        _skip_binary( const std::string_view& type, fc::datastream<const char*>& stream, impl::binary_to_variant_context& ctx )const;
+   void        _skip_struct_binary( const std::string_view& type, fc::datastream<const char*>& stream, const char* start,
+                                    vector<field_range>* ranges, impl::binary_to_variant_context& ctx )const;
+
    bytes       _variant_to_binary( const std::string_view& type, const fc::variant& var, impl::variant_to_binary_context& ctx )const;
    void        _variant_to_binary( const std::string_view& type, const fc::variant& var,
                                    fc::datastream<char*>& ds, impl::variant_to_binary_context& ctx )const;
@@ -392,7 +409,7 @@ namespace impl {
 
          try {
             auto abi = resolver(act.account);
-            if (abi.valid()) {
+            if (abi) {
                auto type = abi->get_action_type(act.name);
                if (!type.empty()) {
                   try {
@@ -642,7 +659,7 @@ namespace impl {
                valid_empty_data = act.data.empty();
             } else if ( data.is_object() ) {
                auto abi = resolver(act.account);
-               if (abi.valid()) {
+               if (abi) {
                   auto type = abi->get_action_type(act.name);
                   if (!type.empty()) {
                      variant_to_binary_context _ctx(*abi, ctx, type);
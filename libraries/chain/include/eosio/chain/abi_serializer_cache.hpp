@@ -0,0 +1,53 @@
+#pragma once
+#include <eosio/chain/abi_serializer.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace eosio { namespace chain {
+
+   /**
+    * Thread safe cache of parsed ABIs and their constructed abi_serializer, keyed by account.
+    *
+    * An entry is only handed out when the packed ABI it was built from is byte for byte identical to the packed ABI
+    * passed in, so a setabi (or the undo of one, which also rolls back abi_sequence) never yields a stale serializer.
+    * Comparing the packed bytes is orders of magnitude cheaper than unpacking and validating the ABI again.
+    */
+   class abi_serializer_cache {
+   public:
+      struct entry {
+         abi_def        abi;        ///< empty if the account has no abi
+         abi_serializer serializer; ///< default constructed if the account has no abi
+      };
+      using entry_ptr = std::shared_ptr<const entry>;
+      /// keeps its entry alive, so resolvers hand out the cached serializer without copying it
+      using serializer_ptr = std::shared_ptr<const abi_serializer>;
+
+      /// @return the serializer of abi, nullptr if abi is nullptr
+      static serializer_ptr get_serializer( const entry_ptr& abi ) {
+         return abi ? serializer_ptr( abi, &abi->serializer ) : serializer_ptr();
+      }
+
+      explicit abi_serializer_cache( size_t max_entries = 1024 );
+
+      /// @return the cached entry for account if built from raw_abi, otherwise a newly constructed and cached entry
+      entry_ptr get( account_name account, const char* raw_abi, size_t raw_abi_size, const fc::microseconds& max_serialization_time );
+
+      void clear();
+      size_t size()const;
+
+   private:
+      struct cached_abi {
+         bytes     raw_abi;
+         entry_ptr abi;
+         uint64_t  last_used = 0;
+      };
+
+      mutable std::mutex                  _mtx;
+      std::map<account_name, cached_abi>  _cache;
+      uint64_t                            _use_counter = 0;
+      const size_t                        _max_entries;
+   };
+
+} } // eosio::chain
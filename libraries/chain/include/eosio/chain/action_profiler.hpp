@@ -0,0 +1,63 @@
+#pragma once
+#include <eosio/chain/types.hpp>
+
+#include <boost/container/flat_map.hpp>
+
+#include <chrono>
+#include <map>
+#include <ostream>
+
+namespace eosio { namespace chain {
+
+   /**
+    * Aggregates the wall time spent executing actions, per receiver and action, and the time spent in the
+    * database and crypto host functions they call. Only used from the main thread.
+    *
+    * At most max_actions distinct actions are tracked, the executions of further actions are aggregated in a single
+    * entry with empty receiver, account and action names.
+    */
+   class action_profiler {
+      public:
+         static constexpr size_t default_max_actions = 10000;
+
+         explicit action_profiler( size_t max_actions = default_max_actions )
+         : _max_actions( max_actions ) {}
+
+         struct host_function_stats {
+            uint64_t calls = 0;
+            uint64_t time_ns = 0;
+         };
+
+         struct action_stats {
+            account_name                                receiver;
+            account_name                                account;
+            action_name                                 action;
+            uint64_t                                    executions = 0;
+            uint64_t                                    time_ns = 0;    ///< including host functions
+            std::map<std::string, host_function_stats>  host_functions;
+         };
+
+         /// keyed by the __func__ of the host function, so lookups compare pointers
+         using host_function_times = boost::container::flat_map<const char*, host_function_stats>;
+
+         void record( account_name receiver, account_name account, action_name action,
+                      std::chrono::nanoseconds elapsed, const host_function_times& host_functions );
+
+         /// actions sorted by decreasing total time, at most `limit`
+         vector<action_stats> get_actions( uint32_t limit = std::numeric_limits<uint32_t>::max() )const;
+
+         /// one `receiver;account::action;function time_ns` line per stack, the input of flamegraph.pl;
+         /// the time spent outside of the profiled host functions is attributed to a `self` frame
+         void write_folded_stacks( std::ostream& out )const;
+
+         void clear() { _actions.clear(); }
+
+      private:
+         size_t                                                                       _max_actions;
+         std::map<std::tuple<account_name, account_name, action_name>, action_stats> _actions;
+   };
+
+} } // namespace eosio::chain
+
+FC_REFLECT( eosio::chain::action_profiler::host_function_stats, (calls)(time_ns) )
+FC_REFLECT( eosio::chain::action_profiler::action_stats, (receiver)(account)(action)(executions)(time_ns)(host_functions) )
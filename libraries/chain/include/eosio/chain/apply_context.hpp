@@ -1,5 +1,6 @@
 #pragma once
 #include <eosio/chain/controller.hpp>
+#include <eosio/chain/action_profiler.hpp>
 #include <eosio/chain/transaction.hpp>
 #include <eosio/chain/contract_table_objects.hpp>
 #include <fc/utility.hpp>
@@ -450,6 +451,32 @@ class apply_context {
    public:
       apply_context(controller& con, transaction_context& trx_ctx, uint32_t action_ordinal, uint32_t depth=0);
 
+   /// Profiling methods:
+   public:
+
+      /// times a host function call when action profiling is enabled
+      class host_function_timer {
+         public:
+            host_function_timer( apply_context& ctx, const char* function )
+            :context(ctx), function(function) {
+               if( context.profiler )
+                  start = std::chrono::steady_clock::now();
+            }
+
+            ~host_function_timer() {
+               if( context.profiler ) {
+                  auto& stats = context._host_function_times[function];
+                  ++stats.calls;
+                  stats.time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+               }
+            }
+
+         private:
+            apply_context&                         context;
+            const char*                            function;
+            std::chrono::steady_clock::time_point  start;
+      };
+
    /// Execution methods:
    public:
 
@@ -586,6 +613,10 @@ class apply_context {
       std::string                         _pending_console_output;
       flat_set<account_delta>             _account_ram_deltas; ///< flat_set of account_delta so json is an array of objects
 
+      action_profiler*                       profiler = nullptr; ///< set while the current action is profiled
+      std::chrono::steady_clock::time_point  _profile_start;
+      action_profiler::host_function_times   _host_function_times;
+
       //bytes                               _cached_trx;
 };
 
@@ -1,12 +1,87 @@
 #pragma once
 #include <fc/filesystem.hpp>
+#include <fc/io/cfile.hpp>
 #include <eosio/chain/block.hpp>
 #include <eosio/chain/genesis_state.hpp>
 
+#include <mutex>
+
 namespace eosio { namespace chain {
 
    namespace detail { class block_log_impl; }
 
+   /* Archive of irreversible blocks grouped into independently zlib compressed packs of blocks_per_pack blocks.
+    * It holds the blocks preceding blocks.log, so only recent blocks stay uncompressed.
+    *
+    * +---------+-----------------+-----------------+---------------------------+--------+--------+-----+
+    * | Version | First Block Num | Blocks per Pack | Genesis State or Chain Id | Pack 1 | Pack 2 | ... |
+    * +---------+-----------------+-----------------+---------------------------+--------+--------+-----+
+    *
+    * +------------+-----------------+----------------------------------------------------------------+
+    * | Num Blocks | Compressed Size | zlib( Offset of Block 1 | ... | Offset of Block N | Block 1 | ... ) |
+    * +------------+-----------------+----------------------------------------------------------------+
+    *
+    * A block is read by decompressing its pack only, the offsets locate it inside the decompressed pack. The
+    * most recently decompressed pack is kept, so reading blocks in order decompresses every pack once. The
+    * genesis state is stored when the archive starts at block 1, the chain id otherwise.
+    *
+    * The index file blocks.packs.index holds the position of every pack. It can be reconstructed by walking
+    * the packs.
+    *
+    * Reading and appending are thread safe, packs may be compressed on any thread.
+    */
+   class block_log_packs {
+      public:
+         /// a pack compressed by compress_pack, ready to be appended
+         struct compressed_pack {
+            uint32_t       first_block_num = 0;
+            uint32_t       num_blocks = 0;
+            vector<char>   data;
+         };
+
+         explicit block_log_packs(const fc::path& data_dir);
+         ~block_log_packs();
+
+         /// creates an empty archive starting at `first_block_num`, with the chain context of blocks.log in `data_dir`
+         static void create(const fc::path& data_dir, uint32_t first_block_num, uint32_t blocks_per_pack);
+         static bool exists(const fc::path& data_dir);
+         static void remove(const fc::path& data_dir);
+
+         static fc::optional<genesis_state> extract_genesis_state( const fc::path& data_dir );
+         static chain_id_type extract_chain_id( const fc::path& data_dir );
+
+         /// `blocks` must be consecutive
+         static compressed_pack compress_pack(const vector<signed_block_ptr>& blocks);
+
+         /// `pack` must hold the blocks_per_pack blocks following end_block_num() - 1
+         void append_pack(const compressed_pack& pack);
+         void append_pack(const vector<signed_block_ptr>& blocks) { append_pack(compress_pack(blocks)); }
+
+         /// nullptr if the block is not archived
+         signed_block_ptr read_block_by_num(uint32_t block_num)const;
+
+         uint32_t first_block_num()const { return _first_block_num; }
+         /// one past the last archived block
+         uint32_t end_block_num()const { return _first_block_num + _num_packs * _blocks_per_pack; }
+         uint32_t blocks_per_pack()const { return _blocks_per_pack; }
+
+         static const uint32_t version;
+
+      private:
+         void construct_index();
+         void load_pack(uint32_t pack)const;
+
+         mutable std::mutex       _mtx;       // guards the files and the cached pack
+         mutable fc::cfile        _pack_file;
+         mutable fc::cfile        _index_file;
+         uint32_t                 _first_block_num = 0;
+         uint32_t                 _blocks_per_pack = 0;
+         uint32_t                 _num_packs = 0;
+         uint64_t                 _first_pack_pos = 0;
+         mutable uint32_t         _cached_pack = std::numeric_limits<uint32_t>::max();
+         mutable vector<char>     _cached_payload;
+   };
+
    /* The block log is an external append only log of the blocks with a header. Blocks should only
     * be written to the log after they irreverisble as the log is append only. The log is a doubly
     * linked list of blocks. There is a secondary index file of only block positions that enables
@@ -30,11 +105,15 @@ namespace eosio { namespace chain {
     *
     * The main file is the only file that needs to persist. The index file can be reconstructed during a
     * linear scan of the main file.
+    *
+    * When packing is enabled the oldest blocks are compressed, and a trimmed copy of blocks.log is written, on a
+    * background thread. Files are swapped in under a lock by a later append, reads may run on other threads.
     */
 
    class block_log {
       public:
-         block_log(const fc::path& data_dir);
+         /// `pack_size` > 0 moves irreversible blocks into blocks.packs in packs of `pack_size` blocks
+         block_log(const fc::path& data_dir, uint32_t pack_size = 0);
          block_log(block_log&& other);
          ~block_log();
 
@@ -81,9 +160,21 @@ namespace eosio { namespace chain {
 
          static bool trim_blocklog_front(const fc::path& block_dir, const fc::path& temp_dir, uint32_t truncate_at_block);
 
+         /// moves all but the most recent blocks of blocks.log into packs of `blocks_per_pack` blocks in blocks.packs
+         static void pack_blocklog(const fc::path& block_dir, uint32_t blocks_per_pack);
+
+         /// moves the blocks of blocks.packs back into a plain blocks.log
+         static void unpack_blocklog(const fc::path& block_dir);
+
+         /// waits for the packing in progress, if any, and swaps in its files
+         void complete_packing();
+
    private:
          void open(const fc::path& data_dir);
          void construct_index();
+         /// starts archiving the oldest blocks of blocks.log once it holds two full packs beyond the archive,
+         /// swaps in the files of a completed packing
+         void pack_blocks(uint32_t blocks_per_pack);
 
          std::unique_ptr<detail::block_log_impl> my;
    };
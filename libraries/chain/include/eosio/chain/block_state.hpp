@@ -56,12 +56,25 @@ namespace eosio { namespace chain {
       }
       const vector<transaction_metadata_ptr>& trxs_metas()const { return _cached_trxs; }
 
+      /// key recovery of every packed transaction of the block, in block order, started when the block was received
+      vector<recover_keys_future> extract_trxs_metas_futures() {
+         if( !_trxs_metas_futures ) return {};
+         auto result = std::move( *_trxs_metas_futures );
+         _trxs_metas_futures.reset();
+         return result;
+      }
+      void set_trxs_metas_futures( vector<recover_keys_future>&& futures ) {
+         _trxs_metas_futures = std::make_shared<vector<recover_keys_future>>( std::move( futures ) );
+      }
+
       bool                                                validated = false;
 
       bool                                                _pub_keys_recovered = false;
       /// this data is redundant with the data stored in block, but facilitates
       /// recapturing transactions when we pop a block
       vector<transaction_metadata_ptr>                    _cached_trxs;
+      /// held by pointer so that block_state stays copyable
+      std::shared_ptr<vector<recover_keys_future>>        _trxs_metas_futures;
    };
 
    using block_state_ptr = std::shared_ptr<block_state>;
@@ -17,6 +17,7 @@ const static auto default_state_dir_name     = "state";
 const static auto forkdb_filename            = "fork_db.dat";
 const static auto default_state_size            = 1*1024*1024*1024ll;
 const static auto default_state_guard_size      =    128*1024*1024ll;
+const static auto default_wasm_instantiation_cache_size = 512*1024*1024ll;
 
 const static name system_account_name    { N(rem) };
 const static name swap_account_name      { N(rem.swap) };
@@ -81,6 +82,7 @@ const static uint32_t   default_max_inline_action_size         = 4 * 1024;   //
 const static uint16_t   default_max_inline_action_depth        = 4;
 const static uint16_t   default_max_auth_depth                 = 6;
 const static uint32_t   default_sig_cpu_bill_pct               = 50 * percent_1; // billable percentage of signature recovery
+const static uint32_t   sig_recovery_cache_size                = 50000; // recovered keys kept for signatures seen again, e.g. in blocks
 const static uint16_t   default_controller_thread_pool_size    = 2;
 const static uint32_t   default_max_variable_signature_length  = 16384u;
 
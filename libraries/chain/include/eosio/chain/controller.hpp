@@ -6,6 +6,7 @@
 #include <boost/signals2/signal.hpp>
 
 #include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/abi_serializer_cache.hpp>
 #include <eosio/chain/account_object.hpp>
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/protocol_feature_manager.hpp>
@@ -21,6 +22,7 @@ namespace boost { namespace asio {
 namespace eosio { namespace chain {
 
    class authorization_manager;
+   class action_profiler;
 
    namespace resource_limits {
       class resource_limits_manager;
@@ -66,6 +68,7 @@ namespace eosio { namespace chain {
             flat_set< pair<account_name, action_name> > action_blacklist;
             flat_set<public_key_type> key_blacklist;
             path                     blocks_dir             =  chain::config::default_blocks_dir_name;
+            uint32_t                 blocks_log_pack_size   =  0;
             path                     state_dir              =  chain::config::default_state_dir_name;
             uint64_t                 state_size             =  chain::config::default_state_size;
             uint64_t                 state_guard_size       =  chain::config::default_state_guard_size;
@@ -73,6 +76,7 @@ namespace eosio { namespace chain {
             uint64_t                 reversible_guard_size  =  chain::config::default_reversible_guard_size;
             uint32_t                 sig_cpu_bill_pct       =  chain::config::default_sig_cpu_bill_pct;
             uint16_t                 thread_pool_size       =  chain::config::default_controller_thread_pool_size;
+            uint32_t                 replay_look_ahead_blocks = 256;
             bool                     read_only              =  false;
             bool                     force_all_checks       =  false;
             bool                     disable_replay_opts    =  false;
@@ -82,6 +86,7 @@ namespace eosio { namespace chain {
             bool                     disable_all_subjective_mitigations = false; //< for testing purposes only
 
             wasm_interface::vm_type  wasm_runtime = chain::config::default_wasm_runtime;
+            uint64_t                 wasm_instantiation_cache_size = chain::config::default_wasm_instantiation_cache_size; ///< 0 for unbounded
             eosvmoc::config          eosvmoc_config;
             bool                     eosvmoc_tierup         = false;
 
@@ -286,6 +291,11 @@ namespace eosio { namespace chain {
          void set_greylist_limit( uint32_t limit );
          uint32_t get_greylist_limit()const;
 
+         /// starts or stops aggregating the time spent in each action, stopping discards the profile
+         void set_action_profiling( bool enabled );
+         /// nullptr unless action profiling is enabled
+         action_profiler* get_action_profiler()const;
+
          void add_to_ram_correction( account_name account, uint64_t ram_bytes );
          bool all_subjective_mitigations_disabled()const;
 
@@ -315,18 +325,25 @@ namespace eosio { namespace chain {
 
          const apply_handler* find_apply_handler( account_name contract, scope_name scope, action_name act )const;
          wasm_interface& get_wasm_interface();
+         const wasm_interface& get_wasm_interface()const;
+
 
+         /**
+          * @return parsed abi and abi_serializer of account n from the shared abi cache, nullptr if n does not exist
+          * Thread safe as long as chainbase is not modified concurrently.
+          */
+         abi_serializer_cache::entry_ptr get_cached_abi( account_name n, const fc::microseconds& max_serialization_time )const;
 
-         optional<abi_serializer> get_abi_serializer( account_name n, const fc::microseconds& max_serialization_time )const {
+         /// @return the cached abi_serializer of account n, nullptr if n does not exist or has no abi
+         abi_serializer_cache::serializer_ptr get_abi_serializer( account_name n, const fc::microseconds& max_serialization_time )const {
             if( n.good() ) {
                try {
                   const auto& a = get_account( n );
-                  abi_def abi;
-                  if( abi_serializer::to_abi( a.abi, abi ))
-                     return abi_serializer( abi, max_serialization_time );
+                  if( !abi_serializer::is_empty_abi( a.abi ) )
+                     return abi_serializer_cache::get_serializer( get_cached_abi( n, max_serialization_time ) );
                } FC_CAPTURE_AND_LOG((n))
             }
-            return optional<abi_serializer>();
+            return abi_serializer_cache::serializer_ptr();
          }
 
          template<typename T>
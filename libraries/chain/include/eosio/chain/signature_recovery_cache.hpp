@@ -0,0 +1,58 @@
+#pragma once
+#include <eosio/chain/types.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+
+#include <mutex>
+
+namespace eosio { namespace chain {
+
+   /**
+    * Keys recovered by any thread, so that a transaction seen again (relayed, then in a block) is not recovered twice.
+    * Beyond capacity the least recently used entries are evicted. Thread safe.
+    */
+   class signature_recovery_cache {
+      public:
+         struct entry {
+            digest_type       key;        ///< hash of the signed digest and the signature
+            public_key_type   pub_key;
+            fc::microseconds  cpu_usage;  ///< time taken by the recovery, reported again on every hit
+         };
+
+         explicit signature_recovery_cache( size_t capacity )
+         : _capacity( capacity ) {}
+
+         /// the cache of transaction::get_signature_keys, config::sig_recovery_cache_size entries
+         static signature_recovery_cache& instance();
+
+         static digest_type key( const digest_type& digest, const signature_type& sig );
+
+         fc::optional<entry> find( const digest_type& key );
+         void insert( entry e );
+
+         size_t size()const;
+         uint64_t hits()const;
+         uint64_t misses()const;
+
+      private:
+         struct by_key;
+         using cache_type = boost::multi_index_container<
+            entry,
+            boost::multi_index::indexed_by<
+               boost::multi_index::sequenced<>,
+               boost::multi_index::hashed_unique<boost::multi_index::tag<by_key>,
+                  boost::multi_index::member<entry, digest_type, &entry::key>, std::hash<digest_type>>
+            >
+         >;
+
+         const size_t        _capacity;
+         mutable std::mutex  _mtx;
+         cache_type          _cache;
+         uint64_t            _hits = 0;
+         uint64_t            _misses = 0;
+   };
+
+} } // namespace eosio::chain
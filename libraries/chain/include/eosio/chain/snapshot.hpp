@@ -2,16 +2,22 @@
 
 #include <eosio/chain/database_utils.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/variant_object.hpp>
 #include <boost/core/demangle.hpp>
+#include <deque>
+#include <functional>
+#include <map>
 #include <ostream>
 
 namespace eosio { namespace chain {
    /**
     * History:
     * Version 1: initial version with string identified sections and rows
+    * Version 2: binary snapshots end with a table of section offsets
     */
-   static const uint32_t current_snapshot_version = 1;
+   static const uint32_t current_snapshot_version = 2;
+   static const uint32_t minimum_snapshot_version = 1;
 
    namespace detail {
       template<typename T>
@@ -67,10 +73,30 @@ namespace eosio { namespace chain {
          std::ostream& inner;
       };
 
+      /**
+       * The rows of a section serialized into memory, apart from any snapshot, so that sections can be serialized
+       * concurrently and written out later
+       */
+      struct section_buffer {
+         auto& write( const char* d, size_t s ) {
+            data.insert(data.end(), d, d + s);
+            return *this;
+         }
+
+         auto& put(char c) {
+            data.push_back(c);
+            return *this;
+         }
+
+         std::vector<char> data;
+         uint64_t          row_count = 0;
+      };
+
 
       struct abstract_snapshot_row_writer {
          virtual void write(ostream_wrapper& out) const = 0;
          virtual void write(fc::sha256::encoder& out) const = 0;
+         virtual void write(section_buffer& out) const = 0;
          virtual variant to_variant() const = 0;
          virtual std::string row_type_name() const = 0;
       };
@@ -93,6 +119,10 @@ namespace eosio { namespace chain {
             write_stream(out);
          }
 
+         void write(section_buffer& out) const override {
+            write_stream(out);
+         }
+
          fc::variant to_variant() const override {
             variant var;
             fc::to_variant(data, var);
@@ -131,12 +161,11 @@ namespace eosio { namespace chain {
                snapshot_writer& _writer;
          };
 
+         using section_function = std::function<void(section_writer&)>;
+
          template<typename F>
          void write_section(const std::string section_name, F f) {
-            write_start_section(section_name);
-            auto section = section_writer(*this);
-            f(section);
-            write_end_section();
+            write_section_parts(section_name, { section_function(std::move(f)) });
          }
 
          template<typename T, typename F>
@@ -144,16 +173,74 @@ namespace eosio { namespace chain {
             write_section(detail::snapshot_section_traits<T>::section_name(), f);
          }
 
+         /**
+          * Writes a single section holding the rows added by each of `parts`, in order.  Writers may run the parts
+          * concurrently, so they must not depend on each other.
+          */
+         virtual void write_section_parts( const std::string& section_name, std::vector<section_function> parts ) {
+            write_start_section(section_name);
+            auto section = section_writer(*this);
+            for( auto& part : parts ) {
+               part(section);
+            }
+            write_end_section();
+         }
+
+         /// true if the rows of a section can be handed over pre-serialized by write_buffered_section
+         virtual bool supports_buffered_sections() const { return false; }
+
       virtual ~snapshot_writer(){};
 
       protected:
+         friend class parallel_snapshot_writer;
+
          virtual void write_start_section( const std::string& section_name ) = 0;
          virtual void write_row( const detail::abstract_snapshot_row_writer& row_writer ) = 0;
          virtual void write_end_section() = 0;
+
+         /// writes a section whose rows are the concatenated rows of `parts`
+         virtual void write_buffered_section( const std::string& section_name, const std::vector<detail::section_buffer>& parts ) {
+            EOS_THROW(snapshot_exception, "Snapshot writer does not support buffered sections");
+         }
    };
 
    using snapshot_writer_ptr = std::shared_ptr<snapshot_writer>;
 
+   /**
+    * Serializes every section part into its own buffer on a thread pool and hands the buffers to the wrapped writer
+    * in the order the sections were written.  The database read by the parts must not be modified until finalize()
+    * returns.  At most `max_pending_parts` parts are buffered at a time.
+    */
+   class parallel_snapshot_writer : public snapshot_writer {
+      public:
+         parallel_snapshot_writer(snapshot_writer_ptr inner, boost::asio::io_context& thread_pool, size_t max_pending_parts);
+         ~parallel_snapshot_writer();
+
+         void write_section_parts( const std::string& section_name, std::vector<section_function> parts ) override;
+
+         /// waits for the pending sections and writes them, the wrapped writer is not finalized
+         void finalize();
+
+      protected:
+         void write_start_section( const std::string& section_name ) override;
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override;
+         void write_end_section( ) override;
+
+      private:
+         struct pending_section {
+            std::string                                     name;
+            std::vector<std::future<detail::section_buffer>> parts;
+         };
+
+         void write_front();
+
+         snapshot_writer_ptr         inner;
+         boost::asio::io_context&    thread_pool;
+         size_t                      max_pending_parts;
+         size_t                      pending_parts = 0;
+         std::deque<pending_section> pending;
+   };
+
    namespace detail {
       struct abstract_snapshot_row_reader {
          virtual void provide(std::istream& in) const = 0;
@@ -335,14 +422,22 @@ namespace eosio { namespace chain {
          void write_end_section( ) override;
          void finalize();
 
+         bool supports_buffered_sections() const override { return true; }
+
          static const uint32_t magic_number = 0x30510550;
 
+      protected:
+         void write_buffered_section( const std::string& section_name, const std::vector<detail::section_buffer>& parts ) override;
+
       private:
+         void write_section_header( const std::string& section_name, uint64_t section_size, uint64_t row_count );
+
          detail::ostream_wrapper snapshot;
          std::streampos          header_pos;
          std::streampos          section_pos;
          uint64_t                row_count;
-
+         /// section names and their offsets from the header, written at the end of the snapshot
+         std::vector<std::pair<std::string, uint64_t>> section_offsets;
    };
 
    class istream_snapshot_reader : public snapshot_reader {
@@ -359,11 +454,17 @@ namespace eosio { namespace chain {
 
       private:
          bool validate_section() const;
+         uint32_t read_version() const;
+         /// offset of the first section from the header
+         std::streamoff first_section_offset() const;
+         /// the offsets of the sections from the header, from the section table or by walking the sections once
+         const std::map<std::string, std::streamoff>& get_section_offsets();
 
          std::istream&  snapshot;
          std::streampos header_pos;
          uint64_t       num_rows;
          uint64_t       cur_row;
+         fc::optional<std::map<std::string, std::streamoff>> section_offsets;
    };
 
    class integrity_hash_snapshot_writer : public snapshot_writer {
@@ -375,6 +476,11 @@ namespace eosio { namespace chain {
          void write_end_section( ) override;
          void finalize();
 
+         bool supports_buffered_sections() const override { return true; }
+
+      protected:
+         void write_buffered_section( const std::string& section_name, const std::vector<detail::section_buffer>& parts ) override;
+
       private:
          fc::sha256::encoder&  enc;
 
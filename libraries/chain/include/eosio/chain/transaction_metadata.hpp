@@ -45,6 +45,9 @@ class transaction_metadata {
                   "signature variable length component size (${s}) greater than subjective maximum (${m})", ("s", sig.variable_size())("m", max));
       }
 
+      static transaction_metadata_ptr recover_keys( packed_transaction_ptr trx, const chain_id_type& chain_id,
+                                                    fc::microseconds time_limit, uint32_t max_variable_sig_size );
+
    public:
       // creation of tranaction_metadata restricted to start_recover_keys and create_no_recover_keys below, public for make_shared
       explicit transaction_metadata( const private_type& pt, packed_transaction_ptr ptrx,
@@ -76,6 +79,14 @@ class transaction_metadata {
                           const chain_id_type& chain_id, fc::microseconds time_limit,
                           uint32_t max_variable_sig_size = UINT32_MAX );
 
+      /// Thread safe. Recovers the keys of all `trxs`, e.g. of a block, spread over the `num_threads` threads of
+      /// `thread_pool` in a few chunks per thread so that the whole batch is queued at once.
+      /// @returns one future per transaction, in the order of `trxs`
+      static std::vector<recover_keys_future>
+      start_recover_keys( std::vector<packed_transaction_ptr> trxs, boost::asio::io_context& thread_pool, size_t num_threads,
+                          const chain_id_type& chain_id, fc::microseconds time_limit,
+                          uint32_t max_variable_sig_size = UINT32_MAX );
+
       /// @returns constructed transaction_metadata with no key recovery (sig_cpu_usage=0, recovered_pub_keys=empty)
       static transaction_metadata_ptr
       create_no_recover_keys( const packed_transaction& trx, trx_type t ) {
@@ -82,7 +82,19 @@ namespace eosio { namespace chain {
             eos_vm_oc
          };
 
-         wasm_interface(vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config);
+         struct instantiation_cache_stats {
+            uint64_t         hits = 0;
+            uint64_t         misses = 0;             ///< instantiations, including re-instantiations of released modules
+            uint64_t         evictions = 0;          ///< modules released to stay within max_module_bytes
+            fc::microseconds instantiation_time;     ///< total time spent instantiating modules
+            uint64_t         modules = 0;            ///< instantiated modules in the cache
+            uint64_t         module_bytes = 0;       ///< approximate size of the instantiated modules, wasm and initial memory
+            uint64_t         max_module_bytes = 0;   ///< 0 for unbounded
+         };
+
+         //instantiated modules are released, least executed first, once they exceed `instantiation_cache_size` bytes (0 for unbounded)
+         wasm_interface(vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config,
+                        uint64_t instantiation_cache_size = 0);
          ~wasm_interface();
 
          //call before dtor to skip what can be minutes of dtor overhead with some runtimes; can cause leaks
@@ -97,6 +109,14 @@ namespace eosio { namespace chain {
          //indicate the current LIB. evicts old cache entries
          void current_lib(const uint32_t lib);
 
+         //indicate that `account` set new code. EOS VM OC compiles it right away if `account` is a configured precompile account
+         void code_updated(const account_name& account, const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version);
+
+         //EOS VM OC compiles the current code of every configured precompile account, ahead of its first execution
+         void precompile_accounts();
+
+         instantiation_cache_stats get_instantiation_cache_stats()const;
+
          //Calls apply or error on a given code
          void apply(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, apply_context& context);
 
@@ -115,3 +135,5 @@ namespace eosio{ namespace chain {
 }}
 
 FC_REFLECT_ENUM( eosio::chain::wasm_interface::vm_type, (wabt)(eos_vm)(eos_vm_jit)(eos_vm_oc) )
+FC_REFLECT( eosio::chain::wasm_interface::instantiation_cache_stats,
+            (hits)(misses)(evictions)(instantiation_time)(modules)(module_bytes)(max_module_bytes) )
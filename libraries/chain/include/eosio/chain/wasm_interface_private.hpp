@@ -16,6 +16,8 @@
 #include <eosio/chain/exceptions.hpp>
 #include <fc/scoped_exit.hpp>
 
+#include <algorithm>
+
 #include "IR/Module.h"
 #include "Runtime/Intrinsics.h"
 #include "Platform/Platform.h"
@@ -45,6 +47,8 @@ namespace eosio { namespace chain {
          std::unique_ptr<wasm_instantiated_module_interface>  module;
          uint8_t                                              vm_type = 0;
          uint8_t                                              vm_version = 0;
+         uint64_t                                             module_bytes = 0;
+         mutable uint64_t                                     executions = 0; ///< halved periodically, not a key
       };
       struct by_hash;
       struct by_first_block_num;
@@ -52,14 +56,19 @@ namespace eosio { namespace chain {
 
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
       struct eosvmoc_tier {
-         eosvmoc_tier(const boost::filesystem::path& d, const eosvmoc::config& c, const chainbase::database& db) : cc(d, c, db), exec(cc) {}
+         eosvmoc_tier(const boost::filesystem::path& d, const eosvmoc::config& c, const chainbase::database& db) : cc(d, c, db), exec(cc),
+            precompile_accounts(c.precompile_accounts.begin(), c.precompile_accounts.end()) {}
          eosvmoc::code_cache_async cc;
          eosvmoc::executor exec;
          eosvmoc::memory mem;
+         flat_set<account_name> precompile_accounts;
       };
 #endif
 
-      wasm_interface_impl(wasm_interface::vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config) : db(d), wasm_runtime_time(vm) {
+      wasm_interface_impl(wasm_interface::vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config,
+                          uint64_t instantiation_cache_size) : db(d), wasm_runtime_time(vm) {
+         cache_stats.max_module_bytes = instantiation_cache_size;
+
          if(vm == wasm_interface::vm_type::wabt)
             runtime_interface = std::make_unique<webassembly::wabt_runtime::wabt_runtime>();
 #ifdef EOSIO_EOS_VM_RUNTIME_ENABLED
@@ -127,9 +136,51 @@ namespace eosio { namespace chain {
          if(eosvmoc) for(auto it = first_it; it != last_it; it++)
             eosvmoc->cc.free_code(it->code_hash, it->vm_version);
 #endif
+         for(auto it = first_it; it != last_it; it++) {
+            if(it->module) {
+               --cache_stats.modules;
+               cache_stats.module_bytes -= it->module_bytes;
+            }
+         }
          wasm_instantiation_cache.get<by_last_block_num>().erase(first_it, last_it);
       }
 
+      void count_execution(const wasm_cache_entry& e) {
+         ++e.executions;
+         //halve all counts now and then, so that they reflect recent executions
+         if(++executions_since_decay < execution_count_decay_interval)
+            return;
+         executions_since_decay = 0;
+         for(const wasm_cache_entry& c : wasm_instantiation_cache)
+            c.executions /= 2;
+      }
+
+      //releases the least executed modules, other than `in_use`, until the instantiated modules fit max_module_bytes
+      void trim_instantiation_cache(wasm_cache_index::iterator in_use) {
+         if(!cache_stats.max_module_bytes || cache_stats.module_bytes <= cache_stats.max_module_bytes)
+            return;
+
+         std::vector<wasm_cache_index::iterator> candidates;
+         for(auto it = wasm_instantiation_cache.begin(); it != wasm_instantiation_cache.end(); ++it) {
+            if(it != in_use && it->module)
+               candidates.push_back(it);
+         }
+         std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+            return a->executions < b->executions;
+         });
+         for(auto it : candidates) {
+            if(cache_stats.module_bytes <= cache_stats.max_module_bytes)
+               break;
+            --cache_stats.modules;
+            cache_stats.module_bytes -= it->module_bytes;
+            ++cache_stats.evictions;
+            wasm_instantiation_cache.modify(it, [](wasm_cache_entry& e) {
+               e.module.reset();
+               e.module_bytes = 0;
+            });
+         }
+      }
+
       const std::unique_ptr<wasm_instantiated_module_interface>& get_instantiated_module( const digest_type& code_hash, const uint8_t& vm_type,
                                                                                  const uint8_t& vm_version, transaction_context& trx_context )
       {
@@ -148,8 +199,13 @@ namespace eosio { namespace chain {
                                                       .vm_version = vm_version
                                                    } ).first;
          }
+         count_execution(*it);
 
-         if(!it->module) {
+         if(it->module) {
+            ++cache_stats.hits;
+         } else {
+            ++cache_stats.misses;
+            const auto start = fc::time_point::now();
             if(!codeobject)
                codeobject = &db.get<code_object,by_code_hash>(boost::make_tuple(code_hash, vm_type, vm_version));
 
@@ -185,9 +241,16 @@ namespace eosio { namespace chain {
                }
             }
 
+            std::vector<uint8_t> initial_memory = parse_initial_memory(module);
+            const uint64_t module_bytes = bytes.size() + initial_memory.size();
             wasm_instantiation_cache.modify(it, [&](auto& c) {
-               c.module = runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), parse_initial_memory(module), code_hash, vm_type, vm_version);
+               c.module = runtime_interface->instantiate_module((const char*)bytes.data(), bytes.size(), std::move(initial_memory), code_hash, vm_type, vm_version);
+               c.module_bytes = module_bytes;
             });
+            ++cache_stats.modules;
+            cache_stats.module_bytes += module_bytes;
+            cache_stats.instantiation_time += fc::time_point::now() - start;
+            trim_instantiation_cache(it);
          }
          return it->module;
       }
@@ -210,6 +273,9 @@ namespace eosio { namespace chain {
          >
       > wasm_cache_index;
       wasm_cache_index wasm_instantiation_cache;
+      wasm_interface::instantiation_cache_stats cache_stats;
+      static constexpr uint64_t execution_count_decay_interval = 1024u*1024u;
+      uint64_t executions_since_decay = 0;
 
       const chainbase::database& db;
       const wasm_interface::vm_type wasm_runtime_time;
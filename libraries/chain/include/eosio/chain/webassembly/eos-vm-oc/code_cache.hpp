@@ -76,6 +76,13 @@ class code_cache_base {
       std::unordered_set<code_tuple> _queued_compiles;
       std::unordered_map<code_tuple, bool> _outstanding_compiles_and_poison;
 
+      //executions of each code, halved periodically so that they reflect recent use. Orders the compile
+      //queue and picks eviction victims among the least recently used entries
+      std::unordered_map<code_tuple, uint64_t> _execution_counts;
+      uint64_t _executions_since_decay = 0;
+      void count_execution(const code_tuple& ct);
+      uint64_t execution_count(const code_tuple& ct) const;
+
       size_t _free_bytes_eviction_threshold;
       void check_eviction_threshold(size_t free_bytes);
       void run_eviction_round();
@@ -96,11 +103,16 @@ class code_cache_async : public code_cache_base {
       //otherwise: return nullptr
       const code_descriptor* const get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version);
 
+      //If code is not in cache, not blacklisted and not compiling: kick off compile (or queue it) ahead of its first execution
+      void precompile(const digest_type& code_id, const uint8_t& vm_version);
+
    private:
       std::thread _monitor_reply_thread;
       boost::lockfree::spsc_queue<wasm_compilation_result_message> _result_queue;
       void wait_on_compile_monitor_message();
       std::tuple<size_t, size_t> consume_compile_thread_queue();
+      void start_compile(const code_tuple& ct);
+      std::unordered_set<code_tuple>::iterator next_queued_compile();
       std::unordered_set<code_tuple> _blacklist;
       size_t _threads;
 };
@@ -7,12 +7,14 @@
 
 #include <boost/filesystem/path.hpp>
 #include <fc/reflect/reflect.hpp>
+#include <eosio/chain/name.hpp>
 
 namespace eosio { namespace chain { namespace eosvmoc {
 
 struct config {
    uint64_t cache_size = 1024u*1024u*1024u;
    uint64_t threads    = 1u;
+   std::vector<name> precompile_accounts; ///< contracts compiled at startup and on setcode, ahead of their first execution
 };
 
 }}}
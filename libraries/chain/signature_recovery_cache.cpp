@@ -0,0 +1,53 @@
+#include <eosio/chain/signature_recovery_cache.hpp>
+#include <eosio/chain/config.hpp>
+
+namespace eosio { namespace chain {
+
+signature_recovery_cache& signature_recovery_cache::instance() {
+   static signature_recovery_cache cache( config::sig_recovery_cache_size );
+   return cache;
+}
+
+digest_type signature_recovery_cache::key( const digest_type& digest, const signature_type& sig ) {
+   digest_type::encoder enc;
+   fc::raw::pack( enc, digest );
+   fc::raw::pack( enc, sig );
+   return enc.result();
+}
+
+fc::optional<signature_recovery_cache::entry> signature_recovery_cache::find( const digest_type& key ) {
+   std::lock_guard<std::mutex> g( _mtx );
+   auto& idx = _cache.get<by_key>();
+   auto it = idx.find( key );
+   if( it == idx.end() ) {
+      ++_misses;
+      return {};
+   }
+   ++_hits;
+   _cache.relocate( _cache.begin(), _cache.project<0>( it ) );
+   return *it;
+}
+
+void signature_recovery_cache::insert( entry e ) {
+   std::lock_guard<std::mutex> g( _mtx );
+   _cache.emplace_front( std::move( e ) );
+   if( _cache.size() > _capacity )
+      _cache.pop_back();
+}
+
+size_t signature_recovery_cache::size()const {
+   std::lock_guard<std::mutex> g( _mtx );
+   return _cache.size();
+}
+
+uint64_t signature_recovery_cache::hits()const {
+   std::lock_guard<std::mutex> g( _mtx );
+   return _hits;
+}
+
+uint64_t signature_recovery_cache::misses()const {
+   std::lock_guard<std::mutex> g( _mtx );
+   return _misses;
+}
+
+} } // namespace eosio::chain
@@ -47,9 +47,9 @@ void variant_snapshot_reader::validate() const {
    EOS_ASSERT(version.is_integer(), snapshot_validation_exception,
          "Variant snapshot version is not an integer");
 
-   EOS_ASSERT(version.as_uint64() == (uint64_t)current_snapshot_version, snapshot_validation_exception,
-         "Variant snapshot is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
-         ("expected", current_snapshot_version)("actual",o["version"].as_uint64()));
+   EOS_ASSERT(version.as_uint64() >= minimum_snapshot_version && version.as_uint64() <= current_snapshot_version, snapshot_validation_exception,
+         "Variant snapshot is an unsuppored version.  Expected : [${min}, ${max}], Got: ${actual}",
+         ("min", minimum_snapshot_version)("max", current_snapshot_version)("actual",o["version"].as_uint64()));
 
    EOS_ASSERT(o.contains("sections"), snapshot_validation_exception,
          "Variant snapshot has no sections");
@@ -119,6 +119,95 @@ void variant_snapshot_reader::return_to_header() {
    clear_section();
 }
 
+namespace {
+   /// collects the rows of one section part into a buffer
+   class section_buffer_writer : public snapshot_writer {
+      public:
+         explicit section_buffer_writer(detail::section_buffer& buffer)
+         :buffer(buffer)
+         {
+         }
+
+      protected:
+         void write_start_section( const std::string& ) override {}
+
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override {
+            row_writer.write(buffer);
+            buffer.row_count++;
+         }
+
+         void write_end_section( ) override {}
+
+      private:
+         detail::section_buffer& buffer;
+   };
+}
+
+parallel_snapshot_writer::parallel_snapshot_writer(snapshot_writer_ptr inner, boost::asio::io_context& thread_pool, size_t max_pending_parts)
+:inner(std::move(inner))
+,thread_pool(thread_pool)
+,max_pending_parts(std::max<size_t>(max_pending_parts, 1))
+{
+   EOS_ASSERT(this->inner->supports_buffered_sections(), snapshot_exception, "Snapshot writer does not support buffered sections");
+}
+
+parallel_snapshot_writer::~parallel_snapshot_writer() {
+   // the parts reference state owned by the caller, they must not outlive it
+   for( auto& section : pending ) {
+      for( auto& part : section.parts ) {
+         if( part.valid() ) part.wait();
+      }
+   }
+}
+
+void parallel_snapshot_writer::write_section_parts( const std::string& section_name, std::vector<section_function> parts ) {
+   while( !pending.empty() && pending_parts + parts.size() > max_pending_parts ) {
+      write_front();
+   }
+
+   pending_section section{section_name, {}};
+   section.parts.reserve(parts.size());
+   for( auto& part : parts ) {
+      section.parts.emplace_back( async_thread_pool( thread_pool, [section_name, part{std::move(part)}]() {
+         detail::section_buffer buffer;
+         section_buffer_writer(buffer).write_section(section_name, part);
+         return buffer;
+      }));
+   }
+   pending_parts += section.parts.size();
+   pending.emplace_back(std::move(section));
+}
+
+void parallel_snapshot_writer::write_front() {
+   auto& section = pending.front();
+   std::vector<detail::section_buffer> buffers;
+   buffers.reserve(section.parts.size());
+   for( auto& part : section.parts ) {
+      buffers.emplace_back(part.get());
+   }
+   inner->write_buffered_section(section.name, buffers);
+   pending_parts -= section.parts.size();
+   pending.pop_front();
+}
+
+void parallel_snapshot_writer::finalize() {
+   while( !pending.empty() ) {
+      write_front();
+   }
+}
+
+void parallel_snapshot_writer::write_start_section( const std::string& ) {
+   EOS_THROW(snapshot_exception, "Parallel snapshot writer only writes whole sections");
+}
+
+void parallel_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& ) {
+   EOS_THROW(snapshot_exception, "Parallel snapshot writer only writes whole sections");
+}
+
+void parallel_snapshot_writer::write_end_section( ) {
+   EOS_THROW(snapshot_exception, "Parallel snapshot writer only writes whole sections");
+}
+
 ostream_snapshot_writer::ostream_snapshot_writer(std::ostream& snapshot)
 :snapshot(snapshot)
 ,header_pos(snapshot.tellp())
@@ -132,6 +221,24 @@ ostream_snapshot_writer::ostream_snapshot_writer(std::ostream& snapshot)
    // write version
    auto version = current_snapshot_version;
    snapshot.write((char*)&version, sizeof(version));
+
+   // write a placeholder for the offset of the section table
+   uint64_t placeholder = std::numeric_limits<uint64_t>::max();
+   snapshot.write((char*)&placeholder, sizeof(placeholder));
+}
+
+void ostream_snapshot_writer::write_section_header( const std::string& section_name, uint64_t section_size, uint64_t row_count ) {
+   section_offsets.emplace_back(section_name, uint64_t(snapshot.tellp() - header_pos));
+
+   // write the section size
+   snapshot.write((char*)&section_size, sizeof(section_size));
+
+   // write the row count
+   snapshot.write((char*)&row_count, sizeof(row_count));
+
+   // write the section name (null terminated)
+   snapshot.write(section_name.data(), section_name.size());
+   snapshot.put(0);
 }
 
 void ostream_snapshot_writer::write_start_section( const std::string& section_name )
@@ -140,17 +247,9 @@ void ostream_snapshot_writer::write_start_section( const std::string& section_na
    section_pos = snapshot.tellp();
    row_count = 0;
 
+   // write placeholders for the section size and row count
    uint64_t placeholder = std::numeric_limits<uint64_t>::max();
-
-   // write a placeholder for the section size
-   snapshot.write((char*)&placeholder, sizeof(placeholder));
-
-   // write placeholder for row count
-   snapshot.write((char*)&placeholder, sizeof(placeholder));
-
-   // write the section name (null terminated)
-   snapshot.write(section_name.data(), section_name.size());
-   snapshot.put(0);
+   write_section_header(section_name, placeholder, placeholder);
 }
 
 void ostream_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& row_writer ) {
@@ -183,11 +282,42 @@ void ostream_snapshot_writer::write_end_section( ) {
    row_count = 0;
 }
 
+void ostream_snapshot_writer::write_buffered_section( const std::string& section_name, const std::vector<detail::section_buffer>& parts ) {
+   EOS_ASSERT(section_pos == std::streampos(-1), snapshot_exception, "Attempting to write a new section without closing the previous section");
+
+   uint64_t section_size = sizeof(uint64_t) + section_name.size() + 1;
+   uint64_t rows = 0;
+   for( const auto& part : parts ) {
+      section_size += part.data.size();
+      rows += part.row_count;
+   }
+
+   write_section_header(section_name, section_size, rows);
+   for( const auto& part : parts ) {
+      snapshot.write(part.data.data(), part.data.size());
+   }
+}
+
 void ostream_snapshot_writer::finalize() {
    uint64_t end_marker = std::numeric_limits<uint64_t>::max();
 
    // write a placeholder for the section size
    snapshot.write((char*)&end_marker, sizeof(end_marker));
+
+   // write the section table and point the header at it
+   uint64_t table_offset = snapshot.tellp() - header_pos;
+   uint64_t num_sections = section_offsets.size();
+   snapshot.write((char*)&num_sections, sizeof(num_sections));
+   for( const auto& section : section_offsets ) {
+      snapshot.write((char*)&section.second, sizeof(section.second));
+      snapshot.write(section.first.data(), section.first.size());
+      snapshot.put(0);
+   }
+
+   auto restore = snapshot.tellp();
+   snapshot.seekp(header_pos + std::streamoff(sizeof(magic_number) + sizeof(current_snapshot_version)));
+   snapshot.write((char*)&table_offset, sizeof(table_offset));
+   snapshot.seekp(restore);
 }
 
 istream_snapshot_reader::istream_snapshot_reader(std::istream& snapshot)
@@ -210,6 +340,7 @@ void istream_snapshot_reader::validate() const {
 
    try {
       // validate totem
+      snapshot.seekg(header_pos);
       auto expected_totem = ostream_snapshot_writer::magic_number;
       decltype(expected_totem) actual_totem;
       snapshot.read((char*)&actual_totem, sizeof(actual_totem));
@@ -217,14 +348,32 @@ void istream_snapshot_reader::validate() const {
                  "Binary snapshot has unexpected magic number!");
 
       // validate version
-      auto expected_version = current_snapshot_version;
-      decltype(expected_version) actual_version;
+      uint32_t actual_version;
       snapshot.read((char*)&actual_version, sizeof(actual_version));
-      EOS_ASSERT(actual_version == expected_version, snapshot_exception,
-                 "Binary snapshot is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
-                 ("expected", expected_version)("actual", actual_version));
+      EOS_ASSERT(actual_version >= minimum_snapshot_version && actual_version <= current_snapshot_version, snapshot_exception,
+                 "Binary snapshot is an unsuppored version.  Expected : [${min}, ${max}], Got: ${actual}",
+                 ("min", minimum_snapshot_version)("max", current_snapshot_version)("actual", actual_version));
+
+      uint64_t table_offset = 0;
+      if (actual_version >= 2) {
+         snapshot.read((char*)&table_offset, sizeof(table_offset));
+      }
 
       while (validate_section()) {}
+
+      if (actual_version >= 2) {
+         EOS_ASSERT(uint64_t(snapshot.tellg() - header_pos) == table_offset, snapshot_exception,
+                    "Binary snapshot section table does not follow the last section");
+         uint64_t num_sections = 0;
+         snapshot.read((char*)&num_sections, sizeof(num_sections));
+         for (uint64_t i = 0; i < num_sections; ++i) {
+            uint64_t section_offset = 0;
+            snapshot.read((char*)&section_offset, sizeof(section_offset));
+            EOS_ASSERT(section_offset < table_offset, snapshot_exception,
+                       "Binary snapshot section table points past the last section");
+            while (snapshot.get() != 0) {}
+         }
+      }
    } catch( const std::exception& e ) {  \
       snapshot_exception fce(FC_LOG_MESSAGE( warn, "Binary snapshot validation threw IO exception (${what})",("what",e.what())));
       throw fce;
@@ -246,85 +395,96 @@ bool istream_snapshot_reader::validate_section() const {
    return true;
 }
 
-bool istream_snapshot_reader::has_section( const string& section_name ) {
-   auto restore_pos = fc::make_scoped_exit([this,pos=snapshot.tellg()](){
-      snapshot.seekg(pos);
-   });
-
-   const std::streamoff header_size = sizeof(ostream_snapshot_writer::magic_number) + sizeof(current_snapshot_version);
-
-   auto next_section_pos = header_pos + header_size;
-
-   while (true) {
-      snapshot.seekg(next_section_pos);
-      uint64_t section_size = 0;
-      snapshot.read((char*)&section_size,sizeof(section_size));
-      if (section_size == std::numeric_limits<uint64_t>::max()) {
-         break;
-      }
-
-      next_section_pos = snapshot.tellg() + std::streamoff(section_size);
-
-      uint64_t ignore = 0;
-      snapshot.read((char*)&ignore,sizeof(ignore));
-
-      bool match = true;
-      for(auto c : section_name) {
-         if(snapshot.get() != c) {
-            match = false;
-            break;
-         }
-      }
+uint32_t istream_snapshot_reader::read_version() const {
+   uint32_t version = 0;
+   snapshot.seekg(header_pos + std::streamoff(sizeof(ostream_snapshot_writer::magic_number)));
+   snapshot.read((char*)&version, sizeof(version));
+   return version;
+}
 
-      if (match && snapshot.get() == 0) {
-         return true;
-      }
+std::streamoff istream_snapshot_reader::first_section_offset() const {
+   std::streamoff header_size = sizeof(ostream_snapshot_writer::magic_number) + sizeof(current_snapshot_version);
+   if (read_version() >= 2) {
+      header_size += sizeof(uint64_t);
    }
-
-   return false;
+   return header_size;
 }
 
-void istream_snapshot_reader::set_section( const string& section_name ) {
+const std::map<std::string, std::streamoff>& istream_snapshot_reader::get_section_offsets() {
+   if (section_offsets) {
+      return *section_offsets;
+   }
+
    auto restore_pos = fc::make_scoped_exit([this,pos=snapshot.tellg()](){
       snapshot.seekg(pos);
    });
 
-   const std::streamoff header_size = sizeof(ostream_snapshot_writer::magic_number) + sizeof(current_snapshot_version);
-
-   auto next_section_pos = header_pos + header_size;
-
-   while (true) {
-      snapshot.seekg(next_section_pos);
-      uint64_t section_size = 0;
-      snapshot.read((char*)&section_size,sizeof(section_size));
-      if (section_size == std::numeric_limits<uint64_t>::max()) {
-         break;
+   std::map<std::string, std::streamoff> offsets;
+   auto add_section = [&offsets](std::string name, std::streamoff offset) {
+      // like the linear scan this replaces, the first section of a name wins
+      offsets.emplace(std::move(name), offset);
+   };
+
+   if (read_version() >= 2) {
+      uint64_t table_offset = 0;
+      snapshot.read((char*)&table_offset, sizeof(table_offset));
+      snapshot.seekg(header_pos + std::streamoff(table_offset));
+
+      uint64_t num_sections = 0;
+      snapshot.read((char*)&num_sections, sizeof(num_sections));
+      for (uint64_t i = 0; i < num_sections; ++i) {
+         uint64_t section_offset = 0;
+         snapshot.read((char*)&section_offset, sizeof(section_offset));
+         std::string name;
+         std::getline(snapshot, name, '\0');
+         add_section(std::move(name), section_offset);
       }
-
-      next_section_pos = snapshot.tellg() + std::streamoff(section_size);
-
-      uint64_t row_count = 0;
-      snapshot.read((char*)&row_count,sizeof(row_count));
-
-      bool match = true;
-      for(auto c : section_name) {
-         if(snapshot.get() != c) {
-            match = false;
+   } else {
+      auto next_section_pos = header_pos + first_section_offset();
+      while (true) {
+         snapshot.seekg(next_section_pos);
+         auto section_pos = next_section_pos;
+         uint64_t section_size = 0;
+         snapshot.read((char*)&section_size,sizeof(section_size));
+         if (section_size == std::numeric_limits<uint64_t>::max()) {
             break;
          }
-      }
 
-      if (match && snapshot.get() == 0) {
-         cur_row = 0;
-         num_rows = row_count;
+         next_section_pos = snapshot.tellg() + std::streamoff(section_size);
 
-         // leave the stream at the right point
-         restore_pos.cancel();
-         return;
+         uint64_t ignore = 0;
+         snapshot.read((char*)&ignore,sizeof(ignore));
+
+         std::string name;
+         std::getline(snapshot, name, '\0');
+         add_section(std::move(name), section_pos - header_pos);
       }
    }
 
-   EOS_THROW(snapshot_exception, "Binary snapshot has no section named ${n}", ("n", section_name));
+   section_offsets.emplace(std::move(offsets));
+   return *section_offsets;
+}
+
+bool istream_snapshot_reader::has_section( const string& section_name ) {
+   const auto& offsets = get_section_offsets();
+   return offsets.find(section_name) != offsets.end();
+}
+
+void istream_snapshot_reader::set_section( const string& section_name ) {
+   const auto& offsets = get_section_offsets();
+   auto itr = offsets.find(section_name);
+   EOS_ASSERT(itr != offsets.end(), snapshot_exception, "Binary snapshot has no section named ${n}", ("n", section_name));
+
+   snapshot.seekg(header_pos + itr->second);
+   uint64_t section_size = 0;
+   snapshot.read((char*)&section_size,sizeof(section_size));
+   uint64_t row_count = 0;
+   snapshot.read((char*)&row_count,sizeof(row_count));
+
+   // leave the stream at the first row
+   snapshot.seekg(std::streamoff(section_name.size() + 1), std::ios_base::cur);
+   cur_row = 0;
+   num_rows = row_count;
 }
 
 bool istream_snapshot_reader::read_row( detail::abstract_snapshot_row_reader& row_reader ) {
@@ -364,6 +524,13 @@ void integrity_hash_snapshot_writer::write_end_section( ) {
    // no-op for structural details
 }
 
+void integrity_hash_snapshot_writer::write_buffered_section( const std::string&, const std::vector<detail::section_buffer>& parts ) {
+   // the buffers hold the same bytes the rows would have written
+   for( const auto& part : parts ) {
+      enc.write(part.data.data(), part.data.size());
+   }
+}
+
 void integrity_hash_snapshot_writer::finalize() {
    // no-op for structural details
 }
@@ -9,6 +9,7 @@
 
 #include <eosio/chain/config.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/chain/transaction.hpp>
 
 namespace eosio { namespace chain {
@@ -63,18 +64,31 @@ fc::microseconds transaction::get_signature_keys( const vector<signature_type>&
    auto start = fc::time_point::now();
    recovered_pub_keys.clear();
    const digest_type digest = sig_digest(chain_id, cfd);
+   auto& cache = signature_recovery_cache::instance();
+   fc::microseconds cached_cpu_usage;
 
    for(const signature_type& sig : signatures) {
       auto now = fc::time_point::now();
       EOS_ASSERT( now < deadline, tx_cpu_usage_exceeded, "transaction signature verification executed for too long ${time}us",
                   ("time", now - start)("now", now)("deadline", deadline)("start", start) );
-      auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( sig, digest );
+      const digest_type key = signature_recovery_cache::key( digest, sig );
+
+      public_key_type recovered_pub_key;
+      if( auto cached = cache.find( key ) ) {
+         // bill what the recovery cost, not the lookup
+         recovered_pub_key = cached->pub_key;
+         cached_cpu_usage += cached->cpu_usage;
+      } else {
+         recovered_pub_key = public_key_type( sig, digest );
+         cache.insert( { key, recovered_pub_key, fc::time_point::now() - now } );
+      }
+      auto[ itr, successful_insertion ] = recovered_pub_keys.emplace( std::move( recovered_pub_key ) );
       EOS_ASSERT( allow_duplicate_keys || successful_insertion, tx_duplicate_sig,
                   "transaction includes more than one signature signed using the same key associated with public key: ${key}",
                   ("key", *itr ) );
    }
 
-   return fc::time_point::now() - start;
+   return fc::time_point::now() - start + cached_cpu_usage;
 } FC_CAPTURE_AND_RETHROW() }
 
 flat_multimap<uint16_t, transaction_extension> transaction::validate_and_extract_extensions()const {
@@ -4,6 +4,20 @@
 
 namespace eosio { namespace chain {
 
+transaction_metadata_ptr transaction_metadata::recover_keys( packed_transaction_ptr trx,
+                                                             const chain_id_type& chain_id,
+                                                             fc::microseconds time_limit,
+                                                             uint32_t max_variable_sig_size )
+{
+   fc::time_point deadline = time_limit == fc::microseconds::maximum() ?
+                             fc::time_point::maximum() : fc::time_point::now() + time_limit;
+   check_variable_sig_size( trx, max_variable_sig_size );
+   const signed_transaction& trn = trx->get_signed_transaction();
+   flat_set<public_key_type> recovered_pub_keys;
+   fc::microseconds cpu_usage = trn.get_signature_keys( chain_id, deadline, recovered_pub_keys );
+   return std::make_shared<transaction_metadata>( private_type(), std::move( trx ), cpu_usage, std::move( recovered_pub_keys ) );
+}
+
 recover_keys_future transaction_metadata::start_recover_keys( packed_transaction_ptr trx,
                                                               boost::asio::io_context& thread_pool,
                                                               const chain_id_type& chain_id,
@@ -11,15 +25,42 @@ recover_keys_future transaction_metadata::start_recover_keys( packed_transaction
                                                               uint32_t max_variable_sig_size )
 {
    return async_thread_pool( thread_pool, [trx{std::move(trx)}, chain_id, time_limit, max_variable_sig_size]() mutable {
-         fc::time_point deadline = time_limit == fc::microseconds::maximum() ?
-                                   fc::time_point::maximum() : fc::time_point::now() + time_limit;
-         check_variable_sig_size( trx, max_variable_sig_size );
-         const signed_transaction& trn = trx->get_signed_transaction();
-         flat_set<public_key_type> recovered_pub_keys;
-         fc::microseconds cpu_usage = trn.get_signature_keys( chain_id, deadline, recovered_pub_keys );
-         return std::make_shared<transaction_metadata>( private_type(), std::move( trx ), cpu_usage, std::move( recovered_pub_keys ) );
+         return recover_keys( std::move( trx ), chain_id, time_limit, max_variable_sig_size );
       }
    );
 }
 
+std::vector<recover_keys_future> transaction_metadata::start_recover_keys( std::vector<packed_transaction_ptr> trxs,
+                                                                           boost::asio::io_context& thread_pool,
+                                                                           size_t num_threads,
+                                                                           const chain_id_type& chain_id,
+                                                                           fc::microseconds time_limit,
+                                                                           uint32_t max_variable_sig_size )
+{
+   // a few tasks per thread keep every thread busy until the end of the batch, small batches go one per task
+   const size_t max_tasks = 4 * std::max<size_t>( num_threads, 1 );
+   const size_t trxs_per_task = std::max<size_t>( ( trxs.size() + max_tasks - 1 ) / max_tasks, 1 );
+
+   auto promises = std::make_shared<std::vector<std::promise<transaction_metadata_ptr>>>( trxs.size() );
+   auto shared_trxs = std::make_shared<std::vector<packed_transaction_ptr>>( std::move( trxs ) );
+   std::vector<recover_keys_future> futures;
+   futures.reserve( promises->size() );
+   for( auto& p : *promises )
+      futures.emplace_back( p.get_future() );
+
+   for( size_t begin = 0; begin < shared_trxs->size(); begin += trxs_per_task ) {
+      const size_t end = std::min( begin + trxs_per_task, shared_trxs->size() );
+      boost::asio::post( thread_pool, [promises, shared_trxs, begin, end, chain_id, time_limit, max_variable_sig_size]() {
+         for( size_t i = begin; i < end; ++i ) {
+            try {
+               (*promises)[i].set_value( recover_keys( std::move( (*shared_trxs)[i] ), chain_id, time_limit, max_variable_sig_size ) );
+            } catch( ... ) {
+               (*promises)[i].set_exception( std::current_exception() );
+            }
+         }
+      } );
+   }
+   return futures;
+}
+
 } } // eosio::chain
@@ -32,8 +32,9 @@
 namespace eosio { namespace chain {
    using namespace webassembly::common;
 
-   wasm_interface::wasm_interface(vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config)
-     : my( new wasm_interface_impl(vm, eosvmoc_tierup, d, data_dir, eosvmoc_config) ) {}
+   wasm_interface::wasm_interface(vm_type vm, bool eosvmoc_tierup, const chainbase::database& d, const boost::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config,
+                                  uint64_t instantiation_cache_size)
+     : my( new wasm_interface_impl(vm, eosvmoc_tierup, d, data_dir, eosvmoc_config, instantiation_cache_size) ) {}
 
    wasm_interface::~wasm_interface() {}
 
@@ -73,6 +74,36 @@ namespace eosio { namespace chain {
       my->current_lib(lib);
    }
 
+   void wasm_interface::code_updated(const account_name& account, const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version) {
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      if(my->eosvmoc && my->eosvmoc->precompile_accounts.count(account)) {
+         try {
+            my->eosvmoc->cc.precompile(code_hash, vm_version);
+         }
+         catch(...) {
+            //not fatal, the code is compiled on its first execution instead
+            elog("EOS VM OC failed to start compiling code of ${a}", ("a", account));
+         }
+      }
+#endif
+   }
+
+   void wasm_interface::precompile_accounts() {
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      if(!my->eosvmoc)
+         return;
+      for(const account_name& account : my->eosvmoc->precompile_accounts) {
+         const auto* metadata = my->db.find<account_metadata_object,by_name>(account);
+         if(metadata && metadata->code_hash != digest_type())
+            code_updated(account, metadata->code_hash, metadata->vm_type, metadata->vm_version);
+      }
+#endif
+   }
+
+   wasm_interface::instantiation_cache_stats wasm_interface::get_instantiation_cache_stats()const {
+      return my->cache_stats;
+   }
+
    void wasm_interface::apply( const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, apply_context& context ) {
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
       if(my->eosvmoc) {
@@ -108,6 +139,9 @@ namespace eosio { namespace chain {
    #undef assert
 #endif
 
+// attributes the time of the enclosing intrinsic to the running action when action profiling is enabled
+#define PROFILE_HOST_FUNCTION() apply_context::host_function_timer _host_function_timer( context, __func__ )
+
 class context_aware_api {
    public:
       context_aware_api(apply_context& ctx, bool context_free = false )
@@ -804,6 +838,7 @@ class crypto_api : public context_aware_api {
       void assert_recover_key( const fc::sha256& digest,
                         array_ptr<char> sig, uint32_t siglen,
                         array_ptr<char> pub, uint32_t publen ) {
+         PROFILE_HOST_FUNCTION();
          fc::crypto::signature s;
          fc::crypto::public_key p;
          datastream<const char*> ds( sig, siglen );
@@ -828,6 +863,7 @@ class crypto_api : public context_aware_api {
       int recover_key( const fc::sha256& digest,
                         array_ptr<char> sig, uint32_t siglen,
                         array_ptr<char> pub, uint32_t publen ) {
+         PROFILE_HOST_FUNCTION();
          fc::crypto::signature s;
          datastream<const char*> ds( sig, siglen );
          fc::raw::unpack(ds, s);
@@ -875,38 +911,46 @@ class crypto_api : public context_aware_api {
       }
 
       void assert_sha256(array_ptr<char> data, uint32_t datalen, const fc::sha256& hash_val) {
+         PROFILE_HOST_FUNCTION();
          auto result = encode<fc::sha256::encoder>( data, datalen );
          EOS_ASSERT( result == hash_val, crypto_api_exception, "hash mismatch" );
       }
 
       void assert_sha1(array_ptr<char> data, uint32_t datalen, const fc::sha1& hash_val) {
+         PROFILE_HOST_FUNCTION();
          auto result = encode<fc::sha1::encoder>( data, datalen );
          EOS_ASSERT( result == hash_val, crypto_api_exception, "hash mismatch" );
       }
 
       void assert_sha512(array_ptr<char> data, uint32_t datalen, const fc::sha512& hash_val) {
+         PROFILE_HOST_FUNCTION();
          auto result = encode<fc::sha512::encoder>( data, datalen );
          EOS_ASSERT( result == hash_val, crypto_api_exception, "hash mismatch" );
       }
 
       void assert_ripemd160(array_ptr<char> data, uint32_t datalen, const fc::ripemd160& hash_val) {
+         PROFILE_HOST_FUNCTION();
          auto result = encode<fc::ripemd160::encoder>( data, datalen );
          EOS_ASSERT( result == hash_val, crypto_api_exception, "hash mismatch" );
       }
 
       void sha1(array_ptr<char> data, uint32_t datalen, fc::sha1& hash_val) {
+         PROFILE_HOST_FUNCTION();
          hash_val = encode<fc::sha1::encoder>( data, datalen );
       }
 
       void sha256(array_ptr<char> data, uint32_t datalen, fc::sha256& hash_val) {
+         PROFILE_HOST_FUNCTION();
          hash_val = encode<fc::sha256::encoder>( data, datalen );
       }
 
       void sha512(array_ptr<char> data, uint32_t datalen, fc::sha512& hash_val) {
+         PROFILE_HOST_FUNCTION();
          hash_val = encode<fc::sha512::encoder>( data, datalen );
       }
 
       void ripemd160(array_ptr<char> data, uint32_t datalen, fc::ripemd160& hash_val) {
+         PROFILE_HOST_FUNCTION();
          hash_val = encode<fc::ripemd160::encoder>( data, datalen );
       }
 };
@@ -1274,38 +1318,49 @@ class console_api : public context_aware_api {
 
 #define DB_API_METHOD_WRAPPERS_SIMPLE_SECONDARY(IDX, TYPE)\
       int db_##IDX##_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const TYPE& secondary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.store( scope, table, account_name(payer), id, secondary );\
       }\
       void db_##IDX##_update( int iterator, uint64_t payer, const TYPE& secondary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.update( iterator, account_name(payer), secondary );\
       }\
       void db_##IDX##_remove( int iterator ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.remove( iterator );\
       }\
       int db_##IDX##_find_secondary( uint64_t code, uint64_t scope, uint64_t table, const TYPE& secondary, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.find_secondary(code, scope, table, secondary, primary);\
       }\
       int db_##IDX##_find_primary( uint64_t code, uint64_t scope, uint64_t table, TYPE& secondary, uint64_t primary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.find_primary(code, scope, table, secondary, primary);\
       }\
       int db_##IDX##_lowerbound( uint64_t code, uint64_t scope, uint64_t table,  TYPE& secondary, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.lowerbound_secondary(code, scope, table, secondary, primary);\
       }\
       int db_##IDX##_upperbound( uint64_t code, uint64_t scope, uint64_t table,  TYPE& secondary, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.upperbound_secondary(code, scope, table, secondary, primary);\
       }\
       int db_##IDX##_end( uint64_t code, uint64_t scope, uint64_t table ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.end_secondary(code, scope, table);\
       }\
       int db_##IDX##_next( int iterator, uint64_t& primary  ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.next_secondary(iterator, primary);\
       }\
       int db_##IDX##_previous( int iterator, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.previous_secondary(iterator, primary);\
       }
 
 #define DB_API_METHOD_WRAPPERS_ARRAY_SECONDARY(IDX, ARR_SIZE, ARR_ELEMENT_TYPE)\
       int db_##IDX##_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, array_ptr<const ARR_ELEMENT_TYPE> data, uint32_t data_len) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( data_len == ARR_SIZE,\
                     db_api_exception,\
                     "invalid size of secondary key array for " #IDX ": given ${given} bytes but expected ${expected} bytes",\
@@ -1313,6 +1368,7 @@ class console_api : public context_aware_api {
          return context.IDX.store(scope, table, account_name(payer), id, data.value);\
       }\
       void db_##IDX##_update( int iterator, uint64_t payer, array_ptr<const ARR_ELEMENT_TYPE> data, uint32_t data_len ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( data_len == ARR_SIZE,\
                     db_api_exception,\
                     "invalid size of secondary key array for " #IDX ": given ${given} bytes but expected ${expected} bytes",\
@@ -1320,9 +1376,11 @@ class console_api : public context_aware_api {
          return context.IDX.update(iterator, account_name(payer), data.value);\
       }\
       void db_##IDX##_remove( int iterator ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.remove(iterator);\
       }\
       int db_##IDX##_find_secondary( uint64_t code, uint64_t scope, uint64_t table, array_ptr<const ARR_ELEMENT_TYPE> data, uint32_t data_len, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( data_len == ARR_SIZE,\
                     db_api_exception,\
                     "invalid size of secondary key array for " #IDX ": given ${given} bytes but expected ${expected} bytes",\
@@ -1330,6 +1388,7 @@ class console_api : public context_aware_api {
          return context.IDX.find_secondary(code, scope, table, data, primary);\
       }\
       int db_##IDX##_find_primary( uint64_t code, uint64_t scope, uint64_t table, array_ptr<ARR_ELEMENT_TYPE> data, uint32_t data_len, uint64_t primary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( data_len == ARR_SIZE,\
                     db_api_exception,\
                     "invalid size of secondary key array for " #IDX ": given ${given} bytes but expected ${expected} bytes",\
@@ -1337,6 +1396,7 @@ class console_api : public context_aware_api {
          return context.IDX.find_primary(code, scope, table, data.value, primary);\
       }\
       int db_##IDX##_lowerbound( uint64_t code, uint64_t scope, uint64_t table, array_ptr<ARR_ELEMENT_TYPE> data, uint32_t data_len, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( data_len == ARR_SIZE,\
                     db_api_exception,\
                     "invalid size of secondary key array for " #IDX ": given ${given} bytes but expected ${expected} bytes",\
@@ -1344,6 +1404,7 @@ class console_api : public context_aware_api {
          return context.IDX.lowerbound_secondary(code, scope, table, data.value, primary);\
       }\
       int db_##IDX##_upperbound( uint64_t code, uint64_t scope, uint64_t table, array_ptr<ARR_ELEMENT_TYPE> data, uint32_t data_len, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( data_len == ARR_SIZE,\
                     db_api_exception,\
                     "invalid size of secondary key array for " #IDX ": given ${given} bytes but expected ${expected} bytes",\
@@ -1351,49 +1412,62 @@ class console_api : public context_aware_api {
          return context.IDX.upperbound_secondary(code, scope, table, data.value, primary);\
       }\
       int db_##IDX##_end( uint64_t code, uint64_t scope, uint64_t table ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.end_secondary(code, scope, table);\
       }\
       int db_##IDX##_next( int iterator, uint64_t& primary  ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.next_secondary(iterator, primary);\
       }\
       int db_##IDX##_previous( int iterator, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.previous_secondary(iterator, primary);\
       }
 
 #define DB_API_METHOD_WRAPPERS_FLOAT_SECONDARY(IDX, TYPE)\
       int db_##IDX##_store( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, const TYPE& secondary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( !softfloat_api::is_nan( secondary ), transaction_exception, "NaN is not an allowed value for a secondary key" );\
          return context.IDX.store( scope, table, account_name(payer), id, secondary );\
       }\
       void db_##IDX##_update( int iterator, uint64_t payer, const TYPE& secondary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( !softfloat_api::is_nan( secondary ), transaction_exception, "NaN is not an allowed value for a secondary key" );\
          return context.IDX.update( iterator, account_name(payer), secondary );\
       }\
       void db_##IDX##_remove( int iterator ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.remove( iterator );\
       }\
       int db_##IDX##_find_secondary( uint64_t code, uint64_t scope, uint64_t table, const TYPE& secondary, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( !softfloat_api::is_nan( secondary ), transaction_exception, "NaN is not an allowed value for a secondary key" );\
          return context.IDX.find_secondary(code, scope, table, secondary, primary);\
       }\
       int db_##IDX##_find_primary( uint64_t code, uint64_t scope, uint64_t table, TYPE& secondary, uint64_t primary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.find_primary(code, scope, table, secondary, primary);\
       }\
       int db_##IDX##_lowerbound( uint64_t code, uint64_t scope, uint64_t table,  TYPE& secondary, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( !softfloat_api::is_nan( secondary ), transaction_exception, "NaN is not an allowed value for a secondary key" );\
          return context.IDX.lowerbound_secondary(code, scope, table, secondary, primary);\
       }\
       int db_##IDX##_upperbound( uint64_t code, uint64_t scope, uint64_t table,  TYPE& secondary, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          EOS_ASSERT( !softfloat_api::is_nan( secondary ), transaction_exception, "NaN is not an allowed value for a secondary key" );\
          return context.IDX.upperbound_secondary(code, scope, table, secondary, primary);\
       }\
       int db_##IDX##_end( uint64_t code, uint64_t scope, uint64_t table ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.end_secondary(code, scope, table);\
       }\
       int db_##IDX##_next( int iterator, uint64_t& primary  ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.next_secondary(iterator, primary);\
       }\
       int db_##IDX##_previous( int iterator, uint64_t& primary ) {\
+         PROFILE_HOST_FUNCTION();\
          return context.IDX.previous_secondary(iterator, primary);\
       }
 
@@ -1402,33 +1476,43 @@ class database_api : public context_aware_api {
       using context_aware_api::context_aware_api;
 
       int db_store_i64( uint64_t scope, uint64_t table, uint64_t payer, uint64_t id, array_ptr<const char> buffer, uint32_t buffer_size ) {
+         PROFILE_HOST_FUNCTION();
          return context.db_store_i64( name(scope), name(table), account_name(payer), id, buffer, buffer_size );
       }
       void db_update_i64( int itr, uint64_t payer, array_ptr<const char> buffer, uint32_t buffer_size ) {
+         PROFILE_HOST_FUNCTION();
          context.db_update_i64( itr, account_name(payer), buffer, buffer_size );
       }
       void db_remove_i64( int itr ) {
+         PROFILE_HOST_FUNCTION();
          context.db_remove_i64( itr );
       }
       int db_get_i64( int itr, array_ptr<char> buffer, uint32_t buffer_size ) {
+         PROFILE_HOST_FUNCTION();
          return context.db_get_i64( itr, buffer, buffer_size );
       }
       int db_next_i64( int itr, uint64_t& primary ) {
+         PROFILE_HOST_FUNCTION();
          return context.db_next_i64(itr, primary);
       }
       int db_previous_i64( int itr, uint64_t& primary ) {
+         PROFILE_HOST_FUNCTION();
          return context.db_previous_i64(itr, primary);
       }
       int db_find_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+         PROFILE_HOST_FUNCTION();
          return context.db_find_i64( name(code), name(scope), name(table), id );
       }
       int db_lowerbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+         PROFILE_HOST_FUNCTION();
          return context.db_lowerbound_i64( name(code), name(scope), name(table), id );
       }
       int db_upperbound_i64( uint64_t code, uint64_t scope, uint64_t table, uint64_t id ) {
+         PROFILE_HOST_FUNCTION();
          return context.db_upperbound_i64( name(code), name(scope), name(table), id );
       }
       int db_end_i64( uint64_t code, uint64_t scope, uint64_t table ) {
+         PROFILE_HOST_FUNCTION();
          return context.db_end_i64( name(code), name(scope), name(table) );
       }
 
@@ -39,6 +39,10 @@ static constexpr size_t descriptor_ptr_from_file_start = header_offset + offseto
 
 static_assert(sizeof(code_cache_header) <= header_size, "code_cache_header too big");
 
+static constexpr uint64_t execution_count_decay_interval = 1024u*1024u;
+static constexpr size_t eviction_round_size = 25u;
+static constexpr size_t eviction_candidates = 4u*eviction_round_size;
+
 code_cache_async::code_cache_async(const bfs::path data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
    code_cache_base(data_dir, eosvmoc_config, db),
    _result_queue(eosvmoc_config.threads * 2),
@@ -107,6 +111,9 @@ std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
 }
 
 const code_descriptor* const code_cache_async::get_descriptor_for_code(const digest_type& code_id, const uint8_t& vm_version) {
+   const code_tuple ct = code_tuple{code_id, vm_version};
+   count_execution(ct);
+
    //if there are any outstanding compiles, process the result queue now
    if(_outstanding_compiles_and_poison.size()) {
       auto [count_processed, bytes_remaining] = consume_compile_thread_queue();
@@ -115,7 +122,7 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(const dig
          check_eviction_threshold(bytes_remaining);
 
       while(count_processed && _queued_compiles.size()) {
-         auto nextup = _queued_compiles.begin();
+         auto nextup = next_queued_compile();
 
          //it's not clear this check is required: if apply() was called for code then it existed in the code_index; and then
          // if we got notification of it no longer existing we would have removed it from queued_compiles
@@ -138,8 +145,6 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(const dig
       return &*it;
    }
 
-   const code_tuple ct = code_tuple{code_id, vm_version};
-
    if(_blacklist.find(ct) != _blacklist.end())
       return nullptr;
    if(auto it = _outstanding_compiles_and_poison.find(ct); it != _outstanding_compiles_and_poison.end()) {
@@ -149,20 +154,42 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(const dig
    if(_queued_compiles.find(ct) != _queued_compiles.end())
       return nullptr;
 
+   start_compile(ct);
+   return nullptr;
+}
+
+void code_cache_async::precompile(const digest_type& code_id, const uint8_t& vm_version) {
+   const code_tuple ct = code_tuple{code_id, vm_version};
+
+   if(_cache_index.get<by_hash>().find(boost::make_tuple(code_id, vm_version)) != _cache_index.get<by_hash>().end())
+      return;
+   if(_blacklist.count(ct) || _outstanding_compiles_and_poison.count(ct) || _queued_compiles.count(ct))
+      return;
+
+   start_compile(ct);
+}
+
+void code_cache_async::start_compile(const code_tuple& ct) {
    if(_outstanding_compiles_and_poison.size() >= _threads) {
       _queued_compiles.emplace(ct);
-      return nullptr;
+      return;
    }
 
-   const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(code_id, 0, vm_version));
+   const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(ct.code_id, 0, ct.vm_version));
    if(!codeobject) //should be impossible right?
-      return nullptr;
+      return;
 
    _outstanding_compiles_and_poison.emplace(ct, false);
    std::vector<wrapped_fd> fds_to_pass;
    fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
    write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct }, fds_to_pass);
-   return nullptr;
+}
+
+//most executed code first; precompiles that have not run yet go last
+std::unordered_set<code_tuple>::iterator code_cache_async::next_queued_compile() {
+   return std::max_element(_queued_compiles.begin(), _queued_compiles.end(), [this](const code_tuple& a, const code_tuple& b) {
+      return execution_count(a) < execution_count(b);
+   });
 }
 
 code_cache_sync::~code_cache_sync() {
@@ -356,6 +383,7 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
 
    //if it's in the queued list, erase it
    _queued_compiles.erase({code_id, vm_version});
+   _execution_counts.erase({code_id, vm_version});
 
    //however, if it's currently being compiled there is no way to cancel the compile,
    //so instead set a poison boolean that indicates not to insert the code in to the cache
@@ -365,11 +393,43 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
       compiling_it->second = true;
 }
 
+void code_cache_base::count_execution(const code_tuple& ct) {
+   ++_execution_counts[ct];
+   if(++_executions_since_decay < execution_count_decay_interval)
+      return;
+
+   _executions_since_decay = 0;
+   for(auto it = _execution_counts.begin(); it != _execution_counts.end();) {
+      if((it->second /= 2) == 0)
+         it = _execution_counts.erase(it);
+      else
+         ++it;
+   }
+}
+
+uint64_t code_cache_base::execution_count(const code_tuple& ct) const {
+   auto it = _execution_counts.find(ct);
+   return it == _execution_counts.end() ? 0 : it->second;
+}
+
 void code_cache_base::run_eviction_round() {
+   //the least executed of the least recently used entries go first; the most recently used entry always stays
+   std::vector<code_cache_index::iterator> candidates;
+   if(_cache_index.size() > 1) {
+      auto it = _cache_index.end();
+      do {
+         candidates.push_back(--it);
+      } while(candidates.size() < eviction_candidates && std::prev(it) != _cache_index.begin());
+   }
+   std::stable_sort(candidates.begin(), candidates.end(), [this](const auto& a, const auto& b) {
+      return execution_count({a->code_hash, a->vm_version}) < execution_count({b->code_hash, b->vm_version});
+   });
+   candidates.resize(std::min(candidates.size(), eviction_round_size));
+
    evict_wasms_message evict_msg;
-   for(unsigned int i = 0; i < 25 && _cache_index.size() > 1; ++i) {
-      evict_msg.codes.emplace_back(_cache_index.back());
-      _cache_index.pop_back();
+   for(const auto& it : candidates) {
+      evict_msg.codes.emplace_back(*it);
+      _cache_index.erase(it);
    }
    write_message_with_fds(_compile_monitor_write_socket, evict_msg);
 }
@@ -44,6 +44,53 @@ struct async_result_visitor : public fc::visitor<fc::variant> {
           } \
        }}
 
+// read-only calls that may run on the chain_plugin read-only thread pool, see chain_plugin::post_read_only
+#define CALL_READ_ONLY(api_name, api_handle, api_namespace, call_name, http_response_code) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [api_handle, &chain_plug](string, string body, url_response_callback cb) mutable { \
+      chain_plug.post_read_only( [api_handle, body{std::move(body)}, cb{std::move(cb)}]() mutable { \
+          api_handle.validate(); \
+          try { \
+             if (body.empty()) body = "{}"; \
+             fc::variant result( api_handle.call_name(fc::json::from_string(body).as<api_namespace::call_name ## _params>()) ); \
+             cb(http_response_code, std::move(result)); \
+          } catch (...) { \
+             http_plugin::handle_exception(#api_name, #call_name, body, cb); \
+          } \
+      } ); \
+   }}
+
+// calls that only gather data on the calling thread and leave the encoding of large results to the http thread pool,
+// api_namespace must provide call_name ## _raw_result, call_name ## _raw() and a matching encoder (to_json() or to_binary())
+#define DEFERRED_CALL_BODY(api_name, api_handle, api_namespace, call_name, encoder, content_type, http_response_code) \
+   api_handle.validate(); \
+   try { \
+      if (body.empty()) body = "{}"; \
+      auto params = fc::json::from_string(body).as<api_namespace::call_name ## _params>(); \
+      auto raw = std::make_shared<const api_namespace::call_name ## _raw_result>( api_handle.call_name ## _raw(params) ); \
+      const size_t estimated_size = raw->estimated_size(); \
+      deferred_cb(http_response_code, estimated_size, \
+                  [api_handle, params{std::move(params)}, raw{std::move(raw)}](const fc::time_point& deadline) { \
+         return api_handle.encoder(params, *raw, deadline); \
+      }, content_type); \
+   } catch (...) { \
+      http_plugin::handle_exception(#api_name, #call_name, body, cb); \
+   }
+
+#define CALL_DEFERRED(api_name, api_handle, api_namespace, call_name, encoder, content_type, http_response_code) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [api_handle](string, string body, url_response_callback cb, url_deferred_response_callback deferred_cb) mutable { \
+      DEFERRED_CALL_BODY(api_name, api_handle, api_namespace, call_name, encoder, content_type, http_response_code) \
+   }}
+
+#define CALL_READ_ONLY_DEFERRED(api_name, api_handle, api_namespace, call_name, encoder, content_type, http_response_code) \
+{std::string("/v1/" #api_name "/" #call_name), \
+   [api_handle, &chain_plug](string, string body, url_response_callback cb, url_deferred_response_callback deferred_cb) mutable { \
+      chain_plug.post_read_only( [api_handle, body{std::move(body)}, cb{std::move(cb)}, deferred_cb{std::move(deferred_cb)}]() mutable { \
+         DEFERRED_CALL_BODY(api_name, api_handle, api_namespace, call_name, encoder, content_type, http_response_code) \
+      } ); \
+   }}
+
 #define CALL_ASYNC(api_name, api_handle, api_namespace, call_name, call_result, http_response_code) \
 {std::string("/v1/" #api_name "/" #call_name), \
    [api_handle](string, string body, url_response_callback cb) mutable { \
@@ -65,42 +112,55 @@ struct async_result_visitor : public fc::visitor<fc::variant> {
 }
 
 #define CHAIN_RO_CALL(call_name, http_response_code) CALL(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
+#define CHAIN_RO_CALL_POOL(call_name, http_response_code) CALL_READ_ONLY(chain, ro_api, chain_apis::read_only, call_name, http_response_code)
+#define CHAIN_RO_CALL_DEFERRED(call_name, http_response_code) CALL_DEFERRED(chain, ro_api, chain_apis::read_only, call_name, to_json, "application/json", http_response_code)
+#define CHAIN_RO_CALL_POOL_DEFERRED(call_name, http_response_code) CALL_READ_ONLY_DEFERRED(chain, ro_api, chain_apis::read_only, call_name, to_json, "application/json", http_response_code)
+#define CHAIN_RO_CALL_POOL_BINARY(call_name, http_response_code) CALL_READ_ONLY_DEFERRED(chain, ro_api, chain_apis::read_only, call_name, to_binary, "application/octet-stream", http_response_code)
 #define CHAIN_RW_CALL(call_name, http_response_code) CALL(chain, rw_api, chain_apis::read_write, call_name, http_response_code)
 #define CHAIN_RO_CALL_ASYNC(call_name, call_result, http_response_code) CALL_ASYNC(chain, ro_api, chain_apis::read_only, call_name, call_result, http_response_code)
 #define CHAIN_RW_CALL_ASYNC(call_name, call_result, http_response_code) CALL_ASYNC(chain, rw_api, chain_apis::read_write, call_name, call_result, http_response_code)
 
 void chain_api_plugin::plugin_startup() {
    ilog( "starting chain_api_plugin" );
-   my.reset(new chain_api_plugin_impl(app().get_plugin<chain_plugin>().chain()));
-   auto ro_api = app().get_plugin<chain_plugin>().get_read_only_api();
-   auto rw_api = app().get_plugin<chain_plugin>().get_read_write_api();
+   auto& chain_plug = app().get_plugin<chain_plugin>();
+   my.reset(new chain_api_plugin_impl(chain_plug.chain()));
+   auto ro_api = chain_plug.get_read_only_api();
+   auto rw_api = chain_plug.get_read_write_api();
 
    auto& _http_plugin = app().get_plugin<http_plugin>();
    ro_api.set_shorten_abi_errors( !_http_plugin.verbose_errors() );
 
+   _http_plugin.add_deferred_api({
+      // block_log reads are not thread safe, always run on the main thread
+      CHAIN_RO_CALL_DEFERRED(get_block, 200),
+      CHAIN_RO_CALL_POOL_DEFERRED(get_table_rows, 200),
+      CHAIN_RO_CALL_POOL_BINARY(get_table_rows_binary, 200)
+   });
+
    _http_plugin.add_api({
-      CHAIN_RO_CALL(get_info, 200l),
-      CHAIN_RO_CALL(get_activated_protocol_features, 200),
-      CHAIN_RO_CALL(get_block, 200),
+      CHAIN_RO_CALL_POOL(get_info, 200l),
+      CHAIN_RO_CALL_POOL(get_activated_protocol_features, 200),
+      // fork database lookups are not thread safe, always run on the main thread
       CHAIN_RO_CALL(get_block_header_state, 200),
-      CHAIN_RO_CALL(get_account, 200),
-      CHAIN_RO_CALL(get_code, 200),
-      CHAIN_RO_CALL(get_code_hash, 200),
-      CHAIN_RO_CALL(get_abi, 200),
-      CHAIN_RO_CALL(get_raw_code_and_abi, 200),
-      CHAIN_RO_CALL(get_raw_abi, 200),
-      CHAIN_RO_CALL(get_table_rows, 200),
-      CHAIN_RO_CALL(get_table_by_scope, 200),
-      CHAIN_RO_CALL(get_currency_balance, 200),
-      CHAIN_RO_CALL(get_currency_stats, 200),
-      CHAIN_RO_CALL(get_producers, 200),
-      CHAIN_RO_CALL(get_voters, 200),
-      CHAIN_RO_CALL(get_producer_schedule, 200),
-      CHAIN_RO_CALL(get_scheduled_transactions, 200),
-      CHAIN_RO_CALL(abi_json_to_bin, 200),
-      CHAIN_RO_CALL(abi_bin_to_json, 200),
-      CHAIN_RO_CALL(get_required_keys, 200),
-      CHAIN_RO_CALL(get_transaction_id, 200),
+      // the wasm interface is only used from the main thread
+      CHAIN_RO_CALL(get_wasm_cache_stats, 200),
+      CHAIN_RO_CALL_POOL(get_account, 200),
+      CHAIN_RO_CALL_POOL(get_code, 200),
+      CHAIN_RO_CALL_POOL(get_code_hash, 200),
+      CHAIN_RO_CALL_POOL(get_abi, 200),
+      CHAIN_RO_CALL_POOL(get_raw_code_and_abi, 200),
+      CHAIN_RO_CALL_POOL(get_raw_abi, 200),
+      CHAIN_RO_CALL_POOL(get_table_by_scope, 200),
+      CHAIN_RO_CALL_POOL(get_currency_balance, 200),
+      CHAIN_RO_CALL_POOL(get_currency_stats, 200),
+      CHAIN_RO_CALL_POOL(get_producers, 200),
+      CHAIN_RO_CALL_POOL(get_voters, 200),
+      CHAIN_RO_CALL_POOL(get_producer_schedule, 200),
+      CHAIN_RO_CALL_POOL(get_scheduled_transactions, 200),
+      CHAIN_RO_CALL_POOL(abi_json_to_bin, 200),
+      CHAIN_RO_CALL_POOL(abi_bin_to_json, 200),
+      CHAIN_RO_CALL_POOL(get_required_keys, 200),
+      CHAIN_RO_CALL_POOL(get_transaction_id, 200),
       CHAIN_RW_CALL_ASYNC(push_block, chain_apis::read_write::push_block_results, 202),
       CHAIN_RW_CALL_ASYNC(push_transaction, chain_apis::read_write::push_transaction_results, 202),
       CHAIN_RW_CALL_ASYNC(push_transactions, chain_apis::read_write::push_transactions_results, 202),
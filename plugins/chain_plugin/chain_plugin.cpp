@@ -12,6 +12,7 @@
 #include <eosio/chain/generated_transaction_object.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/snapshot.hpp>
+#include <eosio/chain/thread_utils.hpp>
 
 #include <eosio/chain/eosio_contract.hpp>
 
@@ -25,6 +26,10 @@
 #include <fc/variant.hpp>
 #include <signal.h>
 #include <cstdlib>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
 
 // reflect chainbase::environment for --print-build-info option
 FC_REFLECT_ENUM( chainbase::environment::os_t,
@@ -179,6 +184,66 @@ public:
    fc::optional<scoped_connection>                                   accepted_transaction_connection;
    fc::optional<scoped_connection>                                   applied_transaction_connection;
 
+   // read-only api execution, see post_read_only()
+   uint16_t                                                          read_only_threads = 0;
+   fc::microseconds                                                  read_only_window_time;
+   fc::optional<named_thread_pool>                                   read_only_thread_pool;
+   std::mutex                                                        read_only_mtx;
+   std::deque<std::function<void()>>                                 read_only_queue;
+   bool                                                              read_only_window_scheduled = false;
+
+   void queue_read_only( std::function<void()> task ) {
+      std::lock_guard<std::mutex> g( read_only_mtx );
+      read_only_queue.emplace_back( std::move( task ) );
+      if( !read_only_window_scheduled ) {
+         read_only_window_scheduled = true;
+         app().post( priority::low, [this]() { execute_read_only_window(); } );
+      }
+   }
+
+   bool pop_read_only( std::function<void()>& task ) {
+      std::lock_guard<std::mutex> g( read_only_mtx );
+      if( read_only_queue.empty() ) return false;
+      task = std::move( read_only_queue.front() );
+      read_only_queue.pop_front();
+      return true;
+   }
+
+   // Runs on the main thread. While this executes the main thread is blocked, so no block or transaction can modify
+   // chainbase; queued read-only calls run concurrently on read_only_thread_pool against that consistent state until
+   // the queue is drained or read_only_window_time expires. Any remaining calls are left for the next window, which is
+   // posted at low priority so that block application interleaves with read windows.
+   void execute_read_only_window() {
+      if( !read_only_thread_pool ) return; // shutting down
+      const auto deadline = fc::time_point::now() + read_only_window_time;
+      std::mutex mtx;
+      std::condition_variable cv;
+      size_t running = read_only_threads;
+      for( size_t i = 0; i < read_only_threads; ++i ) {
+         boost::asio::post( read_only_thread_pool->get_executor(), [this, deadline, &mtx, &cv, &running]() {
+            std::function<void()> task;
+            while( fc::time_point::now() < deadline && pop_read_only( task ) ) {
+               try {
+                  task();
+               } FC_LOG_AND_DROP()
+            }
+            std::lock_guard<std::mutex> g( mtx );
+            if( --running == 0 )
+               cv.notify_one();
+         } );
+      }
+      {
+         std::unique_lock<std::mutex> g( mtx );
+         cv.wait( g, [&running]() { return running == 0; } );
+      }
+
+      std::lock_guard<std::mutex> g( read_only_mtx );
+      if( read_only_queue.empty() ) {
+         read_only_window_scheduled = false;
+      } else {
+         app().post( priority::low, [this]() { execute_read_only_window(); } );
+      }
+   }
 };
 
 chain_plugin::chain_plugin()
@@ -195,6 +260,9 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
    cfg.add_options()
          ("blocks-dir", bpo::value<bfs::path>()->default_value("blocks"),
           "the location of the blocks directory (absolute path or relative to application data dir)")
+         ("blocks-log-pack-size", bpo::value<uint32_t>()->default_value(0),
+          "Number of irreversible blocks per zlib compressed pack moved from blocks.log into blocks.packs, "
+          "blocks.log then keeps only the most recent blocks. 0 disables packing")
          ("protocol-features-dir", bpo::value<bfs::path>()->default_value("protocol_features"),
           "the location of the protocol_features directory (absolute path or relative to application config dir)")
          ("checkpoint", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
@@ -207,6 +275,8 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
             }
 #endif
          }), "Override default WASM runtime")
+         ("wasm-instantiation-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_wasm_instantiation_cache_size / (1024  * 1024)),
+          "Maximum size (in MiB) of the instantiated contracts kept by the WASM runtime, the least executed are released first. 0 for unbounded")
          ("abi-serializer-max-time-ms", bpo::value<uint32_t>()->default_value(config::default_abi_serializer_max_time_ms),
           "Override default maximum ABI serialization time allowed in ms")
          ("chain-state-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024  * 1024)), "Maximum size (in MiB) of the chain state database")
@@ -217,6 +287,13 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "Percentage of actual signature recovery cpu to bill. Whole number percentages, e.g. 50 for 50%")
          ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
           "Number of worker threads in controller thread pool")
+         ("replay-look-ahead-blocks", bpo::value<uint32_t>()->default_value(256),
+          "Number of blocks read and prepared on the controller thread pool ahead of the block applied when replaying the block log")
+         ("read-only-api-threads", bpo::value<uint16_t>()->default_value(0),
+          "Number of worker threads used to execute read-only chain API calls concurrently between block applications. "
+          "0 executes them on the main application thread")
+         ("read-only-api-window-time-us", bpo::value<uint32_t>()->default_value(60000),
+          "Time in microseconds the main thread yields to read-only chain API calls before resuming block processing")
          ("contracts-console", bpo::bool_switch()->default_value(false),
           "print contract's output to console")
          ("actor-whitelist", boost::program_options::value<vector<string>>()->composing()->multitoken(),
@@ -272,6 +349,9 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
                }
          }), "Number of threads to use for EOS VM OC tier-up")
          ("eos-vm-oc-enable", bpo::bool_switch(), "Enable EOS VM OC tier-up runtime")
+         ("eos-vm-oc-precompile-account", bpo::value<vector<string>>()->composing()->multitoken()
+            ->default_value({"rem", "rem.token", "rem.swap", "rem.oracle", "rem.auth", "rem.attr"}, "rem rem.token rem.swap rem.oracle rem.auth rem.attr"),
+          "Account whose contract EOS VM OC tier-up compiles at startup and whenever its code is set, before its first execution (may specify multiple times)")
 #endif
          ;
 
@@ -695,6 +775,7 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          my->abi_serializer_max_time_ms = fc::microseconds(options.at("abi-serializer-max-time-ms").as<uint32_t>() * 1000);
 
       my->chain_config->blocks_dir = my->blocks_dir;
+      my->chain_config->blocks_log_pack_size = options.at( "blocks-log-pack-size" ).as<uint32_t>();
       my->chain_config->state_dir = app().data_dir() / config::default_state_dir_name;
       my->chain_config->read_only = my->readonly;
 
@@ -717,6 +798,15 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
                      "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size) );
       }
 
+      my->chain_config->replay_look_ahead_blocks = options.at( "replay-look-ahead-blocks" ).as<uint32_t>();
+      EOS_ASSERT( my->chain_config->replay_look_ahead_blocks > 0, plugin_config_exception,
+                  "replay-look-ahead-blocks ${num} must be greater than 0", ("num", my->chain_config->replay_look_ahead_blocks) );
+
+      my->read_only_threads = options.at( "read-only-api-threads" ).as<uint16_t>();
+      my->read_only_window_time = fc::microseconds( options.at( "read-only-api-window-time-us" ).as<uint32_t>() );
+      EOS_ASSERT( my->read_only_threads == 0 || my->read_only_window_time > fc::microseconds(0), plugin_config_exception,
+                  "read-only-api-window-time-us must be greater than 0 when read-only-api-threads is set" );
+
       my->chain_config->sig_cpu_bill_pct = options.at("signature-cpu-billable-pct").as<uint32_t>();
       EOS_ASSERT( my->chain_config->sig_cpu_bill_pct >= 0 && my->chain_config->sig_cpu_bill_pct <= 100, plugin_config_exception,
                   "signature-cpu-billable-pct must be 0 - 100, ${pct}", ("pct", my->chain_config->sig_cpu_bill_pct) );
@@ -724,6 +814,7 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 
       if( my->wasm_runtime )
          my->chain_config->wasm_runtime = *my->wasm_runtime;
+      my->chain_config->wasm_instantiation_cache_size = options.at( "wasm-instantiation-cache-size-mb" ).as<uint64_t>() * 1024 * 1024;
 
       my->chain_config->force_all_checks = options.at( "force-all-checks" ).as<bool>();
       my->chain_config->disable_replay_opts = options.at( "disable-replay-opts" ).as<bool>();
@@ -1009,6 +1100,9 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
          my->chain_config->eosvmoc_config.threads = options.at("eos-vm-oc-compile-threads").as<uint64_t>();
       if( options["eos-vm-oc-enable"].as<bool>() )
          my->chain_config->eosvmoc_tierup = true;
+      if( options.count("eos-vm-oc-precompile-account") )
+         for( const auto& a : options.at("eos-vm-oc-precompile-account").as<vector<string>>() )
+            my->chain_config->eosvmoc_config.precompile_accounts.emplace_back( a );
 #endif
 
       my->chain.emplace( *my->chain_config, std::move(pfs), *chain_id );
@@ -1108,6 +1202,11 @@ void chain_plugin::plugin_startup()
       ilog("Blockchain started; head block is #${num}", ("num", my->chain->head_block_num()));
    }
 
+   if( my->read_only_threads > 0 ) {
+      ilog( "executing read-only chain API calls on ${n} threads", ("n", my->read_only_threads) );
+      my->read_only_thread_pool.emplace( "roapi", my->read_only_threads );
+   }
+
    my->chain_config.reset();
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -1118,6 +1217,10 @@ void chain_plugin::plugin_shutdown() {
    my->irreversible_block_connection.reset();
    my->accepted_transaction_connection.reset();
    my->applied_transaction_connection.reset();
+   if( my->read_only_thread_pool ) {
+      my->read_only_thread_pool->stop();
+      my->read_only_thread_pool.reset();
+   }
    if(app().is_quiting())
       my->chain->get_wasm_interface().indicate_shutting_down();
    my->chain.reset();
@@ -1133,6 +1236,14 @@ void chain_apis::read_write::validate() const {
    EOS_ASSERT( db.get_read_mode() != chain::db_read_mode::READ_ONLY, missing_chain_api_plugin_exception, "Not allowed, node in read-only mode" );
 }
 
+void chain_plugin::post_read_only( std::function<void()> task ) {
+   if( my->read_only_thread_pool ) {
+      my->queue_read_only( std::move( task ) );
+   } else {
+      task();
+   }
+}
+
 bool chain_plugin::accept_block(const signed_block_ptr& block, const block_id_type& id ) {
    return my->incoming_block_sync_method(block, id);
 }
@@ -1435,6 +1546,10 @@ read_only::get_info_results read_only::get_info(const read_only::get_info_params
    };
 }
 
+read_only::get_wasm_cache_stats_results read_only::get_wasm_cache_stats(const read_only::get_wasm_cache_stats_params&) const {
+   return db.get_wasm_interface().get_instantiation_cache_stats();
+}
+
 read_only::get_activated_protocol_features_results
 read_only::get_activated_protocol_features( const read_only::get_activated_protocol_features_params& params )const {
    read_only::get_activated_protocol_features_results result;
@@ -1628,12 +1743,9 @@ string convert_to_string(const float128_t& source, const string& key_type, const
    } FC_RETHROW_EXCEPTIONS(warn, "Could not convert ${desc} from '${source}' to string.", ("desc", desc)("source",source) )
 }
 
-abi_def get_abi( const controller& db, const name& account ) {
-   const auto &d = db.db();
-   const account_object *code_accnt = d.find<account_object, by_name>(account);
-   EOS_ASSERT(code_accnt != nullptr, chain::account_query_exception, "Fail to retrieve account for ${account}", ("account", account) );
-   abi_def abi;
-   abi_serializer::to_abi(code_accnt->abi, abi);
+abi_serializer_cache::entry_ptr get_abi( const controller& db, const name& account, const fc::microseconds& abi_serializer_max_time ) {
+   auto abi = db.get_cached_abi( account, abi_serializer_max_time );
+   EOS_ASSERT(abi != nullptr, chain::account_query_exception, "Fail to retrieve account for ${account}", ("account", account) );
    return abi;
 }
 
@@ -1646,8 +1758,9 @@ string get_table_type( const abi_def& abi, const name& table_name ) {
    EOS_ASSERT( false, chain::contract_table_query_exception, "Table ${table} is not specified in the ABI", ("table",table_name) );
 }
 
-read_only::get_table_rows_result read_only::get_table_rows( const read_only::get_table_rows_params& p )const {
-   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
+read_only::get_table_rows_raw_result read_only::get_table_rows_raw( const read_only::get_table_rows_params& p )const {
+   const auto cached_abi = eosio::chain_apis::get_abi( db, p.code, abi_serializer_max_time );
+   const abi_def& abi = cached_abi->abi;
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wstrict-aliasing"
    bool primary = false;
@@ -1656,43 +1769,43 @@ read_only::get_table_rows_result read_only::get_table_rows( const read_only::get
       EOS_ASSERT( p.table == table_with_index, chain::contract_table_query_exception, "Invalid table name ${t}", ( "t", p.table ));
       auto table_type = get_table_type( abi, p.table );
       if( table_type == KEYi64 || p.key_type == "i64" || p.key_type == "name" ) {
-         return get_table_rows_ex<key_value_index>(p,abi);
+         return get_table_rows_ex<key_value_index>(p,cached_abi);
       }
       EOS_ASSERT( false, chain::contract_table_query_exception,  "Invalid table type ${type}", ("type",table_type)("abi",abi));
    } else {
       EOS_ASSERT( !p.key_type.empty(), chain::contract_table_query_exception, "key type required for non-primary index" );
 
       if (p.key_type == chain_apis::i64 || p.key_type == "name") {
-         return get_table_rows_by_seckey<index64_index, uint64_t>(p, abi, [](uint64_t v)->uint64_t {
+         return get_table_rows_by_seckey<index64_index, uint64_t>(p, cached_abi, [](uint64_t v)->uint64_t {
             return v;
          });
       }
       else if (p.key_type == chain_apis::i128) {
-         return get_table_rows_by_seckey<index128_index, uint128_t>(p, abi, [](uint128_t v)->uint128_t {
+         return get_table_rows_by_seckey<index128_index, uint128_t>(p, cached_abi, [](uint128_t v)->uint128_t {
             return v;
          });
       }
       else if (p.key_type == chain_apis::i256) {
          if ( p.encode_type == chain_apis::hex) {
             using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+            return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, cached_abi, conv::function());
          }
          using  conv = keytype_converter<chain_apis::i256>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, cached_abi, conv::function());
       }
       else if (p.key_type == chain_apis::float64) {
-         return get_table_rows_by_seckey<index_double_index, double>(p, abi, [](double v)->float64_t {
+         return get_table_rows_by_seckey<index_double_index, double>(p, cached_abi, [](double v)->float64_t {
             float64_t f = *(float64_t *)&v;
             return f;
          });
       }
       else if (p.key_type == chain_apis::float128) {
          if ( p.encode_type == chain_apis::hex) {
-            return get_table_rows_by_seckey<index_long_double_index, uint128_t>(p, abi, [](uint128_t v)->float128_t{
+            return get_table_rows_by_seckey<index_long_double_index, uint128_t>(p, cached_abi, [](uint128_t v)->float128_t{
                return *reinterpret_cast<float128_t *>(&v);
             });
          }
-         return get_table_rows_by_seckey<index_long_double_index, double>(p, abi, [](double v)->float128_t{
+         return get_table_rows_by_seckey<index_long_double_index, double>(p, cached_abi, [](double v)->float128_t{
             float64_t f = *(float64_t *)&v;
             float128_t f128;
             f64_to_f128M(f, &f128);
@@ -1701,17 +1814,128 @@ read_only::get_table_rows_result read_only::get_table_rows( const read_only::get
       }
       else if (p.key_type == chain_apis::sha256) {
          using  conv = keytype_converter<chain_apis::sha256,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, cached_abi, conv::function());
       }
       else if(p.key_type == chain_apis::ripemd160) {
          using  conv = keytype_converter<chain_apis::ripemd160,chain_apis::hex>;
-         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, abi, conv::function());
+         return get_table_rows_by_seckey<conv::index_type, conv::input_type>(p, cached_abi, conv::function());
       }
       EOS_ASSERT(false, chain::contract_table_query_exception,  "Unsupported secondary index type: ${t}", ("t", p.key_type));
    }
 #pragma GCC diagnostic pop
 }
 
+size_t read_only::get_table_rows_raw_result::estimated_size()const {
+   size_t size = next_key.size();
+   for( const auto& r : rows ) {
+      size += r.data.size() + sizeof(r);
+   }
+   return size;
+}
+
+static fc::variant table_row_to_variant( const read_only::get_table_rows_params& p, const read_only::get_table_rows_raw_result& raw,
+                                         const read_only::get_table_rows_raw_result::row& r,
+                                         const fc::microseconds& abi_serializer_max_time, bool shorten_abi_errors ) {
+   fc::variant data_var;
+   if( p.json ) {
+      const abi_serializer& abis = raw.abi->serializer;
+      data_var = abis.binary_to_variant( abis.get_table_type(p.table), r.data, abi_serializer_max_time, shorten_abi_errors );
+   } else {
+      data_var = fc::variant( r.data );
+   }
+
+   if( p.show_payer && *p.show_payer ) {
+      return fc::mutable_variant_object("data", std::move(data_var))("payer", r.payer);
+   }
+   return data_var;
+}
+
+read_only::get_table_rows_result read_only::get_table_rows( const read_only::get_table_rows_params& p )const {
+   const auto raw = get_table_rows_raw( p );
+
+   read_only::get_table_rows_result result;
+   result.rows.reserve( raw.rows.size() );
+   for( const auto& r : raw.rows ) {
+      result.rows.emplace_back( table_row_to_variant( p, raw, r, abi_serializer_max_time, shorten_abi_errors ) );
+   }
+   result.more = raw.more;
+   result.next_key = raw.next_key;
+   return result;
+}
+
+string read_only::to_json( const read_only::get_table_rows_params& p, const read_only::get_table_rows_raw_result& raw, const fc::time_point& deadline )const {
+   // same layout as fc::json::to_string of get_table_rows_result, only a single row is held as a variant at a time
+   string json = "{\"rows\":[";
+   json.reserve( raw.estimated_size() * 2 );
+   for( size_t i = 0; i < raw.rows.size(); ++i ) {
+      if( i > 0 ) json += ',';
+      json += fc::json::to_string( table_row_to_variant( p, raw, raw.rows[i], abi_serializer_max_time, shorten_abi_errors ), deadline );
+   }
+   json += "],\"more\":";
+   json += raw.more ? "true" : "false";
+   json += ",\"next_key\":";
+   json += fc::json::to_string( fc::variant( raw.next_key ), deadline );
+   json += '}';
+   return json;
+}
+
+read_only::get_table_rows_binary_raw_result read_only::get_table_rows_binary_raw( const read_only::get_table_rows_binary_params& p )const {
+   auto raw = get_table_rows_raw( p );
+   if( !p.fields.empty() ) {
+      const abi_serializer& abis = raw.abi->serializer;
+      auto table_type = abis.get_table_type( p.table );
+      EOS_ASSERT( !table_type.empty(), chain::contract_table_query_exception,
+                  "Table ${table} is not specified in the ABI", ("table", p.table) );
+      std::set<string> known_fields;
+      for( auto type = table_type; !type.empty(); ) {
+         const auto& st = abis.get_struct( type );
+         for( const auto& f : st.fields ) known_fields.insert( f.name );
+         type = st.base;
+      }
+      for( const auto& f : p.fields ) {
+         EOS_ASSERT( known_fields.count( f ), chain::contract_table_query_exception,
+                     "Field ${f} is not part of table ${table}", ("f", f)("table", p.table) );
+      }
+   }
+   return raw;
+}
+
+string read_only::to_binary( const read_only::get_table_rows_binary_params& p, const read_only::get_table_rows_binary_raw_result& raw,
+                             const fc::time_point& deadline )const {
+   get_table_rows_binary_result result;
+   result.more = raw.more;
+   result.next_key = raw.next_key;
+   result.rows.reserve( raw.rows.size() );
+
+   string table_type;
+   if( !p.fields.empty() ) table_type = raw.abi->serializer.get_table_type( p.table );
+   const std::set<string> fields( p.fields.begin(), p.fields.end() );
+
+   for( const auto& r : raw.rows ) {
+      EOS_ASSERT( fc::time_point::now() < deadline, chain::contract_table_query_exception, "Deadline exceeded while encoding table rows" );
+      result.rows.emplace_back();
+      auto& row = result.rows.back();
+      row.primary_key = r.primary_key;
+      row.secondary_key = r.secondary_key;
+      row.payer = r.payer;
+      if( fields.empty() ) {
+         row.data = r.data;
+         continue;
+      }
+      auto ranges = raw.abi->serializer.get_field_ranges( table_type, r.data.data(), r.data.size(), abi_serializer_max_time );
+      for( const auto& range : ranges ) {
+         if( fields.count( range.name ) ) {
+            row.data.insert( row.data.end(), r.data.begin() + range.begin, r.data.begin() + range.end );
+         }
+      }
+   }
+
+   string bin( fc::raw::pack_size( result ), '\0' );
+   fc::datastream<char*> ds( bin.data(), bin.size() );
+   fc::raw::pack( ds, result );
+   return bin;
+}
+
 read_only::get_table_by_scope_result read_only::get_table_by_scope( const read_only::get_table_by_scope_params& p )const {
    read_only::get_table_by_scope_result result;
    const auto& d = db.db();
@@ -1762,8 +1986,7 @@ read_only::get_table_by_scope_result read_only::get_table_by_scope( const read_o
 
 vector<asset> read_only::get_currency_balance( const read_only::get_currency_balance_params& p )const {
 
-   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
-   (void)get_table_type( abi, name("accounts") );
+   (void)get_table_type( eosio::chain_apis::get_abi( db, p.code, abi_serializer_max_time )->abi, name("accounts") );
 
    vector<asset> results;
    walk_key_value_table(p.code, p.account, N(accounts), [&](const key_value_object& obj){
@@ -1789,8 +2012,7 @@ vector<asset> read_only::get_currency_balance( const read_only::get_currency_bal
 fc::variant read_only::get_currency_stats( const read_only::get_currency_stats_params& p )const {
    fc::mutable_variant_object results;
 
-   const abi_def abi = eosio::chain_apis::get_abi( db, p.code );
-   (void)get_table_type( abi, name("stat") );
+   (void)get_table_type( eosio::chain_apis::get_abi( db, p.code, abi_serializer_max_time )->abi, name("stat") );
 
    uint64_t scope = ( eosio::chain::string_to_symbol( 0, boost::algorithm::to_upper_copy(p.symbol).c_str() ) >> 8 );
 
@@ -1828,9 +2050,10 @@ fc::variant get_global_row( const database& db, const abi_def& abi, const abi_se
 }
 
 read_only::get_producers_result read_only::get_producers( const read_only::get_producers_params& p ) const try {
-   const abi_def abi = eosio::chain_apis::get_abi(db, config::system_account_name);
+   const auto cached_abi = eosio::chain_apis::get_abi(db, config::system_account_name, abi_serializer_max_time);
+   const abi_def& abi = cached_abi->abi;
    const auto table_type = get_table_type(abi, N(producers));
-   const abi_serializer abis{ abi, abi_serializer_max_time };
+   const abi_serializer& abis = cached_abi->serializer;
    EOS_ASSERT(table_type == KEYi64, chain::contract_table_query_exception, "Invalid table type ${type} for table producers", ("type",table_type));
 
    const auto& d = db.db();
@@ -1903,10 +2126,11 @@ read_only::get_producers_result read_only::get_producers( const read_only::get_p
 read_only::get_voters_result read_only::get_voters( const read_only::get_voters_params& p ) const {
    get_voters_result result;
    try{
-      const abi_def abi = eosio::chain_apis::get_abi(db, config::system_account_name);
+      const auto cached_abi = eosio::chain_apis::get_abi(db, config::system_account_name, abi_serializer_max_time);
+      const abi_def& abi = cached_abi->abi;
 
       const auto table_type = get_table_type(abi, N(voters));
-      const abi_serializer abis{ abi, abi_serializer_max_time };
+      const abi_serializer& abis = cached_abi->serializer;
       EOS_ASSERT(table_type == KEYi64, chain::contract_table_query_exception, "Invalid table type ${type} for table voters", ("type",table_type));
 
       const auto& d = db.db();
@@ -1956,16 +2180,13 @@ read_only::get_producer_schedule_result read_only::get_producer_schedule( const
 template<typename Api>
 struct resolver_factory {
    static auto make(const Api* api, const fc::microseconds& max_serialization_time) {
-      return [api, max_serialization_time](const account_name &name) -> optional<abi_serializer> {
+      return [api, max_serialization_time](const account_name &name) -> abi_serializer_cache::serializer_ptr {
          const auto* accnt = api->db.db().template find<account_object, by_name>(name);
-         if (accnt != nullptr) {
-            abi_def abi;
-            if (abi_serializer::to_abi(accnt->abi, abi)) {
-               return abi_serializer(abi, max_serialization_time);
-            }
+         if (accnt != nullptr && !abi_serializer::is_empty_abi(accnt->abi)) {
+            return abi_serializer_cache::get_serializer(api->db.get_cached_abi(name, max_serialization_time));
          }
 
-         return optional<abi_serializer>();
+         return abi_serializer_cache::serializer_ptr();
       };
    }
 };
@@ -2049,7 +2270,7 @@ read_only::get_scheduled_transactions( const read_only::get_scheduled_transactio
    return result;
 }
 
-fc::variant read_only::get_block(const read_only::get_block_params& params) const {
+read_only::get_block_raw_result read_only::get_block_raw(const read_only::get_block_params& params) const {
    signed_block_ptr block;
    optional<uint64_t> block_num;
 
@@ -2072,17 +2293,59 @@ fc::variant read_only::get_block(const read_only::get_block_params& params) cons
 
    EOS_ASSERT( block, unknown_block_exception, "Could not find block: ${block}", ("block", params.block_num_or_id));
 
+   get_block_raw_result result;
+   auto resolve = [&]( const vector<action>& actions ) {
+      for( const auto& a : actions ) {
+         if( result.abis.count( a.account ) ) continue;
+         auto abi = db.get_cached_abi( a.account, abi_serializer_max_time );
+         if( abi && !abi->abi.version.empty() )
+            result.abis.emplace( a.account, std::move( abi ) );
+         else
+            result.abis.emplace( a.account, nullptr );
+      }
+   };
+   for( const auto& receipt : block->transactions ) {
+      if( receipt.trx.contains<packed_transaction>() ) {
+         const auto& trx = receipt.trx.get<packed_transaction>().get_transaction();
+         resolve( trx.context_free_actions );
+         resolve( trx.actions );
+      }
+   }
+   result.block = std::move( block );
+   return result;
+}
+
+size_t read_only::get_block_raw_result::estimated_size()const {
+   return fc::raw::pack_size( *block );
+}
+
+static fc::variant block_to_variant( const read_only::get_block_raw_result& raw, const fc::microseconds& abi_serializer_max_time ) {
+   auto resolver = [&raw]( const account_name& name ) -> optional<abi_serializer> {
+      auto itr = raw.abis.find( name );
+      if( itr != raw.abis.end() && itr->second )
+         return itr->second->serializer;
+      return optional<abi_serializer>();
+   };
+
    fc::variant pretty_output;
-   abi_serializer::to_variant(*block, pretty_output, make_resolver(this, abi_serializer_max_time), abi_serializer_max_time);
+   abi_serializer::to_variant(*raw.block, pretty_output, resolver, abi_serializer_max_time);
 
-   uint32_t ref_block_prefix = block->id()._hash[1];
+   uint32_t ref_block_prefix = raw.block->id()._hash[1];
 
    return fc::mutable_variant_object(pretty_output.get_object())
-           ("id", block->id())
-           ("block_num",block->block_num())
+           ("id", raw.block->id())
+           ("block_num", raw.block->block_num())
            ("ref_block_prefix", ref_block_prefix);
 }
 
+fc::variant read_only::get_block(const read_only::get_block_params& params) const {
+   return block_to_variant( get_block_raw( params ), abi_serializer_max_time );
+}
+
+string read_only::to_json(const read_only::get_block_params& params, const read_only::get_block_raw_result& raw, const fc::time_point& deadline) const {
+   return fc::json::to_string( block_to_variant( raw, abi_serializer_max_time ), deadline );
+}
+
 fc::variant read_only::get_block_header_state(const get_block_header_state_params& params) const {
    block_state_ptr b;
    optional<uint64_t> block_num;
@@ -2397,9 +2660,9 @@ read_only::get_account_results read_only::get_account( const get_account_params&
 
    const auto& code_account = db.db().get<account_object,by_name>( config::system_account_name );
 
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account.abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer_max_time );
+   if( !abi_serializer::is_empty_abi(code_account.abi) ) {
+      const auto cached_abi = db.get_cached_abi( config::system_account_name, abi_serializer_max_time );
+      const abi_serializer& abis = cached_abi->serializer;
 
       const auto token_code = N(rem.token);
 
@@ -2494,9 +2757,10 @@ read_only::abi_json_to_bin_result read_only::abi_json_to_bin( const read_only::a
    const auto code_account = db.db().find<account_object,by_name>( params.code );
    EOS_ASSERT(code_account != nullptr, contract_query_exception, "Contract can't be found ${contract}", ("contract", params.code));
 
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account->abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer_max_time );
+   if( !abi_serializer::is_empty_abi(code_account->abi) ) {
+      const auto cached_abi = db.get_cached_abi( params.code, abi_serializer_max_time );
+      const abi_def& abi = cached_abi->abi;
+      const abi_serializer& abis = cached_abi->serializer;
       auto action_type = abis.get_action_type(params.action);
       EOS_ASSERT(!action_type.empty(), action_validate_exception, "Unknown action ${action} in contract ${contract}", ("action", params.action)("contract", params.code));
       try {
@@ -2514,9 +2778,9 @@ read_only::abi_json_to_bin_result read_only::abi_json_to_bin( const read_only::a
 read_only::abi_bin_to_json_result read_only::abi_bin_to_json( const read_only::abi_bin_to_json_params& params )const {
    abi_bin_to_json_result result;
    const auto& code_account = db.db().get<account_object,by_name>( params.code );
-   abi_def abi;
-   if( abi_serializer::to_abi(code_account.abi, abi) ) {
-      abi_serializer abis( abi, abi_serializer_max_time );
+   if( !abi_serializer::is_empty_abi(code_account.abi) ) {
+      const auto cached_abi = db.get_cached_abi( params.code, abi_serializer_max_time );
+      const abi_serializer& abis = cached_abi->serializer;
       result.args = abis.binary_to_variant( abis.get_action_type( params.action ), params.binargs, abi_serializer_max_time, shorten_abi_errors );
    } else {
       EOS_ASSERT(false, abi_not_found_exception, "No ABI found for ${contract}", ("contract", params.code));
@@ -117,6 +117,10 @@ public:
    };
    get_info_results get_info(const get_info_params&) const;
 
+   using get_wasm_cache_stats_params = empty;
+   using get_wasm_cache_stats_results = chain::wasm_interface::instantiation_cache_stats;
+   get_wasm_cache_stats_results get_wasm_cache_stats(const get_wasm_cache_stats_params&) const;
+
    struct get_activated_protocol_features_params {
       optional<uint32_t>  lower_bound;
       optional<uint32_t>  upper_bound;
@@ -280,6 +284,18 @@ public:
 
    fc::variant get_block(const get_block_params& params) const;
 
+   /// block and the abis of its actions, resolved so that it can be converted to JSON without access to chain state
+   struct get_block_raw_result {
+      chain::signed_block_ptr                                       block;
+      chain::flat_map<account_name, chain::abi_serializer_cache::entry_ptr> abis;
+
+      size_t estimated_size()const;
+   };
+
+   get_block_raw_result get_block_raw(const get_block_params& params) const;
+   /// may be called from any thread
+   string to_json(const get_block_params& params, const get_block_raw_result& raw, const fc::time_point& deadline) const;
+
    struct get_block_header_state_params {
       string block_num_or_id;
    };
@@ -310,6 +326,52 @@ public:
 
    get_table_rows_result get_table_rows( const get_table_rows_params& params )const;
 
+   /// rows as stored in chainbase, converted to the requested format only when encoded
+   struct get_table_rows_raw_result {
+      struct row {
+         vector<char>   data;
+         name           payer;
+         uint64_t       primary_key = 0;
+         vector<char>   secondary_key; ///< in-memory (little endian) representation of the secondary key, empty for primary index queries
+      };
+
+      chain::abi_serializer_cache::entry_ptr abi;
+      vector<row>                            rows;
+      bool                                   more = false;
+      string                                 next_key;
+
+      size_t estimated_size()const;
+   };
+
+   get_table_rows_raw_result get_table_rows_raw( const get_table_rows_params& params )const;
+   /// encodes the rows one at a time without building the complete result as an fc::variant; may be called from any thread
+   string to_json( const get_table_rows_params& params, const get_table_rows_raw_result& raw, const fc::time_point& deadline )const;
+
+   /// same row selection as get_table_rows, `json` and `show_payer` are ignored
+   struct get_table_rows_binary_params : get_table_rows_params {
+      vector<string>  fields; ///< top level fields of the table struct to return, all of the row data if empty
+   };
+
+   /// response of get_table_rows_binary, returned fc::raw packed (application/octet-stream) rather than as JSON
+   struct get_table_rows_binary_result {
+      struct row {
+         uint64_t       primary_key = 0;
+         vector<char>   secondary_key;
+         name           payer;
+         vector<char>   data; ///< packed row, or the concatenation of the requested fields in struct order
+      };
+
+      vector<row>   rows;
+      bool          more = false;
+      string        next_key;
+   };
+
+   using get_table_rows_binary_raw_result = get_table_rows_raw_result;
+
+   get_table_rows_binary_raw_result get_table_rows_binary_raw( const get_table_rows_binary_params& params )const;
+   /// projects and packs the rows into a get_table_rows_binary_result; may be called from any thread
+   string to_binary( const get_table_rows_binary_params& params, const get_table_rows_binary_raw_result& raw, const fc::time_point& deadline )const;
+
    struct get_table_by_scope_params {
       name        code; // mandatory
       name        table; // optional, act as filter
@@ -432,14 +494,13 @@ public:
    static uint64_t get_table_index_name(const read_only::get_table_rows_params& p, bool& primary);
 
    template <typename IndexType, typename SecKeyType, typename ConvFn>
-   read_only::get_table_rows_result get_table_rows_by_seckey( const read_only::get_table_rows_params& p, const abi_def& abi, ConvFn conv )const {
-      read_only::get_table_rows_result result;
+   read_only::get_table_rows_raw_result get_table_rows_by_seckey( const read_only::get_table_rows_params& p, chain::abi_serializer_cache::entry_ptr abi, ConvFn conv )const {
+      read_only::get_table_rows_raw_result result;
+      result.abi = std::move(abi);
       const auto& d = db.db();
 
       name scope{ convert_to_type<uint64_t>(p.scope, "scope") };
 
-      abi_serializer abis;
-      abis.set_abi(abi, abi_serializer_max_time);
       bool primary = false;
       const uint64_t table_with_index = get_table_index_name(p, primary);
       const auto* t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(boost::make_tuple(p.code, scope, p.table));
@@ -484,24 +545,17 @@ public:
          auto walk_table_row_range = [&]( auto itr, auto end_itr ) {
             auto cur_time = fc::time_point::now();
             auto end_time = cur_time + fc::microseconds(1000 * 10); /// 10ms max time
-            vector<char> data;
             for( unsigned int count = 0; cur_time <= end_time && count < p.limit && itr != end_itr; ++itr, cur_time = fc::time_point::now() ) {
                const auto* itr2 = d.find<chain::key_value_object, chain::by_scope_primary>( boost::make_tuple(t_id->id, itr->primary_key) );
                if( itr2 == nullptr ) continue;
-               copy_inline_row(*itr2, data);
 
-               fc::variant data_var;
-               if( p.json ) {
-                  data_var = abis.binary_to_variant( abis.get_table_type(p.table), data, abi_serializer_max_time, shorten_abi_errors );
-               } else {
-                  data_var = fc::variant( data );
-               }
-
-               if( p.show_payer && *p.show_payer ) {
-                  result.rows.emplace_back( fc::mutable_variant_object("data", std::move(data_var))("payer", itr->payer) );
-               } else {
-                  result.rows.emplace_back( std::move(data_var) );
-               }
+               result.rows.emplace_back();
+               auto& row = result.rows.back();
+               copy_inline_row(*itr2, row.data);
+               row.payer = itr->payer;
+               row.primary_key = itr->primary_key;
+               row.secondary_key.resize( sizeof(itr->secondary_key) );
+               memcpy( row.secondary_key.data(), &itr->secondary_key, sizeof(itr->secondary_key) );
 
                ++count;
             }
@@ -523,14 +577,13 @@ public:
    }
 
    template <typename IndexType>
-   read_only::get_table_rows_result get_table_rows_ex( const read_only::get_table_rows_params& p, const abi_def& abi )const {
-      read_only::get_table_rows_result result;
+   read_only::get_table_rows_raw_result get_table_rows_ex( const read_only::get_table_rows_params& p, chain::abi_serializer_cache::entry_ptr abi )const {
+      read_only::get_table_rows_raw_result result;
+      result.abi = std::move(abi);
       const auto& d = db.db();
 
       uint64_t scope = convert_to_type<uint64_t>(p.scope, "scope");
 
-      abi_serializer abis;
-      abis.set_abi(abi, abi_serializer_max_time);
       const auto* t_id = d.find<chain::table_id_object, chain::by_code_scope_table>(boost::make_tuple(p.code, name(scope), p.table));
       if( t_id != nullptr ) {
          const auto& idx = d.get_index<IndexType, chain::by_scope_primary>();
@@ -563,22 +616,12 @@ public:
          auto walk_table_row_range = [&]( auto itr, auto end_itr ) {
             auto cur_time = fc::time_point::now();
             auto end_time = cur_time + fc::microseconds(1000 * 10); /// 10ms max time
-            vector<char> data;
             for( unsigned int count = 0; cur_time <= end_time && count < p.limit && itr != end_itr; ++count, ++itr, cur_time = fc::time_point::now() ) {
-               copy_inline_row(*itr, data);
-
-               fc::variant data_var;
-               if( p.json ) {
-                  data_var = abis.binary_to_variant( abis.get_table_type(p.table), data, abi_serializer_max_time, shorten_abi_errors );
-               } else {
-                  data_var = fc::variant( data );
-               }
-
-               if( p.show_payer && *p.show_payer ) {
-                  result.rows.emplace_back( fc::mutable_variant_object("data", std::move(data_var))("payer", itr->payer) );
-               } else {
-                  result.rows.emplace_back( std::move(data_var) );
-               }
+               result.rows.emplace_back();
+               auto& row = result.rows.back();
+               copy_inline_row(*itr, row.data);
+               row.payer = itr->payer;
+               row.primary_key = itr->primary_key;
             }
             if( itr != end_itr ) {
                result.more = true;
@@ -719,6 +762,14 @@ public:
    chain_apis::read_only get_read_only_api() const { return chain_apis::read_only(chain(), get_abi_serializer_max_time()); }
    chain_apis::read_write get_read_write_api() { return chain_apis::read_write(chain(), get_abi_serializer_max_time()); }
 
+   /**
+    * Execute a read-only task. Must be called from the main application thread.
+    * When read-only-api-threads is configured the task is queued and run on the read-only thread pool while the main
+    * thread is paused between block applications; otherwise it is run immediately on the calling thread.
+    * The task must only read chain state that is not modified outside of the main thread, e.g. not the block log.
+    */
+   void post_read_only( std::function<void()> task );
+
    bool accept_block( const chain::signed_block_ptr& block, const chain::block_id_type& id );
    void accept_transaction(const chain::packed_transaction_ptr& trx, chain::plugin_interface::next_function<chain::transaction_trace_ptr> next);
 
@@ -775,6 +826,9 @@ FC_REFLECT(eosio::chain_apis::read_only::get_block_header_state_params, (block_n
 FC_REFLECT( eosio::chain_apis::read_write::push_transaction_results, (transaction_id)(processed) )
 
 FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_params, (json)(code)(scope)(table)(table_key)(lower_bound)(upper_bound)(limit)(key_type)(index_position)(encode_type)(reverse)(show_payer) )
+FC_REFLECT_DERIVED( eosio::chain_apis::read_only::get_table_rows_binary_params, (eosio::chain_apis::read_only::get_table_rows_params), (fields) )
+FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_binary_result::row, (primary_key)(secondary_key)(payer)(data) )
+FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_binary_result, (rows)(more)(next_key) )
 FC_REFLECT( eosio::chain_apis::read_only::get_table_rows_result, (rows)(more)(next_key) );
 
 FC_REFLECT( eosio::chain_apis::read_only::get_table_by_scope_params, (code)(table)(lower_bound)(upper_bound)(limit)(reverse) )
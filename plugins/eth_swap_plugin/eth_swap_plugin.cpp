@@ -3,11 +3,14 @@
  *  @copyright defined in eos/LICENSE
  */
 #include <eosio/eth_swap_plugin/eth_swap_plugin.hpp>
-#include <eosio/eth_swap_plugin/http_client.hpp>
+#include <eosio/rem_oracle_plugin/async_http_client.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
 
 #include <fc/variant.hpp>
+#include <fc/variant_object.hpp>
+#include <fc/io/json.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/reflect/variant.hpp>
 
@@ -16,16 +19,12 @@
 #include <contracts.hpp>
 
 #include <boost/algorithm/clamp.hpp>
-#include <boost/optional/optional.hpp>
-#include <boost/iostreams/stream.hpp>
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/json_parser.hpp>
-
-#include <websocketpp/common/thread.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #include <iostream>
 
 #include <algorithm>
+#include <deque>
 
 
 namespace eosio {
@@ -38,11 +37,86 @@ namespace eosio {
         std::vector<fc::crypto::private_key> _swap_signing_key;
         std::vector<name> _swap_signing_account;
         std::vector<std::string> _swap_signing_permission;
-        std::string _eth_https_provider_host;
-        std::string _eth_https_provider_endpoint;
+        http_url _eth_rpc_url;
+        fc::microseconds _eth_rpc_timeout;
+        bfs::path _checkpoint_file;
+
+        struct block_range {
+            uint64_t from;
+            uint64_t to;
+        };
+
+        enum class swap_status {
+            queued, pushing, waiting_for_resources, finished
+        };
+
+        enum class push_result {
+            succeeded, failed, out_of_resources, not_applied
+        };
+
+        /// init swap transactions of a block range that are not finished yet
+        struct range_submissions {
+            block_range window;
+            size_t pending;
+        };
+
+        /// init swap of one request swap event by one signing authority
+        struct swap_submission {
+            swap_event_data data;
+            size_t signer = 0;
+            uint32_t attempt = 0;
+            swap_status status = swap_status::queued;
+            std::shared_ptr<range_submissions> range;
+            std::unique_ptr<boost::asio::steady_timer> timer;  // retry and resources back-off
+        };
+
+        using swap_submission_ptr = std::shared_ptr<swap_submission>;
+
+        /// called with the results ordered as the calls of the batch, or nullptr if the batch failed
+        using rpc_callback = std::function<void(const fc::variants *)>;
+
+        fc::optional<named_thread_pool> _thread_pool;  // ethereum requests, ingestion and submission state
+        std::unique_ptr<async_http_client> _http_client;
+        std::unique_ptr<boost::asio::steady_timer> _monitor_timer;
+        std::unique_ptr<boost::asio::steady_timer> _backfill_timer;
+
+        // ingestion state, only accessed on the ethswap thread
+        uint64_t _processed_block = 0;                  // every block up to and including it is processed
+        std::map<uint64_t, uint64_t> _completed_ranges; // processed ranges above _processed_block, from -> to
+        uint64_t _next_live_block = 0;
+        std::deque<block_range> _backfill_windows;
+        uint32_t _backfill_requests = 0;
+        bool _backfill_retry_pending = false;
+        std::deque<swap_submission_ptr> _swap_queue;
+        uint32_t _swaps_in_flight = 0;
 
         void start_monitor() {
-            while (eth_swap_contract_address.empty() && return_chain_id.empty()) {
+            _thread_pool.emplace("ethswap", 1);
+            _http_client = std::make_unique<async_http_client>(_thread_pool->get_executor());
+            _monitor_timer = std::make_unique<boost::asio::steady_timer>(_thread_pool->get_executor());
+            _backfill_timer = std::make_unique<boost::asio::steady_timer>(_thread_pool->get_executor());
+            schedule(*_monitor_timer, start_monitor_delay, [this]() { load_swap_params(); });
+        }
+
+        void stop_monitor() {
+            if (_thread_pool) {
+                _thread_pool->stop();
+            }
+        }
+
+        template<typename F>
+        void schedule(boost::asio::steady_timer &timer, uint32_t seconds, F &&f) {
+            timer.expires_after(std::chrono::seconds(seconds));
+            timer.async_wait([f{std::forward<F>(f)}](const boost::system::error_code &ec) {
+                if (ec == boost::asio::error::operation_aborted) return;
+                f();
+            });
+        }
+
+        /// reads rem.swap parameters on the main thread, retries until the swap contract is initialized
+        void load_swap_params() {
+            app().post(priority::low, [this]() {
+                std::string contract_address, chain_id;
                 try {
                     chain_apis::read_only::get_table_rows_params params = {};
                     params.json = true;
@@ -53,248 +127,396 @@ namespace eosio {
                     chain_apis::read_only::get_table_rows_result result = app().get_plugin<chain_plugin>().get_read_only_api().get_table_rows(
                             params);
                     for (const auto &item : result.rows) {
-                        eth_swap_contract_address = item["eth_swap_contract_address"].as<std::string>();
-                        return_chain_id = item["eth_return_chainid"].as<std::string>();
+                        contract_address = item["eth_swap_contract_address"].as<std::string>();
+                        chain_id = item["eth_return_chainid"].as<std::string>();
                     }
                 } FC_LOG_AND_DROP()
-                if (eth_swap_contract_address.empty() && return_chain_id.empty())
-                    sleep(wait_for_swapparams);
-            }
-            ilog("eth swap contract address: ${i}", ("i", eth_swap_contract_address));
-            ilog("eth return chain id: ${i}", ("i", return_chain_id));
-
-            uint64_t last_block_dec = 0;
-            while (last_block_dec == 0) {
-                try {
-                    last_block_dec = get_last_block_num(this->_eth_https_provider_host,
-                                                        this->_eth_https_provider_endpoint);
-                } FC_LOG_WAIT_AND_CONTINUE()
-            }
-
-            std::thread t([this, last_block_dec]() {
-                uint64_t to_block_dec = last_block_dec - min_tx_confirmations - long_polling_blocks_per_filter;
-                uint64_t from_block_dec = to_block_dec - eth_events_window_length;
-                this->init_prev_swap_requests(from_block_dec, to_block_dec);
+                boost::asio::post(_thread_pool->get_executor(), [this, contract_address, chain_id]() {
+                    if (contract_address.empty() && chain_id.empty()) {
+                        schedule(*_monitor_timer, wait_for_swapparams, [this]() { load_swap_params(); });
+                        return;
+                    }
+                    eth_swap_contract_address = contract_address;
+                    return_chain_id = chain_id;
+                    ilog("eth swap contract address: ${i}", ("i", eth_swap_contract_address));
+                    ilog("eth return chain id: ${i}", ("i", return_chain_id));
+                    start_ingestion();
+                });
             });
-            t.detach();
+        }
 
-            uint64_t from_block_dec = last_block_dec - long_polling_blocks_per_filter - min_tx_confirmations;
-            while (true) {
+        /// splits the confirmed blocks into the backfilled history and the live polled head, resuming from the checkpoint
+        void start_ingestion() {
+            rpc_batch({{"eth_blockNumber", fc::variants()}}, [this](const fc::variants *results) {
+                if (!results) {
+                    schedule(*_monitor_timer, wait_for_eth_node, [this]() { start_ingestion(); });
+                    return;
+                }
+                // an error object, a null result or a malformed number must not escape the thread pool
+                bool started = false;
                 try {
-                    last_block_dec = get_last_block_num(this->_eth_https_provider_host,
-                                                        this->_eth_https_provider_endpoint);
-
-                    std::stringstream stream;
-                    stream << std::hex << from_block_dec;
-                    std::string from_block("0x" + stream.str());
-                    stream.str("");
-                    stream.clear();
-
-                    std::string request_swap_filter_id, filter_logs;
-                    uint64_t to_block_dec;
-
-                    to_block_dec = std::min(last_block_dec - min_tx_confirmations,
-                                            from_block_dec + long_polling_blocks_per_filter);
-
-                    if (to_block_dec < from_block_dec)
-                        continue;
-                    stream << std::hex << to_block_dec;
-                    std::string to_block("0x" + stream.str());
-                    stream.str("");
-                    stream.clear();
-
-                    filter_logs = get_filter_logs(this->_eth_https_provider_host,
-                                                  this->_eth_https_provider_endpoint,
-                                                  eth_swap_contract_address,
-                                                  from_block,
-                                                  to_block,
-                                                  "[\"" + string(eth_swap_request_event) + "\"]");
-                    std::vector<swap_event_data> prev_swap_requests;
-                    try {
-                        prev_swap_requests = get_prev_swap_events(filter_logs);
-                    } catch(...) {
-                        wlog("Error parsing response from Infura: ${logs}", ("logs", filter_logs));
-                        sleep(wait_for_eth_node);
-                        continue;
+                    uint64_t last_block = hex_to_uint64((*results)[0].as_string());
+                    ilog("last eth block: ${b}", ("b", last_block));
+                    uint64_t confirmed_block = last_block > min_tx_confirmations ? last_block - min_tx_confirmations : 0;
+                    uint64_t from_block = confirmed_block > eth_events_window_length ? confirmed_block - eth_events_window_length : 1;
+                    auto checkpoint = load_checkpoint();
+                    if (checkpoint) {
+                        ilog("last processed eth block: ${b}", ("b", *checkpoint));
+                        from_block = std::max(from_block, *checkpoint + 1);
                     }
-                    push_txs(prev_swap_requests);
-                    from_block_dec = to_block_dec;
+                    _processed_block = from_block - 1;
 
-                    sleep(long_polling_period);
-                } FC_LOG_WAIT_AND_CONTINUE()
-            }
+                    // a retry after a failure recomputes the windows
+                    _backfill_windows.clear();
+                    for (uint64_t block = from_block; block <= confirmed_block; block += blocks_per_filter) {
+                        _backfill_windows.push_back({block, std::min<uint64_t>(confirmed_block, block + blocks_per_filter - 1)});
+                    }
+                    _next_live_block = std::max(from_block, confirmed_block + 1);
+                    if (!_backfill_windows.empty()) {
+                        ilog("backfilling eth blocks ${f} - ${t}", ("f", from_block)("t", confirmed_block));
+                    }
+                    resume_backfill();
+                    poll_live();
+                    started = true;
+                } FC_LOG_AND_DROP()
+                if (!started) {
+                    schedule(*_monitor_timer, wait_for_eth_node, [this]() { start_ingestion(); });
+                }
+            });
         }
 
-        void push_txs(const std::vector<swap_event_data> &swap_requests) {
-            for (std::vector<swap_event_data>::const_iterator it = swap_requests.begin();
-                 it != swap_requests.end(); ++it) {
-                swap_event_data data = *it;
-                push_init_swap_transaction(data);
+        /// keeps up to backfill_parallel_requests batches of historical windows in flight
+        void resume_backfill() {
+            while (!_backfill_retry_pending && _backfill_requests < backfill_parallel_requests && !_backfill_windows.empty()) {
+                auto count = std::min<size_t>(rpc_batch_size, _backfill_windows.size());
+                std::vector<block_range> windows(_backfill_windows.begin(), _backfill_windows.begin() + count);
+                _backfill_windows.erase(_backfill_windows.begin(), _backfill_windows.begin() + count);
+                ++_backfill_requests;
+                fetch_swap_events(windows, [this, windows](bool success) {
+                    --_backfill_requests;
+                    if (!success) {
+                        _backfill_windows.insert(_backfill_windows.begin(), windows.begin(), windows.end());
+                        if (!_backfill_retry_pending) {
+                            _backfill_retry_pending = true;
+                            schedule(*_backfill_timer, wait_for_eth_node, [this]() {
+                                _backfill_retry_pending = false;
+                                resume_backfill();
+                            });
+                        }
+                        return;
+                    }
+                    if (_backfill_windows.empty() && _backfill_requests == 0) {
+                        ilog("eth blocks backfill finished");
+                    }
+                    resume_backfill();
+                });
             }
         }
 
-        void init_prev_swap_requests(uint64_t min_block_dec, uint64_t to_block_dec) {
-            while (to_block_dec > min_block_dec) {
+        /// follows confirmed blocks every long_polling_period seconds, catching up without delay when behind
+        void poll_live() {
+            rpc_batch({{"eth_blockNumber", fc::variants()}}, [this](const fc::variants *results) {
+                if (!results) {
+                    schedule(*_monitor_timer, wait_for_eth_node, [this]() { poll_live(); });
+                    return;
+                }
+                bool polled = false;
                 try {
-                    while (to_block_dec > min_block_dec) {
-
-                        std::stringstream stream;
-
-                        stream << std::hex << to_block_dec;
-                        std::string to_block = "0x" + stream.str();
-                        stream.str("");
-                        stream.clear();
-
-                        std::string request_swap_filter_id, filter_logs, from_block;
-
-                        stream << std::hex << std::max(min_block_dec, to_block_dec - blocks_per_filter);
-                        from_block = "0x" + stream.str();
-                        stream.str("");
-                        stream.clear();
-
-                        filter_logs = get_filter_logs(this->_eth_https_provider_host,
-                                                      this->_eth_https_provider_endpoint,
-                                                      eth_swap_contract_address,
-                                                      from_block,
-                                                      to_block,
-                                                      "[\"" + string(eth_swap_request_event) + "\"]");
-                        std::vector<swap_event_data> prev_swap_requests;
-                        try {
-                            prev_swap_requests = get_prev_swap_events(filter_logs);
-                        } catch(...) {
-                            wlog("Error parsing response from Infura: ${logs}", ("logs", filter_logs));
-                            sleep(wait_for_eth_node);
-                            continue;
+                    uint64_t last_block = hex_to_uint64((*results)[0].as_string());
+                    uint64_t confirmed_block = last_block > min_tx_confirmations ? last_block - min_tx_confirmations : 0;
+                    std::vector<block_range> windows;
+                    for (uint64_t block = _next_live_block;
+                         block <= confirmed_block && windows.size() < rpc_batch_size; block += long_polling_blocks_per_filter) {
+                        windows.push_back({block, std::min<uint64_t>(confirmed_block, block + long_polling_blocks_per_filter - 1)});
+                    }
+                    if (windows.empty()) {
+                        schedule(*_monitor_timer, long_polling_period, [this]() { poll_live(); });
+                        return;
+                    }
+                    fetch_swap_events(windows, [this, windows, confirmed_block](bool success) {
+                        if (!success) {
+                            schedule(*_monitor_timer, wait_for_eth_node, [this]() { poll_live(); });
+                            return;
                         }
+                        _next_live_block = windows.back().to + 1;
+                        if (_next_live_block <= confirmed_block) {
+                            poll_live();
+                        } else {
+                            schedule(*_monitor_timer, long_polling_period, [this]() { poll_live(); });
+                        }
+                    });
+                    polled = true;
+                } FC_LOG_AND_DROP()
+                if (!polled) {
+                    schedule(*_monitor_timer, wait_for_eth_node, [this]() { poll_live(); });
+                }
+            });
+        }
 
-                        std::reverse(prev_swap_requests.begin(), prev_swap_requests.end());
-
-                        push_txs(prev_swap_requests);
-                        to_block_dec -= blocks_per_filter;
+        /// requests the swap events of all `windows` in a single batch and hands them over to the submission stage
+        void fetch_swap_events(const std::vector<block_range> &windows, std::function<void(bool)> cb) {
+            std::vector<std::pair<std::string, fc::variants>> calls;
+            calls.reserve(windows.size());
+            for (const auto &window : windows) {
+                calls.emplace_back("eth_getLogs", fc::variants{fc::variant(fc::mutable_variant_object()
+                        ("address", eth_swap_contract_address)
+                        ("fromBlock", uint64_to_hex(window.from))
+                        ("toBlock", uint64_to_hex(window.to))
+                        ("topics", fc::variants{fc::variant(eth_swap_request_event)}))});
+            }
+            rpc_batch(calls, [this, windows, cb{std::move(cb)}](const fc::variants *results) {
+                if (!results) {
+                    cb(false);
+                    return;
+                }
+                std::vector<std::vector<swap_event_data>> events;
+                events.reserve(windows.size());
+                try {
+                    for (const auto &result : *results) {
+                        events.push_back(get_swap_events(result.get_array()));
                     }
+                } catch (...) {
+                    wlog("Error parsing eth_getLogs response from ethereum node");
+                    cb(false);
+                    return;
+                }
+                for (size_t i = 0; i < windows.size(); ++i) {
+                    submit(windows[i], std::move(events[i]));
+                }
+                cb(true);
+            });
+        }
 
-                } FC_LOG_WAIT_AND_CONTINUE()
+        /// sends `calls` as one JSON-RPC batch request on a kept alive connection
+        void rpc_batch(const std::vector<std::pair<std::string, fc::variants>> &calls, rpc_callback cb) {
+            fc::variants request;
+            request.reserve(calls.size());
+            for (size_t i = 0; i < calls.size(); ++i) {
+                request.emplace_back(fc::mutable_variant_object()
+                        ("jsonrpc", "2.0")
+                        ("id", i)
+                        ("method", calls[i].first)
+                        ("params", calls[i].second));
             }
+            _http_client->async_request(_eth_rpc_url, "POST", fc::json::to_string(request, fc::time_point::maximum()),
+                                        _eth_rpc_timeout,
+                                        [cb{std::move(cb)}, count = calls.size()](const boost::system::error_code &ec,
+                                                                                  unsigned int status, std::string body) {
+                fc::variants results(count);
+                bool success = false;
+                try {
+                    if (ec) {
+                        wlog("ethereum node request failed: ${e}", ("e", ec.message()));
+                    } else if (status != 200) {
+                        wlog("ethereum node request failed with http status ${c}: ${b}", ("c", status)("b", body));
+                    } else {
+                        auto response = fc::json::from_string(body);
+                        FC_ASSERT(response.is_array(), "unexpected response from ethereum node: ${b}", ("b", body));
+                        size_t received = 0;
+                        for (const auto &item : response.get_array()) {
+                            const auto &reply = item.get_object();
+                            FC_ASSERT(!reply.contains("error"), "ethereum node error: ${e}", ("e", reply["error"]));
+                            auto id = reply["id"].as_uint64();
+                            FC_ASSERT(id < count && reply.contains("result"), "unexpected reply from ethereum node: ${r}", ("r", item));
+                            results[id] = reply["result"];
+                            ++received;
+                        }
+                        FC_ASSERT(received == count, "ethereum node answered ${r} of ${c} calls", ("r", received)("c", count));
+                        success = true;
+                    }
+                } FC_LOG_AND_DROP()
+                cb(success ? &results : nullptr);
+            });
         }
 
-        void push_init_swap_transaction(const swap_event_data &data) {
-            enum TxStatus {
-                NoStatus, Success, Failed, OutOfResources
-            };
-            for (size_t i = 0; i < this->_swap_signing_key.size(); i++) {
-                uint32_t push_tx_attempt = 0;
-                TxStatus status = NoStatus;
-                while (status != Success && status != Failed) {
-                    status = NoStatus;
+        /// queues an init swap per event and signing authority, the window is processed once all of them are finished
+        void submit(const block_range &window, std::vector<swap_event_data> events) {
+            auto range = std::make_shared<range_submissions>(range_submissions{window, 0});
+            const std::string chain_id(app().get_plugin<chain_plugin>().get_chain_id());
+            for (const auto &data : events) {
+                if (data.chain_id != chain_id) {
                     uint32_t slot = (data.timestamp * 1000 - block_timestamp_epoch) / block_interval_ms;
-                    if (push_tx_attempt) {
-                        wlog("Retrying to push init swap transaction(${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp})",
-                             ("txid", data.txid)("pubkey", data.swap_pubkey)("amount", data.amount)
-                                     ("ret_addr", data.return_address)("ret_chainid", data.return_chain_id)("timestamp",
-                                                                                                            epoch_block_timestamp(
-                                                                                                                    slot)));
-                    }
-                    std::vector<signed_transaction> trxs;
-                    trxs.reserve(2);
+                    ilog("Invalid chain identifier in init swap transaction(${chain_id}, ${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp})",
+                         ("chain_id", data.chain_id)("txid", data.txid)("pubkey", data.swap_pubkey)("amount", data.amount)
+                                 ("ret_addr", data.return_address)("ret_chainid", data.return_chain_id)
+                                 ("timestamp", epoch_block_timestamp(slot)));
+                    continue;
+                }
+                for (size_t i = 0; i < _swap_signing_key.size(); i++) {
+                    auto swap = std::make_shared<swap_submission>();
+                    swap->data = data;
+                    swap->signer = i;
+                    swap->range = range;
+                    swap->timer = std::make_unique<boost::asio::steady_timer>(_thread_pool->get_executor());
+                    ++range->pending;
+                    _swap_queue.push_back(std::move(swap));
+                }
+            }
+            if (range->pending == 0) {
+                complete_range(window);
+                return;
+            }
+            push_queued_swaps();
+        }
+
+        /// starts queued swaps while fewer than max_swaps_in_flight wait for the result of their transaction
+        void push_queued_swaps() {
+            while (_swaps_in_flight < max_swaps_in_flight && !_swap_queue.empty()) {
+                auto swap = std::move(_swap_queue.front());
+                _swap_queue.pop_front();
+                ++_swaps_in_flight;
+                push_init_swap_transaction(swap);
+            }
+        }
+
+        void push_init_swap_transaction(const swap_submission_ptr &swap) {
+            const swap_event_data &data = swap->data;
+            const size_t signer = swap->signer;
+            const uint32_t attempt = ++swap->attempt;
+            swap->status = swap_status::pushing;
+
+            uint32_t slot = (data.timestamp * 1000 - block_timestamp_epoch) / block_interval_ms;
+            if (attempt > 1) {
+                wlog("Retrying to push init swap transaction(${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp})",
+                     ("txid", data.txid)("pubkey", data.swap_pubkey)("amount", data.amount)
+                             ("ret_addr", data.return_address)("ret_chainid", data.return_chain_id)
+                             ("timestamp", epoch_block_timestamp(slot)));
+            }
+
+            auto trx = std::make_shared<signed_transaction>();
+            trx->actions.emplace_back(vector<chain::permission_level>{{this->_swap_signing_account[signer], name(
+                    this->_swap_signing_permission[signer])}},
+                                      init{this->_swap_signing_account[signer],
+                                           data.txid,
+                                           data.swap_pubkey,
+                                           uint64_to_rem_asset(data.amount),
+                                           data.return_address,
+                                           data.return_chain_id,
+                                           epoch_block_timestamp(slot)});
+            trx->max_net_usage_words = 5000;
+
+            // retry if the transaction neither failed nor made it to the blockchain in time
+            schedule(*swap->timer, retry_push_tx_time, [this, swap, attempt]() {
+                on_push_result(swap, attempt, push_result::not_applied);
+            });
 
+            app().post(priority::low, [this, swap, attempt, trx, slot]() {
+                try {
                     controller &cc = app().get_plugin<chain_plugin>().chain();
                     auto chainid = app().get_plugin<chain_plugin>().get_chain_id();
 
-                    if (data.chain_id != std::string(chainid)) {
-                        ilog("Invalid chain identifier in init swap transaction(${chain_id}, ${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp})",
-                             ("chain_id", data.chain_id)("txid", data.txid)("pubkey", data.swap_pubkey)("amount",
-                                                                                                        data.amount)
-                                     ("ret_addr", data.return_address)("ret_chainid", data.return_chain_id)("timestamp",
-                                                                                                            epoch_block_timestamp(
-                                                                                                                    slot)));
-                        return;
+                    trx->expiration = cc.head_block_time() + fc::seconds(init_swap_expiration_time);
+                    trx->set_reference_block(cc.head_block_id());
+                    trx->sign(this->_swap_signing_key[swap->signer], chainid);
+
+                    name account = trx->first_authorizer();
+                    app().get_plugin<chain_plugin>().accept_transaction(
+                            std::make_shared<packed_transaction>(*trx),
+                            [this, swap, attempt, slot, account](
+                                    const fc::static_variant<fc::exception_ptr, transaction_trace_ptr> &result) {
+                                const swap_event_data &data = swap->data;
+                                push_result outcome = push_result::not_applied;
+                                if (result.contains<fc::exception_ptr>()) {
+                                    std::string err_str = result.get<fc::exception_ptr>()->to_string();
+                                    if (err_str.find("CPU") != string::npos ||
+                                        err_str.find("NET") != string::npos ||
+                                        err_str.find("RAM") != string::npos)
+                                        outcome = push_result::out_of_resources;
+                                    else
+                                        outcome = push_result::failed;
+                                    if (err_str.find("swap already canceled") == string::npos &&
+                                        err_str.find("swap already finished") == string::npos &&
+                                        err_str.find("approval already exists") == string::npos &&
+                                        err_str.find("only top25 block producers' approvals are recorded") == string::npos &&
+                                        err_str.find("Duplicate transaction") == string::npos)
+                                        elog("${prod} failed to push init swap transaction(${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp}): ${res}",
+                                             ("prod", account)("res", err_str)("txid", data.txid)("pubkey", data.swap_pubkey)
+                                                     ("amount", data.amount)("ret_addr", data.return_address)
+                                                     ("ret_chainid", data.return_chain_id)("timestamp", epoch_block_timestamp(slot)));
+                                    else
+                                        ilog("${prod} skips swap transaction(${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp}): ${res}",
+                                             ("prod", account)("res", err_str)("txid", data.txid)("pubkey", data.swap_pubkey)
+                                                     ("amount", data.amount)("ret_addr", data.return_address)
+                                                     ("ret_chainid", data.return_chain_id)("timestamp", epoch_block_timestamp(slot)));
+                                } else if (result.contains<transaction_trace_ptr>() &&
+                                           result.get<transaction_trace_ptr>()->receipt) {
+                                    outcome = push_result::succeeded;
+                                    auto trx_id = result.get<transaction_trace_ptr>()->id;
+                                    ilog("${prod} pushed init swap transaction(${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp}): ${id}",
+                                         ("prod", account)("id", trx_id)("txid", data.txid)("pubkey", data.swap_pubkey)
+                                                 ("amount", data.amount)("ret_addr", data.return_address)
+                                                 ("ret_chainid", data.return_chain_id)("timestamp", epoch_block_timestamp(slot)));
+                                }
+                                if (outcome != push_result::not_applied) {
+                                    boost::asio::post(_thread_pool->get_executor(), [this, swap, attempt, outcome]() {
+                                        on_push_result(swap, attempt, outcome);
+                                    });
+                                }
+                            });
+                } FC_LOG_AND_DROP()
+            });
+        }
+
+        /// advances the state of `swap`, results of superseded attempts are ignored
+        void on_push_result(const swap_submission_ptr &swap, uint32_t attempt, push_result outcome) {
+            if (swap->attempt != attempt || swap->status != swap_status::pushing)
+                return;
+            swap->timer->cancel();
+            --_swaps_in_flight;
+            switch (outcome) {
+                case push_result::succeeded:
+                case push_result::failed:
+                    swap->status = swap_status::finished;
+                    if (--swap->range->pending == 0) {
+                        complete_range(swap->range->window);
                     }
-                    signed_transaction trx;
-                    trx.actions.emplace_back(vector<chain::permission_level>{{this->_swap_signing_account[i], name(
-                            this->_swap_signing_permission[i])}},
-                                             init{this->_swap_signing_account[i],
-                                                  data.txid,
-                                                  data.swap_pubkey,
-                                                  uint64_to_rem_asset(data.amount),
-                                                  data.return_address,
-                                                  data.return_chain_id,
-                                                  epoch_block_timestamp(slot)});
-
-                    trx.max_net_usage_words = 5000;
-                    trxs.emplace_back(std::move(trx));
-                    try {
-                        auto trxs_copy = std::make_shared<std::decay_t<decltype(trxs)>>(std::move(trxs));
-                        app().post(priority::low, [this, trxs_copy, &status, data, slot]() {
-                            controller &cc = app().get_plugin<chain_plugin>().chain();
-                            auto chainid = app().get_plugin<chain_plugin>().get_chain_id();
-                            for (size_t i = 0; i < trxs_copy->size(); ++i) {
-
-                                trxs_copy->at(i).expiration =
-                                        cc.head_block_time() + fc::seconds(init_swap_expiration_time);
-                                trxs_copy->at(i).set_reference_block(cc.head_block_id());
-                                trxs_copy->at(i).sign(this->_swap_signing_key[i], chainid);
-
-                                name account = trxs_copy->at(i).first_authorizer();
-                                app().get_plugin<chain_plugin>().accept_transaction(
-                                        std::make_shared<packed_transaction>(trxs_copy->at(i)),
-                                        [&status, data, slot, account](
-                                                const fc::static_variant<fc::exception_ptr, transaction_trace_ptr> &result) {
-                                            if (result.contains<fc::exception_ptr>()) {
-                                                std::string err_str = result.get<fc::exception_ptr>()->to_string();
-                                                if (err_str.find("CPU") != string::npos ||
-                                                    err_str.find("NET") != string::npos ||
-                                                    err_str.find("RAM") != string::npos)
-                                                    status = OutOfResources;
-                                                else
-                                                    status = Failed;
-                                                if (err_str.find("swap already canceled") == string::npos &&
-                                                    err_str.find("swap already finished") == string::npos &&
-                                                    err_str.find("approval already exists") == string::npos &&
-                                                    err_str.find("only top25 block producers' approvals are recorded") == string::npos &&
-                                                    err_str.find("Duplicate transaction") == string::npos)
-                                                    elog("${prod} failed to push init swap transaction(${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp}): ${res}",
-                                                         ("prod", account)("res",
-                                                                           result.get<fc::exception_ptr>()->to_string())(
-                                                                 "txid", data.txid)("pubkey", data.swap_pubkey)(
-                                                                 "amount", data.amount)
-                                                                 ("ret_addr", data.return_address)("ret_chainid",
-                                                                                                   data.return_chain_id)(
-                                                                 "timestamp", epoch_block_timestamp(slot)));
-                                                else
-                                                    ilog("${prod} skips swap transaction(${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp}): ${res}",
-                                                         ("prod", account)("res",
-                                                                           result.get<fc::exception_ptr>()->to_string())(
-                                                                 "txid", data.txid)("pubkey", data.swap_pubkey)(
-                                                                 "amount", data.amount)
-                                                                 ("ret_addr", data.return_address)("ret_chainid",
-                                                                                                   data.return_chain_id)(
-                                                                 "timestamp", epoch_block_timestamp(slot)));
-                                            } else {
-                                                if (result.contains<transaction_trace_ptr>() &&
-                                                    result.get<transaction_trace_ptr>()->receipt) {
-                                                    status = Success;
-                                                    auto trx_id = result.get<transaction_trace_ptr>()->id;
-                                                    ilog("${prod} pushed init swap transaction(${txid}, ${pubkey}, ${amount}, ${ret_addr}, ${ret_chainid}, ${timestamp}): ${id}",
-                                                         ("prod", account)("id", trx_id)("txid", data.txid)("pubkey",
-                                                                                                            data.swap_pubkey)(
-                                                                 "amount", data.amount)
-                                                                 ("ret_addr", data.return_address)("ret_chainid",
-                                                                                                   data.return_chain_id)(
-                                                                 "timestamp", epoch_block_timestamp(slot)));
-                                                }
-                                            }
-                                        });
-                            }
-                        });
-                    } FC_LOG_AND_DROP()
-                    for (uint j = 0; j < retry_push_tx_time / wait_for_accept_tx && status == NoStatus; j++)
-                        sleep(wait_for_accept_tx);
-                    if (status == OutOfResources)
-                        sleep(wait_for_resources);
-                    push_tx_attempt++;
-                }
+                    break;
+                case push_result::out_of_resources:
+                    swap->status = swap_status::waiting_for_resources;
+                    schedule(*swap->timer, wait_for_resources, [this, swap]() {
+                        swap->status = swap_status::queued;
+                        _swap_queue.push_back(swap);
+                        push_queued_swaps();
+                    });
+                    break;
+                case push_result::not_applied:
+                    swap->status = swap_status::queued;
+                    _swap_queue.push_back(swap);
+                    break;
+            }
+            push_queued_swaps();
+        }
+
+        /// advances the checkpoint over the contiguous prefix of processed ranges
+        void complete_range(const block_range &window) {
+            _completed_ranges[window.from] = window.to;
+            const uint64_t processed_block = _processed_block;
+            for (auto itr = _completed_ranges.begin();
+                 itr != _completed_ranges.end() && itr->first == _processed_block + 1; itr = _completed_ranges.erase(itr)) {
+                _processed_block = itr->second;
+            }
+            if (_processed_block != processed_block) {
+                save_checkpoint();
             }
         }
+
+        fc::optional<uint64_t> load_checkpoint() {
+            try {
+                if (bfs::exists(_checkpoint_file)) {
+                    return fc::json::from_file(_checkpoint_file).get_object()["last_processed_block"].as_uint64();
+                }
+            } FC_LOG_AND_DROP()
+            return {};
+        }
+
+        void save_checkpoint() {
+            try {
+                auto tmp_file = _checkpoint_file;
+                tmp_file += ".tmp";
+                fc::json::save_to_file(fc::mutable_variant_object()("last_processed_block", _processed_block), tmp_file);
+                bfs::rename(tmp_file, _checkpoint_file);
+            } FC_LOG_AND_DROP()
+        }
     };
 
     eth_swap_plugin::eth_swap_plugin() : my(new eth_swap_plugin_impl()) {}
@@ -309,6 +531,8 @@ namespace eosio {
                  "Account name and permission to authorize init swap actions. For example blockproducer1@active")
                 ("swap-signing-key", bpo::value<std::vector<std::string>>(),
                  "A private key to sign init swap actions")
+                ("eth-swap-checkpoint-file", bpo::value<bfs::path>()->default_value("eth-swap-checkpoint.json"),
+                 "File the last processed ethereum block is saved to, so that restarts resume from it. If relative, relative to data-dir")
 
                 //("eth_swap_contract_address", bpo::value<std::string>(), "")
                 ("eth_swap_request_event", bpo::value<std::string>()->default_value(eth_swap_request_event), "")
@@ -316,8 +540,14 @@ namespace eosio {
 
                 ("eth_events_window_length", bpo::value<uint32_t>()->default_value(eth_events_window_length), "")
                 ("blocks_per_filter", bpo::value<uint32_t>()->default_value(blocks_per_filter), "")
-                ("check_tx_confirmations_times", bpo::value<uint32_t>()->default_value(check_tx_confirmations_times),
-                 "")
+                ("rpc_batch_size", bpo::value<uint32_t>()->default_value(rpc_batch_size),
+                 "Maximum number of block ranges requested in one JSON-RPC batch request")
+                ("backfill_parallel_requests", bpo::value<uint32_t>()->default_value(backfill_parallel_requests),
+                 "Maximum number of batch requests in flight while backfilling eth_events_window_length blocks")
+                ("eth_rpc_timeout", bpo::value<uint32_t>()->default_value(eth_rpc_timeout),
+                 "Seconds to wait for a response of the ethereum node")
+                ("check_tx_confirmations_times", bpo::value<uint32_t>(),
+                 "Deprecated and ignored, confirmations are checked on every poll of the ethereum node")
                 ("min_tx_confirmations", bpo::value<uint32_t>()->default_value(min_tx_confirmations), "")
 
                 ("long_polling_blocks_per_filter",
@@ -328,6 +558,8 @@ namespace eosio {
 
                 ("init_swap_expiration_time", bpo::value<uint32_t>()->default_value(init_swap_expiration_time), "")
                 ("retry_push_tx_time", bpo::value<uint32_t>()->default_value(retry_push_tx_time), "")
+                ("max_swaps_in_flight", bpo::value<uint32_t>()->default_value(max_swaps_in_flight),
+                 "Maximum number of init swap transactions waiting for their result at the same time")
                 ("start_monitor_delay", bpo::value<uint32_t>()->default_value(start_monitor_delay), "");
     }
 
@@ -350,23 +582,17 @@ namespace eosio {
             }
 
             std::string eth_https_provider = options.at("eth-https-provider").as<std::string>();
-            size_t protocol_len = 0;
-            if (eth_https_provider.rfind("https://", 0) == 0)
-                protocol_len = 8;
-            else if (eth_https_provider.rfind("http://", 0) == 0)
-                protocol_len = 7;
-
-            if (protocol_len != 0) {
-                eth_https_provider.erase(0, protocol_len);
-
-                string::size_type pos;
-                pos = eth_https_provider.find('/', 0);
-                my->_eth_https_provider_host = eth_https_provider.substr(0, pos);
-                my->_eth_https_provider_endpoint = eth_https_provider.substr(pos, eth_https_provider.length() - pos);
-            } else {
+            if (eth_https_provider.rfind("https://", 0) != 0 && eth_https_provider.rfind("http://", 0) != 0) {
                 throw InvalidEthLinkException(
                         "Invalid Ethereum https link. Should be https://mainnet.infura.io/v3/<infura_id>");
             }
+            my->_eth_rpc_url = http_url::parse(eth_https_provider);
+
+            auto checkpoint_file = options.at("eth-swap-checkpoint-file").as<bfs::path>();
+            if (checkpoint_file.is_relative())
+                my->_checkpoint_file = app().data_dir() / checkpoint_file;
+            else
+                my->_checkpoint_file = checkpoint_file;
 
             //eth_swap_contract_address = options.at( "eth_swap_contract_address" ).as<std::string>();
             eth_swap_request_event = options.at("eth_swap_request_event").as<std::string>();
@@ -374,17 +600,30 @@ namespace eosio {
 
             eth_events_window_length = options.at("eth_events_window_length").as<uint32_t>();
             blocks_per_filter = options.at("blocks_per_filter").as<uint32_t>();
-
-            check_tx_confirmations_times = options.at("check_tx_confirmations_times").as<uint32_t>();
+            rpc_batch_size = options.at("rpc_batch_size").as<uint32_t>();
+            backfill_parallel_requests = options.at("backfill_parallel_requests").as<uint32_t>();
+            eth_rpc_timeout = options.at("eth_rpc_timeout").as<uint32_t>();
+            EOS_ASSERT(blocks_per_filter > 0 && rpc_batch_size > 0 && backfill_parallel_requests > 0,
+                       chain::plugin_config_exception,
+                       "blocks_per_filter, rpc_batch_size and backfill_parallel_requests must be positive");
+            my->_eth_rpc_timeout = fc::seconds(eth_rpc_timeout);
+
+            if (options.count("check_tx_confirmations_times")) {
+                wlog("check_tx_confirmations_times is deprecated and ignored, swap requests are initialized once they have min_tx_confirmations");
+            }
             min_tx_confirmations = options.at("min_tx_confirmations").as<uint32_t>();
 
             long_polling_blocks_per_filter = options.at("long_polling_blocks_per_filter").as<uint32_t>();
             long_polling_period = options.at("long_polling_period").as<uint32_t>();
+            EOS_ASSERT(long_polling_blocks_per_filter > 0, chain::plugin_config_exception,
+                       "long_polling_blocks_per_filter must be positive");
 
             wait_for_resources = options.at("wait_for_resources").as<uint32_t>();
 
             init_swap_expiration_time = options.at("init_swap_expiration_time").as<uint32_t>();
             retry_push_tx_time = options.at("retry_push_tx_time").as<uint32_t>();
+            max_swaps_in_flight = options.at("max_swaps_in_flight").as<uint32_t>();
+            EOS_ASSERT(max_swaps_in_flight > 0, chain::plugin_config_exception, "max_swaps_in_flight must be positive");
 
             start_monitor_delay = options.at("start_monitor_delay").as<uint32_t>();
         } FC_LOG_AND_RETHROW()
@@ -392,62 +631,22 @@ namespace eosio {
 
     void eth_swap_plugin::plugin_startup() {
         ilog("Ethereum swap plugin started");
-
-        try {
-            ilog("last eth block: " +
-                 to_string(get_last_block_num(my->_eth_https_provider_host, my->_eth_https_provider_endpoint)));
-        } FC_LOG_AND_RETHROW()
-
-        std::thread t2([=]() {
-            sleep(start_monitor_delay);
-            try {
-                my->start_monitor();
-            } FC_LOG_AND_RETHROW()
-        });
-        t2.detach();
+        my->start_monitor();
     }
 
     void eth_swap_plugin::plugin_shutdown() {
+        my->stop_monitor();
     }
 
-    template<typename T>
-    boost::optional<T> get_json_optional(const std::string &payload, const std::string &path) {
-        boost::iostreams::stream<boost::iostreams::array_source> stream(payload.c_str(), payload.size());
-        namespace pt = boost::property_tree;
-        pt::ptree root;
-        pt::read_json(stream, root);
-        return root.get_optional<T>(path.c_str());
-    }
-
-    uint64_t get_last_block_num(std::string host, std::string endpoint) {
-        const char *get_last_block_body = "{\"jsonrpc\":\"2.0\",\"method\":\"eth_blockNumber\",\"params\":[],\"id\":0}";
-        std::string res = make_request(host, endpoint, "POST", get_last_block_body);
-        boost::optional<std::string> block_num_hex = get_json_optional<std::string>(res, "result");
-        uint64_t last_block_num;
-
-        if (block_num_hex) {
-            std::stringstream ss;
-            ss << std::hex << block_num_hex;
-            ss >> last_block_num;
-            return last_block_num;
-        }
-        return 0;
+    std::string uint64_to_hex(uint64_t value) {
+        std::stringstream ss;
+        ss << "0x" << std::hex << value;
+        return ss.str();
     }
 
-    std::string get_filter_logs(const std::string &host,
-                                const std::string &endpoint,
-                                const std::string &contract_address,
-                                const std::string &from_block,
-                                const std::string &to_block,
-                                const std::string &topics) {
-        std::string get_logs_body = "{\"id\": " + std::to_string(0) + "," \
-        "\"method\": \"eth_getLogs\"," \
-        "\"params\": [{\"address\": \"" + contract_address + "\"," \
-        "\"fromBlock\": \"" + from_block + "\"," \
-        "\"toBlock\": \"" + to_block + "\"," \
-        "\"topics\": " + topics + "}]}";
-
-        return make_request(host, endpoint, "POST", get_logs_body);
+    uint64_t hex_to_uint64(const std::string &hex) {
+        FC_ASSERT(hex.rfind("0x", 0) == 0 && hex.size() > 2, "invalid hex quantity ${h}", ("h", hex));
+        return std::stoull(hex.substr(2), nullptr, 16);
     }
 
     std::string hex_to_string(const std::string &input) {
@@ -501,43 +700,6 @@ namespace eosio {
         return data;
     }
 
-    swap_event_data *get_swap_event_data(boost::property_tree::ptree root,
-                                         swap_event_data *data,
-                                         const char *data_key,
-                                         const char *txid_key,
-                                         const char *block_number_key) {
-        boost::optional<string> hex_data_opt = root.get_optional<string>(data_key);
-        boost::optional<string> txid = root.get_optional<string>(txid_key);
-        boost::optional<string> block_number = root.get_optional<string>(block_number_key);
-        if (!hex_data_opt)
-            return nullptr;
-        string hex_data = hex_data_opt.get();
-        parse_swap_event_hex(hex_data.substr(2), data);
-
-        data->return_chain_id = return_chain_id;
-        data->txid = txid.get().substr(2);
-
-        std::stringstream ss;
-        ss << std::hex << block_number.get().substr(2);
-        uint64_t block_number_dec;
-        ss >> block_number_dec;
-        data->block_number = block_number_dec;
-
-        return data;
-    }
-
-    swap_event_data *get_swap_event_data(const std::string &event_str,
-                                         swap_event_data *data,
-                                         const char *data_key,
-                                         const char *txid_key,
-                                         const char *block_number_key) {
-        boost::iostreams::stream<boost::iostreams::array_source> stream(event_str.c_str(), event_str.size());
-        namespace pt = boost::property_tree;
-        pt::ptree root;
-        pt::read_json(stream, root);
-        return get_swap_event_data(root, data, data_key, txid_key, block_number_key);
-    }
-
     asset uint64_to_rem_asset(unsigned long long amount) {
         std::string amount_dec_rem(to_string(amount));
         amount_dec_rem.insert(amount_dec_rem.end() - 4, '.');
@@ -546,27 +708,22 @@ namespace eosio {
         return asset::from_string(amount_dec_rem);
     }
 
-    std::vector<swap_event_data> get_prev_swap_events(const std::string &logs) {
-        vector<swap_event_data> swap_events;
 
-        boost::iostreams::stream<boost::iostreams::array_source> stream(logs.c_str(), logs.size());
-        namespace pt = boost::property_tree;
-        pt::ptree root;
-        pt::read_json(stream, root);
-
-        for (pt::ptree::value_type &log : root.get_child("result")) {
-            const std::string &key = log.first; // key
-            const boost::property_tree::ptree &subtree = log.second;
-
-            boost::optional<std::string> data_opt = subtree.get_optional<std::string>("data");
-            boost::optional<std::string> txid_opt = subtree.get_optional<std::string>("transactionHash");
+    std::vector<swap_event_data> get_swap_events(const fc::variants &logs) {
+        std::vector<swap_event_data> swap_events;
+        swap_events.reserve(logs.size());
+        for (const auto &log : logs) {
+            const auto &event = log.get_object();
+            if (!event.contains("data") || !event.contains("transactionHash"))
+                continue;
 
-            if (data_opt && txid_opt) {
-                swap_event_data event_data;
-                get_swap_event_data(subtree, &event_data, "data", "transactionHash", "blockNumber");
-                swap_events.push_back(event_data);
-            } else
+            swap_event_data event_data;
+            if (!parse_swap_event_hex(event["data"].as_string().substr(2), &event_data))
                 continue;
+            event_data.return_chain_id = return_chain_id;
+            event_data.txid = event["transactionHash"].as_string().substr(2);
+            event_data.block_number = event.contains("blockNumber") ? hex_to_uint64(event["blockNumber"].as_string()) : 0;
+            swap_events.push_back(std::move(event_data));
         }
         return swap_events;
     }
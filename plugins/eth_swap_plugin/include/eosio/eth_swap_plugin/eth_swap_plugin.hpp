@@ -8,38 +8,10 @@
 #include <eosio/http_plugin/http_plugin.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
 
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/json_parser.hpp>
-
 #include <websocketpp/config/asio_client.hpp>
 #include <websocketpp/client.hpp>
 #include <websocketpp/common/thread.hpp>
 
-#define FC_LOG_WAIT_AND_CONTINUE(...)  \
-    catch( const boost::interprocess::bad_alloc& ) {\
-       throw;\
-    } catch( fc::exception& er ) { \
-       wlog( "${details}", ("details",er.to_detail_string()) ); \
-       sleep(wait_for_eth_node); \
-       continue; \
-    } catch( const std::exception& e ) {  \
-       fc::exception fce( \
-                 FC_LOG_MESSAGE( warn, "rethrow ${what}: ",FC_FORMAT_ARG_PARAMS( __VA_ARGS__  )("what",e.what()) ), \
-                 fc::std_exception_code,\
-                 BOOST_CORE_TYPEID(e).name(), \
-                 e.what() ) ; \
-       wlog( "${details}", ("details",fce.to_detail_string()) ); \
-       sleep(wait_for_eth_node); \
-       continue; \
-    } catch( ... ) {  \
-       fc::unhandled_exception e( \
-                 FC_LOG_MESSAGE( warn, "rethrow", FC_FORMAT_ARG_PARAMS( __VA_ARGS__) ), \
-                 std::current_exception() ); \
-       wlog( "${details}", ("details",e.to_detail_string()) ); \
-       sleep(wait_for_eth_node); \
-       continue; \
-    }
-
 #define FC_LOG_AND_RETURN(...) \
     catch( const boost::interprocess::bad_alloc& ) {\
        throw;\
@@ -93,13 +65,15 @@ namespace eosio {
   infura doesn't support long filters so need to split to several filters
 */
     uint32_t blocks_per_filter = 10000;
-    uint32_t long_polling_blocks_per_filter = 10000;
-    uint32_t long_polling_period = 60;
 /*
-  maximum amount of checks for transaction confirmations of ethereum
-  if transaction doesn't have min_tx_confirmations
+  amount of filters requested in one JSON-RPC batch request
+  and amount of batch requests in flight while backfilling eth_events_window_length blocks
 */
-    uint32_t check_tx_confirmations_times = 5;
+    uint32_t rpc_batch_size = 10;
+    uint32_t backfill_parallel_requests = 4;
+    uint32_t eth_rpc_timeout = 30;  // amount of seconds to wait for a response of ethereum node
+    uint32_t long_polling_blocks_per_filter = 10000;
+    uint32_t long_polling_period = 60;
     uint32_t min_tx_confirmations = 10;  // minimum required request swap transaction confirmations on ethereum to init swap on remprotocol
     uint32_t wait_for_tx_confirmation = min_tx_confirmations *
                                         30;  // check if request swap transaction on ethereum is confirmed every wait_for_tx_confirmation seconds
@@ -110,7 +84,7 @@ namespace eosio {
   if transaction didn't make it to blockchain then retry to push it after <retry_push_tx_time> seconds
 */
     uint32_t retry_push_tx_time = init_swap_expiration_time + 60;
-    uint32_t wait_for_accept_tx = 1;  // amount of seconds to wait before checking if transaction is included to blockchain
+    uint32_t max_swaps_in_flight = 20;  // maximum amount of init swap transactions waiting for their result at the same time
 
     uint32_t start_monitor_delay = 15;  // amount of seconds to wait before running swap plugin functionality
 
@@ -131,25 +105,13 @@ namespace eosio {
 
     swap_event_data *parse_swap_event_hex(const std::string &hex_data, swap_event_data *data);
 
-    swap_event_data *get_swap_event_data(boost::property_tree::ptree root, swap_event_data *data, const char *data_key,
-                                         const char *txid_key, const char *block_number_key);
-
-    swap_event_data *
-    get_swap_event_data(const std::string &event_str, swap_event_data *data, const char *data_key, const char *txid_key,
-                        const char *block_number_key);
-
     eosio::asset uint64_to_rem_asset(unsigned long long amount);
 
-    std::vector<swap_event_data> get_prev_swap_events(const std::string &logs);
+    std::string uint64_to_hex(uint64_t value);
 
-    uint64_t get_last_block_num(std::string host, std::string endpoint);
+    uint64_t hex_to_uint64(const std::string &hex);
 
-    std::string get_filter_logs(const std::string &host,
-                                const std::string &endpoint,
-                                const std::string &contract_address,
-                                const std::string &from_block,
-                                const std::string &to_block,
-                                const std::string &topics);
+    std::vector<swap_event_data> get_swap_events(const fc::variants &logs);
 
     class InvalidEthLinkException : public std::exception {
     public:
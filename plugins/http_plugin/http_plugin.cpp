@@ -140,7 +140,7 @@ namespace eosio {
 
    class http_plugin_impl {
       public:
-         map<string,url_handler>  url_handlers;
+         map<string,url_deferred_handler>  url_handlers;
          optional<tcp::endpoint>  listen_endpoint;
          string                   access_control_allow_origin;
          string                   access_control_allow_headers;
@@ -291,6 +291,35 @@ namespace eosio {
             return true;
          }
 
+         template<class T>
+         void send_response( typename websocketpp::server<T>::connection_ptr con, int code, size_t response_size, response_body_writer writer,
+                             const string& content_type = "application/json" ) {
+            bytes_in_flight += response_size;
+            if( !verify_max_bytes_in_flight( con ) ) {
+               con->send_http_response();
+               bytes_in_flight -= response_size;
+               return;
+            }
+            boost::asio::post( thread_pool->get_executor(),
+                               [writer{std::move( writer )}, response_size, &bytes_in_flight = this->bytes_in_flight,
+                                con, code, content_type, max_response_time = max_response_time]() mutable {
+               size_t body_size = 0;
+               try {
+                  std::string body = writer( fc::time_point::now() + max_response_time );
+                  writer = nullptr; // release response data before sending
+                  body_size = body.size();
+                  bytes_in_flight += body_size;
+                  con->replace_header( "Content-type", content_type );
+                  con->set_body( std::move( body ) );
+                  con->set_status( websocketpp::http::status_code::value( code ) );
+               } catch( ... ) {
+                  handle_exception<T>( con );
+               }
+               con->send_http_response();
+               bytes_in_flight -= (body_size + response_size);
+            } );
+         }
+
          template<class T>
          void handle_http_request(typename websocketpp::server<T>::connection_ptr con) {
             try {
@@ -328,7 +357,7 @@ namespace eosio {
                   con->defer_http_response();
                   bytes_in_flight += body.size();
                   app().post( appbase::priority::low,
-                              [&ioc = thread_pool->get_executor(), &bytes_in_flight = this->bytes_in_flight,
+                              [&bytes_in_flight = this->bytes_in_flight,
                                handler_itr, this, resource{std::move( resource )}, body{std::move( body )}, con]() mutable {
                      const size_t body_size = body.size();
                      if( !verify_max_bytes_in_flight( con ) ) {
@@ -338,34 +367,18 @@ namespace eosio {
                      }
                      try {
                         handler_itr->second( std::move( resource ), std::move( body ),
-                                 [&ioc, &bytes_in_flight, con, this]( int code, fc::variant response_body ) {
+                                 [con, this]( int code, fc::variant response_body ) {
                            size_t response_size = 0;
                            try {
                               response_size = fc::raw::pack_size( response_body );
                            } catch(...) {}
-                           bytes_in_flight += response_size;
-                           if( !verify_max_bytes_in_flight( con ) ) {
-                              con->send_http_response();
-                              bytes_in_flight -= response_size;
-                           } else {
-                              boost::asio::post( ioc,
-                                 [response_body{std::move( response_body )}, response_size, &bytes_in_flight,
-                                  con, code, max_response_time=max_response_time]() mutable {
-                                 std::string json;
-                                 try {
-                                    json = fc::json::to_string( response_body, fc::time_point::now() + max_response_time );
-                                    con->set_body( std::move( json ) );
-                                    con->set_status( websocketpp::http::status_code::value( code ) );
-                                 } catch( ... ) {
-                                    handle_exception<T>( con );
-                                 }
-                                 response_body.clear();
-                                 const size_t json_size = json.size();
-                                 bytes_in_flight += json_size;
-                                 con->send_http_response();
-                                 bytes_in_flight -= (json_size + response_size);
-                              } );
-                           }
+                           send_response<T>( con, code, response_size,
+                                             [response_body{std::move( response_body )}]( const fc::time_point& deadline ) {
+                              return fc::json::to_string( response_body, deadline );
+                           } );
+                        },
+                                 [con, this]( int code, size_t response_size, response_body_writer writer, string content_type ) {
+                           send_response<T>( con, code, response_size, std::move( writer ), content_type );
                         });
                      } catch( ... ) {
                         handle_exception<T>( con );
@@ -696,6 +709,12 @@ namespace eosio {
    }
 
    void http_plugin::add_handler(const string& url, const url_handler& handler) {
+      add_deferred_handler( url, [handler]( string url, string body, url_response_callback cb, url_deferred_response_callback ) {
+         handler( std::move( url ), std::move( body ), std::move( cb ) );
+      } );
+   }
+
+   void http_plugin::add_deferred_handler(const string& url, const url_deferred_handler& handler) {
       fc_ilog( logger, "add api url: ${c}", ("c", url) );
       my->url_handlers.insert(std::make_pair(url,handler));
    }
@@ -27,6 +27,35 @@ namespace eosio {
     **/
    using url_handler = std::function<void(string,string,url_response_callback)>;
 
+   /**
+    * @brief Produces an already encoded (usually JSON) response body
+    *
+    * Called on an http thread, so that serialization of large responses happens neither on the
+    * calling thread nor through an intermediate fc::variant of the whole response.
+    *
+    * Arguments: deadline for producing the body
+    */
+   using response_body_writer = std::function<std::string(const fc::time_point&)>;
+
+   /**
+    * @brief A callback function provided to a deferred URL handler to allow it to specify the HTTP
+    * response code, content type and a writer for the body
+    *
+    * Arguments: response_code, estimated_response_size, response_body_writer, content_type
+    * The estimated size (in bytes) of the data held by the writer is used for http-max-bytes-in-flight-mb accounting.
+    */
+   using url_deferred_response_callback = std::function<void(int,size_t,response_body_writer,string)>;
+
+   /**
+    * @brief Callback type for a deferred URL handler
+    *
+    * Same as url_handler, the handler may respond through either url_response_callback (e.g. for errors)
+    * or url_deferred_response_callback, and must gaurantee that exactly one of them is called.
+    *
+    * Arguments: url, request_body, response_callback, deferred_response_callback
+    **/
+   using url_deferred_handler = std::function<void(string,string,url_response_callback,url_deferred_response_callback)>;
+
    /**
     * @brief An API, containing URLs and handlers
     *
@@ -35,6 +64,7 @@ namespace eosio {
     * call, and the handler is the function which implements the API call
     */
    using api_description = std::map<string, url_handler>;
+   using deferred_api_description = std::map<string, url_deferred_handler>;
 
    struct http_plugin_defaults {
       //If empty, unix socket support will be completely disabled. If not empty,
@@ -83,6 +113,12 @@ namespace eosio {
               add_handler(call.first, call.second);
         }
 
+        void add_deferred_handler(const string& url, const url_deferred_handler&);
+        void add_deferred_api(const deferred_api_description& api) {
+           for (const auto& call : api)
+              add_deferred_handler(call.first, call.second);
+        }
+
         // standard exception handling for api handlers
         static void handle_exception( const char *api_name, const char *call_name, const string& body, url_response_callback cb );
 
@@ -135,6 +135,11 @@ namespace eosio {
       uint32_t end_block;
    };
 
+   /// zlib compressed net_message, sent only to peers that negotiated compression
+   struct compressed_message {
+      bytes data; ///< the compressed net_message without its length header
+   };
+
    using net_message = static_variant<handshake_message,
                                       chain_size_message,
                                       go_away_message,
@@ -143,7 +148,8 @@ namespace eosio {
                                       request_message,
                                       sync_request_message,
                                       signed_block,         // which = 7
-                                      packed_transaction>;  // which = 8
+                                      packed_transaction,   // which = 8
+                                      compressed_message>;  // which = 9
 
 } // namespace eosio
 
@@ -162,6 +168,7 @@ FC_REFLECT( eosio::time_message, (org)(rec)(xmt)(dst) )
 FC_REFLECT( eosio::notice_message, (known_trx)(known_blocks) )
 FC_REFLECT( eosio::request_message, (req_trx)(req_blocks) )
 FC_REFLECT( eosio::sync_request_message, (start_block)(end_block) )
+FC_REFLECT( eosio::compressed_message, (data) )
 
 /**
  *
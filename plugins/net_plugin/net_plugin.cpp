@@ -23,9 +23,12 @@
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/steady_timer.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
 
 #include <atomic>
-#include <shared_mutex>
+#include <memory>
 
 using namespace eosio::chain::plugin_interface;
 
@@ -145,16 +148,47 @@ namespace eosio {
       connection_ptr sync_source;
       std::atomic<stages> sync_state;
 
+      /**
+       * With sync_fetch_peers > 1 lib catchup fetches spans of blocks from up to sync_fetch_peers peers at once.
+       * Blocks arriving ahead of the head are held in the reorder buffer until the blocks before them are applied.
+       *  @{
+       */
+      struct sync_span {
+         connection_ptr conn;
+         uint32_t       start = 0;
+         uint32_t       end = 0;
+         uint32_t       next_num = 0;  ///< next block expected from the peer
+         fc::time_point requested;
+      };
+
+      struct buffered_sync_block {
+         connection_wptr  conn;
+         block_id_type    id;
+         signed_block_ptr block;
+      };
+
+      uint32_t                                  sync_fetch_peers;
+      std::map<uint32_t, sync_span>             sync_spans;          ///< by connection_id, one span per peer
+      std::deque<std::pair<uint32_t, uint32_t>> sync_orphan_spans;   ///< ranges to request again, their peer went away
+      std::map<uint32_t, double>                sync_peer_rates;     ///< blocks per second by connection_id
+      std::map<uint32_t, buffered_sync_block>   sync_reorder_buffer; ///< by block number
+      /** @} */
+
    private:
       constexpr static auto stage_str( stages s );
       void set_state( stages s );
       bool is_sync_required( uint32_t fork_head_block_num );
       void request_next_chunk( std::unique_lock<std::mutex> g_sync, const connection_ptr& conn = connection_ptr() );
+      void request_sync_spans( std::unique_lock<std::mutex> g_sync );
+      void release_sync_span( const connection_ptr& c );
+      void orphan_sync_block( uint32_t blk_num );
+      uint32_t sync_span_size( uint32_t connection_id ) const;
+      size_t max_buffered_sync_blocks() const { return size_t( sync_req_span ) * sync_fetch_peers * 2; }
       void start_sync( const connection_ptr& c, uint32_t target );
       bool verify_catchup( const connection_ptr& c, uint32_t num, const block_id_type& id );
 
    public:
-      explicit sync_manager( uint32_t span );
+      sync_manager( uint32_t span, uint32_t fetch_peers );
       static void send_handshakes();
       bool syncing_with_peer() const { return sync_state == lib_catchup; }
       void sync_reset_lib_num( const connection_ptr& conn );
@@ -164,6 +198,20 @@ namespace eosio {
       void sync_update_expected( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied );
       void recv_handshake( const connection_ptr& c, const handshake_message& msg );
       void sync_recv_notice( const connection_ptr& c, const notice_message& msg );
+
+      void sync_block_arrived( const connection_ptr& c, uint32_t blk_num );
+      bool buffer_sync_block( const connection_ptr& c, const block_id_type& blk_id, const signed_block_ptr& b, uint32_t fork_head_num );
+      void apply_buffered_sync_block( uint32_t blk_num );
+   };
+
+   /// a block or transaction message as sent on the wire, length header included
+   struct wire_message {
+      std::shared_ptr<std::vector<char>> plain;
+      std::shared_ptr<std::vector<char>> compressed; ///< compressed_message of plain, null if unknown or not smaller
+
+      const std::shared_ptr<std::vector<char>>& for_peer( bool compress ) const {
+         return compress && compressed ? compressed : plain;
+      }
    };
 
    class dispatch_manager {
@@ -172,6 +220,15 @@ namespace eosio {
       mutable std::mutex      local_txns_mtx;
       node_transaction_index  local_txns;
 
+      // wire bytes of blocks and transactions received from peers, relayed as received instead of repacking them.
+      // Only relayed for the very object unpacked from them, which is kept alongside.
+      mutable std::mutex      received_mtx;
+      std::map<block_id_type, std::pair<signed_block_ptr, wire_message>>             received_blocks;
+      std::map<transaction_id_type, std::pair<packed_transaction_ptr, wire_message>> received_txns;
+
+      wire_message take_received_block( const block_state_ptr& bs );
+      wire_message take_received_txn( const packed_transaction& trx );
+
    public:
       boost::asio::io_context::strand  strand;
 
@@ -186,6 +243,9 @@ namespace eosio {
 
       void recv_block(const connection_ptr& conn, const block_id_type& msg, uint32_t bnum);
       void expire_blocks( uint32_t bnum );
+
+      void add_received_block( const block_id_type& id, const signed_block_ptr& sb, wire_message wire );
+      void add_received_txn( const packed_transaction_ptr& trx, wire_message wire );
       void recv_notice(const connection_ptr& conn, const notice_message& msg, bool generated);
 
       void retry_fetch(const connection_ptr& conn);
@@ -249,10 +309,25 @@ namespace eosio {
       chain_plugin*                         chain_plug = nullptr;
       producer_plugin*                      producer_plug = nullptr;
       bool                                  use_socket_read_watermark = false;
+      bool                                  p2p_compression = false;
       /** @} */
 
-      mutable std::shared_mutex             connections_mtx;
-      std::set< connection_ptr >            connections;     // todo: switch to a thread safe container to avoid big mutex over complete collection
+      using connection_set = std::set< connection_ptr >;
+
+      std::mutex                            connections_mtx; // serializes updates of connections
+      /// copy on write, so that broadcasts iterate a snapshot without contending with accept, close and connection_monitor
+      std::shared_ptr<const connection_set> connections = std::make_shared<const connection_set>();
+
+      /// thread safe, the connections at the time of the call
+      std::shared_ptr<const connection_set> connections_snapshot() const { return std::atomic_load( &connections ); }
+
+      /// call with connections_mtx, publishes a copy of the connections modified by `f`
+      template<typename Function>
+      void update_connections( Function f ) {
+         auto updated = std::make_shared<connection_set>( *connections_snapshot() );
+         f( *updated );
+         std::atomic_store( &connections, std::shared_ptr<const connection_set>( std::move( updated ) ) );
+      }
 
       std::mutex                            connector_check_timer_mtx;
       unique_ptr<boost::asio::steady_timer> connector_check_timer;
@@ -332,7 +407,7 @@ namespace eosio {
 
       constexpr uint16_t to_protocol_version(uint16_t v);
 
-      connection_ptr find_connection(const string& host)const; // must call with held mutex
+      connection_ptr find_connection(const string& host)const;
    };
 
    const fc::string logger_name("net_plugin_impl");
@@ -388,10 +463,13 @@ namespace eosio {
    constexpr auto     def_txn_expire_wait = std::chrono::seconds(3);
    constexpr auto     def_resp_expected_wait = std::chrono::seconds(5);
    constexpr auto     def_sync_fetch_span = 100;
+   constexpr auto     def_sync_fetch_peers = 1;
+   constexpr auto     def_compression_min_size = 1024; // smaller messages are not worth compressing
 
    constexpr auto     message_header_size = 4;
    constexpr uint32_t signed_block_which = 7;        // see protocol net_message
    constexpr uint32_t packed_transaction_which = 8;  // see protocol net_message
+   constexpr uint32_t compressed_message_which = 9;  // see protocol net_message
 
    /**
     *  For a while, network version was a 16 bit value equal to the second set of 16 bits
@@ -414,8 +492,9 @@ namespace eosio {
    constexpr uint16_t proto_base = 0;
    constexpr uint16_t proto_explicit_sync = 1;
    constexpr uint16_t block_id_notify = 2; // reserved. feature was removed. next net_version should be 3
+   constexpr uint16_t proto_compression = 3; // peer accepts compressed_message
 
-   constexpr uint16_t net_version = proto_explicit_sync;
+   constexpr uint16_t net_version = proto_compression;
 
    /**
     * Index by start_block_num
@@ -574,6 +653,7 @@ namespace eosio {
       int16_t                 sent_handshake_count = 0;
       std::atomic<bool>       connecting{true};
       std::atomic<bool>       syncing{false};
+      std::atomic<bool>       compress_messages{false}; // we and the peer both support compression
       uint16_t                protocol_version = 0;
       uint16_t                consecutive_rejected_blocks = 0;
       std::atomic<uint16_t>   consecutive_immediate_connection_close = 0;
@@ -634,6 +714,10 @@ namespace eosio {
        * encountered unpacking or processing the message.
        */
       bool process_next_message(uint32_t message_length);
+      /// copy of the next message, header included, as a send buffer; pending_message_buffer is not advanced
+      std::shared_ptr<std::vector<char>> peek_message(uint32_t message_length);
+      void process_wire_message( uint32_t which, wire_message wire );
+      void drop_padded_wire( const fc::datastream<const char*>& ds, wire_message& wire );
 
       void send_handshake( bool force = false );
 
@@ -710,11 +794,12 @@ namespace eosio {
       void handle_message( const request_message& msg );
       void handle_message( const sync_request_message& msg );
       void handle_message( const signed_block& msg ) = delete; // signed_block_ptr overload used instead
-      void handle_message( const block_id_type& id, signed_block_ptr msg );
+      void handle_message( const block_id_type& id, signed_block_ptr msg, wire_message wire );
       void handle_message( const packed_transaction& msg ) = delete; // packed_transaction_ptr overload used instead
-      void handle_message( packed_transaction_ptr msg );
+      void handle_message( packed_transaction_ptr msg, wire_message wire );
 
-      void process_signed_block( const block_id_type& id, signed_block_ptr msg );
+      /// `buffered` blocks come from the sync reorder buffer and are applied even if the connection closed since
+      void process_signed_block( const block_id_type& id, signed_block_ptr msg, bool buffered = false );
 
       fc::variant_object get_logger_variant()  {
          fc::mutable_variant_object mvo;
@@ -787,16 +872,16 @@ namespace eosio {
 
    template<typename Function>
    void for_each_connection( Function f ) {
-      std::shared_lock<std::shared_mutex> g( my_impl->connections_mtx );
-      for( auto& c : my_impl->connections ) {
+      auto connections = my_impl->connections_snapshot();
+      for( auto& c : *connections ) {
          if( !f( c ) ) return;
       }
    }
 
    template<typename Function>
    void for_each_block_connection( Function f ) {
-      std::shared_lock<std::shared_mutex> g( my_impl->connections_mtx );
-      for( auto& c : my_impl->connections ) {
+      auto connections = my_impl->connections_snapshot();
+      for( auto& c : *connections ) {
          if( c->is_transactions_only_connection() ) continue;
          if( !f( c ) ) return;
       }
@@ -1238,10 +1323,78 @@ namespace eosio {
       return create_send_buffer( packed_transaction_which, trx );
    }
 
+   namespace bio = boost::iostreams;
+
+   template<size_t Limit>
+   struct decompression_limiter {
+      using char_type = char;
+      using category = bio::multichar_output_filter_tag;
+
+      template<typename Sink>
+      size_t write( Sink& sink, const char* s, size_t count ) {
+         EOS_ASSERT( _total + count <= Limit, plugin_exception, "Exceeded maximum decompressed message size" );
+         _total += count;
+         return bio::write( sink, s, count );
+      }
+
+      size_t _total = 0;
+   };
+
+   // compressed_message of the message in send_buffer, null if the message is small or does not compress
+   static std::shared_ptr<std::vector<char>> create_compressed_send_buffer( const std::vector<char>& send_buffer ) {
+      if( send_buffer.size() < def_compression_min_size ) return {};
+
+      compressed_message msg;
+      bio::filtering_ostream comp;
+      comp.push( bio::zlib_compressor( bio::zlib::default_compression ) );
+      comp.push( bio::back_inserter( msg.data ) );
+      bio::write( comp, send_buffer.data() + message_header_size, send_buffer.size() - message_header_size );
+      bio::close( comp );
+
+      auto compressed = create_send_buffer( compressed_message_which, msg );
+      if( compressed->size() >= send_buffer.size() ) return {};
+      return compressed;
+   }
+
+   // the message compressed in the compressed_message of compressed_buffer, length header included
+   static std::shared_ptr<std::vector<char>> decompress_send_buffer( const std::vector<char>& compressed_buffer ) {
+      fc::datastream<const char*> ds( compressed_buffer.data() + message_header_size, compressed_buffer.size() - message_header_size );
+      unsigned_int which{};
+      fc::raw::unpack( ds, which ); // throw away
+      compressed_message msg;
+      fc::raw::unpack( ds, msg );
+      EOS_ASSERT( ds.remaining() == 0, plugin_exception, "Unexpected data after compressed message" );
+
+      auto send_buffer = std::make_shared<std::vector<char>>( message_header_size );
+      try {
+         bio::filtering_ostream decomp;
+         decomp.push( bio::zlib_decompressor() );
+         decomp.push( decompression_limiter<def_send_buffer_size*2>() ); // same limit as uncompressed messages
+         decomp.push( bio::back_inserter( *send_buffer ) );
+         bio::write( decomp, msg.data.data(), msg.data.size() );
+         bio::close( decomp );
+      } catch( fc::exception& er ) {
+         throw;
+      } catch( ... ) {
+         fc::unhandled_exception er( FC_LOG_MESSAGE( warn, "internal decompression error"), std::current_exception() );
+         throw er;
+      }
+
+      const uint32_t payload_size = send_buffer->size() - message_header_size;
+      EOS_ASSERT( payload_size > 0, plugin_exception, "Empty compressed message" );
+      memcpy( send_buffer->data(), &payload_size, message_header_size );
+      return send_buffer;
+   }
+
    void connection::enqueue_block( const signed_block_ptr& sb, bool to_sync_queue) {
       fc_dlog( logger, "enqueue block ${num}", ("num", sb->block_num()) );
       verify_strand_in_this_thread( strand, __func__, __LINE__ );
-      enqueue_buffer( create_send_buffer( sb ), no_reason, to_sync_queue);
+      auto send_buffer = create_send_buffer( sb );
+      if( compress_messages ) {
+         auto compressed = create_compressed_send_buffer( *send_buffer );
+         if( compressed ) send_buffer = std::move( compressed );
+      }
+      enqueue_buffer( send_buffer, no_reason, to_sync_queue);
    }
 
    void connection::enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
@@ -1335,13 +1488,14 @@ namespace eosio {
 
    //-----------------------------------------------------------
 
-    sync_manager::sync_manager( uint32_t req_span )
+    sync_manager::sync_manager( uint32_t req_span, uint32_t fetch_peers )
       :sync_known_lib_num( 0 )
       ,sync_last_requested_num( 0 )
       ,sync_next_expected_num( 1 )
       ,sync_req_span( req_span )
       ,sync_source()
       ,sync_state(in_sync)
+      ,sync_fetch_peers( fetch_peers )
    {
    }
 
@@ -1373,6 +1527,11 @@ namespace eosio {
          if( c->last_handshake_recv.last_irreversible_block_num > sync_known_lib_num ) {
             sync_known_lib_num = c->last_handshake_recv.last_irreversible_block_num;
          }
+      } else if( sync_fetch_peers > 1 ) {
+         if( sync_spans.count( c->connection_id ) ) {
+            release_sync_span( c );
+            request_sync_spans( std::move(g) );
+         }
       } else if( c == sync_source ) {
          sync_last_requested_num = 0;
          request_next_chunk( std::move(g) );
@@ -1381,6 +1540,11 @@ namespace eosio {
 
    // call with g_sync locked
    void sync_manager::request_next_chunk( std::unique_lock<std::mutex> g_sync, const connection_ptr& conn ) {
+      if( sync_fetch_peers > 1 ) {
+         request_sync_spans( std::move( g_sync ) );
+         return;
+      }
+
       uint32_t fork_head_block_num = 0;
       uint32_t lib_block_num = 0;
       std::tie( lib_block_num, std::ignore, fork_head_block_num,
@@ -1404,36 +1568,36 @@ namespace eosio {
       if (conn && conn->current() ) {
          sync_source = conn;
       } else {
-         std::shared_lock<std::shared_mutex> g( my_impl->connections_mtx );
-         if( my_impl->connections.size() == 0 ) {
+         auto connections = my_impl->connections_snapshot();
+         if( connections->size() == 0 ) {
             sync_source.reset();
-         } else if( my_impl->connections.size() == 1 ) {
+         } else if( connections->size() == 1 ) {
             if (!sync_source) {
-               sync_source = *my_impl->connections.begin();
+               sync_source = *connections->begin();
             }
          } else {
             // init to a linear array search
-            auto cptr = my_impl->connections.begin();
-            auto cend = my_impl->connections.end();
+            auto cptr = connections->begin();
+            auto cend = connections->end();
             // do we remember the previous source?
             if (sync_source) {
                //try to find it in the list
-               cptr = my_impl->connections.find( sync_source );
+               cptr = connections->find( sync_source );
                cend = cptr;
-               if( cptr == my_impl->connections.end() ) {
+               if( cptr == connections->end() ) {
                   //not there - must have been closed! cend is now connections.end, so just flatten the ring.
                   sync_source.reset();
-                  cptr = my_impl->connections.begin();
+                  cptr = connections->begin();
                } else {
                   //was found - advance the start to the next. cend is the old source.
-                  if( ++cptr == my_impl->connections.end() && cend != my_impl->connections.end() ) {
-                     cptr = my_impl->connections.begin();
+                  if( ++cptr == connections->end() && cend != connections->end() ) {
+                     cptr = connections->begin();
                   }
                }
             }
 
             //scan the list of peers looking for another able to provide sync blocks.
-            if( cptr != my_impl->connections.end() ) {
+            if( cptr != connections->end() ) {
                auto cstart_it = cptr;
                do {
                   //select the first one which is current and break out.
@@ -1441,8 +1605,8 @@ namespace eosio {
                      sync_source = *cptr;
                      break;
                   }
-                  if( ++cptr == my_impl->connections.end() )
-                     cptr = my_impl->connections.begin();
+                  if( ++cptr == connections->end() )
+                     cptr = connections->begin();
                } while( cptr != cstart_it );
             }
             // no need to check the result, either source advanced or the whole list was checked and the old source is reused.
@@ -1482,6 +1646,224 @@ namespace eosio {
       }
    }
 
+   // call with g_sync locked, hands the next spans to idle peers, fastest first
+   void sync_manager::request_sync_spans( std::unique_lock<std::mutex> g_sync ) {
+      uint32_t fork_head_block_num = 0;
+      uint32_t lib_block_num = 0;
+      std::tie( lib_block_num, std::ignore, fork_head_block_num,
+                std::ignore, std::ignore, std::ignore ) = my_impl->get_chain_info();
+
+      if( sync_state != lib_catchup ) {
+         return;
+      }
+
+      // drop what has been applied since the spans were orphaned
+      for( auto itr = sync_orphan_spans.begin(); itr != sync_orphan_spans.end(); ) {
+         if( itr->second <= fork_head_block_num ) {
+            itr = sync_orphan_spans.erase( itr );
+         } else {
+            itr->first = std::max( itr->first, fork_head_block_num + 1 );
+            ++itr;
+         }
+      }
+
+      const size_t max_buffered = max_buffered_sync_blocks();
+      if( sync_spans.empty() && sync_orphan_spans.empty() && sync_reorder_buffer.size() >= max_buffered ) {
+         // nothing outstanding can fill the gap before the buffered blocks, fetch it again
+         const uint32_t first_buffered = sync_reorder_buffer.begin()->first;
+         if( first_buffered > fork_head_block_num + 1 ) {
+            sync_orphan_spans.emplace_back( fork_head_block_num + 1, first_buffered - 1 );
+         }
+      }
+
+      std::vector<std::pair<connection_ptr, uint32_t>> idle_peers; // with the lib they reported
+      for_each_block_connection( [this, &idle_peers]( const auto& c ) {
+         if( c->current() && sync_spans.find( c->connection_id ) == sync_spans.end() ) {
+            std::lock_guard<std::mutex> g_conn( c->conn_mtx );
+            idle_peers.emplace_back( c, c->last_handshake_recv.last_irreversible_block_num );
+         }
+         return true;
+      } );
+
+      // peers without a measured rate first, so that every peer gets measured
+      auto rate = [this]( const connection_ptr& c ) {
+         auto itr = sync_peer_rates.find( c->connection_id );
+         return itr == sync_peer_rates.end() ? std::numeric_limits<double>::max() : itr->second;
+      };
+      std::sort( idle_peers.begin(), idle_peers.end(), [&rate]( const auto& a, const auto& b ) {
+         return rate( a.first ) > rate( b.first );
+      } );
+
+      std::vector<std::tuple<connection_ptr, uint32_t, uint32_t>> requests;
+      for( const auto& peer : idle_peers ) {
+         if( sync_spans.size() >= sync_fetch_peers ) break;
+         const connection_ptr& c = peer.first;
+         const uint32_t peer_lib = peer.second;
+
+         uint32_t start = 0;
+         uint32_t end = 0;
+         if( !sync_orphan_spans.empty() && sync_orphan_spans.front().second <= peer_lib ) {
+            std::tie( start, end ) = sync_orphan_spans.front();
+            sync_orphan_spans.pop_front();
+         } else {
+            if( sync_reorder_buffer.size() >= max_buffered ) break;
+            start = std::max( sync_last_requested_num, fork_head_block_num ) + 1;
+            end = std::min( { start + sync_span_size( c->connection_id ) - 1, sync_known_lib_num, peer_lib } );
+            if( start > sync_known_lib_num ) break;
+            if( end < start ) continue;
+            sync_last_requested_num = end;
+         }
+
+         sync_spans[c->connection_id] = sync_span{ c, start, end, start, fc::time_point::now() };
+         requests.emplace_back( c, start, end );
+      }
+
+      if( sync_spans.empty() && !idle_peers.empty() ) {
+         // every idle peer reported a lib below what is left to fetch, so the blocks past their lib are fetched from
+         // the peer with the highest lib, the way lib catchup does with a single sync peer
+         const auto& best = *std::max_element( idle_peers.begin(), idle_peers.end(), []( const auto& a, const auto& b ) {
+            return a.second < b.second;
+         } );
+         uint32_t start = 0;
+         uint32_t end = 0;
+         if( !sync_orphan_spans.empty() ) {
+            std::tie( start, end ) = sync_orphan_spans.front();
+            sync_orphan_spans.pop_front();
+         } else if( sync_reorder_buffer.size() < max_buffered ) {
+            start = std::max( sync_last_requested_num, fork_head_block_num ) + 1;
+            end = std::min( start + sync_req_span - 1, sync_known_lib_num );
+            if( end >= start ) sync_last_requested_num = end;
+         }
+         if( start > 0 && end >= start ) {
+            fc_dlog( logger, "no peer lib covers ${s}, fetching from ${p} alone", ("s", start)("p", best.first->peer_name()) );
+            sync_spans[best.first->connection_id] = sync_span{ best.first, start, end, start, fc::time_point::now() };
+            requests.emplace_back( best.first, start, end );
+         }
+      }
+
+      if( sync_spans.empty() && idle_peers.empty() ) {
+         fc_elog( logger, "Unable to continue syncing at this time");
+         sync_known_lib_num = lib_block_num;
+         sync_last_requested_num = 0;
+         set_state( in_sync ); // probably not, but we can't do anything else
+         return;
+      }
+      g_sync.unlock();
+
+      for( const auto& r : requests ) {
+         const auto& c = std::get<0>( r );
+         c->strand.post( [c, start = std::get<1>( r ), end = std::get<2>( r )]() {
+            fc_ilog( logger, "requesting range ${s} to ${e}, from ${n}", ("n", c->peer_name())( "s", start )( "e", end ) );
+            c->request_sync_blocks( start, end );
+         } );
+      }
+   }
+
+   // call with g_sync locked, the rest of the span of `c` is requested again from another peer
+   void sync_manager::release_sync_span( const connection_ptr& c ) {
+      auto itr = sync_spans.find( c->connection_id );
+      if( itr == sync_spans.end() ) return;
+      if( itr->second.next_num <= itr->second.end ) {
+         sync_orphan_spans.emplace_back( itr->second.next_num, itr->second.end );
+      }
+      sync_spans.erase( itr );
+   }
+
+   // call with g_sync locked, `blk_num` is requested again, consecutive blocks in a single span
+   void sync_manager::orphan_sync_block( uint32_t blk_num ) {
+      if( !sync_orphan_spans.empty() && sync_orphan_spans.back().second + 1 == blk_num ) {
+         sync_orphan_spans.back().second = blk_num;
+      } else {
+         sync_orphan_spans.emplace_back( blk_num, blk_num );
+      }
+   }
+
+   // call with g_sync locked, the fastest peer gets sync_req_span blocks, slower peers proportionally less
+   uint32_t sync_manager::sync_span_size( uint32_t connection_id ) const {
+      auto itr = sync_peer_rates.find( connection_id );
+      if( itr == sync_peer_rates.end() ) return sync_req_span;
+      double best_rate = 0;
+      for( const auto& r : sync_peer_rates ) {
+         best_rate = std::max( best_rate, r.second );
+      }
+      const uint32_t min_span = std::max<uint32_t>( sync_req_span / 4, 1 );
+      return std::max<uint32_t>( sync_req_span * ( itr->second / best_rate ), min_span );
+   }
+
+   // called from connection strand, tracks the progress of the span of `c`
+   void sync_manager::sync_block_arrived( const connection_ptr& c, uint32_t blk_num ) {
+      if( sync_fetch_peers <= 1 ) return;
+      std::unique_lock<std::mutex> g_sync( sync_mtx );
+      auto itr = sync_spans.find( c->connection_id );
+      if( itr == sync_spans.end() || blk_num < itr->second.next_num || blk_num > itr->second.end ) return;
+
+      auto& span = itr->second;
+      span.next_num = blk_num + 1;
+      if( blk_num < span.end ) {
+         g_sync.unlock();
+         c->sync_wait();
+         return;
+      }
+
+      const int64_t elapsed_us = std::max<int64_t>( (fc::time_point::now() - span.requested).count(), 1 );
+      const double rate = ( span.end - span.start + 1 ) * 1000000.0 / elapsed_us;
+      auto r = sync_peer_rates.emplace( c->connection_id, rate );
+      if( !r.second ) {
+         r.first->second = ( r.first->second + rate ) / 2;
+      }
+      fc_dlog( logger, "span ${s} to ${e} from ${p} done, ${r} blocks/sec",
+               ("s", span.start)("e", span.end)("p", c->peer_name())("r", r.first->second) );
+      sync_spans.erase( itr );
+      c->cancel_wait();
+      request_sync_spans( std::move( g_sync ) );
+   }
+
+   // called from application thread, true if the block is held until the blocks before it are applied
+   bool sync_manager::buffer_sync_block( const connection_ptr& c, const block_id_type& blk_id, const signed_block_ptr& b,
+                                         uint32_t fork_head_num ) {
+      if( sync_fetch_peers <= 1 ) return false;
+      const uint32_t blk_num = b->block_num();
+      std::lock_guard<std::mutex> g_sync( sync_mtx );
+      sync_reorder_buffer.erase( sync_reorder_buffer.begin(), sync_reorder_buffer.upper_bound( fork_head_num ) );
+      if( sync_state != lib_catchup || blk_num <= fork_head_num + 1 || blk_num > sync_last_requested_num ) {
+         return false;
+      }
+      if( sync_reorder_buffer.size() >= max_buffered_sync_blocks() ) {
+         // the blocks farthest from the head make room and are fetched again later
+         auto last = std::prev( sync_reorder_buffer.end() );
+         if( blk_num > last->first ) {
+            orphan_sync_block( blk_num );
+            return true;
+         }
+         orphan_sync_block( last->first );
+         sync_reorder_buffer.erase( last );
+      }
+      sync_reorder_buffer.emplace( blk_num, buffered_sync_block{ c, blk_id, b } );
+      return true;
+   }
+
+   // called from application thread, applies the buffered block `blk_num` if there is one
+   void sync_manager::apply_buffered_sync_block( uint32_t blk_num ) {
+      if( sync_fetch_peers <= 1 ) return;
+      std::unique_lock<std::mutex> g_sync( sync_mtx );
+      auto itr = sync_reorder_buffer.find( blk_num );
+      if( itr == sync_reorder_buffer.end() ) return;
+      buffered_sync_block next = std::move( itr->second );
+      sync_reorder_buffer.erase( itr );
+      connection_ptr c = next.conn.lock();
+      if( !c ) {
+         // its peer went away, the block is fetched again rather than keeping the connection alive
+         sync_orphan_spans.emplace_front( blk_num, blk_num );
+         request_sync_spans( std::move( g_sync ) );
+         return;
+      }
+      g_sync.unlock();
+
+      app().post( priority::high, [c{std::move( c )}, next{std::move( next )}]() {
+         c->process_signed_block( next.id, next.block, true );
+      } );
+   }
+
    // static, thread safe
    void sync_manager::send_handshakes() {
       for_each_connection( []( auto& ci ) {
@@ -1535,7 +1917,13 @@ namespace eosio {
       fc_ilog( logger, "reassign_fetch, our last req is ${cc}, next expected is ${ne} peer ${p}",
                ("cc", sync_last_requested_num)( "ne", sync_next_expected_num )( "p", c->peer_name() ) );
 
-      if( c == sync_source ) {
+      if( sync_fetch_peers > 1 ) {
+         if( sync_spans.count( c->connection_id ) ) {
+            release_sync_span( c );
+            c->cancel_sync(reason);
+            request_sync_spans( std::move(g) );
+         }
+      } else if( c == sync_source ) {
          c->cancel_sync(reason);
          sync_last_requested_num = 0;
          request_next_chunk( std::move(g) );
@@ -1725,6 +2113,14 @@ namespace eosio {
    // called from connection strand
    void sync_manager::rejected_block( const connection_ptr& c, uint32_t blk_num ) {
       std::unique_lock<std::mutex> g( sync_mtx );
+      const bool refetch = sync_fetch_peers > 1 && sync_state == lib_catchup;
+      if( refetch ) {
+         // the blocks buffered after it do not link without it, the gap up to them is fetched again right away
+         release_sync_span( c );
+         auto next_buffered = sync_reorder_buffer.upper_bound( blk_num );
+         const uint32_t end = next_buffered == sync_reorder_buffer.end() ? blk_num : next_buffered->first - 1;
+         sync_orphan_spans.emplace_front( blk_num, end );
+      }
       if( ++c->consecutive_rejected_blocks > def_max_consecutive_rejected_blocks ) {
          fc_wlog( logger, "block ${bn} not accepted from ${p}, closing connection", ("bn", blk_num)("p", c->peer_name()) );
          sync_last_requested_num = 0;
@@ -1732,8 +2128,13 @@ namespace eosio {
          g.unlock();
          c->close();
       } else {
+         g.unlock();
          c->send_handshake( true );
       }
+      if( refetch ) {
+         g.lock();
+         request_sync_spans( std::move( g ) );
+      }
    }
 
    // called from connection strand
@@ -1799,8 +2200,16 @@ namespace eosio {
          if( blk_num == sync_known_lib_num ) {
             fc_dlog( logger, "All caught up with last known last irreversible block resending handshake" );
             set_state( in_sync );
+            sync_spans.clear();
+            sync_orphan_spans.clear();
+            sync_reorder_buffer.clear();
             g_sync.unlock();
             send_handshakes();
+         } else if( sync_fetch_peers > 1 ) {
+            // spans are requested as peers finish theirs, and as the reorder buffer drains
+            if( blk_applied && sync_spans.size() < sync_fetch_peers ) {
+               request_sync_spans( std::move( g_sync ) );
+            }
          } else if( blk_num == sync_last_requested_num ) {
             request_next_chunk( std::move( g_sync) );
          } else {
@@ -1908,13 +2317,62 @@ namespace eosio {
       end_size = local_txns.size();
       g.unlock();
 
+      // transactions which were never acked
+      std::unique_lock<std::mutex> g_received( received_mtx );
+      const fc::time_point_sec now = time_point::now();
+      for( auto itr = received_txns.begin(); itr != received_txns.end(); ) {
+         if( itr->second.first->expiration() < now ) {
+            itr = received_txns.erase( itr );
+         } else {
+            ++itr;
+         }
+      }
+      g_received.unlock();
+
       fc_dlog( logger, "expire_local_txns size ${s} removed ${r}", ("s", start_size)( "r", start_size - end_size ) );
    }
 
    void dispatch_manager::expire_blocks( uint32_t lib_num ) {
-      std::lock_guard<std::mutex> g(blk_state_mtx);
+      std::unique_lock<std::mutex> g(blk_state_mtx);
       auto& stale_blk = blk_state.get<by_block_num>();
       stale_blk.erase( stale_blk.lower_bound(1), stale_blk.upper_bound(lib_num) );
+      g.unlock();
+
+      // block ids start with the big endian block number, so received_blocks is ordered by block number
+      std::lock_guard<std::mutex> g_received( received_mtx );
+      while( !received_blocks.empty() && block_header::num_from_id( received_blocks.begin()->first ) <= lib_num ) {
+         received_blocks.erase( received_blocks.begin() );
+      }
+   }
+
+   void dispatch_manager::add_received_block( const block_id_type& id, const signed_block_ptr& sb, wire_message wire ) {
+      if( !wire.plain ) return; // repacked when relayed
+      std::lock_guard<std::mutex> g( received_mtx );
+      received_blocks.emplace( id, std::make_pair( sb, std::move( wire ) ) );
+   }
+
+   wire_message dispatch_manager::take_received_block( const block_state_ptr& bs ) {
+      std::lock_guard<std::mutex> g( received_mtx );
+      auto itr = received_blocks.find( bs->id );
+      if( itr == received_blocks.end() ) return {};
+      auto wire = itr->second.first == bs->block ? std::move( itr->second.second ) : wire_message();
+      received_blocks.erase( itr );
+      return wire;
+   }
+
+   void dispatch_manager::add_received_txn( const packed_transaction_ptr& trx, wire_message wire ) {
+      if( !wire.plain ) return; // repacked when relayed
+      std::lock_guard<std::mutex> g( received_mtx );
+      received_txns.emplace( trx->id(), std::make_pair( trx, std::move( wire ) ) );
+   }
+
+   wire_message dispatch_manager::take_received_txn( const packed_transaction& trx ) {
+      std::lock_guard<std::mutex> g( received_mtx );
+      auto itr = received_txns.find( trx.id() );
+      if( itr == received_txns.end() ) return {};
+      auto wire = itr->second.first.get() == &trx ? std::move( itr->second.second ) : wire_message();
+      received_txns.erase( itr );
+      return wire;
    }
 
    // thread safe
@@ -1924,7 +2382,8 @@ namespace eosio {
       if( my_impl->sync_master->syncing_with_peer() ) return;
 
       bool have_connection = false;
-      for_each_block_connection( [&have_connection]( auto& cp ) {
+      bool compress = false;
+      for_each_block_connection( [&have_connection, &compress]( auto& cp ) {
          peer_dlog( cp, "socket_is_open ${s}, connecting ${c}, syncing ${ss}",
                     ("s", cp->socket_is_open())("c", cp->connecting.load())("ss", cp->syncing.load()) );
 
@@ -1932,17 +2391,27 @@ namespace eosio {
             return true;
          }
          have_connection = true;
-         return false;
+         compress = cp->compress_messages;
+         return !compress;
       } );
 
+      wire_message wire = take_received_block( bs );
       if( !have_connection ) return;
-      std::shared_ptr<std::vector<char>> send_buffer = create_send_buffer( bs->block );
+      if( !wire.plain ) {
+         wire.plain = create_send_buffer( bs->block );
+      } else {
+         fc_dlog( logger, "relaying block ${bn} as received", ("bn", bs->block_num) );
+      }
+      if( compress && !wire.compressed ) {
+         // compressed once for all peers that negotiated compression
+         wire.compressed = create_compressed_send_buffer( *wire.plain );
+      }
 
-      for_each_block_connection( [this, bs, send_buffer]( auto& cp ) {
+      for_each_block_connection( [this, bs, &wire]( auto& cp ) {
          if( !cp->current() ) {
             return true;
          }
-         cp->strand.post( [this, cp, bs, send_buffer]() {
+         cp->strand.post( [this, cp, bs, send_buffer = wire.for_peer( cp->compress_messages )]() {
             uint32_t bnum = bs->block_num;
             std::unique_lock<std::mutex> g_conn( cp->conn_mtx );
             bool has_block = cp->last_handshake_recv.last_irreversible_block_num >= bnum;
@@ -1986,8 +2455,9 @@ namespace eosio {
       time_point_sec trx_expiration = trx.expiration();
       node_transaction_state nts = {id, trx_expiration, 0, 0};
 
-      std::shared_ptr<std::vector<char>> send_buffer;
-      for_each_connection( [this, &trx, &nts, &send_buffer]( auto& cp ) {
+      wire_message wire = take_received_txn( trx );
+      bool compression_tried = false;
+      for_each_connection( [this, &trx, &nts, &wire, &compression_tried]( auto& cp ) {
          if( cp->is_blocks_only_connection() || !cp->current() ) {
             return true;
          }
@@ -1995,11 +2465,16 @@ namespace eosio {
          if( !add_peer_txn(nts) ) {
             return true;
          }
-         if( !send_buffer ) {
-            send_buffer = create_send_buffer( trx );
+         if( !wire.plain ) {
+            wire.plain = create_send_buffer( trx );
+         }
+         const bool compress = cp->compress_messages;
+         if( compress && !wire.compressed && !compression_tried ) {
+            compression_tried = true;
+            wire.compressed = create_compressed_send_buffer( *wire.plain );
          }
 
-         cp->strand.post( [cp, send_buffer]() {
+         cp->strand.post( [cp, send_buffer = wire.for_peer( compress )]() {
             fc_dlog( logger, "sending trx to ${n}", ("n", cp->peer_name()) );
             cp->enqueue_buffer( send_buffer, no_reason );
          } );
@@ -2008,6 +2483,7 @@ namespace eosio {
    }
 
    void dispatch_manager::rejected_transaction(const packed_transaction_ptr& trx, uint32_t head_blk_num) {
+      take_received_txn( *trx );
       fc_dlog( logger, "not sending rejected transaction ${tid}", ("tid", trx->id()) );
       // keep rejected transaction around for awhile so we don't broadcast it
       // update its block number so it will be purged when current block number is lib
@@ -2202,8 +2678,10 @@ namespace eosio {
                   if( from_addr < max_nodes_per_host && (max_client_count == 0 || visitors < max_client_count)) {
                      fc_ilog( logger, "Accepted new connection: " + paddr_str );
                      if( new_connection->start_session()) {
-                        std::lock_guard<std::shared_mutex> g_unique( connections_mtx );
-                        connections.insert( new_connection );
+                        std::lock_guard<std::mutex> g_unique( connections_mtx );
+                        update_connections( [&new_connection]( connection_set& connections ) {
+                           connections.insert( new_connection );
+                        } );
                      }
 
                   } else {
@@ -2362,63 +2840,35 @@ namespace eosio {
    // called from connection strand
    bool connection::process_next_message( uint32_t message_length ) {
       try {
-         // if next message is a block we already have, exit early
          auto peek_ds = pending_message_buffer.create_peek_datastream();
          unsigned_int which{};
          fc::raw::unpack( peek_ds, which );
-         if( which == signed_block_which ) {
-            block_header bh;
-            fc::raw::unpack( peek_ds, bh );
-
-            const block_id_type blk_id = bh.id();
-            const uint32_t blk_num = bh.block_num();
-            if( my_impl->dispatcher->have_block( blk_id ) ) {
-               fc_dlog( logger, "canceling wait on ${p}, already received block ${num}, id ${id}...",
-                        ("p", peer_name())("num", blk_num)("id", blk_id.str().substr(8,16)) );
-               my_impl->sync_master->sync_recv_block( shared_from_this(), blk_id, blk_num, false );
-               cancel_wait();
-
-               pending_message_buffer.advance_read_ptr( message_length );
-               return true;
-            }
-            fc_dlog( logger, "${p} received block ${num}, id ${id}..., latency: ${latency}",
-                     ("p", peer_name())("num", bh.block_num())("id", blk_id.str().substr(8,16))
-                     ("latency", (fc::time_point::now() - bh.timestamp).count()/1000) );
-            if( !my_impl->sync_master->syncing_with_peer() ) { // guard against peer thinking it needs to send us old blocks
-               uint32_t lib = 0;
-               std::tie( lib, std::ignore, std::ignore, std::ignore, std::ignore, std::ignore ) = my_impl->get_chain_info();
-               if( blk_num < lib ) {
-                  std::unique_lock<std::mutex> g( conn_mtx );
-                  const auto last_sent_lib = last_handshake_sent.last_irreversible_block_num;
-                  g.unlock();
-                  if( blk_num < last_sent_lib ) {
-                     fc_ilog( logger, "received block ${n} less than sent lib ${lib}", ("n", blk_num)("lib", last_sent_lib) );
-                     close();
-                  } else {
-                     fc_ilog( logger, "received block ${n} less than lib ${lib}", ("n", blk_num)("lib", lib) );
-                     enqueue( (sync_request_message) {0, 0} );
-                     send_handshake();
-                     cancel_wait();
-                  }
-
-                  pending_message_buffer.advance_read_ptr( message_length );
-                  return true;
-               }
+         if( which == signed_block_which || which == packed_transaction_which ) {
+            // keep the received bytes, they are relayed as is once the block or transaction is accepted
+            wire_message wire;
+            wire.plain = peek_message( message_length );
+            pending_message_buffer.advance_read_ptr( message_length );
+            process_wire_message( which, std::move( wire ) );
+
+         } else if( which == compressed_message_which ) {
+            // both forms are kept, peers that negotiated compression are relayed the compressed bytes
+            wire_message wire;
+            wire.compressed = peek_message( message_length );
+            pending_message_buffer.advance_read_ptr( message_length );
+            wire.plain = decompress_send_buffer( *wire.compressed );
+
+            fc::datastream<const char*> ds( wire.plain->data() + message_header_size, wire.plain->size() - message_header_size );
+            auto inner_ds = ds;
+            fc::raw::unpack( inner_ds, which );
+            if( which == signed_block_which || which == packed_transaction_which ) {
+               process_wire_message( which, std::move( wire ) );
+            } else {
+               net_message msg;
+               fc::raw::unpack( ds, msg );
+               msg_handler m( shared_from_this() );
+               msg.visit( m ); // a nested compressed_message is rejected by msg_handler
             }
 
-            auto ds = pending_message_buffer.create_datastream();
-            fc::raw::unpack( ds, which ); // throw away
-            shared_ptr<signed_block> ptr = std::make_shared<signed_block>();
-            fc::raw::unpack( ds, *ptr );
-            handle_message( blk_id, std::move( ptr ) );
-
-         } else if( which == packed_transaction_which ) {
-            auto ds = pending_message_buffer.create_datastream();
-            fc::raw::unpack( ds, which ); // throw away
-            shared_ptr<packed_transaction> ptr = std::make_shared<packed_transaction>();
-            fc::raw::unpack( ds, *ptr );
-            handle_message( std::move( ptr ) );
-
          } else {
             auto ds = pending_message_buffer.create_datastream();
             net_message msg;
@@ -2436,6 +2886,84 @@ namespace eosio {
       return true;
    }
 
+   // called from connection strand, wire.plain holds a signed_block or packed_transaction message
+   void connection::process_wire_message( uint32_t which, wire_message wire ) {
+      fc::datastream<const char*> ds( wire.plain->data() + message_header_size, wire.plain->size() - message_header_size );
+      unsigned_int w{};
+      fc::raw::unpack( ds, w ); // throw away
+      if( which == signed_block_which ) {
+         // if next message is a block we already have, exit early
+         auto peek_ds = ds;
+         block_header bh;
+         fc::raw::unpack( peek_ds, bh );
+
+         const block_id_type blk_id = bh.id();
+         const uint32_t blk_num = bh.block_num();
+         my_impl->sync_master->sync_block_arrived( shared_from_this(), blk_num );
+         if( my_impl->dispatcher->have_block( blk_id ) ) {
+            fc_dlog( logger, "canceling wait on ${p}, already received block ${num}, id ${id}...",
+                     ("p", peer_name())("num", blk_num)("id", blk_id.str().substr(8,16)) );
+            my_impl->sync_master->sync_recv_block( shared_from_this(), blk_id, blk_num, false );
+            cancel_wait();
+            return;
+         }
+         fc_dlog( logger, "${p} received block ${num}, id ${id}..., latency: ${latency}",
+                  ("p", peer_name())("num", bh.block_num())("id", blk_id.str().substr(8,16))
+                  ("latency", (fc::time_point::now() - bh.timestamp).count()/1000) );
+         if( !my_impl->sync_master->syncing_with_peer() ) { // guard against peer thinking it needs to send us old blocks
+            uint32_t lib = 0;
+            std::tie( lib, std::ignore, std::ignore, std::ignore, std::ignore, std::ignore ) = my_impl->get_chain_info();
+            if( blk_num < lib ) {
+               std::unique_lock<std::mutex> g( conn_mtx );
+               const auto last_sent_lib = last_handshake_sent.last_irreversible_block_num;
+               g.unlock();
+               if( blk_num < last_sent_lib ) {
+                  fc_ilog( logger, "received block ${n} less than sent lib ${lib}", ("n", blk_num)("lib", last_sent_lib) );
+                  close();
+               } else {
+                  fc_ilog( logger, "received block ${n} less than lib ${lib}", ("n", blk_num)("lib", lib) );
+                  enqueue( (sync_request_message) {0, 0} );
+                  send_handshake();
+                  cancel_wait();
+               }
+               return;
+            }
+         }
+
+         shared_ptr<signed_block> ptr = std::make_shared<signed_block>();
+         fc::raw::unpack( ds, *ptr );
+         drop_padded_wire( ds, wire );
+         handle_message( blk_id, std::move( ptr ), std::move( wire ) );
+
+      } else {
+         shared_ptr<packed_transaction> ptr = std::make_shared<packed_transaction>();
+         fc::raw::unpack( ds, *ptr );
+         drop_padded_wire( ds, wire );
+         handle_message( std::move( ptr ), std::move( wire ) );
+      }
+   }
+
+   // only the exact encoding of what was unpacked is relayed, bytes trailing it would be forwarded to every peer
+   void connection::drop_padded_wire( const fc::datastream<const char*>& ds, wire_message& wire ) {
+      if( ds.remaining() != 0 ) {
+         fc_dlog( logger, "${p} sent ${n} bytes after the message, relaying it repacked",
+                  ("p", peer_name())("n", ds.remaining()) );
+         wire = wire_message();
+      }
+   }
+
+   // called from connection strand
+   std::shared_ptr<std::vector<char>> connection::peek_message( uint32_t message_length ) {
+      constexpr size_t header_size = sizeof( message_length );
+      static_assert( header_size == message_header_size, "invalid message_header_size" );
+
+      auto wire_buffer = std::make_shared<std::vector<char>>( header_size + message_length );
+      memcpy( wire_buffer->data(), &message_length, header_size );
+      auto index = pending_message_buffer.read_index();
+      pending_message_buffer.peek( wire_buffer->data() + header_size, message_length, index );
+      return wire_buffer;
+   }
+
    // call only from main application thread
    void net_plugin_impl::update_chain_info() {
       controller& cc = chain_plug->chain();
@@ -2526,8 +3054,8 @@ namespace eosio {
          if( peer_address().empty() || last_handshake_recv.node_id == fc::sha256()) {
             g_conn.unlock();
             fc_dlog(logger, "checking for duplicate" );
-            std::shared_lock<std::shared_mutex> g_cnts( my_impl->connections_mtx );
-            for(const auto& check : my_impl->connections) {
+            auto connections = my_impl->connections_snapshot();
+            for(const auto& check : *connections) {
                if(check.get() == this)
                   continue;
                if(check->connected() && check->peer_name() == msg.p2p_address) {
@@ -2571,6 +3099,7 @@ namespace eosio {
             fc_ilog( logger, "Local network version: ${nv} Remote version: ${mnv}",
                      ("nv", net_version)( "mnv", protocol_version ) );
          }
+         compress_messages = my_impl->p2p_compression && protocol_version >= proto_compression;
 
          g_conn.lock();
          if( conn_node_id != msg.node_id ) {
@@ -2811,7 +3340,7 @@ namespace eosio {
              trx->get_signatures().size() * sizeof(signature_type);
    }
 
-   void connection::handle_message( packed_transaction_ptr trx ) {
+   void connection::handle_message( packed_transaction_ptr trx, wire_message wire ) {
       if( my_impl->db_read_mode == eosio::db_read_mode::READ_ONLY ) {
          fc_dlog( logger, "got a txn in read-only mode - dropping" );
          return;
@@ -2837,6 +3366,7 @@ namespace eosio {
       }
 
       trx_in_progress_size += calc_trx_size( trx );
+      my_impl->dispatcher->add_received_txn( trx, std::move( wire ) );
       app().post( priority::low, [trx{std::move(trx)}, weak = weak_from_this()]() {
          my_impl->chain_plug->accept_transaction( trx,
             [weak, trx](const static_variant<fc::exception_ptr, transaction_trace_ptr>& result) mutable {
@@ -2860,26 +3390,34 @@ namespace eosio {
    }
 
    // called from connection strand
-   void connection::handle_message( const block_id_type& id, signed_block_ptr ptr ) {
+   void connection::handle_message( const block_id_type& id, signed_block_ptr ptr, wire_message wire ) {
       peer_dlog( this, "received signed_block ${id}", ("id", ptr->block_num() ) );
+      my_impl->dispatcher->add_received_block( id, ptr, std::move( wire ) );
       app().post(priority::high, [ptr{std::move(ptr)}, id, c = shared_from_this()]() mutable {
          c->process_signed_block( id, std::move( ptr ) );
       });
    }
 
    // called from application thread
-   void connection::process_signed_block( const block_id_type& blk_id, signed_block_ptr msg ) {
+   void connection::process_signed_block( const block_id_type& blk_id, signed_block_ptr msg, bool buffered ) {
       controller& cc = my_impl->chain_plug->chain();
       uint32_t blk_num = msg->block_num();
       // use c in this method instead of this to highlight that all methods called on c-> must be thread safe
       connection_ptr c = shared_from_this();
 
       // if we have closed connection then stop processing
-      if( !c->socket_is_open() )
+      if( !c->socket_is_open() && !buffered )
          return;
 
+      // hold blocks fetched ahead of the head until they link
+      if( my_impl->sync_master->buffer_sync_block( c, blk_id, msg, cc.fork_db_pending_head_block_num() ) ) {
+         peer_dlog( c, "buffering sync block ${n}", ("n", blk_num) );
+         return;
+      }
+
       try {
          if( cc.fetch_block_by_id(blk_id) ) {
+            my_impl->sync_master->apply_buffered_sync_block( cc.fork_db_pending_head_block_num() + 1 );
             c->strand.post( [sync_master = my_impl->sync_master.get(),
                              dispatcher = my_impl->dispatcher.get(), c, blk_id, blk_num]() {
                dispatcher->add_peer_block( blk_id, c->connection_id );
@@ -2921,6 +3459,7 @@ namespace eosio {
       }
 
       if( reason == no_reason ) {
+         my_impl->sync_master->apply_buffered_sync_block( cc.fork_db_pending_head_block_num() + 1 );
          boost::asio::post( my_impl->thread_pool->get_executor(), [dispatcher = my_impl->dispatcher.get(), cid=c->connection_id, blk_id, msg]() {
             fc_dlog( logger, "accepted signed_block : #${n} ${id}...", ("n", msg->block_num())("id", blk_id.str().substr(8,16)) );
             dispatcher->add_peer_block( blk_id, cid );
@@ -3027,14 +3566,22 @@ namespace eosio {
       auto max_time = fc::time_point::now();
       max_time += fc::milliseconds(max_cleanup_time_ms);
       auto from = from_connection.lock();
-      std::unique_lock<std::shared_mutex> g( connections_mtx );
-      auto it = (from ? connections.find(from) : connections.begin());
-      if (it == connections.end()) it = connections.begin();
+      auto connections = connections_snapshot();
+      auto it = (from ? connections->find(from) : connections->begin());
+      if (it == connections->end()) it = connections->begin();
       size_t num_rm = 0, num_clients = 0, num_peers = 0;
-      while (it != connections.end()) {
+      std::vector<connection_ptr> removed;
+      auto remove_connections = [this, &removed]() {
+         if( removed.empty() ) return;
+         std::lock_guard<std::mutex> g( connections_mtx );
+         update_connections( [&removed]( connection_set& connections ) {
+            for( const auto& c : removed ) connections.erase( c );
+         } );
+      };
+      while (it != connections->end()) {
          if (fc::time_point::now() >= max_time) {
             connection_wptr wit = *it;
-            g.unlock();
+            remove_connections();
             fc_dlog( logger, "Exiting connection monitor early, ran out of time: ${t}", ("t", max_time - fc::time_point::now()) );
             if( reschedule ) {
                start_conn_timer( std::chrono::milliseconds( 1 ), wit ); // avoid exhausting
@@ -3045,19 +3592,17 @@ namespace eosio {
          if( !(*it)->socket_is_open() && !(*it)->connecting) {
             if( !(*it)->peer_address().empty() ) {
                if( !(*it)->resolve_and_connect() ) {
-                  it = connections.erase(it);
+                  removed.push_back( *it );
                   --num_peers; ++num_rm;
-                  continue;
                }
             } else {
                --num_clients; ++num_rm;
-               it = connections.erase(it);
-               continue;
+               removed.push_back( *it );
             }
          }
          ++it;
       }
-      g.unlock();
+      remove_connections();
       if( num_clients > 0 || num_peers > 0 )
          fc_ilog( logger, "p2p client connections: ${num}/${max}, peer connections: ${pnum}/${pmax}",
                   ("num", num_clients)("max", max_client_count)("pnum", num_peers)("pmax", supplied_peers.size()) );
@@ -3238,6 +3783,8 @@ namespace eosio {
            "    p2p.trx.eos.io:9876:trx\n"
            "    p2p.blk.eos.io:9876:blk\n")
          ( "p2p-max-nodes-per-host", bpo::value<int>()->default_value(def_max_nodes_per_host), "Maximum number of client nodes from any single IP address")
+         ( "p2p-compression", bpo::value<bool>()->default_value(false),
+           "Send blocks and transactions zlib compressed to peers that support it. A block is compressed once for all such peers.")
          ( "agent-name", bpo::value<string>()->default_value("\"EOS Test Agent\""), "The name supplied to identify this node amongst the peers.")
          ( "allowed-connection", bpo::value<vector<string>>()->multitoken()->default_value({"any"}, "any"), "Can be 'any' or 'producers' or 'specified' or 'none'. If 'specified', peer-key must be specified at least once. If only 'producers', peer-key is not required. 'producers' and 'specified' may be combined.")
          ( "peer-key", bpo::value<vector<string>>()->composing()->multitoken(), "Optional public key of peer allowed to connect.  May be used multiple times.")
@@ -3249,6 +3796,8 @@ namespace eosio {
          ( "net-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
            "Number of worker threads in net_plugin thread pool" )
          ( "sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
+         ( "sync-fetch-peers", bpo::value<uint32_t>()->default_value(def_sync_fetch_peers),
+           "number of peers to retrieve chunks from concurrently during synchronization, faster peers are given larger chunks")
          ( "use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable expirimental socket read watermark optimization")
          ( "peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" ${_ip}:${_port}]" ),
            "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
@@ -3273,7 +3822,9 @@ namespace eosio {
       try {
          peer_log_format = options.at( "peer-log-format" ).as<string>();
 
-         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>()));
+         const auto sync_fetch_peers = options.at( "sync-fetch-peers" ).as<uint32_t>();
+         EOS_ASSERT( sync_fetch_peers > 0, plugin_config_exception, "sync-fetch-peers must be greater than 0" );
+         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>(), sync_fetch_peers ));
 
          my->connector_period = std::chrono::seconds( options.at( "connection-cleanup-period" ).as<int>());
          my->max_cleanup_time_ms = options.at("max-cleanup-time-msec").as<int>();
@@ -3281,6 +3832,7 @@ namespace eosio {
          my->resp_expected_period = def_resp_expected_wait;
          my->max_client_count = options.at( "max-clients" ).as<int>();
          my->max_nodes_per_host = options.at( "p2p-max-nodes-per-host" ).as<int>();
+         my->p2p_compression = options.at( "p2p-compression" ).as<bool>();
 
          my->use_socket_read_watermark = options.at( "use-socket-read-watermark" ).as<bool>();
 
@@ -3469,13 +4021,16 @@ namespace eosio {
          }
 
          {
-            fc_ilog( logger, "close ${s} connections", ("s", my->connections.size()) );
-            std::lock_guard<std::shared_mutex> g( my->connections_mtx );
-            for( auto& con : my->connections ) {
+            std::lock_guard<std::mutex> g( my->connections_mtx );
+            auto connections = my->connections_snapshot();
+            fc_ilog( logger, "close ${s} connections", ("s", connections->size()) );
+            for( auto& con : *connections ) {
                fc_dlog( logger, "close: ${p}", ("p", con->peer_name()) );
                con->close( false, true );
             }
-            my->connections.clear();
+            my->update_connections( []( net_plugin_impl::connection_set& connections ) {
+               connections.clear();
+            } );
          }
 
          if( my->thread_pool ) {
@@ -3498,7 +4053,7 @@ namespace eosio {
     *  Used to trigger a new connection from RPC API
     */
    string net_plugin::connect( const string& host ) {
-      std::lock_guard<std::shared_mutex> g( my->connections_mtx );
+      std::lock_guard<std::mutex> g( my->connections_mtx );
       if( my->find_connection( host ) )
          return "already connected";
 
@@ -3506,26 +4061,28 @@ namespace eosio {
       fc_dlog( logger, "calling active connector: ${h}", ("h", host) );
       if( c->resolve_and_connect() ) {
          fc_dlog( logger, "adding new connection to the list: ${c}", ("c", c->peer_name()) );
-         my->connections.insert( c );
+         my->update_connections( [&c]( net_plugin_impl::connection_set& connections ) {
+            connections.insert( c );
+         } );
       }
       return "added connection";
    }
 
    string net_plugin::disconnect( const string& host ) {
-      std::lock_guard<std::shared_mutex> g( my->connections_mtx );
-      for( auto itr = my->connections.begin(); itr != my->connections.end(); ++itr ) {
-         if( (*itr)->peer_address() == host ) {
-            fc_ilog( logger, "disconnecting: ${p}", ("p", (*itr)->peer_name()) );
-            (*itr)->close();
-            my->connections.erase(itr);
-            return "connection removed";
-         }
-      }
-      return "no known connection for host";
+      std::lock_guard<std::mutex> g( my->connections_mtx );
+      connection_ptr c = my->find_connection( host );
+      if( !c )
+         return "no known connection for host";
+
+      fc_ilog( logger, "disconnecting: ${p}", ("p", c->peer_name()) );
+      c->close();
+      my->update_connections( [&c]( net_plugin_impl::connection_set& connections ) {
+         connections.erase( c );
+      } );
+      return "connection removed";
    }
 
    optional<connection_status> net_plugin::status( const string& host )const {
-      std::shared_lock<std::shared_mutex> g( my->connections_mtx );
       auto con = my->find_connection( host );
       if( con )
          return con->get_status();
@@ -3534,17 +4091,18 @@ namespace eosio {
 
    vector<connection_status> net_plugin::connections()const {
       vector<connection_status> result;
-      std::shared_lock<std::shared_mutex> g( my->connections_mtx );
-      result.reserve( my->connections.size() );
-      for( const auto& c : my->connections ) {
+      auto connections = my->connections_snapshot();
+      result.reserve( connections->size() );
+      for( const auto& c : *connections ) {
          result.push_back( c->get_status() );
       }
       return result;
    }
 
-   // call with connections_mtx
+   // thread safe
    connection_ptr net_plugin_impl::find_connection( const string& host )const {
-      for( const auto& c : connections )
+      auto connections = connections_snapshot();
+      for( const auto& c : *connections )
          if( c->peer_address() == host ) return c;
       return connection_ptr();
    }
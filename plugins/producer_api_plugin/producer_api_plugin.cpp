@@ -124,6 +124,10 @@ void producer_api_plugin::plugin_startup() {
                                  producer_plugin::get_supported_protocol_features_params), 201),
        CALL(producer, producer, get_account_ram_corrections,
             INVOKE_R_R(producer, get_account_ram_corrections, producer_plugin::get_account_ram_corrections_params), 201),
+       CALL(producer, producer, get_action_profile,
+            INVOKE_R_R(producer, get_action_profile, producer_plugin::get_action_profile_params), 201),
+       CALL(producer, producer, clear_action_profile,
+            INVOKE_V_V(producer, clear_action_profile), 201),
    });
 }
 
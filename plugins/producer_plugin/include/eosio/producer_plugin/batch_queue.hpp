@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+namespace eosio {
+
+/**
+ * Entries pushed from any thread are consumed in batches of at most max_batch_size entries. A consumer is scheduled
+ * while entries are queued: push() asks for one when the queue was empty, pop_batch() when entries are left after
+ * the batch it returns, so a burst of entries never holds the consumer's thread for more than one batch.
+ */
+template<typename T>
+class batch_queue {
+public:
+   explicit batch_queue( size_t max_batch_size )
+   : _max_batch_size( max_batch_size ) {}
+
+   /// true if the consumer has to be scheduled
+   bool push( T e ) {
+      std::lock_guard<std::mutex> g( _mtx );
+      _queue.push_back( std::move( e ) );
+      return _queue.size() == 1;
+   }
+
+   /// the oldest entries, `more` is set if the consumer has to be scheduled again for the entries left
+   std::vector<T> pop_batch( bool& more ) {
+      std::lock_guard<std::mutex> g( _mtx );
+      const size_t n = std::min( _queue.size(), _max_batch_size );
+      std::vector<T> batch;
+      batch.reserve( n );
+      std::move( _queue.begin(), _queue.begin() + n, std::back_inserter( batch ) );
+      _queue.erase( _queue.begin(), _queue.begin() + n );
+      more = !_queue.empty();
+      return batch;
+   }
+
+   size_t size() const {
+      std::lock_guard<std::mutex> g( _mtx );
+      return _queue.size();
+   }
+
+private:
+   const size_t       _max_batch_size;
+   mutable std::mutex _mtx;
+   std::deque<T>      _queue;
+};
+
+} // namespace eosio
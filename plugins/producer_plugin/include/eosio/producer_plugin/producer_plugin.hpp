@@ -2,6 +2,7 @@
 
 #include <eosio/chain_plugin/chain_plugin.hpp>
 #include <eosio/http_client_plugin/http_client_plugin.hpp>
+#include <eosio/chain/action_profiler.hpp>
 
 #include <appbase/application.hpp>
 
@@ -22,6 +23,7 @@ public:
       fc::optional<int32_t>   subjective_cpu_leeway_us;
       fc::optional<double>    incoming_defer_ratio;
       fc::optional<uint32_t>  greylist_limit;
+      fc::optional<bool>      profile_actions;
    };
 
    struct whitelist_blacklist {
@@ -68,6 +70,16 @@ public:
       optional<account_name>   more;
    };
 
+   struct get_action_profile_params {
+      uint32_t                limit = 100;
+      bool                    folded_stacks = false; ///< also return the whole profile in flamegraph.pl input format
+   };
+
+   struct get_action_profile_result {
+      std::vector<chain::action_profiler::action_stats> actions;
+      optional<std::string>                             folded_stacks;
+   };
+
    template<typename T>
    using next_function = std::function<void(const fc::static_variant<fc::exception_ptr, T>&)>;
 
@@ -110,13 +122,16 @@ public:
 
    get_account_ram_corrections_result  get_account_ram_corrections( const get_account_ram_corrections_params& params ) const;
 
+   get_action_profile_result get_action_profile( const get_action_profile_params& params ) const;
+   void clear_action_profile();
+
 private:
    std::shared_ptr<class producer_plugin_impl> my;
 };
 
 } //eosio
 
-FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(max_scheduled_transaction_time_per_block_ms)(subjective_cpu_leeway_us)(incoming_defer_ratio)(greylist_limit));
+FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(max_scheduled_transaction_time_per_block_ms)(subjective_cpu_leeway_us)(incoming_defer_ratio)(greylist_limit)(profile_actions));
 FC_REFLECT(eosio::producer_plugin::greylist_params, (accounts));
 FC_REFLECT(eosio::producer_plugin::whitelist_blacklist, (actor_whitelist)(actor_blacklist)(contract_whitelist)(contract_blacklist)(action_blacklist)(key_blacklist) )
 FC_REFLECT(eosio::producer_plugin::integrity_hash_information, (head_block_id)(integrity_hash))
@@ -125,3 +140,5 @@ FC_REFLECT(eosio::producer_plugin::scheduled_protocol_feature_activations, (prot
 FC_REFLECT(eosio::producer_plugin::get_supported_protocol_features_params, (exclude_disabled)(exclude_unactivatable))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_params, (lower_bound)(upper_bound)(limit)(reverse))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_result, (rows)(more))
+FC_REFLECT(eosio::producer_plugin::get_action_profile_params, (limit)(folded_stacks))
+FC_REFLECT(eosio::producer_plugin::get_action_profile_result, (actions)(folded_stacks))
@@ -1,4 +1,5 @@
 #include <eosio/producer_plugin/producer_plugin.hpp>
+#include <eosio/producer_plugin/batch_queue.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
@@ -16,7 +17,9 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <iostream>
+#include <sstream>
 #include <algorithm>
+#include <mutex>
 #include <boost/algorithm/string.hpp>
 #include <boost/range/adaptor/map.hpp>
 #include <boost/function_output_iterator.hpp>
@@ -108,11 +111,12 @@ class pending_snapshot {
 public:
    using next_t = producer_plugin::next_function<producer_plugin::snapshot_information>;
 
-   pending_snapshot(const block_id_type& block_id, next_t& next, std::string pending_path, std::string final_path)
+   pending_snapshot(const block_id_type& block_id, next_t& next, std::string pending_path, std::string final_path, bool written = true)
    : block_id(block_id)
    , next(next)
    , pending_path(pending_path)
    , final_path(final_path)
+   , written(written)
    {}
 
    uint32_t get_height() const {
@@ -156,6 +160,7 @@ public:
    next_t            next;
    std::string       pending_path;
    std::string       final_path;
+   bool              written = true; ///< false until a background write has produced pending_path
 };
 
 using pending_snapshot_index = multi_index_container<
@@ -201,6 +206,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       pending_block_mode                                        _pending_block_mode;
       unapplied_transaction_queue                               _unapplied_transactions;
       fc::optional<named_thread_pool>                           _thread_pool;
+      fc::optional<named_thread_pool>                           _snapshot_thread_pool; ///< writes snapshots in the background when enabled
 
       std::atomic<int32_t>                                      _max_transaction_time_ms; // modified by app thread, read by net_plugin thread pool
       fc::microseconds                                          _max_irreversible_block_age_us;
@@ -225,6 +231,7 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       transaction_id_with_expiry_index                         _blacklisted_transactions;
       pending_snapshot_index                                   _pending_snapshot_index;
+      std::map<block_id_type, pending_snapshot::next_t>        _snapshots_in_flight; ///< background writes of irreversible mode snapshots, by head id
 
       fc::optional<scoped_connection>                          _accepted_block_connection;
       fc::optional<scoped_connection>                          _accepted_block_header_connection;
@@ -275,14 +282,20 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       void on_irreversible_block( const signed_block_ptr& lib ) {
          _irreversible_block_time = lib->timestamp.to_time_point();
-         const chain::controller& chain = chain_plug->chain();
+         promote_pending_snapshots( lib->block_num() );
+      }
 
-         // promote any pending snapshots
+      void promote_pending_snapshots( uint32_t lib_height ) {
+         const chain::controller& chain = chain_plug->chain();
          auto& snapshots_by_height = _pending_snapshot_index.get<by_height>();
-         uint32_t lib_height = lib->block_num();
 
          while (!snapshots_by_height.empty() && snapshots_by_height.begin()->get_height() <= lib_height) {
             const auto& pending = snapshots_by_height.begin();
+            // promoted once its background write completes
+            if (!pending->written) {
+               break;
+            }
+
             auto next = pending->next;
 
             try {
@@ -293,6 +306,103 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          }
       }
 
+      /// writes the serialized `snapshot` to `temp_path` then renames it to `path` on the snapshot thread, `done` is
+      /// called on the main thread afterwards
+      void write_snapshot_in_background( std::shared_ptr<std::stringstream> snapshot, bfs::path temp_path, bfs::path path,
+                                         std::function<void(const fc::exception_ptr&)> done ) {
+         boost::asio::post( _snapshot_thread_pool->get_executor(),
+                            [snapshot{std::move(snapshot)}, temp_path{std::move(temp_path)}, path{std::move(path)}, done{std::move(done)}]() {
+            auto report = [&done]( const fc::exception_ptr& e ) {
+               app().post( priority::medium, [done, e]() { done( e ); } );
+            };
+
+            try {
+               {
+                  auto snap_out = std::ofstream( temp_path.generic_string(), (std::ios::out | std::ios::binary) );
+                  snap_out << snapshot->rdbuf();
+                  snap_out.flush();
+                  EOS_ASSERT( snap_out.good(), snapshot_finalization_exception,
+                              "Unable to write snapshot to ${path}", ("path", temp_path.generic_string()) );
+               }
+
+               boost::system::error_code ec;
+               bfs::rename( temp_path, path, ec );
+               EOS_ASSERT( !ec, snapshot_finalization_exception,
+                           "Unable to rename snapshot ${from} to ${to}: [code: ${ec}] ${message}",
+                           ("from", temp_path.generic_string())
+                           ("to", path.generic_string())
+                           ("ec", ec.value())
+                           ("message", ec.message()) );
+               report( fc::exception_ptr() );
+            } CATCH_AND_CALL( report );
+         });
+      }
+
+      void on_pending_snapshot_written( const block_id_type& block_id, const fc::exception_ptr& e ) {
+         auto& pending_by_id = _pending_snapshot_index.get<by_id>();
+         auto itr = pending_by_id.find( block_id );
+         if( itr == pending_by_id.end() ) {
+            return;
+         }
+
+         if( e ) {
+            auto next = itr->next;
+            pending_by_id.erase( itr );
+            next( e );
+            return;
+         }
+
+         pending_by_id.modify( itr, []( auto& entry ) {
+            entry.written = true;
+         });
+         promote_pending_snapshots( chain_plug->chain().last_irreversible_block_num() );
+      }
+
+      void on_snapshot_written( const block_id_type& block_id, const fc::exception_ptr& e ) {
+         auto itr = _snapshots_in_flight.find( block_id );
+         if( itr == _snapshots_in_flight.end() ) {
+            return;
+         }
+
+         auto next = std::move( itr->second );
+         _snapshots_in_flight.erase( itr );
+         if( e ) {
+            next( e );
+         } else {
+            next( producer_plugin::snapshot_information{block_id, pending_snapshot::get_final_path(block_id, _snapshots_dir).generic_string()} );
+         }
+      }
+
+      /// called once the snapshot thread is stopped, the writes it dropped are reported as failed
+      void fail_unwritten_snapshots() {
+         auto shutdown_exception = []( const block_id_type& block_id ) -> fc::exception_ptr {
+            return snapshot_finalization_exception( FC_LOG_MESSAGE( error, "Shut down before the snapshot of block ${id} was written",
+                                                                    ("id", block_id) ) ).dynamic_copy_exception();
+         };
+
+         while( !_snapshots_in_flight.empty() ) {
+            const auto block_id = _snapshots_in_flight.begin()->first;
+            // a write which completed while stopping has not reported yet
+            if( fc::is_regular_file( pending_snapshot::get_final_path(block_id, _snapshots_dir) ) ) {
+               on_snapshot_written( block_id, fc::exception_ptr() );
+            } else {
+               on_snapshot_written( block_id, shutdown_exception( block_id ) );
+            }
+         }
+
+         auto& pending_by_id = _pending_snapshot_index.get<by_id>();
+         for( auto itr = pending_by_id.begin(); itr != pending_by_id.end(); ) {
+            if( itr->written || fc::is_regular_file( itr->pending_path ) ) {
+               ++itr;
+               continue;
+            }
+            auto next = itr->next;
+            const auto block_id = itr->block_id;
+            itr = pending_by_id.erase( itr );
+            next( shutdown_exception( block_id ) );
+         }
+      }
+
       template<typename Type, typename Channel, typename F>
       auto publish_results_of(const Type &data, Channel& channel, F f) {
          auto publish_success = fc::make_scoped_exit([&, this](){
@@ -449,6 +559,10 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       incoming_transaction_queue _pending_incoming_transactions;
 
+      // transactions with recovered keys, waiting for the main thread which applies them in batches
+      static constexpr size_t max_recovered_transactions_per_post = 32;
+      batch_queue<std::tuple<recover_keys_future, bool, next_function<transaction_trace_ptr>>> _recovered_transactions{max_recovered_transactions_per_post};
+
       void on_incoming_transaction_async(const packed_transaction_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
          chain::controller& chain = chain_plug->chain();
          const auto max_trx_time_ms = _max_transaction_time_ms.load();
@@ -459,15 +573,41 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          boost::asio::post( _thread_pool->get_executor(), [self = this, future{std::move(future)}, persist_until_expired, next{std::move(next)}]() mutable {
             if( future.valid() ) {
                future.wait();
-               app().post( priority::low, [self, future{std::move(future)}, persist_until_expired, next{std::move( next )}]() mutable {
-                  try {
-                     self->process_incoming_transaction_async( future.get(), persist_until_expired, std::move( next ) );
-                  } CATCH_AND_CALL(next);
-               } );
+               self->add_recovered_transaction( std::move( future ), persist_until_expired, std::move( next ) );
             }
          });
       }
 
+      // called from thread pool, only the first transaction of a batch posts to the main thread
+      void add_recovered_transaction( recover_keys_future future, bool persist_until_expired, next_function<transaction_trace_ptr> next ) {
+         if( _recovered_transactions.push( std::make_tuple( std::move( future ), persist_until_expired, std::move( next ) ) ) ) {
+            post_recovered_transactions();
+         }
+      }
+
+      void post_recovered_transactions() {
+         app().post( priority::low, [self = this]() {
+            self->process_recovered_transactions();
+         } );
+      }
+
+      // called from main thread, applies the recovered transactions in the order their keys were recovered, the
+      // transactions beyond one batch are posted again so that blocks and other work interleave with them
+      void process_recovered_transactions() {
+         bool more = false;
+         auto batch = _recovered_transactions.pop_batch( more );
+         if( more ) {
+            post_recovered_transactions();
+         }
+         for( auto& e : batch ) {
+            auto& next = std::get<2>( e );
+            try {
+               auto trx = std::get<0>( e ).get();
+               process_incoming_transaction_async( trx, std::get<1>( e ), std::move( next ) );
+            } CATCH_AND_CALL(next);
+         }
+      }
+
       void process_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
          chain::controller& chain = chain_plug->chain();
 
@@ -673,6 +813,10 @@ void producer_plugin::set_program_options(
           "Number of worker threads in producer thread pool")
          ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
           "the location of the snapshots directory (absolute path or relative to application data dir)")
+         ("background-snapshot-write", bpo::value<bool>()->default_value(false),
+          "Resume block processing as soon as a snapshot is serialized and write it to disk on a background thread. The whole snapshot is held in memory until it is written.")
+         ("profile-actions", bpo::value<bool>()->default_value(false),
+          "Aggregate the wall time of every action and of its database and crypto host function calls, see /v1/producer/get_action_profile")
          ;
    config_file_options.add(producer_options);
 }
@@ -845,6 +989,10 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
                   "No such directory '${dir}'", ("dir", my->_snapshots_dir.generic_string()) );
    }
 
+   if( options.at( "background-snapshot-write" ).as<bool>() ) {
+      my->_snapshot_thread_pool.emplace( "snap", 1 );
+   }
+
    my->_incoming_block_subscription = app().get_channel<incoming::channels::block>().subscribe(
          [this](const signed_block_ptr& block) {
       try {
@@ -883,6 +1031,8 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
       chain.set_greylist_limit( greylist_limit );
    }
 
+   chain.set_action_profiling( options.at( "profile-actions" ).as<bool>() );
+
 } FC_LOG_AND_RETHROW() }
 
 void producer_plugin::plugin_startup()
@@ -942,6 +1092,11 @@ void producer_plugin::plugin_shutdown() {
       my->_thread_pool->stop();
    }
 
+   if( my->_snapshot_thread_pool ) {
+      my->_snapshot_thread_pool->stop();
+      my->fail_unwritten_snapshots();
+   }
+
    app().post( 0, [me = my](){} ); // keep my pointer alive until queue is drained
 }
 
@@ -1011,6 +1166,10 @@ void producer_plugin::update_runtime_options(const runtime_options& options) {
    if (options.greylist_limit) {
       chain.set_greylist_limit(*options.greylist_limit);
    }
+
+   if (options.profile_actions) {
+      chain.set_action_profiling(*options.profile_actions);
+   }
 }
 
 producer_plugin::runtime_options producer_plugin::get_runtime_options() const {
@@ -1024,7 +1183,8 @@ producer_plugin::runtime_options producer_plugin::get_runtime_options() const {
             my->chain_plug->chain().get_subjective_cpu_leeway()->count() :
             fc::optional<int32_t>(),
       my->_incoming_defer_ratio,
-      my->chain_plug->chain().get_greylist_limit()
+      my->chain_plug->chain().get_greylist_limit(),
+      my->chain_plug->chain().get_action_profiler() != nullptr
    };
 }
 
@@ -1099,6 +1259,16 @@ void producer_plugin::create_snapshot(producer_plugin::next_function<producer_pl
    const auto& snapshot_path = pending_snapshot::get_final_path(head_id, my->_snapshots_dir);
    const auto& temp_path     = pending_snapshot::get_temp_path(head_id, my->_snapshots_dir);
 
+   // in irreversible mode, a snapshot of this block still being written answers this request as well
+   auto in_flight = my->_snapshots_in_flight.find(head_id);
+   if( in_flight != my->_snapshots_in_flight.end() ) {
+      in_flight->second = [prev = std::move(in_flight->second), next](const fc::static_variant<fc::exception_ptr, producer_plugin::snapshot_information>& res){
+         prev(res);
+         next(res);
+      };
+      return;
+   }
+
    // maintain legacy exception if the snapshot exists
    if( fc::is_regular_file(snapshot_path) ) {
       auto ex = snapshot_exists_exception( FC_LOG_MESSAGE( error, "snapshot named ${name} already exists", ("name", snapshot_path.generic_string()) ) );
@@ -1106,7 +1276,7 @@ void producer_plugin::create_snapshot(producer_plugin::next_function<producer_pl
       return;
    }
 
-   auto write_snapshot = [&]( const bfs::path& p ) -> void {
+   auto serialize_snapshot = [&]( std::ostream& snap_out ) -> void {
       auto reschedule = fc::make_scoped_exit([this](){
          my->schedule_production_loop();
       });
@@ -1118,19 +1288,43 @@ void producer_plugin::create_snapshot(producer_plugin::next_function<producer_pl
          reschedule.cancel();
       }
 
-      bfs::create_directory( p.parent_path() );
-
       // create the snapshot
-      auto snap_out = std::ofstream(p.generic_string(), (std::ios::out | std::ios::binary));
       auto writer = std::make_shared<ostream_snapshot_writer>(snap_out);
       chain.write_snapshot(writer);
       writer->finalize();
+   };
+
+   auto write_snapshot = [&]( const bfs::path& p ) -> void {
+      bfs::create_directory( p.parent_path() );
+
+      auto snap_out = std::ofstream(p.generic_string(), (std::ios::out | std::ios::binary));
+      serialize_snapshot(snap_out);
       snap_out.flush();
       snap_out.close();
    };
 
+   // only the serialization blocks the main thread, the snapshot is written by write_snapshot_in_background
+   auto serialize_snapshot_to_memory = [&]() {
+      bfs::create_directory( temp_path.parent_path() );
+
+      auto snap_out = std::make_shared<std::stringstream>(std::ios::in | std::ios::out | std::ios::binary);
+      serialize_snapshot(*snap_out);
+      return snap_out;
+   };
+
    // If in irreversible mode, create snapshot and return path to snapshot immediately.
    if( chain.get_read_mode() == db_read_mode::IRREVERSIBLE ) {
+      if( my->_snapshot_thread_pool ) {
+         try {
+            auto snapshot = serialize_snapshot_to_memory();
+            my->_snapshots_in_flight.emplace(head_id, next);
+            my->write_snapshot_in_background( std::move(snapshot), temp_path, snapshot_path, [my = my, head_id]( const fc::exception_ptr& e ) {
+               my->on_snapshot_written( head_id, e );
+            });
+         } CATCH_AND_CALL (next);
+         return;
+      }
+
       try {
          write_snapshot( temp_path );
 
@@ -1163,6 +1357,17 @@ void producer_plugin::create_snapshot(producer_plugin::next_function<producer_pl
    } else {
       const auto& pending_path = pending_snapshot::get_pending_path(head_id, my->_snapshots_dir);
 
+      if( my->_snapshot_thread_pool ) {
+         try {
+            auto snapshot = serialize_snapshot_to_memory();
+            my->_pending_snapshot_index.emplace(head_id, next, pending_path.generic_string(), snapshot_path.generic_string(), false);
+            my->write_snapshot_in_background( std::move(snapshot), temp_path, pending_path, [my = my, head_id]( const fc::exception_ptr& e ) {
+               my->on_pending_snapshot_written( head_id, e );
+            });
+         } CATCH_AND_CALL (next);
+         return;
+      }
+
       try {
          write_snapshot( temp_path ); // create a new pending snapshot
 
@@ -1284,6 +1489,27 @@ producer_plugin::get_account_ram_corrections( const get_account_ram_corrections_
    return result;
 }
 
+producer_plugin::get_action_profile_result
+producer_plugin::get_action_profile( const get_action_profile_params& params ) const {
+   const auto* profiler = my->chain_plug->chain().get_action_profiler();
+   EOS_ASSERT( profiler, producer_exception, "action profiling is not enabled, see profile-actions" );
+
+   get_action_profile_result result;
+   result.actions = profiler->get_actions( params.limit );
+   if( params.folded_stacks ) {
+      std::ostringstream out;
+      profiler->write_folded_stacks( out );
+      result.folded_stacks = out.str();
+   }
+   return result;
+}
+
+void producer_plugin::clear_action_profile() {
+   auto* profiler = my->chain_plug->chain().get_action_profiler();
+   EOS_ASSERT( profiler, producer_exception, "action profiling is not enabled, see profile-actions" );
+   profiler->clear();
+}
+
 optional<fc::time_point> producer_plugin_impl::calculate_next_block_time(const account_name& producer_name, const block_timestamp_type& current_block_time) const {
    chain::controller& chain = chain_plug->chain();
    const auto& hbs = chain.head_block_state();
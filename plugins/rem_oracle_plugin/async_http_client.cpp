@@ -0,0 +1,237 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#include <eosio/rem_oracle_plugin/async_http_client.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <map>
+#include <vector>
+
+namespace eosio {
+
+   using boost::asio::ip::tcp;
+   namespace http = boost::beast::http;
+   namespace ssl = boost::asio::ssl;
+
+   http_url http_url::parse( const std::string& url ) {
+      http_url result;
+      auto scheme_end = url.find( "://" );
+      FC_ASSERT( scheme_end != std::string::npos, "url ${u} has no scheme", ("u", url) );
+      result.scheme = url.substr( 0, scheme_end );
+      FC_ASSERT( result.scheme == "http" || result.scheme == "https", "unsupported url scheme ${s}", ("s", result.scheme) );
+      result.port = result.scheme == "https" ? "443" : "80";
+
+      auto host_begin = scheme_end + 3;
+      auto target_begin = url.find( '/', host_begin );
+      std::string host_port = url.substr( host_begin, target_begin == std::string::npos ? std::string::npos : target_begin - host_begin );
+      if( target_begin != std::string::npos ) result.target = url.substr( target_begin );
+
+      auto port_begin = host_port.rfind( ':' );
+      if( port_begin != std::string::npos ) {
+         result.port = host_port.substr( port_begin + 1 );
+         host_port.resize( port_begin );
+      }
+      FC_ASSERT( !host_port.empty() && !result.port.empty(), "invalid url ${u}", ("u", url) );
+      result.host = std::move( host_port );
+      return result;
+   }
+
+   namespace {
+
+      /// a single keep-alive connection, plain or TLS
+      struct http_connection {
+         http_connection( boost::asio::io_context& ioc, ssl::context& ctx, const http_url& url )
+            : key( url.connection_key() ), resolver( ioc ), timer( ioc ) {
+            if( url.scheme == "https" ) {
+               tls = std::make_unique<ssl::stream<tcp::socket>>( ioc, ctx );
+            } else {
+               plain = std::make_unique<tcp::socket>( ioc );
+            }
+         }
+
+         tcp::socket& socket() { return tls ? tls->next_layer() : *plain; }
+
+         template<typename F>
+         void with_stream( F&& f ) {
+            if( tls ) f( *tls );
+            else f( *plain );
+         }
+
+         void close() {
+            boost::system::error_code ec;
+            socket().close( ec );
+         }
+
+         const std::string                              key;
+         tcp::resolver                                  resolver;
+         boost::asio::steady_timer                      timer;
+         std::unique_ptr<ssl::stream<tcp::socket>>      tls;
+         std::unique_ptr<tcp::socket>                   plain;
+         boost::beast::flat_buffer                      buffer;
+         http::request<http::string_body>               req;
+         http::response<http::string_body>              res;
+         bool                                           connected = false;
+         bool                                           timed_out = false;
+      };
+
+      using http_connection_ptr = std::shared_ptr<http_connection>;
+   }
+
+   class async_http_client_impl : public std::enable_shared_from_this<async_http_client_impl> {
+   public:
+      explicit async_http_client_impl( boost::asio::io_context& ioc )
+         : ioc( ioc ), ssl_ctx( ssl::context::sslv23 ) {
+         ssl_ctx.set_default_verify_paths();
+      }
+
+      boost::asio::io_context&                         ioc;
+      ssl::context                                     ssl_ctx;
+      std::map<std::string, std::vector<http_connection_ptr>> idle_connections;
+
+      void request( const http_url& url, const std::string& method, const std::string& body,
+                    const fc::microseconds& timeout, async_http_client::response_callback cb, bool allow_retry ) {
+         http_connection_ptr conn;
+         auto& idle = idle_connections[url.connection_key()];
+         if( !idle.empty() ) {
+            conn = std::move( idle.back() );
+            idle.pop_back();
+         } else {
+            conn = std::make_shared<http_connection>( ioc, ssl_ctx, url );
+         }
+         const bool reused = conn->connected;
+
+         conn->req = {};
+         conn->req.method_string( method );
+         conn->req.target( url.target );
+         conn->req.version( 11 );
+         conn->req.set( http::field::host, url.host );
+         conn->req.set( http::field::accept, "*/*" );
+         conn->req.keep_alive( true );
+         if( !body.empty() ) {
+            conn->req.set( http::field::content_type, "application/json" );
+            conn->req.body() = body;
+         }
+         conn->req.prepare_payload();
+         conn->res = {};
+         conn->timed_out = false;
+
+         conn->timer.expires_after( std::chrono::microseconds( timeout.count() ) );
+         conn->timer.async_wait( [conn]( const boost::system::error_code& ec ) {
+            if( ec == boost::asio::error::operation_aborted ) return;
+            conn->timed_out = true;
+            boost::system::error_code ignored;
+            conn->resolver.cancel();
+            conn->socket().close( ignored );
+         } );
+
+         auto self = shared_from_this();
+         auto done = [self, conn, url, method, body, timeout, cb{std::move(cb)}, allow_retry, reused]( boost::system::error_code ec ) mutable {
+            conn->timer.cancel();
+            if( conn->timed_out ) ec = boost::asio::error::timed_out;
+            if( ec ) {
+               conn->connected = false;
+               conn->close();
+               // the server may have closed an idle keep-alive connection, retry once on a new connection
+               if( reused && allow_retry && !conn->timed_out ) {
+                  self->request( url, method, body, timeout, std::move( cb ), false );
+                  return;
+               }
+               cb( ec, 0, std::string() );
+               return;
+            }
+            const unsigned int status = conn->res.result_int();
+            std::string response_body = std::move( conn->res.body() );
+            if( conn->res.keep_alive() ) {
+               self->idle_connections[conn->key].push_back( conn );
+            } else {
+               conn->connected = false;
+               conn->close();
+            }
+            cb( ec, status, std::move( response_body ) );
+         };
+
+         if( reused ) {
+            write_request( conn, std::move( done ) );
+         } else {
+            connect( conn, url, std::move( done ) );
+         }
+      }
+
+      template<typename Done>
+      void connect( const http_connection_ptr& conn, const http_url& url, Done done ) {
+         conn->resolver.async_resolve( url.host, url.port,
+                                       [this, conn, host = url.host, done{std::move(done)}]( const boost::system::error_code& ec,
+                                                                                             tcp::resolver::results_type endpoints ) mutable {
+            if( ec ) return done( ec );
+            boost::asio::async_connect( conn->socket(), endpoints,
+                                        [this, conn, host, done{std::move(done)}]( const boost::system::error_code& ec, const tcp::endpoint& ) mutable {
+               if( ec ) return done( ec );
+               if( !conn->tls ) {
+                  conn->connected = true;
+                  return write_request( conn, std::move( done ) );
+               }
+               if( !SSL_set_tlsext_host_name( conn->tls->native_handle(), host.c_str() ) ) {
+                  return done( boost::system::error_code( static_cast<int>( ::ERR_get_error() ), boost::asio::error::get_ssl_category() ) );
+               }
+               conn->tls->set_verify_mode( ssl::verify_peer );
+               conn->tls->set_verify_callback( ssl::rfc2818_verification( host ) );
+               conn->tls->async_handshake( ssl::stream_base::client,
+                                           [this, conn, done{std::move(done)}]( const boost::system::error_code& ec ) mutable {
+                  if( ec ) return done( ec );
+                  conn->connected = true;
+                  write_request( conn, std::move( done ) );
+               } );
+            } );
+         } );
+      }
+
+      template<typename Done>
+      void write_request( const http_connection_ptr& conn, Done done ) {
+         conn->with_stream( [&]( auto& stream ) {
+            http::async_write( stream, conn->req,
+                               [conn, &stream, done{std::move(done)}]( const boost::system::error_code& ec, size_t ) mutable {
+               if( ec ) return done( ec );
+               http::async_read( stream, conn->buffer, conn->res,
+                                 [conn, done{std::move(done)}]( const boost::system::error_code& ec, size_t ) mutable {
+                  done( ec );
+               } );
+            } );
+         } );
+      }
+
+      void close() {
+         for( auto& idle : idle_connections ) {
+            for( auto& conn : idle.second ) {
+               conn->close();
+            }
+         }
+         idle_connections.clear();
+      }
+   };
+
+   async_http_client::async_http_client( boost::asio::io_context& ioc )
+      : my( std::make_shared<async_http_client_impl>( ioc ) ) {}
+
+   async_http_client::~async_http_client() {}
+
+   void async_http_client::async_request( const http_url& url, const std::string& method, const std::string& body,
+                                          const fc::microseconds& timeout, response_callback cb ) {
+      boost::asio::post( my->ioc, [my = my, url, method, body, timeout, cb{std::move(cb)}]() mutable {
+         my->request( url, method, body, timeout, std::move( cb ), true );
+      } );
+   }
+
+   void async_http_client::close() {
+      boost::asio::post( my->ioc, [my = my]() {
+         my->close();
+      } );
+   }
+
+}
@@ -0,0 +1,61 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#pragma once
+
+#include <fc/time.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/system/error_code.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace eosio {
+
+   /// http or https url split into the parts needed to connect and issue a request
+   struct http_url {
+      std::string scheme = "https";
+      std::string host;
+      std::string port = "443";
+      std::string target = "/";
+
+      /// parses `scheme://host[:port][/target]`, throws fc::exception on malformed urls
+      static http_url parse( const std::string& url );
+
+      std::string connection_key()const { return scheme + "://" + host + ":" + port; }
+   };
+
+   /**
+    * Asynchronous HTTP/1.1 client running on a caller provided io_context.
+    *
+    * Connections are kept alive and reused by later requests to the same scheme, host and port. Several requests
+    * may be in flight at the same time, each on its own connection. The io_context must be run by a single thread;
+    * callbacks are invoked on that thread.
+    */
+   class async_http_client {
+   public:
+      /// Arguments: error (also set on timeout), http status, response body
+      using response_callback = std::function<void(const boost::system::error_code&, unsigned int, std::string)>;
+
+      explicit async_http_client( boost::asio::io_context& ioc );
+      ~async_http_client();
+
+      /// a non-empty `body` is sent as application/json
+      void async_request( const http_url& url, const std::string& method, const std::string& body,
+                          const fc::microseconds& timeout, response_callback cb );
+
+      void async_get( const http_url& url, const fc::microseconds& timeout, response_callback cb ) {
+         async_request( url, "GET", std::string(), timeout, std::move(cb) );
+      }
+
+      /// closes idle connections; requests in flight are not affected
+      void close();
+
+   private:
+      std::shared_ptr<class async_http_client_impl> my;
+   };
+
+}
@@ -0,0 +1,59 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#pragma once
+
+#include <eosio/rem_oracle_plugin/async_http_client.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace eosio {
+
+   /**
+    * A source of REM token prices queried by rem_oracle_plugin.
+    *
+    * Each source answers a single http request with the prices of all requested currencies, sources are queried
+    * concurrently and their prices averaged per currency.
+    */
+   class price_source {
+   public:
+      virtual ~price_source() {}
+
+      virtual const char* name()const = 0;
+
+      virtual http_url request_url()const = 0;
+
+      /// @return prices by currency (e.g. "USD"), currencies not quoted by the response are omitted
+      virtual std::map<std::string, double> parse_prices( const std::string& response_body,
+                                                          const std::vector<std::string>& currencies )const = 0;
+   };
+
+   using price_source_ptr = std::unique_ptr<price_source>;
+
+   /// prices by currency
+   using source_prices = std::map<std::string, double>;
+
+   /**
+    * Queries all `sources` concurrently through `client` and calls `done` on the client's thread once all of them
+    * answered, with the prices of each source in the order of `sources`. A source whose request failed or timed out,
+    * which answered with a status other than 200 or with a malformed body has no prices. `sources` must outlive the
+    * call of `done`.
+    */
+   void fetch_prices( async_http_client& client, const std::vector<price_source_ptr>& sources,
+                      const std::vector<std::string>& currencies, const fc::microseconds& timeout,
+                      std::function<void(std::vector<source_prices>)> done );
+
+   /// @return the average of the positive prices of each currency, currencies no source quotes are omitted
+   source_prices average_prices( const std::vector<source_prices>& prices, const std::vector<std::string>& currencies );
+
+   /// `base_url` e.g. https://api.coingecko.com
+   price_source_ptr make_coingecko_price_source( const std::string& base_url );
+   /// `base_url` e.g. https://min-api.cryptocompare.com
+   price_source_ptr make_cryptocompare_price_source( const std::string& base_url, const std::string& apikey );
+
+}
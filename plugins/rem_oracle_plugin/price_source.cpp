@@ -0,0 +1,143 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE
+ */
+#include <eosio/rem_oracle_plugin/price_source.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/variant_object.hpp>
+
+namespace eosio {
+
+   namespace {
+
+      /// https://www.coingecko.com/en, averages the last price of all REM tickers per target currency
+      class coingecko_price_source : public price_source {
+      public:
+         explicit coingecko_price_source( const std::string& base_url )
+            : url( http_url::parse( base_url + "/api/v3/coins/remme/tickers" ) ) {}
+
+         const char* name()const override { return "coingecko"; }
+
+         http_url request_url()const override { return url; }
+
+         std::map<std::string, double> parse_prices( const std::string& response_body,
+                                                     const std::vector<std::string>& currencies )const override {
+            std::map<std::string, double> prices;
+            const auto response = fc::json::from_string( response_body ).get_object();
+            for( const auto& currency : currencies ) {
+               // USD is only traded against tether
+               const std::string target = currency == "USD" ? "USDT" : currency;
+               double sum = 0;
+               int count = 0;
+               for( const auto& ticker : response["tickers"].get_array() ) {
+                  const auto& t = ticker.get_object();
+                  if( t.contains( "target" ) && t["target"].as_string() == target && t.contains( "last" ) ) {
+                     sum += t["last"].as_double();
+                     ++count;
+                  }
+               }
+               if( count > 0 ) prices[currency] = sum / count;
+            }
+            return prices;
+         }
+
+      private:
+         http_url url;
+      };
+
+      /// https://www.cryptocompare.com/, quotes all currencies in a single flat object
+      class cryptocompare_price_source : public price_source {
+      public:
+         cryptocompare_price_source( const std::string& base_url, const std::string& apikey )
+            : url( http_url::parse( base_url + "/data/price?fsym=REM&tsyms=USD,BTC,ETH&apikey=" + apikey ) ) {}
+
+         const char* name()const override { return "cryptocompare"; }
+
+         http_url request_url()const override { return url; }
+
+         std::map<std::string, double> parse_prices( const std::string& response_body,
+                                                     const std::vector<std::string>& currencies )const override {
+            std::map<std::string, double> prices;
+            const auto response = fc::json::from_string( response_body ).get_object();
+            for( const auto& currency : currencies ) {
+               if( response.contains( currency.c_str() ) ) prices[currency] = response[currency].as_double();
+            }
+            return prices;
+         }
+
+      private:
+         http_url url;
+      };
+   }
+
+   price_source_ptr make_coingecko_price_source( const std::string& base_url ) {
+      return std::make_unique<coingecko_price_source>( base_url );
+   }
+
+   price_source_ptr make_cryptocompare_price_source( const std::string& base_url, const std::string& apikey ) {
+      return std::make_unique<cryptocompare_price_source>( base_url, apikey );
+   }
+
+   void fetch_prices( async_http_client& client, const std::vector<price_source_ptr>& sources,
+                      const std::vector<std::string>& currencies, const fc::microseconds& timeout,
+                      std::function<void(std::vector<source_prices>)> done ) {
+      struct price_round {
+         std::vector<source_prices>                     prices;
+         size_t                                         pending = 0;
+         std::vector<std::string>                       currencies;
+         std::function<void(std::vector<source_prices>)> done;
+      };
+      auto round = std::make_shared<price_round>();
+      round->prices.resize( sources.size() );
+      round->pending = sources.size();
+      round->currencies = currencies;
+      round->done = std::move( done );
+      if( sources.empty() ) {
+         round->done( std::move( round->prices ) );
+         return;
+      }
+
+      for( size_t i = 0; i < sources.size(); ++i ) {
+         const price_source* source = sources[i].get();
+         client.async_get( source->request_url(), timeout,
+                           [round, i, source]( const boost::system::error_code& ec, unsigned int status, std::string body ) {
+            try {
+               if( ec ) {
+                  wlog( "${s} request failed: ${e}", ("s", source->name())("e", ec.message()) );
+               } else if( status != 200 ) {
+                  wlog( "${s} request failed with http status ${c}", ("s", source->name())("c", status) );
+               } else {
+                  round->prices[i] = source->parse_prices( body, round->currencies );
+                  for( const auto& p : round->prices[i] ) {
+                     ilog( "avg ${c} ${s}: ${p}", ("c", p.first)("s", source->name())("p", p.second) );
+                  }
+               }
+            } FC_LOG_AND_DROP()
+            if( --round->pending == 0 ) {
+               round->done( std::move( round->prices ) );
+            }
+         } );
+      }
+   }
+
+   source_prices average_prices( const std::vector<source_prices>& prices, const std::vector<std::string>& currencies ) {
+      source_prices result;
+      for( const auto& currency : currencies ) {
+         double price_sum = 0;
+         int count = 0;
+         for( const auto& source : prices ) {
+            auto itr = source.find( currency );
+            if( itr != source.end() && itr->second > 0 ) {
+               price_sum += itr->second;
+               ++count;
+            }
+         }
+         if( count > 0 ) result[currency] = price_sum / count;
+      }
+      return result;
+   }
+
+}
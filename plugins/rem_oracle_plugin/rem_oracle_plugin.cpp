@@ -3,8 +3,10 @@
  *  @copyright defined in eos/LICENSE
  */
 #include <eosio/rem_oracle_plugin/rem_oracle_plugin.hpp>
-#include <eosio/rem_oracle_plugin/http_client.hpp>
+#include <eosio/rem_oracle_plugin/async_http_client.hpp>
+#include <eosio/rem_oracle_plugin/price_source.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/wast_to_wasm.hpp>
 
 #include <fc/variant.hpp>
@@ -22,18 +24,8 @@
 
 #include <contracts.hpp>
 
-#include <boost/optional/optional.hpp>
-#include <boost/iostreams/stream.hpp>
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/json_parser.hpp>
-#include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
-
-#include <boost/asio.hpp>
-#include <boost/bind.hpp>
-#include <boost/asio/ssl.hpp>
-
-using boost::asio::ip::tcp;
+#include <boost/asio/steady_timer.hpp>
 
 namespace eosio {
     static appbase::abstract_plugin &_rem_oracle_plugin = app().register_plugin<rem_oracle_plugin>();
@@ -47,126 +39,76 @@ namespace eosio {
         std::vector<std::string> _oracle_signing_permission;
 
         std::string _cryptocompare_apikey;
+        std::string _coingecko_url;
+        std::string _cryptocompare_url;
+        fc::microseconds _request_timeout;
+
+        fc::optional<named_thread_pool> _thread_pool;
+        std::unique_ptr<async_http_client> _http_client;
+        std::unique_ptr<boost::asio::steady_timer> _timer;
+        std::vector<price_source_ptr> _sources;
+        const std::vector<std::string> _currencies{"USD", "BTC", "ETH"};
 
         void start_monitor() {
             ilog("price monitor started");
-            while (true) {
-                try {
-                    uint32_t current_time_secs = fc::time_point::now().sec_since_epoch();
-                    uint32_t current_minutes = (current_time_secs / 60) % 60;
-
-                    if (current_minutes >= setprice_minutes_from && current_minutes < setprice_minutes_to) {
-                        std::map<std::string, double> coingecko_prices;
-                        std::map<std::string, double> cryptocompare_prices;
-                        std::map<name, double> average_prices;
-                        std::string currencies[] = {"USD", "BTC", "ETH"};
-
-                        for (size_t i = 0; i < 3; i++) {
-                            coingecko_prices[currencies[i]] = get_coingecko_rem_price(coingecko_host,
-                                                                                      coingecko_endpoint,
-                                                                                      (currencies[i] == "USD" ? "USDT"
-                                                                                                              : currencies[i].c_str()));
-                            ilog("avg ${c} coingecko: ${p}",
-                                 ("c", currencies[i])("p", coingecko_prices[currencies[i]]));
-
-                            cryptocompare_prices[currencies[i]] = 0;
-
-                            if (_cryptocompare_apikey != "0") {
-                                cryptocompare_prices[currencies[i]] = get_cryptocompare_rem_price(cryptocompare_host,
-                                                                                                  (string(cryptocompare_endpoint) +
-                                                                                                   string(cryptocompare_params) +
-                                                                                                   _cryptocompare_apikey).c_str(),
-                                                                                                  currencies[i].c_str());
-                                ilog("avg ${c} cryptocompare: ${p}",
-                                     ("c", currencies[i])("p", cryptocompare_prices[currencies[i]]));
-                            } else {
-                                wlog("cryptocompare-apikey is not set");
-                            }
-                            int count = (coingecko_prices[currencies[i]] == 0 ? 0 : 1) +
-                                        (cryptocompare_prices[currencies[i]] == 0 ? 0 : 1);
-                            if (count == 0) {
-                                elog("Can't retrieve REM token price data neither from https://www.cryptocompare.com/ not from https://www.coingecko.com/en");
-                                continue;
-                            }
-                            double price_sum =
-                                    (coingecko_prices[currencies[i]] == 0 ? 0 : coingecko_prices[currencies[i]]) +
-                                    (cryptocompare_prices[currencies[i]] == 0 ? 0
-                                                                              : cryptocompare_prices[currencies[i]]);
-                            average_prices[eosio::chain::string_to_name(
-                                    boost::algorithm::to_lower_copy("REM." + currencies[i]).c_str())] =
-                                    price_sum / count;
-                        }
+            _sources.emplace_back(make_coingecko_price_source(_coingecko_url));
+            if (_cryptocompare_apikey != "0") {
+                _sources.emplace_back(make_cryptocompare_price_source(_cryptocompare_url, _cryptocompare_apikey));
+            } else {
+                wlog("cryptocompare-apikey is not set");
+            }
 
-                        this->push_set_price_transaction(average_prices);
-                    }
-                    sleep(update_price_period);
+            _thread_pool.emplace("oracle", 1);
+            _http_client = std::make_unique<async_http_client>(_thread_pool->get_executor());
+            _timer = std::make_unique<boost::asio::steady_timer>(_thread_pool->get_executor());
+            boost::asio::post(_thread_pool->get_executor(), [this]() { update_prices(); });
+        }
 
-                } FC_LOG_WAIT_AND_CONTINUE()
+        void stop_monitor() {
+            if (_thread_pool) {
+                _thread_pool->stop();
             }
         }
 
-        std::string make_request(const char *host, const char *endpoint) {
-            boost::asio::ssl::context ctx(boost::asio::ssl::context::sslv23);
-            ctx.set_default_verify_paths();
+        void schedule_update() {
+            _timer->expires_after(std::chrono::seconds(update_price_period));
+            _timer->async_wait([this](const boost::system::error_code &ec) {
+                if (ec == boost::asio::error::operation_aborted) return;
+                update_prices();
+            });
+        }
 
-            boost::asio::io_service io_service;
-            http_client c(io_service, ctx, host, endpoint, "GET");
-            io_service.run();
+        /// runs on the oracle thread, queries all sources concurrently and pushes the averaged prices
+        void update_prices() {
+            uint32_t current_time_secs = fc::time_point::now().sec_since_epoch();
+            uint32_t current_minutes = (current_time_secs / 60) % 60;
+            if (current_minutes < setprice_minutes_from || current_minutes >= setprice_minutes_to) {
+                schedule_update();
+                return;
+            }
 
-            std::string response = c.get_response_body();
-            return response;
+            fetch_prices(*_http_client, _sources, _currencies, _request_timeout,
+                         [this](std::vector<source_prices> prices) {
+                push_average_prices(prices);
+                schedule_update();
+            });
         }
 
-        double
-        get_coingecko_rem_price(const char *coingecko_host, const char *remme_endpoint, const char *to_currency) {
-            try {
-                std::string response = make_request(coingecko_host, remme_endpoint);
-
-                boost::iostreams::stream<boost::iostreams::array_source> stream(response.c_str(), response.size());
-                namespace pt = boost::property_tree;
-                pt::ptree root;
-                pt::read_json(stream, root);
-                double sum = 0;
-                int counter = 0;
-                for (pt::ptree::value_type &log : root.get_child("tickers")) {
-                    //const std::string& key = log.first; // key
-                    const boost::property_tree::ptree &subtree = log.second;
-
-                    boost::optional<std::string> target_opt = subtree.get_optional<std::string>("target");
-                    boost::optional<std::string> last_opt = subtree.get_optional<std::string>("last");
-                    //boost::optional<std::string> txid_opt = subtree.get_optional<std::string>("transactionHash");
-                    //cout << "t2: " << data_opt.get() << endl;
-
-                    if (target_opt && target_opt.get() == to_currency) {
-                        sum += boost::lexical_cast<double>(last_opt.get());
-                        counter++;
-                    } else
-                        continue;
+        void push_average_prices(const std::vector<source_prices> &prices) {
+            std::map<name, double> pairs_data;
+            const auto average = average_prices(prices, _currencies);
+            for (const auto &currency : _currencies) {
+                auto itr = average.find(currency);
+                if (itr == average.end()) {
+                    elog("Can't retrieve REM token price data neither from https://www.cryptocompare.com/ not from https://www.coingecko.com/en");
+                    continue;
                 }
-                return sum / counter;
-            } catch (...) {
-                return 0;
+                pairs_data[eosio::chain::string_to_name(
+                        boost::algorithm::to_lower_copy("REM." + currency).c_str())] = itr->second;
             }
-        }
-
-        double get_cryptocompare_rem_price(const char *cryptocompare_host, const char *cryptocompare_endpoint,
-                                           const char *to_currency) {
             try {
-                std::string response = make_request(cryptocompare_host, cryptocompare_endpoint);
-
-                boost::iostreams::stream<boost::iostreams::array_source> stream(response.c_str(), response.size());
-                namespace pt = boost::property_tree;
-                pt::ptree root;
-                pt::read_json(stream, root);
-                boost::optional<double> price_opt = root.get_optional<double>(to_currency);
-                if (price_opt)
-                    return price_opt.get();
-                else
-                    return 0;
-            } catch (...) {
-                return 0;
-            }
-
+                push_set_price_transaction(pairs_data);
+            } FC_LOG_AND_DROP()
         }
 
         void push_set_price_transaction(const std::map<name, double> &pairs_data) {
@@ -224,6 +166,12 @@ namespace eosio {
                 ("cryptocompare-apikey",
                  bpo::value<std::string>()->default_value(std::string("0")),  // doesn't accept empty strings
                  "cryptocompare api key for reading REM token price")
+                ("coingecko-url", bpo::value<std::string>()->default_value("https://api.coingecko.com"),
+                 "coingecko api url for reading REM token price")
+                ("cryptocompare-url", bpo::value<std::string>()->default_value("https://min-api.cryptocompare.com"),
+                 "cryptocompare api url for reading REM token price")
+                ("oracle-request-timeout-ms", bpo::value<uint32_t>()->default_value(10000),
+                 "Timeout in milliseconds of a single request to a price source")
                 ("oracle-authority", bpo::value<std::vector<std::string>>(),
                  "Account name and permission to authorize set rem token price actions. For example blockproducer1@active")
                 ("oracle-signing-key", bpo::value<std::vector<std::string>>(),
@@ -255,6 +203,12 @@ namespace eosio {
 
             std::string cryptocompare_apikey = options.at("cryptocompare-apikey").as<std::string>();
             my->_cryptocompare_apikey = cryptocompare_apikey;
+            my->_coingecko_url = options.at("coingecko-url").as<std::string>();
+            my->_cryptocompare_url = options.at("cryptocompare-url").as<std::string>();
+            my->_request_timeout = fc::milliseconds(options.at("oracle-request-timeout-ms").as<uint32_t>());
+            // fail on malformed urls at startup rather than on every price update
+            http_url::parse(my->_coingecko_url);
+            http_url::parse(my->_cryptocompare_url);
 
             update_price_period = options.at("update_price_period").as<uint32_t>();
             setprice_minutes_from = options.at("setprice_minutes_from").as<uint32_t>();
@@ -265,16 +219,11 @@ namespace eosio {
     }
 
     void rem_oracle_plugin::plugin_startup() {
-        std::thread t2([=]() {
-            try {
-                my->start_monitor();
-            } FC_LOG_AND_RETHROW()
-        });
-        t2.detach();
+        my->start_monitor();
     }
 
     void rem_oracle_plugin::plugin_shutdown() {
-
+        my->stop_monitor();
     }
 
 }
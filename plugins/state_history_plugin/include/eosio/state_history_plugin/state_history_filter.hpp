@@ -0,0 +1,57 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <eosio/state_history_plugin/state_history_plugin.hpp>
+
+#include <deque>
+#include <map>
+#include <mutex>
+
+namespace eosio {
+
+/// Server side filter of a get_blocks_request_v2
+class history_filter {
+ public:
+   history_filter(std::vector<action_filter> action_filters, std::vector<table_filter> table_filters);
+
+   /// identical filters have the same id, so sessions share their filtered history
+   const fc::sha256& id() const { return _id; }
+
+   bool filters_traces() const { return !action_filters.empty(); }
+   bool filters_deltas() const { return !table_filters.empty(); }
+
+   /// keeps the matching action traces, and the transaction traces holding some
+   bytes filter_traces(const bytes& traces) const;
+
+   /// keeps the matching rows of the contract table deltas, drops the other deltas
+   bytes filter_deltas(const bytes& deltas) const;
+
+ private:
+   bool matches(chain::name receiver, chain::name action) const;
+   bool matches(chain::name code, chain::name scope, chain::name table) const;
+
+   std::vector<action_filter> action_filters;
+   std::vector<table_filter>  table_filters;
+   fc::sha256                 _id;
+};
+
+/// Filtered traces and deltas by filter and block, thread safe. The oldest entries are evicted beyond capacity.
+class filtered_history_cache {
+ public:
+   explicit filtered_history_cache(size_t capacity)
+       : capacity(capacity) {}
+
+   std::shared_ptr<const bytes> get(const fc::sha256& filter_id, const chain::block_id_type& block_id, bool deltas);
+   void put(const fc::sha256& filter_id, const chain::block_id_type& block_id, bool deltas,
+            std::shared_ptr<const bytes> filtered);
+
+ private:
+   using key = std::tuple<fc::sha256, chain::block_id_type, bool>;
+
+   const size_t                                 capacity;
+   std::mutex                                   mx;
+   std::map<key, std::shared_ptr<const bytes>> entries;
+   std::deque<key>                              insertion_order;
+};
+
+} // namespace eosio
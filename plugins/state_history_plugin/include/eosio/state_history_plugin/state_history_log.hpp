@@ -2,6 +2,7 @@
 
 #include <boost/filesystem.hpp>
 #include <fstream>
+#include <mutex>
 #include <stdint.h>
 
 #include <eosio/chain/block_header.hpp>
@@ -26,6 +27,8 @@ namespace eosio {
  * each entry:
  *    state_history_log_header
  *    payload
+ *
+ * The public members are thread safe: entries are written by the plugin's writer threads while sessions read them.
  */
 
 inline uint64_t       ship_magic(uint32_t version) { return N(ship).to_uint64_t() | version; }
@@ -53,6 +56,7 @@ class state_history_log {
    uint32_t             _begin_block = 0;
    uint32_t             _end_block   = 0;
    chain::block_id_type last_block_id;
+   mutable std::mutex   mx;
 
  public:
    state_history_log(const char* const name, std::string log_filename, std::string index_filename)
@@ -63,9 +67,63 @@ class state_history_log {
       open_index();
    }
 
-   uint32_t begin_block() const { return _begin_block; }
-   uint32_t end_block() const { return _end_block; }
+   uint32_t begin_block() const {
+      std::lock_guard<std::mutex> lock(mx);
+      return _begin_block;
+   }
+   uint32_t end_block() const {
+      std::lock_guard<std::mutex> lock(mx);
+      return _end_block;
+   }
 
+   template <typename F>
+   void write_entry(const state_history_log_header& header, const chain::block_id_type& prev_id, F write_payload) {
+      std::lock_guard<std::mutex> lock(mx);
+      write_entry_impl(header, prev_id, write_payload);
+   }
+
+   // calls read_payload(header, stream) with the cfile positioned at the payload, returns false if the log does not
+   // hold block_num
+   template <typename F>
+   bool read_entry(uint32_t block_num, F read_payload) {
+      std::lock_guard<std::mutex> lock(mx);
+      if (block_num < _begin_block || block_num >= _end_block)
+         return false;
+      state_history_log_header header;
+      auto&                    stream = get_entry(block_num, header);
+      read_payload(header, stream);
+      return true;
+   }
+
+   // calls read_payload(header, stream) for the entries of [begin_block, end_block) held by the log, walking the log
+   // sequentially from the first one instead of looking up every entry in the index
+   template <typename F>
+   void read_entries(uint32_t begin_block, uint32_t end_block, F read_payload) {
+      std::lock_guard<std::mutex> lock(mx);
+      begin_block = std::max(begin_block, _begin_block);
+      end_block   = std::min(end_block, _end_block);
+      if (begin_block >= end_block)
+         return;
+      uint64_t pos = get_pos(begin_block);
+      for (auto block_num = begin_block; block_num < end_block; ++block_num) {
+         state_history_log_header header;
+         log.seek(pos);
+         read_header(header);
+         read_payload(header, log);
+         pos += state_history_log_header_serial_size + header.payload_size + sizeof(uint64_t);
+      }
+   }
+
+   fc::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+      std::lock_guard<std::mutex> lock(mx);
+      if (block_num < _begin_block || block_num >= _end_block)
+         return {};
+      state_history_log_header header;
+      get_entry(block_num, header);
+      return header.block_id;
+   }
+
+ private:
    void read_header(state_history_log_header& header, bool assert_version = true) {
       char bytes[state_history_log_header_serial_size];
       log.read(bytes, sizeof(bytes));
@@ -86,7 +144,7 @@ class state_history_log {
    }
 
    template <typename F>
-   void write_entry(const state_history_log_header& header, const chain::block_id_type& prev_id, F write_payload) {
+   void write_entry_impl(const state_history_log_header& header, const chain::block_id_type& prev_id, F& write_payload) {
       auto block_num = chain::block_header::num_from_id(header.block_id);
       EOS_ASSERT(_begin_block == _end_block || block_num <= _end_block, chain::plugin_exception,
                  "missed a block in ${name}.log", ("name", name));
@@ -131,13 +189,6 @@ class state_history_log {
       return log;
    }
 
-   chain::block_id_type get_block_id(uint32_t block_num) {
-      state_history_log_header header;
-      get_entry(block_num, header);
-      return header.block_id;
-   }
-
- private:
    bool get_last_block(uint64_t size) {
       state_history_log_header header;
       uint64_t                 suffix;
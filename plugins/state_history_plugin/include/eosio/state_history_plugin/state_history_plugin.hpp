@@ -98,6 +98,31 @@ struct get_blocks_request_v0 {
    bool                        fetch_deltas           = false;
 };
 
+// answered with get_blocks_result_v1 messages holding up to max_blocks_per_message consecutive blocks each
+struct get_blocks_request_v1 : get_blocks_request_v0 {
+   uint32_t max_blocks_per_message = 0;
+};
+
+// an empty name matches any
+struct action_filter {
+   chain::name receiver = {};
+   chain::name action   = {};
+};
+
+// an empty name matches any
+struct table_filter {
+   chain::name code  = {};
+   chain::name scope = {};
+   chain::name table = {};
+};
+
+// Traces only hold the action traces matching one of action_filters, and the transaction traces holding some. Deltas
+// only hold the contract table rows matching one of table_filters. Empty filters leave traces or deltas unfiltered.
+struct get_blocks_request_v2 : get_blocks_request_v1 {
+   std::vector<action_filter> action_filters = {};
+   std::vector<table_filter>  table_filters  = {};
+};
+
 struct get_blocks_ack_request_v0 {
    uint32_t num_messages = 0;
 };
@@ -112,8 +137,23 @@ struct get_blocks_result_v0 {
    fc::optional<bytes>          deltas;
 };
 
-using state_request = fc::static_variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0>;
-using state_result  = fc::static_variant<get_status_result_v0, get_blocks_result_v0>;
+struct block_result {
+   block_position               this_block;
+   fc::optional<block_position> prev_block;
+   fc::optional<bytes>          block;
+   fc::optional<bytes>          traces;
+   fc::optional<bytes>          deltas;
+};
+
+struct get_blocks_result_v1 {
+   block_position            head;
+   block_position            last_irreversible;
+   std::vector<block_result> blocks;
+};
+
+using state_request = fc::static_variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0,
+                                         get_blocks_request_v1, get_blocks_request_v2>;
+using state_result  = fc::static_variant<get_status_result_v0, get_blocks_result_v0, get_blocks_result_v1>;
 
 class state_history_plugin : public plugin<state_history_plugin> {
  public:
@@ -140,5 +180,9 @@ FC_REFLECT(eosio::block_position, (block_num)(block_id));
 FC_REFLECT_EMPTY(eosio::get_status_request_v0);
 FC_REFLECT(eosio::get_status_result_v0, (head)(last_irreversible)(trace_begin_block)(trace_end_block)(chain_state_begin_block)(chain_state_end_block));
 FC_REFLECT(eosio::get_blocks_request_v0, (start_block_num)(end_block_num)(max_messages_in_flight)(have_positions)(irreversible_only)(fetch_block)(fetch_traces)(fetch_deltas));
+FC_REFLECT_DERIVED(eosio::get_blocks_request_v1, (eosio::get_blocks_request_v0), (max_blocks_per_message));
+FC_REFLECT(eosio::action_filter, (receiver)(action));
+FC_REFLECT(eosio::table_filter, (code)(scope)(table));
+FC_REFLECT_DERIVED(eosio::get_blocks_request_v2, (eosio::get_blocks_request_v1), (action_filters)(table_filters));
 FC_REFLECT(eosio::get_blocks_ack_request_v0, (num_messages));
 // clang-format on
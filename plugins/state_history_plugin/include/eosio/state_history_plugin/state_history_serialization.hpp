@@ -85,6 +85,17 @@ datastream<ST>& operator<<(datastream<ST>& ds, const history_serial_big_vector_w
    return ds;
 }
 
+template <typename ST, typename T>
+datastream<ST>& operator>>(datastream<ST>& ds, history_serial_big_vector_wrapper<T>& obj) {
+   fc::unsigned_int size;
+   fc::raw::unpack(ds, size);
+   FC_ASSERT(size.value <= 1024 * 1024 * 1024);
+   obj.obj.resize(size.value);
+   for (auto& x : obj.obj)
+      fc::raw::unpack(ds, x);
+   return ds;
+}
+
 template <typename ST>
 inline void history_pack_varuint64(datastream<ST>& ds, uint64_t val) {
    do {
@@ -692,4 +703,24 @@ datastream<ST>& operator<<(datastream<ST>& ds, const eosio::get_blocks_result_v0
    return ds;
 }
 
+template <typename ST>
+datastream<ST>& operator<<(datastream<ST>& ds, const eosio::block_result& obj) {
+   fc::raw::pack(ds, obj.this_block);
+   fc::raw::pack(ds, obj.prev_block);
+   history_pack_big_bytes(ds, obj.block);
+   history_pack_big_bytes(ds, obj.traces);
+   history_pack_big_bytes(ds, obj.deltas);
+   return ds;
+}
+
+template <typename ST>
+datastream<ST>& operator<<(datastream<ST>& ds, const eosio::get_blocks_result_v1& obj) {
+   fc::raw::pack(ds, obj.head);
+   fc::raw::pack(ds, obj.last_irreversible);
+   fc::raw::pack(ds, fc::unsigned_int(obj.blocks.size()));
+   for (auto& b : obj.blocks)
+      ds << b;
+   return ds;
+}
+
 } // namespace fc
@@ -0,0 +1,242 @@
+#include <eosio/state_history_plugin/state_history_filter.hpp>
+#include <eosio/state_history_plugin/state_history_serialization.hpp>
+
+#include <algorithm>
+#include <set>
+
+namespace eosio {
+using namespace chain;
+
+history_filter::history_filter(std::vector<action_filter> action_filters, std::vector<table_filter> table_filters)
+    : action_filters(std::move(action_filters))
+    , table_filters(std::move(table_filters)) {
+   _id = fc::sha256::hash(fc::raw::pack(std::make_pair(this->action_filters, this->table_filters)));
+}
+
+bool history_filter::matches(name receiver, name action) const {
+   for (auto& f : action_filters) {
+      if ((f.receiver.empty() || f.receiver == receiver) && (f.action.empty() || f.action == action))
+         return true;
+   }
+   return false;
+}
+
+bool history_filter::matches(name code, name scope, name table) const {
+   for (auto& f : table_filters) {
+      if ((f.code.empty() || f.code == code) && (f.scope.empty() || f.scope == scope) &&
+          (f.table.empty() || f.table == table))
+         return true;
+   }
+   return false;
+}
+
+namespace {
+
+using trace_stream = fc::datastream<const char*>;
+
+void skip(trace_stream& ds, size_t size) {
+   EOS_ASSERT(ds.remaining() >= size, plugin_exception, "truncated transaction trace");
+   ds.skip(size);
+}
+
+fc::unsigned_int read_varuint(trace_stream& ds) {
+   fc::unsigned_int v;
+   fc::raw::unpack(ds, v);
+   return v;
+}
+
+bool read_bool(trace_stream& ds) {
+   bool v;
+   fc::raw::unpack(ds, v);
+   return v;
+}
+
+// vector of `element_size` byte elements, or bytes and string when element_size is 1
+void skip_vector(trace_stream& ds, size_t element_size) {
+   uint64_t size = read_varuint(ds).value;
+   EOS_ASSERT(size <= ds.remaining() / element_size, plugin_exception, "truncated transaction trace");
+   ds.skip(size * element_size);
+}
+
+void skip_optional(trace_stream& ds, size_t size) {
+   if (read_bool(ds))
+      skip(ds, size);
+}
+
+void skip_optional_string(trace_stream& ds) {
+   if (read_bool(ds))
+      skip_vector(ds, 1);
+}
+
+void skip_action_receipt(trace_stream& ds) {
+   read_varuint(ds); // action_receipt_v0
+   skip(ds, sizeof(uint64_t) + sizeof(digest_type) + 2 * sizeof(uint64_t));
+   skip_vector(ds, 2 * sizeof(uint64_t)); // auth_sequence
+   read_varuint(ds);                      // code_sequence
+   read_varuint(ds);                      // abi_sequence
+}
+
+// leaves ds after receiver and act.name
+void read_action_trace_names(trace_stream& ds, uint64_t& receiver, uint64_t& action) {
+   read_varuint(ds); // action_trace_v0
+   read_varuint(ds); // action_ordinal
+   read_varuint(ds); // creator_action_ordinal
+   if (read_bool(ds))
+      skip_action_receipt(ds);
+   fc::raw::unpack(ds, receiver);
+   skip(ds, sizeof(uint64_t)); // act.account
+   fc::raw::unpack(ds, action);
+}
+
+void skip_action_trace_rest(trace_stream& ds) {
+   skip_vector(ds, 2 * sizeof(uint64_t));    // act.authorization
+   skip_vector(ds, 1);                       // act.data
+   skip(ds, sizeof(bool) + sizeof(int64_t)); // context_free, elapsed
+   skip_vector(ds, 1);                       // console
+   skip_vector(ds, 2 * sizeof(uint64_t));    // account_ram_deltas
+   skip_optional_string(ds);                 // except
+   skip_optional(ds, sizeof(uint64_t));      // error_code
+}
+
+// everything of a transaction_trace_v0 before its action traces
+void skip_transaction_trace_header(trace_stream& ds) {
+   read_varuint(ds); // transaction_trace_v0
+   skip(ds, sizeof(transaction_id_type) + sizeof(uint8_t) + sizeof(uint32_t)); // id, status, cpu_usage_us
+   read_varuint(ds);                                                           // net_usage_words
+   skip(ds, sizeof(int64_t) + sizeof(uint64_t) + sizeof(bool)); // elapsed, net_usage, scheduled
+}
+
+void skip_transaction_trace(trace_stream& ds);
+
+// everything of a transaction_trace_v0 after its action traces
+void skip_transaction_trace_tail(trace_stream& ds) {
+   skip_optional(ds, 2 * sizeof(uint64_t)); // account_ram_delta
+   skip_optional_string(ds);                // except
+   skip_optional(ds, sizeof(uint64_t));     // error_code
+   if (read_bool(ds))
+      skip_transaction_trace(ds); // failed_dtrx_trace
+   if (read_bool(ds)) {           // partial
+      read_varuint(ds);           // partial_transaction_v0
+      skip(ds, sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t)); // expiration, ref_block_num, ref_block_prefix
+      read_varuint(ds);                                                 // max_net_usage_words
+      skip(ds, sizeof(uint8_t));                                        // max_cpu_usage_ms
+      read_varuint(ds);                                                 // delay_sec
+      extensions_type             transaction_extensions;
+      std::vector<signature_type> signatures;
+      fc::raw::unpack(ds, transaction_extensions);
+      fc::raw::unpack(ds, signatures);
+      uint64_t context_free_data = read_varuint(ds).value;
+      for (uint64_t i = 0; i < context_free_data; ++i)
+         skip_vector(ds, 1);
+   }
+}
+
+void skip_transaction_trace(trace_stream& ds) {
+   skip_transaction_trace_header(ds);
+   uint64_t action_traces = read_varuint(ds).value;
+   for (uint64_t i = 0; i < action_traces; ++i) {
+      uint64_t receiver, action;
+      read_action_trace_names(ds, receiver, action);
+      skip_action_trace_rest(ds);
+   }
+   skip_transaction_trace_tail(ds);
+}
+
+} // namespace
+
+bytes history_filter::filter_traces(const bytes& traces) const {
+   // walks the packed transaction_trace[] and copies the byte ranges to keep, so the cost stays linear in the
+   // size of the traces without the deadline of the abi serializer
+   trace_stream ds(traces.data(), traces.size());
+   const char*  begin = traces.data();
+   auto         pos   = [&] { return ds.pos() - begin; };
+
+   bytes    kept;
+   uint32_t kept_traces = 0;
+   uint64_t num_traces  = read_varuint(ds).value;
+   for (uint64_t i = 0; i < num_traces; ++i) {
+      const auto trace_begin = pos();
+      skip_transaction_trace_header(ds);
+      const auto                                   header_end    = pos();
+      uint64_t                                     action_traces = read_varuint(ds).value;
+      std::vector<std::pair<ptrdiff_t, ptrdiff_t>> matching;
+      for (uint64_t j = 0; j < action_traces; ++j) {
+         const auto action_begin = pos();
+         uint64_t   receiver, action;
+         read_action_trace_names(ds, receiver, action);
+         skip_action_trace_rest(ds);
+         if (matches(name(receiver), name(action)))
+            matching.emplace_back(action_begin, pos());
+      }
+      const auto tail_begin = pos();
+      skip_transaction_trace_tail(ds);
+      if (matching.empty())
+         continue;
+
+      ++kept_traces;
+      kept.insert(kept.end(), begin + trace_begin, begin + header_end);
+      const auto count = fc::raw::pack(fc::unsigned_int(matching.size()));
+      kept.insert(kept.end(), count.begin(), count.end());
+      for (auto& m : matching)
+         kept.insert(kept.end(), begin + m.first, begin + m.second);
+      kept.insert(kept.end(), begin + tail_begin, begin + pos());
+   }
+   EOS_ASSERT(ds.remaining() == 0, plugin_exception, "unexpected data after transaction traces");
+
+   bytes result = fc::raw::pack(fc::unsigned_int(kept_traces));
+   result.insert(result.end(), kept.begin(), kept.end());
+   return result;
+}
+
+bytes history_filter::filter_deltas(const bytes& deltas) const {
+   static const std::set<std::string> contract_tables = {"contract_table",        "contract_row",
+                                                         "contract_index64",      "contract_index128",
+                                                         "contract_index256",     "contract_index_double",
+                                                         "contract_index_long_double"};
+
+   auto                     all = fc::raw::unpack<std::vector<table_delta>>(deltas);
+   std::vector<table_delta> result;
+   for (auto& delta : all) {
+      if (!contract_tables.count(delta.name))
+         continue;
+      auto& rows = delta.rows.obj;
+      // each contract table row starts with its variant index, code, scope and table
+      rows.erase(std::remove_if(rows.begin(), rows.end(),
+                                [&](const std::pair<bool, bytes>& row) {
+                                   fc::datastream<const char*> ds(row.second.data(), row.second.size());
+                                   fc::unsigned_int            version;
+                                   uint64_t                    code, scope, table;
+                                   fc::raw::unpack(ds, version);
+                                   fc::raw::unpack(ds, code);
+                                   fc::raw::unpack(ds, scope);
+                                   fc::raw::unpack(ds, table);
+                                   return !matches(name(code), name(scope), name(table));
+                                }),
+                 rows.end());
+      if (!rows.empty())
+         result.push_back(std::move(delta));
+   }
+   return fc::raw::pack(result);
+}
+
+std::shared_ptr<const bytes> filtered_history_cache::get(const fc::sha256& filter_id, const block_id_type& block_id,
+                                                         bool deltas) {
+   std::lock_guard<std::mutex> lock(mx);
+   auto                        it = entries.find(key{filter_id, block_id, deltas});
+   return it == entries.end() ? std::shared_ptr<const bytes>() : it->second;
+}
+
+void filtered_history_cache::put(const fc::sha256& filter_id, const block_id_type& block_id, bool deltas,
+                                 std::shared_ptr<const bytes> filtered) {
+   std::lock_guard<std::mutex> lock(mx);
+   key                         k{filter_id, block_id, deltas};
+   if (!entries.emplace(k, std::move(filtered)).second)
+      return;
+   insertion_order.push_back(std::move(k));
+   while (insertion_order.size() > capacity) {
+      entries.erase(insertion_order.front());
+      insertion_order.pop_front();
+   }
+}
+
+} // namespace eosio
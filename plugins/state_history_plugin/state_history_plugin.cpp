@@ -1,9 +1,12 @@
 #include <eosio/chain/config.hpp>
+#include <eosio/chain/thread_utils.hpp>
+#include <eosio/state_history_plugin/state_history_filter.hpp>
 #include <eosio/state_history_plugin/state_history_log.hpp>
 #include <eosio/state_history_plugin/state_history_serialization.hpp>
 
 #include <boost/asio/bind_executor.hpp>
 #include <boost/asio/ip/host_name.hpp>
+#include <boost/asio/io_context_strand.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
@@ -13,6 +16,10 @@
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/signals2/connection.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+
 using tcp    = boost::asio::ip::tcp;
 namespace ws = boost::beast::websocket;
 
@@ -58,6 +65,127 @@ static bytes zlib_decompress(const bytes& in) {
    return out;
 }
 
+/// Compresses the entries of a state_history_log on the thread pool and writes them in the order they were stored.
+/// The first entry which fails to compress or to be written stops the writer: later entries would leave a gap in
+/// the log, so they are dropped, on_failed is called once and store() throws from then on.
+class state_history_log_writer {
+ public:
+   state_history_log_writer(state_history_log& log, boost::asio::io_context& thread_pool, size_t max_pending,
+                            std::function<void()> on_written, std::function<void()> on_failed)
+       : log(log)
+       , thread_pool(thread_pool)
+       , max_pending(max_pending)
+       , on_written(std::move(on_written))
+       , on_failed(std::move(on_failed)) {}
+
+   // blocks while max_pending entries are waiting to be written
+   void store(const block_id_type& block_id, const block_id_type& prev_id, bytes payload) {
+      auto e = std::make_shared<entry>();
+      e->block_id = block_id;
+      e->prev_id  = prev_id;
+      {
+         std::unique_lock<std::mutex> lock(mx);
+         cv.wait(lock, [&] { return failed || queue.size() < max_pending; });
+         EOS_ASSERT(!failed, plugin_exception, "state history log writer stopped after a failed write, block ${id} is not stored",
+                    ("id", block_id));
+         queue.push_back(e);
+      }
+      boost::asio::post(thread_pool, [this, e, payload = std::move(payload)]() mutable {
+         fc::optional<bytes> compressed;
+         catch_and_log([&] { compressed = zlib_compress_bytes(std::move(payload)); });
+         std::unique_lock<std::mutex> lock(mx);
+         e->compressed = std::move(compressed);
+         e->done       = true;
+         write_ready_entries(lock);
+      });
+   }
+
+   // entries of this block and above may still change in the log
+   uint32_t first_pending_block() const {
+      std::lock_guard<std::mutex> lock(mx);
+      uint32_t                    result = std::numeric_limits<uint32_t>::max();
+      for (auto& e : queue)
+         result = std::min(result, block_header::num_from_id(e->block_id));
+      return result;
+   }
+
+   void wait_until_written() {
+      std::unique_lock<std::mutex> lock(mx);
+      cv.wait(lock, [&] { return queue.empty() && !writing; });
+   }
+
+ private:
+   struct entry {
+      block_id_type       block_id;
+      block_id_type       prev_id;
+      fc::optional<bytes> compressed;
+      bool                done = false;
+   };
+
+   // entries stay queued until written, so first_pending_block() covers the entry being written
+   void write_ready_entries(std::unique_lock<std::mutex>& lock) {
+      if (writing || failed)
+         return; // the writing thread picks up entries which complete meanwhile
+      writing      = true;
+      bool written = false;
+      while (!queue.empty() && queue.front()->done) {
+         auto e = queue.front();
+         lock.unlock();
+         bool ok = false;
+         catch_and_log([&] {
+            write(*e);
+            ok = true;
+         });
+         lock.lock();
+         if (!ok) {
+            failed = true;
+            queue.clear();
+            break;
+         }
+         written = true;
+         queue.pop_front();
+         cv.notify_all();
+      }
+      writing = false;
+      cv.notify_all();
+      if (written || failed) {
+         lock.unlock();
+         if (written)
+            on_written();
+         if (failed)
+            on_failed();
+         lock.lock();
+      }
+   }
+
+   void write(const entry& e) {
+      EOS_ASSERT(e.compressed, plugin_exception, "failed to compress entry of block ${id}", ("id", e.block_id));
+      auto& bin = *e.compressed;
+      EOS_ASSERT(bin.size() == (uint32_t)bin.size(), plugin_exception, "entry of block ${id} is too big",
+                 ("id", e.block_id));
+      state_history_log_header header{.magic        = ship_magic(ship_current_version),
+                                      .block_id     = e.block_id,
+                                      .payload_size = sizeof(uint32_t) + bin.size()};
+      log.write_entry(header, e.prev_id, [&](auto& stream) {
+         uint32_t s = (uint32_t)bin.size();
+         stream.write((char*)&s, sizeof(s));
+         if (!bin.empty())
+            stream.write(bin.data(), bin.size());
+      });
+   }
+
+   state_history_log&                 log;
+   boost::asio::io_context&           thread_pool;
+   const size_t                       max_pending;
+   std::function<void()>              on_written;
+   std::function<void()>              on_failed;
+   mutable std::mutex                 mx;
+   std::condition_variable            cv;
+   std::deque<std::shared_ptr<entry>> queue;
+   bool                               writing = false;
+   bool                               failed  = false;
+};
+
 template <typename T>
 bool include_delta(const T& old, const T& curr) {
    return true;
@@ -114,27 +242,60 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    chain_plugin*                                              chain_plug = nullptr;
    fc::optional<state_history_log>                            trace_log;
    fc::optional<state_history_log>                            chain_state_log;
-   bool                                                       trace_debug_mode = false;
-   bool                                                       stopping = false;
+   fc::optional<state_history_log_writer>                     trace_log_writer;
+   fc::optional<state_history_log_writer>                     chain_state_log_writer;
+   bool                                                       chain_state_log_empty = false;
+   bool                                                       trace_debug_mode      = false;
+   std::atomic<bool>                                          stopping{false};
    fc::optional<scoped_connection>                            applied_transaction_connection;
    fc::optional<scoped_connection>                            accepted_block_connection;
    string                                                     endpoint_address = "0.0.0.0";
    uint16_t                                                   endpoint_port    = 8080;
    std::unique_ptr<tcp::acceptor>                             acceptor;
+   uint16_t                                                   thread_pool_size = 2;
+   fc::optional<named_thread_pool>                            thread_pool; // compression, log writes and sessions
    std::map<transaction_id_type, augmented_transaction_trace> cached_traces;
    fc::optional<augmented_transaction_trace>                  onblock_trace;
+   filtered_history_cache                                     filtered_cache{1024};
 
-   void get_log_entry(state_history_log& log, uint32_t block_num, fc::optional<bytes>& result) {
-      if (block_num < log.begin_block() || block_num >= log.end_block())
-         return;
-      state_history_log_header header;
-      auto&                    stream = log.get_entry(block_num, header);
-      uint32_t                 s;
+   // upper bound of get_blocks_request_v1::max_blocks_per_message
+   static constexpr uint32_t max_blocks_per_message = 500;
+
+   static bytes read_compressed_payload(fc::cfile& stream) {
+      uint32_t s;
       stream.read((char*)&s, sizeof(s));
       bytes compressed(s);
       if (s)
          stream.read(compressed.data(), s);
-      result = zlib_decompress(compressed);
+      return compressed;
+   }
+
+   // thread safe, returns false if the log holds a different block than block_id
+   bool get_log_entry(state_history_log& log, const block_id_type& block_id, fc::optional<bytes>& result) {
+      bool  matches = true;
+      bytes compressed;
+      bool  found = log.read_entry(block_header::num_from_id(block_id), [&](const auto& header, auto& stream) {
+         matches = header.block_id == block_id;
+         if (matches)
+            compressed = read_compressed_payload(stream);
+      });
+      if (!matches)
+         return false;
+      if (found)
+         result = zlib_decompress(compressed);
+      return true;
+   }
+
+   // thread safe, the entries of [begin_block, end_block) held by the log
+   std::vector<std::pair<block_id_type, bytes>> get_log_entries(state_history_log& log, uint32_t begin_block,
+                                                                uint32_t end_block) {
+      std::vector<std::pair<block_id_type, bytes>> result;
+      log.read_entries(begin_block, end_block, [&](const auto& header, auto& stream) {
+         result.emplace_back(header.block_id, read_compressed_payload(stream));
+      });
+      for (auto& e : result)
+         e.second = zlib_decompress(e.second);
+      return result;
    }
 
    void get_block(uint32_t block_num, fc::optional<bytes>& result) {
@@ -149,10 +310,14 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    }
 
    fc::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
-      if (trace_log && block_num >= trace_log->begin_block() && block_num < trace_log->end_block())
-         return trace_log->get_block_id(block_num);
-      if (chain_state_log && block_num >= chain_state_log->begin_block() && block_num < chain_state_log->end_block())
-         return chain_state_log->get_block_id(block_num);
+      if (trace_log) {
+         if (auto id = trace_log->get_block_id(block_num))
+            return id;
+      }
+      if (chain_state_log) {
+         if (auto id = chain_state_log->get_block_id(block_num))
+            return id;
+      }
       try {
          auto block = chain_plug->chain().fetch_block_by_number(block_num);
          if (block)
@@ -162,17 +327,68 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       return {};
    }
 
+   // last block of the next response to req, which holds up to max_blocks blocks up to current
+   static uint32_t last_block_of_response(const get_blocks_request_v0& req, uint32_t current, uint32_t max_blocks) {
+      uint32_t last = std::min(current, req.end_block_num - 1);
+      if (last - req.start_block_num >= max_blocks)
+         last = req.start_block_num + max_blocks - 1;
+      return last;
+   }
+
+   // main thread; fills in everything but the traces and deltas of the next response, which the session reads from
+   // the logs. Returns the last block the session may send, blocks with history still being written are held back.
+   uint32_t get_blocks_result(const get_blocks_request_v0& req, uint32_t max_blocks, get_blocks_result_v1& result) {
+      auto& chain              = chain_plug->chain();
+      result.head              = {chain.head_block_num(), chain.head_block_id()};
+      result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
+      uint32_t current         = req.irreversible_only ? result.last_irreversible.block_num : result.head.block_num;
+      if (req.fetch_traces && trace_log_writer)
+         current = std::min(current, trace_log_writer->first_pending_block() - 1);
+      if (req.fetch_deltas && chain_state_log_writer)
+         current = std::min(current, chain_state_log_writer->first_pending_block() - 1);
+      if (req.start_block_num > current || req.start_block_num >= req.end_block_num)
+         return current;
+      const uint32_t last    = last_block_of_response(req, current, max_blocks);
+      auto           prev_id = get_block_id(req.start_block_num - 1);
+      for (uint32_t block_num = req.start_block_num; block_num <= last; ++block_num) {
+         auto block_id = get_block_id(block_num);
+         if (block_id) {
+            result.blocks.emplace_back();
+            auto& b      = result.blocks.back();
+            b.this_block = block_position{block_num, *block_id};
+            if (prev_id)
+               b.prev_block = block_position{block_num - 1, *prev_id};
+            if (req.fetch_block)
+               get_block(block_num, b.block);
+         }
+         prev_id = block_id;
+      }
+      return current;
+   }
+
+   using prefetched_entries = std::map<uint32_t, std::pair<block_id_type, bytes>>;
+
+   // Sessions run on the thread pool, each on its own strand. Chain state is only accessed on the main thread through
+   // query_chain(), traces and deltas are read and decompressed on the strand.
    struct session : std::enable_shared_from_this<session> {
       std::shared_ptr<state_history_plugin_impl> plugin;
+      boost::asio::io_context::strand            strand;
       std::unique_ptr<ws::stream<tcp::socket>>   socket_stream;
       bool                                       sending  = false;
       bool                                       sent_abi = false;
       std::vector<std::vector<char>>             send_queue;
       fc::optional<get_blocks_request_v0>        current_request;
+      uint32_t                                   blocks_per_message  = 0; // 0 for get_blocks_request_v0
+      uint32_t                                   request_generation  = 0; // changes when current_request is reset
+      std::shared_ptr<const history_filter>      filter; // of get_blocks_request_v2
+      prefetched_entries                         prefetched_traces;
+      prefetched_entries                         prefetched_deltas;
       bool                                       need_to_send_update = false;
+      bool                                       updating            = false; // waiting for get_blocks_result()
 
       session(std::shared_ptr<state_history_plugin_impl> plugin)
-          : plugin(std::move(plugin)) {}
+          : plugin(std::move(plugin))
+          , strand(this->plugin->thread_pool->get_executor()) {}
 
       void start(tcp::socket socket) {
          ilog("incoming connection");
@@ -181,18 +397,21 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          socket_stream->next_layer().set_option(boost::asio::ip::tcp::no_delay(true));
          socket_stream->next_layer().set_option(boost::asio::socket_base::send_buffer_size(1024 * 1024));
          socket_stream->next_layer().set_option(boost::asio::socket_base::receive_buffer_size(1024 * 1024));
-         socket_stream->async_accept([self = shared_from_this()](boost::system::error_code ec) {
-            self->callback(ec, "async_accept", [self] {
-               self->start_read();
-               self->send(state_history_plugin_abi);
-            });
-         });
+         socket_stream->async_accept(
+             boost::asio::bind_executor(strand, [self = shared_from_this()](boost::system::error_code ec) {
+                self->callback(ec, "async_accept", [self] {
+                   self->start_read();
+                   self->send(state_history_plugin_abi);
+                });
+             }));
       }
 
+      // the next request is read once the current one is handled, so requests are handled in order
       void start_read() {
          auto in_buffer = std::make_shared<boost::beast::flat_buffer>();
          socket_stream->async_read(
-             *in_buffer, [self = shared_from_this(), in_buffer](boost::system::error_code ec, size_t) {
+             *in_buffer, boost::asio::bind_executor(strand, [self = shared_from_this(), in_buffer](
+                                                                boost::system::error_code ec, size_t) {
                 self->callback(ec, "async_read", [self, in_buffer] {
                    auto d = boost::asio::buffer_cast<char const*>(boost::beast::buffers_front(in_buffer->data()));
                    auto s = boost::asio::buffer_size(in_buffer->data());
@@ -200,9 +419,8 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
                    state_request               req;
                    fc::raw::unpack(ds, req);
                    req.visit(*self);
-                   self->start_read();
                 });
-             });
+             }));
       }
 
       void send(const char* s) {
@@ -226,85 +444,249 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          sent_abi = true;
          socket_stream->async_write( //
              boost::asio::buffer(send_queue[0]),
-             [self = shared_from_this()](boost::system::error_code ec, size_t) {
+             boost::asio::bind_executor(strand, [self = shared_from_this()](boost::system::error_code ec, size_t) {
                 self->callback(ec, "async_write", [self] {
                    self->send_queue.erase(self->send_queue.begin());
                    self->sending = false;
                    self->send();
                 });
-             });
+             }));
+      }
+
+      // runs query on the main thread and hands its result to then on the strand
+      template <typename Query, typename Then>
+      void query_chain(Query query, Then then) {
+         app().post(priority::medium, [self = shared_from_this(), query = std::move(query),
+                                       then = std::move(then)]() mutable {
+            if (self->plugin->stopping)
+               return;
+            fc::optional<decltype(query())> result;
+            catch_and_log([&] { result.emplace(query()); });
+            boost::asio::post(self->strand, [self, result = std::move(result), then = std::move(then)]() mutable {
+               if (self->plugin->stopping)
+                  return;
+               if (!result)
+                  return self->close();
+               self->catch_and_close([&] { then(std::move(*result)); });
+            });
+         });
       }
 
       using result_type = void;
       void operator()(get_status_request_v0&) {
-         auto&                chain = plugin->chain_plug->chain();
-         get_status_result_v0 result;
-         result.head              = {chain.head_block_num(), chain.head_block_id()};
-         result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
-         if (plugin->trace_log) {
-            result.trace_begin_block = plugin->trace_log->begin_block();
-            result.trace_end_block   = plugin->trace_log->end_block();
-         }
-         if (plugin->chain_state_log) {
-            result.chain_state_begin_block = plugin->chain_state_log->begin_block();
-            result.chain_state_end_block   = plugin->chain_state_log->end_block();
-         }
-         send(std::move(result));
+         query_chain(
+             [plugin = plugin] {
+                auto&                chain = plugin->chain_plug->chain();
+                get_status_result_v0 result;
+                result.head              = {chain.head_block_num(), chain.head_block_id()};
+                result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
+                if (plugin->trace_log) {
+                   result.trace_begin_block = plugin->trace_log->begin_block();
+                   result.trace_end_block   = plugin->trace_log->end_block();
+                }
+                if (plugin->chain_state_log) {
+                   result.chain_state_begin_block = plugin->chain_state_log->begin_block();
+                   result.chain_state_end_block   = plugin->chain_state_log->end_block();
+                }
+                return result;
+             },
+             [this](get_status_result_v0 result) {
+                send(std::move(result));
+                start_read();
+             });
       }
 
-      void operator()(get_blocks_request_v0& req) {
-         for (auto& cp : req.have_positions) {
-            if (req.start_block_num <= cp.block_num)
-               continue;
-            auto id = plugin->get_block_id(cp.block_num);
-            if (!id || *id != cp.block_id)
-               req.start_block_num = std::min(req.start_block_num, cp.block_num);
-         }
-         req.have_positions.clear();
-         current_request = req;
-         send_update(true);
+      void operator()(get_blocks_request_v0& req) { start_get_blocks(req, 0); }
+
+      void operator()(get_blocks_request_v1& req) { start_get_blocks(req, get_blocks_per_message(req)); }
+
+      void operator()(get_blocks_request_v2& req) {
+         std::shared_ptr<const history_filter> filter;
+         if (!req.action_filters.empty() || !req.table_filters.empty())
+            filter = std::make_shared<history_filter>(std::move(req.action_filters), std::move(req.table_filters));
+         start_get_blocks(req, get_blocks_per_message(req), std::move(filter));
+      }
+
+      static uint32_t get_blocks_per_message(const get_blocks_request_v1& req) {
+         return std::min(std::max(req.max_blocks_per_message, 1u), max_blocks_per_message);
+      }
+
+      void start_get_blocks(get_blocks_request_v0 req, uint32_t blocks_per_message,
+                            std::shared_ptr<const history_filter> filter = {}) {
+         query_chain(
+             [plugin = plugin, req]() mutable {
+                for (auto& cp : req.have_positions) {
+                   if (req.start_block_num <= cp.block_num)
+                      continue;
+                   auto id = plugin->get_block_id(cp.block_num);
+                   if (!id || *id != cp.block_id)
+                      req.start_block_num = std::min(req.start_block_num, cp.block_num);
+                }
+                req.have_positions.clear();
+                return req;
+             },
+             [this, blocks_per_message, filter](get_blocks_request_v0 req) {
+                current_request          = std::move(req);
+                this->blocks_per_message = blocks_per_message;
+                this->filter             = filter;
+                ++request_generation;
+                prefetched_traces.clear();
+                prefetched_deltas.clear();
+                send_update(true);
+                start_read();
+             });
       }
 
       void operator()(get_blocks_ack_request_v0& req) {
-         if (!current_request)
-            return;
-         current_request->max_messages_in_flight += req.num_messages;
-         send_update();
+         if (current_request) {
+            current_request->max_messages_in_flight += req.num_messages;
+            send_update();
+         }
+         start_read();
       }
 
       void send_update(bool changed = false) {
          if (changed)
             need_to_send_update = true;
-         if (!send_queue.empty() || !need_to_send_update || !current_request ||
+         if (updating || !send_queue.empty() || !need_to_send_update || !current_request ||
              !current_request->max_messages_in_flight)
             return;
-         auto&                chain = plugin->chain_plug->chain();
+         updating                  = true;
+         const uint32_t max_blocks = std::max(blocks_per_message, 1u);
+         query_chain(
+             [plugin = plugin, req = *current_request, max_blocks] {
+                std::pair<get_blocks_result_v1, uint32_t> r;
+                r.second = plugin->get_blocks_result(req, max_blocks, r.first);
+                return r;
+             },
+             [this, generation = request_generation, max_blocks](std::pair<get_blocks_result_v1, uint32_t> r) {
+                updating = false;
+                if (generation != request_generation || !current_request)
+                   return send_update();
+                auto&          req     = *current_request;
+                auto&          result  = r.first;
+                const uint32_t current = r.second;
+                if (req.start_block_num <= current && req.start_block_num < req.end_block_num) {
+                   if (!read_history(result.blocks))
+                      return send_update(); // forked out of the logs meanwhile
+                   req.start_block_num = last_block_of_response(req, current, max_blocks) + 1;
+                }
+                --req.max_messages_in_flight;
+                need_to_send_update = req.start_block_num <= current && req.start_block_num < req.end_block_num;
+                if (blocks_per_message)
+                   send(std::move(result));
+                else
+                   send(to_v0(std::move(result)));
+             });
+         if (blocks_per_message)
+            prefetch_history();
+      }
+
+      static get_blocks_result_v0 to_v0(get_blocks_result_v1&& r) {
          get_blocks_result_v0 result;
-         result.head              = {chain.head_block_num(), chain.head_block_id()};
-         result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
-         uint32_t current =
-             current_request->irreversible_only ? result.last_irreversible.block_num : result.head.block_num;
-         if (current_request->start_block_num <= current &&
-             current_request->start_block_num < current_request->end_block_num) {
-            auto block_id = plugin->get_block_id(current_request->start_block_num);
-            if (block_id) {
-               result.this_block  = block_position{current_request->start_block_num, *block_id};
-               auto prev_block_id = plugin->get_block_id(current_request->start_block_num - 1);
-               if (prev_block_id)
-                  result.prev_block = block_position{current_request->start_block_num - 1, *prev_block_id};
-               if (current_request->fetch_block)
-                  plugin->get_block(current_request->start_block_num, result.block);
-               if (current_request->fetch_traces && plugin->trace_log)
-                  plugin->get_log_entry(*plugin->trace_log, current_request->start_block_num, result.traces);
-               if (current_request->fetch_deltas && plugin->chain_state_log)
-                  plugin->get_log_entry(*plugin->chain_state_log, current_request->start_block_num, result.deltas);
+         result.head              = r.head;
+         result.last_irreversible = r.last_irreversible;
+         if (!r.blocks.empty()) {
+            auto& b           = r.blocks.front();
+            result.this_block = b.this_block;
+            result.prev_block = b.prev_block;
+            result.block      = std::move(b.block);
+            result.traces     = std::move(b.traces);
+            result.deltas     = std::move(b.deltas);
+         }
+         return result;
+      }
+
+      // false if a block was forked out of the logs meanwhile
+      bool read_history(std::vector<block_result>& blocks) {
+         for (auto& b : blocks) {
+            if (current_request->fetch_traces && plugin->trace_log &&
+                !read_filtered_log_entry(false, *plugin->trace_log, prefetched_traces, b.this_block, b.traces))
+               return false;
+            if (current_request->fetch_deltas && plugin->chain_state_log &&
+                !read_filtered_log_entry(true, *plugin->chain_state_log, prefetched_deltas, b.this_block, b.deltas))
+               return false;
+         }
+         return true;
+      }
+
+      // filtered entries are shared through the plugin's cache with the sessions using the same filter
+      bool read_filtered_log_entry(bool deltas, state_history_log& log, prefetched_entries& prefetched,
+                                   const block_position& pos, fc::optional<bytes>& result) {
+         const bool filtered = filter && (deltas ? filter->filters_deltas() : filter->filters_traces());
+         if (filtered) {
+            if (auto cached = plugin->filtered_cache.get(filter->id(), pos.block_id, deltas)) {
+               result = *cached;
+               return true;
+            }
+         }
+         if (!read_log_entry(log, prefetched, pos, result))
+            return false;
+         if (filtered && result) {
+            auto filtered_entry = std::make_shared<const bytes>(deltas ? filter->filter_deltas(*result)
+                                                                       : filter->filter_traces(*result));
+            plugin->filtered_cache.put(filter->id(), pos.block_id, deltas, filtered_entry);
+            result = *filtered_entry;
+         }
+         return true;
+      }
+
+      bool read_log_entry(state_history_log& log, prefetched_entries& prefetched, const block_position& pos,
+                          fc::optional<bytes>& result) {
+         auto it = prefetched.find(pos.block_num);
+         if (it != prefetched.end()) {
+            auto entry = std::move(it->second);
+            prefetched.erase(it);
+            if (entry.first == pos.block_id) {
+               result = std::move(entry.second);
+               return true;
             }
-            ++current_request->start_block_num;
          }
-         send(std::move(result));
-         --current_request->max_messages_in_flight;
-         need_to_send_update = current_request->start_block_num <= current &&
-                               current_request->start_block_num < current_request->end_block_num;
+         return plugin->get_log_entry(log, pos.block_id, result);
+      }
+
+      // Reads ahead the log entries of the next two responses while the main thread looks up their blocks. A session
+      // catching up reads the logs sequentially this way rather than seeking every entry through the index.
+      void prefetch_history() {
+         const uint32_t begin = current_request->start_block_num;
+         const uint32_t end   = std::min<uint64_t>(uint64_t(begin) + 2 * blocks_per_message,
+                                                   current_request->end_block_num);
+         if (current_request->fetch_traces && plugin->trace_log)
+            prefetch(*plugin->trace_log, prefetched_traces, begin, end);
+         if (current_request->fetch_deltas && plugin->chain_state_log)
+            prefetch(*plugin->chain_state_log, prefetched_deltas, begin, end);
+      }
+
+      void prefetch(state_history_log& log, prefetched_entries& prefetched, uint32_t begin, uint32_t end) {
+         prefetched.erase(prefetched.begin(), prefetched.lower_bound(begin));
+         if (!prefetched.empty())
+            begin = std::max(begin, prefetched.rbegin()->first + 1);
+         for (auto& e : plugin->get_log_entries(log, begin, end))
+            prefetched[block_header::num_from_id(e.first)] = std::move(e);
+      }
+
+      // main thread
+      void on_accepted_block(uint32_t block_num) {
+         boost::asio::post(strand, [self = shared_from_this(), block_num] {
+            if (self->plugin->stopping)
+               return;
+            self->catch_and_close([&] {
+               if (self->current_request && block_num < self->current_request->start_block_num) {
+                  self->current_request->start_block_num = block_num;
+                  ++self->request_generation;
+               }
+               self->send_update(true);
+            });
+         });
+      }
+
+      // main thread
+      void on_history_written() {
+         boost::asio::post(strand, [self = shared_from_this()] {
+            if (self->plugin->stopping)
+               return;
+            self->catch_and_close([&] { self->send_update(true); });
+         });
       }
 
       template <typename F>
@@ -325,13 +707,11 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
 
       template <typename F>
       void callback(boost::system::error_code ec, const char* what, F f) {
-         app().post( priority::medium, [=]() {
-            if( plugin->stopping )
-               return;
-            if( ec )
-               return on_fail( ec, what );
-            catch_and_close( f );
-         } );
+         if (plugin->stopping)
+            return;
+         if (ec)
+            return on_fail(ec, what);
+         catch_and_close(f);
       }
 
       void on_fail(boost::system::error_code ec, const char* what) {
@@ -345,10 +725,10 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
 
       void close() {
          socket_stream->next_layer().close();
-         plugin->sessions.erase(this);
+         app().post(priority::medium, [self = shared_from_this()] { self->plugin->sessions.erase(self.get()); });
       }
    };
-   std::map<session*, std::shared_ptr<session>> sessions;
+   std::map<session*, std::shared_ptr<session>> sessions; // main thread
 
    void listen() {
       boost::system::error_code ec;
@@ -375,7 +755,7 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    }
 
    void do_accept() {
-      auto socket = std::make_shared<tcp::socket>(app().get_io_service());
+      auto socket = std::make_shared<tcp::socket>(thread_pool->get_executor());
       acceptor->async_accept(*socket, [self = shared_from_this(), socket, this](const boost::system::error_code& ec) {
          if (stopping)
             return;
@@ -421,11 +801,44 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       store_chain_state(block_state);
       for (auto& s : sessions) {
          auto& p = s.second;
-         if (p) {
-            if (p->current_request && block_state->block_num < p->current_request->start_block_num)
-               p->current_request->start_block_num = block_state->block_num;
-            p->send_update(true);
+         if (p)
+            p->on_accepted_block(block_state->block_num);
+      }
+   }
+
+   void on_history_written() {
+      app().post(priority::medium, [this] {
+         if (stopping)
+            return;
+         for (auto& s : sessions) {
+            auto& p = s.second;
+            if (p)
+               p->on_history_written();
          }
+      });
+   }
+
+   // a log which stopped being written would never serve the following blocks, so the node stops
+   void on_write_failed(const char* name) {
+      app().post(priority::high, [this, name] {
+         if (stopping)
+            return;
+         elog("failed to write the ${name} log, shutting down", ("name", name));
+         app().quit();
+      });
+   }
+
+   void create_writers() {
+      // bounds the memory held by blocks waiting for compression, e.g. while replaying
+      const size_t max_pending = 4 * thread_pool_size;
+      if (trace_log)
+         trace_log_writer.emplace(*trace_log, thread_pool->get_executor(), max_pending, [this] { on_history_written(); },
+                                  [this] { on_write_failed("trace history"); });
+      if (chain_state_log) {
+         chain_state_log_writer.emplace(*chain_state_log, thread_pool->get_executor(), max_pending,
+                                        [this] { on_history_written(); },
+                                        [this] { on_write_failed("chain state history"); });
+         chain_state_log_empty = chain_state_log->begin_block() == chain_state_log->end_block();
       }
    }
 
@@ -449,25 +862,17 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       cached_traces.clear();
       onblock_trace.reset();
 
-      auto& db         = chain_plug->chain().db();
-      auto  traces_bin = zlib_compress_bytes(fc::raw::pack(make_history_context_wrapper(db, trace_debug_mode, traces)));
-      EOS_ASSERT(traces_bin.size() == (uint32_t)traces_bin.size(), plugin_exception, "traces is too big");
-
-      state_history_log_header header{.magic        = ship_magic(ship_current_version),
-                                      .block_id     = block_state->block->id(),
-                                      .payload_size = sizeof(uint32_t) + traces_bin.size()};
-      trace_log->write_entry(header, block_state->block->previous, [&](auto& stream) {
-         uint32_t s = (uint32_t)traces_bin.size();
-         stream.write((char*)&s, sizeof(s));
-         if (!traces_bin.empty())
-            stream.write(traces_bin.data(), traces_bin.size());
-      });
+      auto& db = chain_plug->chain().db();
+      trace_log_writer->store(block_state->id, block_state->block->previous,
+                              fc::raw::pack(make_history_context_wrapper(db, trace_debug_mode, traces)));
    }
 
    void store_chain_state(const block_state_ptr& block_state) {
       if (!chain_state_log)
          return;
-      bool fresh = chain_state_log->begin_block() == chain_state_log->end_block();
+      // the log may still be empty while the first entry is compressed
+      bool fresh            = chain_state_log_empty;
+      chain_state_log_empty = false;
       if (fresh)
          ilog("Placing initial state in block ${n}", ("n", block_state->block->block_num()));
 
@@ -550,17 +955,7 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       process_table("resource_limits_state", db.get_index<resource_limits::resource_limits_state_index>(), pack_row);
       process_table("resource_limits_config", db.get_index<resource_limits::resource_limits_config_index>(), pack_row);
 
-      auto deltas_bin = zlib_compress_bytes(fc::raw::pack(deltas));
-      EOS_ASSERT(deltas_bin.size() == (uint32_t)deltas_bin.size(), plugin_exception, "deltas is too big");
-      state_history_log_header header{.magic        = ship_magic(ship_current_version),
-                                      .block_id     = block_state->block->id(),
-                                      .payload_size = sizeof(uint32_t) + deltas_bin.size()};
-      chain_state_log->write_entry(header, block_state->block->previous, [&](auto& stream) {
-         uint32_t s = (uint32_t)deltas_bin.size();
-         stream.write((char*)&s, sizeof(s));
-         if (!deltas_bin.empty())
-            stream.write(deltas_bin.data(), deltas_bin.size());
-      });
+      chain_state_log_writer->store(block_state->id, block_state->block->previous, fc::raw::pack(deltas));
    } // store_chain_state
 };   // state_history_plugin_impl
 
@@ -581,6 +976,8 @@ void state_history_plugin::set_program_options(options_description& cli, options
            "your internal network.");
    options("trace-history-debug-mode", bpo::bool_switch()->default_value(false),
            "enable debug mode for trace history");
+   options("state-history-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
+           "number of worker threads compressing state history and serving state history sessions");
 }
 
 void state_history_plugin::plugin_initialize(const variables_map& options) {
@@ -628,6 +1025,13 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
       if (options.at("chain-state-history").as<bool>())
          my->chain_state_log.emplace("chain_state_history", (state_history_dir / "chain_state_history.log").string(),
                                      (state_history_dir / "chain_state_history.index").string());
+
+      my->thread_pool_size = options.at("state-history-threads").as<uint16_t>();
+      EOS_ASSERT(my->thread_pool_size > 0, plugin_exception, "state-history-threads ${num} must be greater than 0",
+                 ("num", my->thread_pool_size));
+      // started here as replaying the chain stores history before plugin_startup
+      my->thread_pool.emplace("ship", my->thread_pool_size);
+      my->create_writers();
    }
    FC_LOG_AND_RETHROW()
 } // state_history_plugin::plugin_initialize
@@ -637,9 +1041,18 @@ void state_history_plugin::plugin_startup() { my->listen(); }
 void state_history_plugin::plugin_shutdown() {
    my->applied_transaction_connection.reset();
    my->accepted_block_connection.reset();
-   while (!my->sessions.empty())
-      my->sessions.begin()->second->close();
    my->stopping = true;
+   if (my->trace_log_writer)
+      my->trace_log_writer->wait_until_written();
+   if (my->chain_state_log_writer)
+      my->chain_state_log_writer->wait_until_written();
+   for (auto& s : my->sessions) {
+      auto p = s.second;
+      boost::asio::post(p->strand, [p] { catch_and_log([&] { p->socket_stream->next_layer().close(); }); });
+   }
+   my->sessions.clear();
+   if (my->thread_pool)
+      my->thread_pool->stop();
 }
 
 } // namespace eosio
@@ -47,6 +47,9 @@ struct blocklog {
    bool                             make_index = false;
    bool                             trim_log = false;
    bool                             smoke_test = false;
+   bool                             pack_log = false;
+   bool                             unpack_log = false;
+   uint32_t                         pack_size = 10000;
    bool                             help = false;
 };
 
@@ -185,6 +188,12 @@ void blocklog::set_program_options(options_description& cli)
           "Trim blocks.log and blocks.index. Must give 'blocks-dir' and 'first and/or 'last'.")
          ("smoke-test", bpo::bool_switch(&smoke_test)->default_value(false),
           "Quick test that blocks.log and blocks.index are well formed and agree with each other.")
+         ("pack-blocklog", bpo::bool_switch(&pack_log)->default_value(false),
+          "Move all but the most recent blocks of blocks.log into zlib compressed packs in blocks.packs. Must give 'blocks-dir'.")
+         ("unpack-blocklog", bpo::bool_switch(&unpack_log)->default_value(false),
+          "Move the blocks of blocks.packs back into blocks.log. Must give 'blocks-dir'.")
+         ("pack-size", bpo::value<uint32_t>(&pack_size)->default_value(10000),
+          "the number of blocks per pack if pack-blocklog creates blocks.packs")
          ("help,h", bpo::bool_switch(&help)->default_value(false), "Print this help message and exit.")
          ;
 }
@@ -301,6 +310,18 @@ int main(int argc, char** argv) {
          }
          return 0;
       }
+      if (blog.pack_log) {
+         report_time rt("packing blocklog");
+         block_log::pack_blocklog(vmap.at("blocks-dir").as<bfs::path>(), blog.pack_size);
+         rt.report();
+         return 0;
+      }
+      if (blog.unpack_log) {
+         report_time rt("unpacking blocklog");
+         block_log::unpack_blocklog(vmap.at("blocks-dir").as<bfs::path>());
+         rt.report();
+         return 0;
+      }
       if (blog.make_index) {
          const bfs::path blocks_dir = vmap.at("blocks-dir").as<bfs::path>();
          bfs::path out_file = blocks_dir / "blocks.index";
@@ -0,0 +1,84 @@
+#include <boost/test/unit_test.hpp>
+
+#include <eosio/producer_plugin/batch_queue.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(batch_queue_tests)
+
+BOOST_AUTO_TEST_CASE(batches_are_capped) {
+   batch_queue<int> q( 3 );
+   // only the first entry schedules the consumer
+   BOOST_REQUIRE( q.push( 1 ) );
+   for( int i = 2; i <= 7; ++i )
+      BOOST_REQUIRE( !q.push( i ) );
+
+   bool more = false;
+   auto batch = q.pop_batch( more );
+   BOOST_REQUIRE( more );
+   BOOST_REQUIRE( batch == std::vector<int>( { 1, 2, 3 } ) );
+   // the consumer is still scheduled for the remainder
+   BOOST_REQUIRE( !q.push( 8 ) );
+
+   batch = q.pop_batch( more );
+   BOOST_REQUIRE( more );
+   BOOST_REQUIRE( batch == std::vector<int>( { 4, 5, 6 } ) );
+
+   batch = q.pop_batch( more );
+   BOOST_REQUIRE( !more );
+   BOOST_REQUIRE( batch == std::vector<int>( { 7, 8 } ) );
+   BOOST_REQUIRE_EQUAL( q.size(), 0u );
+
+   // an empty queue schedules the consumer again
+   BOOST_REQUIRE( q.push( 9 ) );
+   batch = q.pop_batch( more );
+   BOOST_REQUIRE( !more );
+   BOOST_REQUIRE( batch == std::vector<int>( { 9 } ) );
+}
+
+BOOST_AUTO_TEST_CASE(move_only_entries) {
+   batch_queue<std::unique_ptr<int>> q( 2 );
+   q.push( std::make_unique<int>( 1 ) );
+   q.push( std::make_unique<int>( 2 ) );
+   q.push( std::make_unique<int>( 3 ) );
+   bool more = false;
+   auto batch = q.pop_batch( more );
+   BOOST_REQUIRE( more );
+   BOOST_REQUIRE_EQUAL( batch.size(), 2u );
+   BOOST_REQUIRE_EQUAL( *batch[0], 1 );
+   BOOST_REQUIRE_EQUAL( *batch[1], 2 );
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_producers) {
+   batch_queue<int> q( 10 );
+   constexpr int per_thread = 1000;
+   std::atomic<int> schedules{0};
+   std::vector<std::thread> threads;
+   for( int t = 0; t < 4; ++t ) {
+      threads.emplace_back( [&q, &schedules, t]() {
+         for( int i = 0; i < per_thread; ++i ) {
+            if( q.push( t * per_thread + i ) )
+               ++schedules;
+         }
+      } );
+   }
+   for( auto& t : threads )
+      t.join();
+
+   // nothing was consumed, so the consumer was scheduled once
+   BOOST_REQUIRE_EQUAL( schedules.load(), 1 );
+   size_t consumed = 0;
+   bool more = true;
+   while( more ) {
+      auto batch = q.pop_batch( more );
+      BOOST_REQUIRE_LE( batch.size(), 10u );
+      consumed += batch.size();
+   }
+   BOOST_REQUIRE_EQUAL( consumed, 4u * per_thread );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,257 @@
+#include <boost/test/unit_test.hpp>
+
+#include <eosio/rem_oracle_plugin/async_http_client.hpp>
+#include <eosio/rem_oracle_plugin/price_source.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace eosio;
+
+namespace {
+
+   using boost::asio::ip::tcp;
+   namespace http = boost::beast::http;
+
+   /// keep-alive http server on the loopback interface answering each target with a preset response
+   class mock_http_server {
+   public:
+      struct response {
+         unsigned int              status = 200;
+         std::string               body;
+         std::chrono::milliseconds delay{0};
+      };
+
+      mock_http_server()
+         : acceptor( ioc, tcp::endpoint( boost::asio::ip::address_v4::loopback(), 0 ) ) {
+         accept();
+         thread = std::thread( [this]() { ioc.run(); } );
+      }
+
+      ~mock_http_server() {
+         ioc.stop();
+         thread.join();
+      }
+
+      std::string url()const { return "http://127.0.0.1:" + std::to_string( acceptor.local_endpoint().port() ); }
+
+      /// `target` without the query string
+      void set_response( const std::string& target, response r ) {
+         std::lock_guard<std::mutex> g( mtx );
+         responses[target] = std::move( r );
+      }
+
+      std::atomic<uint32_t> connections{0};
+
+   private:
+      struct session {
+         explicit session( tcp::socket s ) : socket( std::move( s ) ), timer( socket.get_executor() ) {}
+
+         tcp::socket                        socket;
+         boost::asio::steady_timer          timer;
+         boost::beast::flat_buffer          buffer;
+         http::request<http::string_body>   req;
+         http::response<http::string_body>  res;
+      };
+
+      void accept() {
+         acceptor.async_accept( [this]( const boost::system::error_code& ec, tcp::socket socket ) {
+            if( ec ) return;
+            ++connections;
+            read( std::make_shared<session>( std::move( socket ) ) );
+            accept();
+         } );
+      }
+
+      void read( std::shared_ptr<session> s ) {
+         s->req = {};
+         http::async_read( s->socket, s->buffer, s->req, [this, s]( const boost::system::error_code& ec, size_t ) {
+            if( ec ) return;
+            std::string target = s->req.target().to_string();
+            target = target.substr( 0, target.find( '?' ) );
+            response r{ 404, "" };
+            {
+               std::lock_guard<std::mutex> g( mtx );
+               auto itr = responses.find( target );
+               if( itr != responses.end() ) r = itr->second;
+            }
+            s->res = http::response<http::string_body>( static_cast<http::status>( r.status ), s->req.version() );
+            s->res.keep_alive( s->req.keep_alive() );
+            s->res.body() = r.body;
+            s->res.prepare_payload();
+            s->timer.expires_after( r.delay );
+            s->timer.async_wait( [this, s]( const boost::system::error_code& ) {
+               http::async_write( s->socket, s->res, [this, s]( const boost::system::error_code& ec, size_t ) {
+                  if( ec || !s->res.keep_alive() ) return;
+                  read( s );
+               } );
+            } );
+         } );
+      }
+
+      boost::asio::io_context                 ioc;
+      tcp::acceptor                           acceptor;
+      std::mutex                              mtx;
+      std::map<std::string, response>         responses;
+      std::thread                             thread;
+   };
+
+   struct http_result {
+      boost::system::error_code ec;
+      unsigned int              status = 0;
+      std::string               body;
+   };
+
+   http_result get( async_http_client& client, boost::asio::io_context& ioc, const std::string& url,
+                    const fc::microseconds& timeout = fc::seconds(5) ) {
+      http_result result;
+      client.async_get( http_url::parse( url ), timeout,
+                        [&result]( const boost::system::error_code& ec, unsigned int status, std::string body ) {
+         result = http_result{ ec, status, std::move( body ) };
+      } );
+      ioc.restart();
+      ioc.run();
+      return result;
+   }
+
+   const std::vector<std::string> currencies{ "USD", "BTC", "ETH" };
+
+   const std::string coingecko_body = R"({"tickers":[{"target":"USDT","last":0.01},{"target":"BTC","last":0.000001},)"
+                                      R"({"target":"USDT","last":0.03}]})";
+}
+
+BOOST_AUTO_TEST_SUITE(rem_oracle_plugin_tests)
+
+BOOST_AUTO_TEST_CASE(http_client_success) {
+   mock_http_server server;
+   server.set_response( "/prices", { 200, "{\"USD\":0.02}" } );
+
+   boost::asio::io_context ioc;
+   async_http_client client( ioc );
+   for( int i = 0; i < 2; ++i ) {
+      const auto result = get( client, ioc, server.url() + "/prices" );
+      BOOST_REQUIRE( !result.ec );
+      BOOST_REQUIRE_EQUAL( result.status, 200u );
+      BOOST_REQUIRE_EQUAL( result.body, "{\"USD\":0.02}" );
+   }
+   // the second request reused the keep-alive connection
+   BOOST_REQUIRE_EQUAL( server.connections.load(), 1u );
+}
+
+BOOST_AUTO_TEST_CASE(http_client_timeout) {
+   mock_http_server server;
+   server.set_response( "/slow", { 200, "{}", std::chrono::milliseconds(2000) } );
+
+   boost::asio::io_context ioc;
+   async_http_client client( ioc );
+   const auto start = fc::time_point::now();
+   const auto result = get( client, ioc, server.url() + "/slow", fc::milliseconds(100) );
+   BOOST_REQUIRE( result.ec == boost::asio::error::timed_out );
+   BOOST_REQUIRE_EQUAL( result.status, 0u );
+   BOOST_REQUIRE( fc::time_point::now() - start < fc::milliseconds(1500) );
+
+   // a timed out connection is not reused
+   server.set_response( "/slow", { 200, "{}" } );
+   const auto retry = get( client, ioc, server.url() + "/slow" );
+   BOOST_REQUIRE( !retry.ec );
+   BOOST_REQUIRE_EQUAL( retry.status, 200u );
+}
+
+BOOST_AUTO_TEST_CASE(http_client_error_status) {
+   mock_http_server server;
+   server.set_response( "/prices", { 503, "unavailable" } );
+
+   boost::asio::io_context ioc;
+   async_http_client client( ioc );
+   const auto result = get( client, ioc, server.url() + "/prices" );
+   BOOST_REQUIRE( !result.ec );
+   BOOST_REQUIRE_EQUAL( result.status, 503u );
+
+   // a non-200 answer yields no prices
+   std::vector<price_source_ptr> sources;
+   sources.emplace_back( make_cryptocompare_price_source( server.url(), "key" ) );
+   server.set_response( "/data/price", { 503, "unavailable" } );
+   std::vector<source_prices> prices;
+   fetch_prices( client, sources, currencies, fc::seconds(5), [&]( std::vector<source_prices> p ) { prices = std::move( p ); } );
+   ioc.restart();
+   ioc.run();
+   BOOST_REQUIRE_EQUAL( prices.size(), 1u );
+   BOOST_REQUIRE( prices[0].empty() );
+}
+
+BOOST_AUTO_TEST_CASE(price_source_malformed_json) {
+   const auto coingecko = make_coingecko_price_source( "http://127.0.0.1" );
+   const auto cryptocompare = make_cryptocompare_price_source( "http://127.0.0.1", "key" );
+   BOOST_CHECK_THROW( coingecko->parse_prices( "{\"tickers\":[", currencies ), fc::exception );
+   BOOST_CHECK_THROW( coingecko->parse_prices( "[1,2]", currencies ), fc::exception );
+   BOOST_CHECK_THROW( cryptocompare->parse_prices( "not json", currencies ), fc::exception );
+
+   const auto prices = coingecko->parse_prices( coingecko_body, currencies );
+   BOOST_REQUIRE_EQUAL( prices.size(), 2u );
+   BOOST_REQUIRE_CLOSE( prices.at( "USD" ), 0.02, 1e-9 );
+   BOOST_REQUIRE_CLOSE( prices.at( "BTC" ), 0.000001, 1e-9 );
+
+   // a malformed answer yields no prices
+   mock_http_server server;
+   server.set_response( "/data/price", { 200, "{\"USD\":" } );
+   boost::asio::io_context ioc;
+   async_http_client client( ioc );
+   std::vector<price_source_ptr> sources;
+   sources.emplace_back( make_cryptocompare_price_source( server.url(), "key" ) );
+   std::vector<source_prices> fetched;
+   fetch_prices( client, sources, currencies, fc::seconds(5), [&]( std::vector<source_prices> p ) { fetched = std::move( p ); } );
+   ioc.run();
+   BOOST_REQUIRE_EQUAL( fetched.size(), 1u );
+   BOOST_REQUIRE( fetched[0].empty() );
+}
+
+BOOST_AUTO_TEST_CASE(fetch_prices_one_source_failing) {
+   mock_http_server server;
+   server.set_response( "/api/v3/coins/remme/tickers", { 200, coingecko_body } );
+   server.set_response( "/data/price", { 200, "{}", std::chrono::milliseconds(2000) } );
+
+   boost::asio::io_context ioc;
+   async_http_client client( ioc );
+   std::vector<price_source_ptr> sources;
+   sources.emplace_back( make_coingecko_price_source( server.url() ) );
+   sources.emplace_back( make_cryptocompare_price_source( server.url(), "key" ) );
+
+   bool done = false;
+   std::vector<source_prices> prices;
+   fetch_prices( client, sources, currencies, fc::milliseconds(200), [&]( std::vector<source_prices> p ) {
+      done = true;
+      prices = std::move( p );
+   } );
+   ioc.run();
+   BOOST_REQUIRE( done );
+   BOOST_REQUIRE_EQUAL( prices.size(), 2u );
+   BOOST_REQUIRE_EQUAL( prices[0].size(), 2u );
+   BOOST_REQUIRE( prices[1].empty() );
+
+   // the failed source does not drag the average, currencies nobody quotes are left out
+   const auto average = average_prices( prices, currencies );
+   BOOST_REQUIRE_EQUAL( average.size(), 2u );
+   BOOST_REQUIRE_CLOSE( average.at( "USD" ), 0.02, 1e-9 );
+   BOOST_REQUIRE_CLOSE( average.at( "BTC" ), 0.000001, 1e-9 );
+   BOOST_REQUIRE( average.count( "ETH" ) == 0 );
+
+   // both sources answering are averaged
+   server.set_response( "/data/price", { 200, R"({"USD":0.04,"BTC":0.000003,"ETH":0.0001})" } );
+   fetch_prices( client, sources, currencies, fc::seconds(5), [&]( std::vector<source_prices> p ) { prices = std::move( p ); } );
+   ioc.restart();
+   ioc.run();
+   const auto both = average_prices( prices, currencies );
+   BOOST_REQUIRE_CLOSE( both.at( "USD" ), 0.03, 1e-9 );
+   BOOST_REQUIRE_CLOSE( both.at( "BTC" ), 0.000002, 1e-9 );
+   BOOST_REQUIRE_CLOSE( both.at( "ETH" ), 0.0001, 1e-9 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,232 @@
+#include <boost/test/unit_test.hpp>
+
+#include <eosio/state_history_plugin/state_history_filter.hpp>
+#include <eosio/state_history_plugin/state_history_serialization.hpp>
+#include <eosio/chain/contract_table_objects.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <algorithm>
+#include <functional>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+namespace {
+
+   action_trace make_action_trace( uint32_t ordinal, account_name receiver, account_name account, action_name name ) {
+      action_trace at;
+      at.action_ordinal = ordinal;
+      at.creator_action_ordinal = ordinal > 1 ? 1 : 0;
+      at.receipt.emplace();
+      at.receipt->receiver = receiver;
+      at.receipt->act_digest = digest_type::hash( name.to_string() );
+      at.receipt->global_sequence = ordinal;
+      at.receipt->recv_sequence = ordinal;
+      at.receipt->auth_sequence[account] = ordinal;
+      at.receiver = receiver;
+      at.act = action( vector<permission_level>{{account, config::active_name}}, account, name, bytes{ 'd', 'a', 't', 'a' } );
+      at.elapsed = fc::microseconds( 10 );
+      at.console = "console";
+      at.account_ram_deltas.emplace( receiver, 128 );
+      return at;
+   }
+
+   transaction_trace_ptr make_transaction_trace( const transaction_id_type& id, std::vector<action_trace> action_traces,
+                                                 transaction_receipt_header::status_enum status ) {
+      auto trace = std::make_shared<transaction_trace>();
+      trace->id = id;
+      trace->receipt.emplace( status );
+      trace->receipt->cpu_usage_us = 100;
+      trace->receipt->net_usage_words = 12;
+      trace->elapsed = fc::microseconds( 200 );
+      trace->net_usage = 96;
+      trace->action_traces = std::move( action_traces );
+      return trace;
+   }
+
+   /// one trace of every shape the state history serializes: notifications, partial transaction, exception,
+   /// ram delta and failed deferred transaction
+   std::vector<augmented_transaction_trace> make_traces() {
+      signed_transaction trx;
+      trx.expiration = fc::time_point_sec( 1000 );
+      trx.max_net_usage_words = 300;
+      trx.delay_sec = 5;
+      trx.signatures.emplace_back();
+      trx.context_free_data.push_back( bytes{ 'c', 'f', 'd' } );
+
+      std::vector<augmented_transaction_trace> traces;
+      traces.emplace_back( make_transaction_trace( digest_type::hash( std::string( "transfer" ) ), {
+         make_action_trace( 1, N(rem.token), N(rem.token), N(transfer) ),
+         make_action_trace( 2, N(alice), N(rem.token), N(transfer) ),
+         make_action_trace( 3, N(bob), N(rem.token), N(transfer) ) },
+         transaction_receipt_header::executed ), trx );
+
+      auto failing = make_action_trace( 1, N(alice), N(alice), N(hi) );
+      failing.except = fc::exception( fc::assert_exception_code, "assert", "failing action" );
+      failing.error_code = 42;
+      auto failed = make_transaction_trace( digest_type::hash( std::string( "failed" ) ), { failing },
+                                            transaction_receipt_header::hard_fail );
+      failed->account_ram_delta.emplace( N(alice), -64 );
+      failed->except = failing.except;
+      failed->error_code = 42;
+      traces.emplace_back( failed );
+
+      auto dtrx = make_transaction_trace( digest_type::hash( std::string( "deferred" ) ),
+                                          { make_action_trace( 1, N(bob), N(bob), N(deferred) ) },
+                                          transaction_receipt_header::hard_fail );
+      dtrx->except = fc::exception( fc::assert_exception_code, "assert", "failing deferred transaction" );
+      auto onerror = make_transaction_trace( digest_type::hash( std::string( "onerror" ) ),
+                                             { make_action_trace( 1, N(bob), N(bob), N(onerror) ) },
+                                             transaction_receipt_header::soft_fail );
+      onerror->scheduled = true;
+      onerror->failed_dtrx_trace = dtrx;
+      traces.emplace_back( onerror, trx );
+      return traces;
+   }
+
+   /// traces holding only the action traces for which keep returns true, without the ones left empty
+   std::vector<augmented_transaction_trace> filtered( const std::vector<augmented_transaction_trace>& traces,
+                                                      const std::function<bool( const action_trace& )>& keep ) {
+      std::vector<augmented_transaction_trace> result;
+      for( const auto& t : traces ) {
+         auto trace = std::make_shared<transaction_trace>( *t.trace );
+         auto& action_traces = trace->action_traces;
+         action_traces.erase( std::remove_if( action_traces.begin(), action_traces.end(),
+                                              [&]( const action_trace& at ) { return !keep( at ); } ),
+                              action_traces.end() );
+         if( !action_traces.empty() )
+            result.emplace_back( trace, t.partial );
+      }
+      return result;
+   }
+
+   std::vector<std::pair<bool, bytes>>& rows( std::vector<table_delta>& deltas, const std::string& name ) {
+      deltas.push_back( {} );
+      deltas.back().name = name;
+      return deltas.back().rows.obj;
+   }
+
+   void check_deltas( const bytes& filtered_deltas, const std::vector<table_delta>& expected ) {
+      const auto result = fc::raw::unpack<std::vector<table_delta>>( filtered_deltas );
+      BOOST_REQUIRE_EQUAL( result.size(), expected.size() );
+      for( size_t i = 0; i < result.size(); ++i ) {
+         BOOST_CHECK_EQUAL( result[i].name, expected[i].name );
+         BOOST_CHECK( result[i].rows.obj == expected[i].rows.obj );
+      }
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(state_history_filter_tests)
+
+BOOST_AUTO_TEST_CASE(filter_traces) { try {
+   tester chain;
+   const auto& db = chain.control->db();
+   const auto traces = make_traces();
+
+   for( bool debug_mode : { false, true } ) {
+      auto pack = [&]( const std::vector<augmented_transaction_trace>& t ) {
+         return fc::raw::pack( make_history_context_wrapper( db, debug_mode, t ) );
+      };
+      const bytes packed = pack( traces );
+
+      // only the action trace of the contract is kept out of its notifications, the other transactions are dropped
+      history_filter transfers( { { N(rem.token), N(transfer) } }, {} );
+      BOOST_CHECK( transfers.filter_traces( packed ) == pack( filtered( traces, []( const action_trace& at ) {
+         return at.receiver == N(rem.token);
+      } ) ) );
+
+      // any action of a receiver or any receiver of an action, the failed deferred transaction is kept as is
+      history_filter alice_or_onerror( { { N(alice), {} }, { {}, N(onerror) } }, {} );
+      BOOST_CHECK( alice_or_onerror.filter_traces( packed ) == pack( filtered( traces, []( const action_trace& at ) {
+         return at.receiver == N(alice) || at.act.name == N(onerror);
+      } ) ) );
+
+      history_filter carol( { { N(carol), {} } }, {} );
+      BOOST_CHECK( carol.filter_traces( packed ) == pack( {} ) );
+
+      // truncated traces are rejected rather than misread
+      const bytes truncated( packed.begin(), packed.end() - 1 );
+      BOOST_CHECK_THROW( transfers.filter_traces( truncated ), plugin_exception );
+   }
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(filter_deltas) { try {
+   tester chain;
+   auto& db = chain.control->mutable_db();
+
+   auto create_table = [&]( account_name code, scope_name scope, table_name table ) -> const table_id_object& {
+      return db.create<table_id_object>( [&]( table_id_object& t ) {
+         t.code = code;
+         t.scope = scope;
+         t.table = table;
+         t.payer = scope;
+      } );
+   };
+   auto create_row = [&]( const table_id_object& t, uint64_t primary_key ) -> const key_value_object& {
+      return db.create<key_value_object>( [&]( key_value_object& o ) {
+         o.t_id = t.id;
+         o.primary_key = primary_key;
+         o.payer = t.payer;
+         o.value.assign( "row", 3 );
+      } );
+   };
+   const auto& alice_accounts = create_table( N(rem.token), N(alice), N(accounts) );
+   const auto& bob_accounts = create_table( N(rem.token), N(bob), N(accounts) );
+   const auto& other_stat = create_table( N(other), N(alice), N(stat) );
+   const auto& alice_row = create_row( alice_accounts, 1 );
+   const auto& alice_removed_row = create_row( alice_accounts, 2 );
+   const auto& bob_row = create_row( bob_accounts, 1 );
+   const auto& other_index = db.create<index64_object>( [&]( index64_object& o ) {
+      o.t_id = other_stat.id;
+      o.primary_key = 1;
+      o.payer = other_stat.payer;
+      o.secondary_key = 7;
+   } );
+
+   auto table_row = [&]( bool present, const table_id_object& t ) {
+      return std::make_pair( present, fc::raw::pack( make_history_serial_wrapper( db, t ) ) );
+   };
+   auto contract_row = [&]( bool present, const table_id_object& t, const auto& row ) {
+      return std::make_pair( present, fc::raw::pack( make_history_context_wrapper( db, t, row ) ) );
+   };
+
+   std::vector<table_delta> deltas;
+   rows( deltas, "account" ).emplace_back(
+      true, fc::raw::pack( make_history_serial_wrapper( db, db.get<account_object, by_name>( config::system_account_name ) ) ) );
+   rows( deltas, "contract_table" ) = { table_row( true, alice_accounts ), table_row( true, bob_accounts ), table_row( true, other_stat ) };
+   rows( deltas, "contract_row" ) = { contract_row( true, alice_accounts, alice_row ), contract_row( true, bob_accounts, bob_row ),
+                                      contract_row( false, alice_accounts, alice_removed_row ) };
+   rows( deltas, "contract_index64" ) = { contract_row( true, other_stat, other_index ) };
+   const bytes packed = fc::raw::pack( deltas );
+
+   // rows of a scope, including the removed ones, the deltas left without rows and the other tables are dropped
+   std::vector<table_delta> alice;
+   rows( alice, "contract_table" ) = { table_row( true, alice_accounts ) };
+   rows( alice, "contract_row" ) = { contract_row( true, alice_accounts, alice_row ),
+                                     contract_row( false, alice_accounts, alice_removed_row ) };
+   check_deltas( history_filter( {}, { { N(rem.token), N(alice), {} } } ).filter_deltas( packed ), alice );
+
+   // a table of any contract and scope, the index rows are matched as the contract rows
+   std::vector<table_delta> stat;
+   rows( stat, "contract_table" ) = { table_row( true, other_stat ) };
+   rows( stat, "contract_index64" ) = { contract_row( true, other_stat, other_index ) };
+   check_deltas( history_filter( {}, { { {}, {}, N(stat) } } ).filter_deltas( packed ), stat );
+
+   std::vector<table_delta> all_contracts( deltas.begin() + 1, deltas.end() );
+   check_deltas( history_filter( {}, { { N(rem.token), {}, {} }, { N(other), {}, {} } } ).filter_deltas( packed ), all_contracts );
+
+   check_deltas( history_filter( {}, { { N(carol), {}, {} } } ).filter_deltas( packed ), {} );
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(filter_id) {
+   const history_filter f1( { { N(alice), {} } }, { { N(rem.token), {}, N(accounts) } } );
+   const history_filter f2( { { N(alice), {} } }, { { N(rem.token), {}, N(accounts) } } );
+   const history_filter f3( { { N(bob), {} } }, { { N(rem.token), {}, N(accounts) } } );
+   BOOST_CHECK( f1.id() == f2.id() );
+   BOOST_CHECK( f1.id() != f3.id() );
+   BOOST_CHECK( f1.filters_traces() && f1.filters_deltas() );
+   BOOST_CHECK( !history_filter( {}, {} ).filters_traces() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
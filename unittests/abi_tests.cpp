@@ -13,6 +13,7 @@
 
 #include <eosio/chain/contract_types.hpp>
 #include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/abi_serializer_cache.hpp>
 #include <eosio/chain/eosio_contract.hpp>
 #include <eosio/testing/tester.hpp>
 
@@ -2787,4 +2788,115 @@ BOOST_AUTO_TEST_CASE(serialize_optional_struct_type)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(abi_serializer_cache_test)
+{
+   auto abi1 = R"({
+      "version": "eosio::abi/1.0",
+      "structs": [
+         {"name": "s", "base": "", "fields": [
+            {"name": "i0", "type": "int8"}
+         ]},
+      ],
+   })";
+   auto abi2 = R"({
+      "version": "eosio::abi/1.0",
+      "structs": [
+         {"name": "s", "base": "", "fields": [
+            {"name": "i0", "type": "int16"}
+         ]},
+      ],
+   })";
+
+   try {
+      const bytes packed1 = fc::raw::pack( fc::json::from_string(abi1).as<abi_def>() );
+      const bytes packed2 = fc::raw::pack( fc::json::from_string(abi2).as<abi_def>() );
+
+      abi_serializer_cache cache( 2 );
+      auto e1 = cache.get( N(alice), packed1.data(), packed1.size(), max_serialization_time );
+      BOOST_REQUIRE( e1 );
+      BOOST_CHECK( e1 == cache.get( N(alice), packed1.data(), packed1.size(), max_serialization_time ) );
+      verify_round_trip_conversion(e1->serializer, "s", R"({"i0":5})", "05");
+
+      // resolvers share the cached serializer, which stays alive while they hold it
+      auto s1 = abi_serializer_cache::get_serializer( e1 );
+      BOOST_CHECK( s1.get() == &e1->serializer );
+      BOOST_CHECK( !abi_serializer_cache::get_serializer( abi_serializer_cache::entry_ptr() ) );
+
+      // same account with a new abi must not return the stale serializer
+      auto e2 = cache.get( N(alice), packed2.data(), packed2.size(), max_serialization_time );
+      BOOST_CHECK( e1 != e2 );
+      verify_round_trip_conversion(e2->serializer, "s", R"({"i0":5})", "0500");
+      BOOST_CHECK_EQUAL( cache.size(), 1u );
+
+      // least recently used entry is evicted when full
+      cache.get( N(bob), packed1.data(), packed1.size(), max_serialization_time );
+      cache.get( N(alice), packed2.data(), packed2.size(), max_serialization_time );
+      cache.get( N(carol), packed1.data(), packed1.size(), max_serialization_time );
+      BOOST_CHECK_EQUAL( cache.size(), 2u );
+      BOOST_CHECK( e2 == cache.get( N(alice), packed2.data(), packed2.size(), max_serialization_time ) );
+      e1.reset();
+      verify_round_trip_conversion(*s1, "s", R"({"i0":5})", "05");
+
+      // account without abi yields an empty serializer
+      const bytes empty;
+      auto e3 = cache.get( N(dave), empty.data(), empty.size(), max_serialization_time );
+      BOOST_CHECK( e3->serializer.get_action_type( N(foo) ).empty() );
+
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(abi_field_ranges_test)
+{
+   auto abi = R"({
+      "version": "eosio::abi/1.1",
+      "structs": [
+         {"name": "b", "base": "", "fields": [
+            {"name": "id", "type": "uint64"}
+         ]},
+         {"name": "s", "base": "b", "fields": [
+            {"name": "owner", "type": "name"},
+            {"name": "memo", "type": "string"},
+            {"name": "keys", "type": "public_key[]"},
+            {"name": "opt", "type": "v?"},
+            {"name": "ext", "type": "uint16$"}
+         ]}
+      ],
+      "variants": [
+         {"name": "v", "types": ["int8", "b"]}
+      ],
+   })";
+
+   try {
+      abi_serializer abis( fc::json::from_string(abi).as<abi_def>(), max_serialization_time );
+      auto data = abis.variant_to_binary( "s", fc::json::from_string(R"({"id":1,"owner":"alice","memo":"hi",
+         "keys":["EOS6MRyAjQq8ud7hVNYcfnVPJqcVpscN5So8BhtHuGYqET5GDW5CV"],"opt":["b",{"id":2}]})"), max_serialization_time );
+
+      auto ranges = abis.get_field_ranges( "s", data.data(), data.size(), max_serialization_time );
+      BOOST_REQUIRE_EQUAL( ranges.size(), 5u ); // ext not present
+      BOOST_CHECK_EQUAL( ranges[0].name, "id" );
+      BOOST_CHECK_EQUAL( ranges[0].begin, 0u );
+      BOOST_CHECK_EQUAL( ranges[0].end, 8u );
+      BOOST_CHECK_EQUAL( ranges[1].name, "owner" );
+      BOOST_CHECK_EQUAL( ranges[1].end, 16u );
+      BOOST_CHECK_EQUAL( ranges[2].name, "memo" );
+      BOOST_CHECK_EQUAL( ranges[2].end, 19u );
+      BOOST_CHECK_EQUAL( ranges[3].name, "keys" );
+      BOOST_CHECK_EQUAL( ranges[3].end, 19u + 1 + 34 );
+      BOOST_CHECK_EQUAL( ranges[4].name, "opt" );
+      BOOST_CHECK_EQUAL( ranges[4].end, data.size() );
+      BOOST_CHECK_EQUAL( ranges[4].end - ranges[4].begin, 1u + 1 + 8 );
+
+      data.push_back( 7 );
+      data.push_back( 0 );
+      ranges = abis.get_field_ranges( "s", data.data(), data.size(), max_serialization_time );
+      BOOST_REQUIRE_EQUAL( ranges.size(), 6u );
+      BOOST_CHECK_EQUAL( ranges[5].name, "ext" );
+      BOOST_CHECK_EQUAL( ranges[5].end, data.size() );
+
+      data.resize( 12 );
+      BOOST_CHECK_THROW( abis.get_field_ranges( "s", data.data(), data.size(), max_serialization_time ), unpack_exception );
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,4 +1,5 @@
 #include <boost/test/unit_test.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/testing/tester.hpp>
 
 using namespace eosio;
@@ -166,6 +167,88 @@ BOOST_AUTO_TEST_CASE(untrusted_producer_test)
    }) ;
 }
 
+// verify that a block with a transaction expired at the block time is rejected, the expiration is checked when the
+// transaction keys are queued for recovery as the block is received
+BOOST_AUTO_TEST_CASE(block_with_expired_tx_test)
+{
+   tester main;
+
+   // First we create a valid block with valid transaction
+   main.create_account(N(newacc));
+   auto b = main.produce_block();
+
+   // Make a copy of the valid block and expire the transaction
+   auto copy_b = std::make_shared<signed_block>(b->clone());
+   const auto& packed_trx = copy_b->transactions.back().trx.get<packed_transaction>();
+   auto signed_tx = packed_trx.get_signed_transaction();
+   signed_tx.expiration = fc::time_point_sec( copy_b->timestamp.to_time_point() - fc::seconds(1) );
+   // Re-sign the transaction
+   signed_tx.signatures.clear();
+   signed_tx.sign(main.get_private_key(config::system_account_name, "active"), main.control->get_chain_id());
+   // Replace the valid transaction with the expired transaction
+   auto expired_packed_tx = packed_transaction(signed_tx, packed_trx.get_compression());
+   copy_b->transactions.back().trx = expired_packed_tx;
+
+   // Re-calculate the transaction merkle
+   vector<digest_type> trx_digests;
+   const auto& trxs = copy_b->transactions;
+   for( const auto& a : trxs )
+      trx_digests.emplace_back( a.digest() );
+   copy_b->transaction_mroot = merkle( move(trx_digests) );
+
+   // Re-sign the block
+   auto header_bmroot = digest_type::hash( std::make_pair( copy_b->digest(), main.control->head_block_state()->blockroot_merkle.get_root() ) );
+   auto sig_digest = digest_type::hash( std::make_pair(header_bmroot, main.control->head_block_state()->pending_schedule.schedule_hash) );
+   copy_b->producer_signature = main.get_private_key(config::system_account_name, "active").sign(sig_digest);
+
+   // Push block with expired transaction to other chain
+   tester validator;
+   auto bs = validator.control->create_block_state_future( copy_b );
+   validator.control->abort_block();
+   BOOST_REQUIRE_EXCEPTION(validator.control->push_block( bs, forked_branch_callback{}, trx_meta_cache_lookup{} ), fc::exception ,
+   [] (const fc::exception &e)->bool {
+      return e.code() == expired_tx_exception::code_value ;
+   }) ;
+}
+
+// verify that the keys of the transactions of a received block are only recovered when the block is fully validated,
+// once, and not at all for light validation or a trusted producer
+BOOST_AUTO_TEST_CASE(light_validation_skips_prevalidation_test)
+{
+   tester main;
+   main.create_account(N(newacc));
+   main.create_account(N(newacc2));
+   auto b = main.produce_block();
+
+   size_t signatures = 0;
+   for( const auto& receipt : b->transactions )
+      signatures += receipt.trx.get<packed_transaction>().get_signed_transaction().signatures.size();
+   BOOST_REQUIRE_GT( signatures, 0u );
+
+   // every recovery of the chains looks up the process wide cache, whether it hits or not
+   const auto& cache = signature_recovery_cache::instance();
+   auto push_and_count_recoveries = [&]( tester& node ) {
+      for( uint32_t n = node.control->head_block_num() + 1; n < b->block_num(); ++n )
+         node.push_block( main.control->fetch_block_by_number( n ) );
+      const auto lookups = cache.hits() + cache.misses();
+      node.push_block( b );
+      BOOST_REQUIRE_EQUAL( b->id(), node.control->head_block_id() );
+      return cache.hits() + cache.misses() - lookups;
+   };
+
+   fc::temp_directory full_dir;
+   tester full( full_dir, []( controller::config& ) {}, true );
+   BOOST_CHECK_EQUAL( signatures, push_and_count_recoveries( full ) );
+
+   fc::temp_directory light_dir;
+   tester light( light_dir, []( controller::config& cfg ) { cfg.block_validation_mode = validation_mode::LIGHT; }, true );
+   BOOST_CHECK_EQUAL( 0u, push_and_count_recoveries( light ) );
+
+   fc::temp_directory trusted_dir;
+   tester trusted( trusted_dir, [&]( controller::config& cfg ) { cfg.trusted_producers.insert( b->producer ); }, true );
+   BOOST_CHECK_EQUAL( 0u, push_and_count_recoveries( trusted ) );
+}
+
 /**
  * Ensure that the block broadcasted by producing node and receiving node is identical
  */
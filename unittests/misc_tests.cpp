@@ -2,6 +2,7 @@
 #include <eosio/chain/authority.hpp>
 #include <eosio/chain/authority_checker.hpp>
 #include <eosio/chain/chain_config.hpp>
+#include <eosio/chain/signature_recovery_cache.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/testing/tester.hpp>
@@ -856,6 +857,76 @@ BOOST_AUTO_TEST_CASE(transaction_metadata_test) { try {
       BOOST_CHECK_EQUAL(1u, keys3.size());
       BOOST_CHECK_EQUAL(public_key, *keys3.begin());
 
+      // a batch spans several tasks, results stay in order
+      std::vector<packed_transaction_ptr> batch( 20, ptrx );
+      batch.push_back( ptrx2 );
+      auto futs = transaction_metadata::start_recover_keys( batch, thread_pool.get_executor(), 5, test.control->get_chain_id(), fc::microseconds::maximum() );
+      BOOST_REQUIRE_EQUAL(batch.size(), futs.size());
+      for( size_t i = 0; i < futs.size(); ++i ) {
+         auto m = futs[i].get();
+         BOOST_CHECK(batch[i] == m->packed_trx());
+         BOOST_CHECK_EQUAL(1u, m->recovered_keys().size());
+         BOOST_CHECK_EQUAL(public_key, *m->recovered_keys().begin());
+      }
+
+      thread_pool.stop();
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE(signature_recovery_cache_test) { try {
+      validating_tester test;
+      signed_transaction trx;
+      test.set_transaction_headers(trx);
+      trx.actions.emplace_back( vector<permission_level>{{config::system_account_name, config::active_name}},
+                                newaccount{ config::system_account_name, N(cached), authority(), authority() } );
+      auto private_key = test.get_private_key( config::system_account_name, "active" );
+      trx.sign( private_key, test.control->get_chain_id() );
+      const auto ptrx = std::make_shared<packed_transaction>( trx, packed_transaction::compression_type::none );
+
+      named_thread_pool thread_pool( "misc", 1 );
+      auto& cache = signature_recovery_cache::instance();
+      const auto key = signature_recovery_cache::key( trx.sig_digest( test.control->get_chain_id(), trx.context_free_data ),
+                                                      trx.signatures.at(0) );
+      BOOST_REQUIRE( !cache.find( key ) );
+
+      // the first recovery fills the cache
+      const auto misses = cache.misses();
+      auto mtrx = transaction_metadata::start_recover_keys( ptrx, thread_pool.get_executor(), test.control->get_chain_id(),
+                                                               fc::microseconds::maximum() ).get();
+      BOOST_CHECK_EQUAL( misses + 1, cache.misses() );
+      const auto cached = cache.find( key );
+      BOOST_REQUIRE( cached );
+      BOOST_CHECK_EQUAL( private_key.get_public_key(), cached->pub_key );
+      BOOST_CHECK_EQUAL( 1u, mtrx->recovered_keys().size() );
+      BOOST_CHECK_EQUAL( private_key.get_public_key(), *mtrx->recovered_keys().begin() );
+
+      // recovering the same signature again is a hit, it reports the cpu time of the original recovery
+      const auto hits = cache.hits();
+      auto mtrx2 = transaction_metadata::start_recover_keys( ptrx, thread_pool.get_executor(), test.control->get_chain_id(),
+                                                               fc::microseconds::maximum() ).get();
+      BOOST_CHECK_EQUAL( hits + 1, cache.hits() );
+      BOOST_CHECK_EQUAL( misses + 1, cache.misses() );
+      BOOST_CHECK( mtrx2->recovered_keys() == mtrx->recovered_keys() );
+      BOOST_CHECK_GE( mtrx2->signature_cpu_usage().count(), cached->cpu_usage.count() );
+      const auto cached2 = cache.find( key );
+      BOOST_REQUIRE( cached2 );
+      BOOST_CHECK_EQUAL( cached->cpu_usage.count(), cached2->cpu_usage.count() );
+
+      // beyond capacity the least recently used entry is evicted
+      signature_recovery_cache small( 2 );
+      const auto k1 = digest_type::hash( std::string( "1" ) );
+      const auto k2 = digest_type::hash( std::string( "2" ) );
+      const auto k3 = digest_type::hash( std::string( "3" ) );
+      small.insert( { k1, cached->pub_key, fc::microseconds( 1 ) } );
+      small.insert( { k2, cached->pub_key, fc::microseconds( 2 ) } );
+      BOOST_REQUIRE( small.find( k1 ) );
+      small.insert( { k3, cached->pub_key, fc::microseconds( 3 ) } );
+      BOOST_CHECK_EQUAL( 2u, small.size() );
+      BOOST_CHECK( !small.find( k2 ) );
+      BOOST_REQUIRE( small.find( k1 ) );
+      BOOST_CHECK_EQUAL( 1, small.find( k1 )->cpu_usage.count() );
+      BOOST_CHECK( small.find( k3 ) );
+
       thread_pool.stop();
 
 } FC_LOG_AND_RETHROW() }
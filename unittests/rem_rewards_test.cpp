@@ -203,6 +203,28 @@ public:
        return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "voter_info", data, abi_serializer_max_time );
     }
 
+    fc::variant get_guardian_state() {
+       vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(globalguard), N(globalguard) );
+       return data.empty() ? fc::variant() : abi_ser.binary_to_variant( "eosio_global_guardian_state", data, abi_serializer_max_time );
+    }
+
+    bool is_in_guardians_table( const account_name& act ) {
+       return !get_row_by_account( config::system_account_name, config::system_account_name, N(guardians), act ).empty();
+    }
+
+    // pending_perstake_reward of the voter row plus the reward accrued since it was last settled
+    int64_t get_pending_perstake_reward( const account_name& act ) {
+       int64_t pending = get_voter_info( act )["pending_perstake_reward"].as_int64();
+       vector<char> data = get_row_by_account( config::system_account_name, config::system_account_name, N(guardians), act );
+       if( !data.empty() ) {
+          const auto guardian = abi_ser.binary_to_variant( "guardian_info", data, abi_serializer_max_time );
+          data = get_row_by_account( config::system_account_name, config::system_account_name, N(globalguard), N(globalguard) );
+          const auto reward_per_stake = abi_ser.binary_to_variant( "eosio_global_guardian_state", data, abi_serializer_max_time )["reward_per_stake"].as_double();
+          pending += int64_t( guardian["stake"].as_int64() * ( reward_per_stake - guardian["reward_per_stake_index"].as_double() ) );
+       }
+       return pending;
+    }
+
  
     // Vote for producers
     void votepro( account_name voter, vector<account_name> producers ) {
@@ -324,7 +346,7 @@ BOOST_FIXTURE_TEST_CASE( perstake_rewards_test, rewards_tester ) {
         {
             torewards( config::system_account_name, config::system_account_name, asset{ 100'0000 } );
             // 100'000 * 0.6 perstake share
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 59'9998 );
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 60'0000 );
             // 100'000 * 0.3 percote share
             BOOST_TEST_REQUIRE( get_global_state()["pervote_bucket"].as_int64() == 29'9997 );
 
@@ -334,7 +356,7 @@ BOOST_FIXTURE_TEST_CASE( perstake_rewards_test, rewards_tester ) {
             BOOST_TEST_REQUIRE( get_global_state()["total_guardians_stake"].as_int64() == 171'499'999'4000 );
 
             // b1 staked: 99'999'999'9000; total_staked: 171'499'999'4000; share ~0.583 * 60'0000
-            BOOST_TEST_REQUIRE( get_voter_info( N(b1) )["pending_perstake_reward"].as_int64() == 34'9854 );
+            BOOST_TEST_REQUIRE( get_pending_perstake_reward( N(b1) ) == 34'9854 );
 
             // proda-prodc have the same total_votes so their pervote shares are equal ~0.33 * 29'9997
             BOOST_TEST_REQUIRE( get_producer_info( N(prodb) )["pending_pervote_reward"].as_int64() == 9'9999 );
@@ -342,8 +364,8 @@ BOOST_FIXTURE_TEST_CASE( perstake_rewards_test, rewards_tester ) {
 
             // each of b1, whale1-whale2, proda-prodc has stakes more then 250'000'0000 and voted so all of them participate in perstake rewards
             // prodb staked: 499'999'9000; total_staked: 171'499'999'4000; share ~0.002 * 60'0000 and should be thesame as prodc
-            BOOST_TEST_REQUIRE( get_voter_info( N(prodb) )["pending_perstake_reward"].as_int64() == 1749 );
-            BOOST_TEST_REQUIRE( get_voter_info( N(prodb) )["pending_perstake_reward"].as_int64() == get_voter_info( N(prodc) )["pending_perstake_reward"].as_int64() );
+            BOOST_TEST_REQUIRE( get_pending_perstake_reward( N(prodb) ) == 1749 );
+            BOOST_TEST_REQUIRE( get_pending_perstake_reward( N(prodb) ) == get_pending_perstake_reward( N(prodc) ) );
         }
 
         {
@@ -353,8 +375,8 @@ BOOST_FIXTURE_TEST_CASE( perstake_rewards_test, rewards_tester ) {
             BOOST_TEST_REQUIRE( get_producer_info( N(proda) )["pending_pervote_reward"].as_int64() == 0 );
             BOOST_TEST_REQUIRE( get_voter_info( N(proda) )["pending_perstake_reward"].as_int64() == 0 );
 
-            // 59'9998 - 1749
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 59'8249 );
+            // 60'0000 - 1749
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 59'8251 );
         }
 
         // b1 can claim his pending_perstake_reward even after loosing Guardian status
@@ -365,8 +387,8 @@ BOOST_FIXTURE_TEST_CASE( perstake_rewards_test, rewards_tester ) {
             claim_rewards( N(prodb) );
             BOOST_TEST_REQUIRE( get_voter_info( N(prodb) )["pending_perstake_reward"].as_int64() == 0 );
 
-            // 59'8249 - 34'9854 - 1749
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 24'6646 );
+            // 59'8251 - 34'9854 - 1749
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 24'6648 );
         }
 
         // after 30 days all Guardians loose their status if vote is not re-asserted
@@ -377,24 +399,25 @@ BOOST_FIXTURE_TEST_CASE( perstake_rewards_test, rewards_tester ) {
 
             BOOST_TEST_REQUIRE( get_global_state()["total_guardians_stake"].as_int64() == 0 );
             
+            // expired Guardian status settled the reward into the voter row
             BOOST_TEST_REQUIRE( get_voter_info( N(prodc) )["pending_perstake_reward"].as_int64() == 1749 );
 
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 24'6646 );
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 24'6648 );
         }
 
         // after prodc re-asserted vote he is the only one challenger on `perstake_bucket`
         {
             votepro( N(prodc), { N(prodc) } );
-            BOOST_TEST_REQUIRE( get_voter_info( N(prodc) )["pending_perstake_reward"].as_int64() == 1749 );
+            BOOST_TEST_REQUIRE( get_pending_perstake_reward( N(prodc) ) == 1749 );
 
             torewards( config::system_account_name, config::system_account_name, asset{ 100'0000 } );
-            // 24'6646 + 60'0000
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 84'6646 );
+            // 24'6648 + 60'0000
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 84'6648 );
 
-            BOOST_TEST_REQUIRE( get_voter_info( N(prodc) )["pending_perstake_reward"].as_int64() == 60'1749 );
+            BOOST_TEST_REQUIRE( get_pending_perstake_reward( N(prodc) ) == 60'1749 );
         }
 
-        // after everyone claimed their rewards perstake_bucket should be 0
+        // after everyone claimed their rewards only the rounding remainders of the settled rewards are left in perstake_bucket
         {
             produce_min_num_of_blocks_to_spend_time_wo_inactive_prod( fc::days( 1 ) );
 
@@ -403,7 +426,8 @@ BOOST_FIXTURE_TEST_CASE( perstake_rewards_test, rewards_tester ) {
                 claim_rewards( claimer );
             }
         
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 0 );
+            // 2 * 60'0000 - (34'9854 + 13'9941 + 10'4956 + 3 * 1749 + 60'0000)
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 2 );
             for( const auto& claimer : claimers ) {
                 BOOST_TEST_REQUIRE( get_voter_info( claimer )["pending_perstake_reward"].as_int64() == 0 );
             }
@@ -411,6 +435,94 @@ BOOST_FIXTURE_TEST_CASE( perstake_rewards_test, rewards_tester ) {
     } FC_LOG_AND_RETHROW()
 }
 
+// A contract upgraded from the version without the guardians table has voter rows but neither guardians rows nor
+// "globalguard" state, the same as a freshly deployed contract before its first distribution. The table is rebuilt
+// in batches of `guardians_migration_batch` voters while rewards are still paid by walking the voters.
+BOOST_FIXTURE_TEST_CASE( guardians_migration_test, rewards_tester ) {
+    try {
+        const auto producers = std::vector< name >{ N(proda), N(prodb), N(prodc) };
+        for( const auto& producer : producers ) {
+            register_producer(producer);
+            votepro( producer, {producer} );
+        }
+
+        const auto whales = std::vector< name >{ N(b1), N(whale1), N(whale2) };
+        for( const auto& whale : whales ) {
+            votepro( whale, producers );
+        }
+
+        // more voters than a single batch of the rebuild
+        std::vector< name > guardians;
+        for( char c1 = 'a'; c1 < 'e'; ++c1 ) {
+            for( char c2 = 'a'; c2 < 'k'; ++c2 ) {
+                const name guardian{ std::string("guardian") + c1 + c2 };
+                create_account( guardian, config::system_account_name );
+                const auto r = delegate_bandwidth( N(rem.stake), guardian, asset( 500'000'0000ll - 1000 ) );
+                BOOST_REQUIRE( !r->except_ptr );
+                votepro( guardian, producers );
+                guardians.push_back( guardian );
+            }
+        }
+        produce_blocks_for_n_rounds(2);
+
+        // stake of b1, whale1-whale2, proda-prodc and guardianaa-guardiandj
+        const int64_t total_guardians_stake = 171'499'999'4000 + 40 * 499'999'9000;
+
+        // nothing was migrated yet, voting did not add rows nor stake
+        BOOST_TEST_REQUIRE( get_guardian_state()["migrated"].as_bool() == false );
+        BOOST_TEST_REQUIRE( get_global_state()["total_guardians_stake"].as_int64() == 0 );
+        for( const auto& voter : { N(b1), N(guardianaa), N(whale1) } ) {
+            BOOST_TEST_REQUIRE( !is_in_guardians_table( voter ) );
+        }
+
+        // the first batch reaches guardianaa but not the whales, everybody is paid by walking the voters
+        int64_t whale1_reward = 0;
+        {
+            torewards( config::system_account_name, config::system_account_name, asset{ 100'0000 } );
+
+            BOOST_TEST_REQUIRE( get_guardian_state()["migrated"].as_bool() == false );
+            BOOST_TEST_REQUIRE( is_in_guardians_table( N(b1) ) );
+            BOOST_TEST_REQUIRE( is_in_guardians_table( N(guardianaa) ) );
+            BOOST_TEST_REQUIRE( !is_in_guardians_table( N(whale1) ) );
+            BOOST_TEST_REQUIRE( get_global_state()["total_guardians_stake"].as_int64() == total_guardians_stake );
+
+            whale1_reward = get_voter_info( N(whale1) )["pending_perstake_reward"].as_int64();
+            BOOST_TEST_REQUIRE( whale1_reward == int64_t( 60'0000 * ( double(39'999'999'9000) / double(total_guardians_stake) ) ) );
+            BOOST_TEST_REQUIRE( get_voter_info( N(b1) )["pending_perstake_reward"].as_int64() ==
+                                int64_t( 60'0000 * ( double(99'999'999'9000) / double(total_guardians_stake) ) ) );
+        }
+
+        // touching migrated and not yet migrated Guardians does not count their stake twice
+        {
+            votepro( N(b1), producers );
+            votepro( N(whale2), producers );
+            BOOST_TEST_REQUIRE( get_global_state()["total_guardians_stake"].as_int64() == total_guardians_stake );
+            BOOST_TEST_REQUIRE( !is_in_guardians_table( N(whale2) ) );
+        }
+
+        // the second batch completes the table and the total is summed from it
+        {
+            torewards( config::system_account_name, config::system_account_name, asset{ 100'0000 } );
+
+            BOOST_TEST_REQUIRE( get_guardian_state()["migrated"].as_bool() == true );
+            BOOST_TEST_REQUIRE( get_guardian_state()["reward_per_stake"].as_double() > 0 );
+            for( const auto& guardian : guardians ) {
+                BOOST_TEST_REQUIRE( is_in_guardians_table( guardian ) );
+            }
+            BOOST_TEST_REQUIRE( is_in_guardians_table( N(whale1) ) );
+            BOOST_TEST_REQUIRE( get_global_state()["total_guardians_stake"].as_int64() == total_guardians_stake );
+
+            // the Guardian untouched since the upgrade accrues its share
+            const int64_t accrued = get_pending_perstake_reward( N(whale1) ) - whale1_reward;
+            BOOST_TEST_REQUIRE( std::abs( accrued - whale1_reward ) <= 1 );
+
+            // 2 * 60'0000 minus the rounding remainders of the first distribution
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() <= 120'0000 );
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() > 119'9900 );
+        }
+    } FC_LOG_AND_RETHROW()
+}
+
 BOOST_FIXTURE_TEST_CASE( pervote_rewards_test, rewards_tester ) {
     try {
         const auto producers = std::vector< name >{
@@ -467,7 +579,7 @@ BOOST_FIXTURE_TEST_CASE( pervote_rewards_test, rewards_tester ) {
         { //check that only producers that started producing will receive pervote rewards
             torewards( config::system_account_name, config::system_account_name, asset{ 10'0000 } );
             // 10'0000 * 0.6 perstake share
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 5'9996 );
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 6'0000 );
             // 10'0000 * 0.3 pervote share
             BOOST_TEST_REQUIRE( get_global_state()["pervote_bucket"].as_int64() == 2'9981 );
 
@@ -499,7 +611,7 @@ BOOST_FIXTURE_TEST_CASE( pervote_rewards_test, rewards_tester ) {
             BOOST_TEST_REQUIRE(control->head_block_state()->active_schedule.producers.at(20).producer_name == name{"runnerup1"} );
             torewards( config::system_account_name, config::system_account_name, asset{ 10'0000 } );
             // ~ 2 * 10'0000 * 0.6 perstake share
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 5'9996 * 2 );
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 6'0000 * 2 );
             // ~ 2 * 10'0000 * 0.3 pervote share
             BOOST_TEST_REQUIRE( get_global_state()["pervote_bucket"].as_int64() == 2'9981 + 2'9981 );
 
@@ -523,7 +635,7 @@ BOOST_FIXTURE_TEST_CASE( pervote_rewards_test, rewards_tester ) {
             BOOST_TEST_REQUIRE(control->head_block_state()->active_schedule.producers.at(20).producer_name == name{"runnerup2"} );
             torewards( config::system_account_name, config::system_account_name, asset{ 10'0000 } );
             // ~ 3 * 10'0000 * 0.6 perstake share
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 5'9996 * 3 );
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 6'0000 * 3 );
             // ~ 3 * 10'0000 * 0.3 pervote share
             BOOST_TEST_REQUIRE( get_global_state()["pervote_bucket"].as_int64() == 3 * 2'9981 );
 
@@ -547,7 +659,7 @@ BOOST_FIXTURE_TEST_CASE( pervote_rewards_test, rewards_tester ) {
             BOOST_TEST_REQUIRE(control->head_block_state()->active_schedule.producers.at(20).producer_name == name{"runnerup3"} );
             torewards( config::system_account_name, config::system_account_name, asset{ 10'0000 } );
             // ~ 4 * 10'0000 * 0.6 perstake share
-            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 5'9996 * 4 );
+            BOOST_TEST_REQUIRE( get_global_state()["perstake_bucket"].as_int64() == 6'0000 * 4 );
             // ~ 4 * 10'0000 * 0.3 pervote share
             BOOST_TEST_REQUIRE( get_global_state()["pervote_bucket"].as_int64() == 4 * 2'9981 );
 
@@ -78,4 +78,130 @@ BOOST_AUTO_TEST_CASE(test_restart_with_different_chain_id)
    BOOST_REQUIRE_EXCEPTION(other.open(chain_id), chain_id_type_exception, fc_exception_message_starts_with("chain ID in state "));
 }
 
+BOOST_AUTO_TEST_CASE(test_restart_with_packed_block_log)
+{
+   tester chain;
+   chain.produce_blocks(40);
+   const auto lib_num = chain.control->last_irreversible_block_num();
+   std::vector<block_id_type> ids;
+   for (uint32_t n = 1; n <= lib_num; ++n) {
+      ids.push_back(chain.control->get_block_id_for_num(n));
+   }
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   const auto genesis = block_log::extract_genesis_state(blocks_dir);
+   BOOST_REQUIRE(genesis);
+   block_log::pack_blocklog(blocks_dir, 8);
+   BOOST_REQUIRE(block_log_packs::exists(blocks_dir));
+   BOOST_REQUIRE(block_log::extract_genesis_state(blocks_dir));
+   BOOST_REQUIRE_EQUAL(block_log::extract_chain_id(blocks_dir), genesis->compute_chain_id());
+
+   {
+      block_log blog(blocks_dir);
+      BOOST_REQUIRE_EQUAL(blog.first_block_num(), 1u);
+      for (uint32_t n = 1; n <= lib_num; ++n) {
+         BOOST_REQUIRE_EQUAL(blog.read_block_id_by_num(n), ids[n - 1]);
+         BOOST_REQUIRE_EQUAL(blog.read_block_by_num(n)->id(), ids[n - 1]);
+      }
+   }
+
+   // the chain keeps appending to blocks.log after its first blocks were packed
+   chain.open();
+   chain.produce_blocks(5);
+   BOOST_REQUIRE_EQUAL(chain.control->fetch_block_by_number(2)->id(), ids[1]);
+   chain.close();
+
+   block_log::unpack_blocklog(blocks_dir);
+   BOOST_REQUIRE(!block_log_packs::exists(blocks_dir));
+   block_log blog(blocks_dir);
+   BOOST_REQUIRE_EQUAL(blog.first_block_num(), 1u);
+   for (uint32_t n = 1; n <= lib_num; ++n) {
+      BOOST_REQUIRE_EQUAL(blog.read_block_by_num(n)->id(), ids[n - 1]);
+   }
+}
+
+BOOST_AUTO_TEST_CASE(test_replay_block_log)
+{
+   tester chain;
+   chain.create_accounts({N(alice), N(bob)});
+   chain.produce_blocks(10);
+   chain.create_accounts({N(carol), N(dave)});
+   chain.produce_blocks(20);
+   chain.close();
+
+   const auto blocks_dir = chain.get_config().blocks_dir;
+   const auto log_head = block_log(blocks_dir).head();
+   BOOST_REQUIRE(log_head);
+
+   // replay with and without key recovery, with a look-ahead shorter than the block log
+   for (bool force_all_checks : {false, true}) {
+      fc::temp_directory tempdir;
+      auto cfg = chain.get_config();
+      cfg.blocks_dir = tempdir.path() / config::default_blocks_dir_name;
+      cfg.state_dir = tempdir.path() / config::default_state_dir_name;
+      cfg.force_all_checks = force_all_checks;
+      cfg.replay_look_ahead_blocks = 4;
+      fc::create_directories(cfg.blocks_dir);
+      fc::copy(blocks_dir / "blocks.log", cfg.blocks_dir / "blocks.log");
+
+      tester replay(cfg);
+      BOOST_REQUIRE_EQUAL(replay.control->head_block_num(), log_head->block_num());
+      BOOST_REQUIRE_EQUAL(replay.control->head_block_id(), log_head->id());
+      BOOST_REQUIRE(replay.control->get_account(N(dave)).name == N(dave));
+      replay.produce_block();
+   }
+}
+
+BOOST_AUTO_TEST_CASE(test_restart_with_online_packed_block_log)
+{
+   fc::temp_directory tempdir;
+   tester chain(tempdir, [](controller::config& cfg) { cfg.blocks_log_pack_size = 8; }, true);
+   const auto blocks_dir = chain.get_config().blocks_dir;
+
+   // packs are compressed in the background while the chain appends, every block stays readable
+   std::vector<block_id_type> ids;
+   for (int i = 0; i < 60; ++i) {
+      chain.produce_block();
+      const auto lib_num = chain.control->last_irreversible_block_num();
+      for (uint32_t n = ids.size() + 1; n <= lib_num; ++n) {
+         ids.push_back(chain.control->get_block_id_for_num(n));
+      }
+      for (uint32_t n = 1; n <= ids.size(); ++n) {
+         BOOST_REQUIRE_EQUAL(chain.control->fetch_block_by_number(n)->id(), ids[n - 1]);
+      }
+   }
+   BOOST_REQUIRE_GT(ids.size(), 32u);
+
+   // closing completes the packing in progress
+   chain.close();
+   BOOST_REQUIRE(block_log_packs::exists(blocks_dir));
+   BOOST_REQUIRE(!fc::exists(blocks_dir / "packs-tmp"));
+   uint32_t packed_end = 0;
+   {
+      block_log_packs packs(blocks_dir);
+      BOOST_REQUIRE_EQUAL(packs.first_block_num(), 1u);
+      packed_end = packs.end_block_num();
+      // at least two packs, the most recent blocks stay in blocks.log
+      BOOST_REQUIRE_GE(packed_end, 17u);
+      BOOST_REQUIRE_LT(packed_end, ids.size());
+   }
+
+   chain.open();
+   // reads across the boundary of the packs and blocks.log
+   for (uint32_t n = packed_end - 9; n <= packed_end + 1; ++n) {
+      BOOST_REQUIRE_EQUAL(chain.control->fetch_block_by_number(n)->id(), ids[n - 1]);
+      BOOST_REQUIRE_EQUAL(chain.control->get_block_id_for_num(n), ids[n - 1]);
+   }
+   chain.produce_blocks(20);
+   chain.close();
+
+   block_log blog(blocks_dir);
+   BOOST_REQUIRE_EQUAL(blog.first_block_num(), 1u);
+   for (uint32_t n = 1; n <= ids.size(); ++n) {
+      BOOST_REQUIRE_EQUAL(blog.read_block_by_num(n)->id(), ids[n - 1]);
+   }
+   BOOST_REQUIRE(blog.read_block_by_num(blog.head()->block_num()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
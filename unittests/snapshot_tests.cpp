@@ -587,4 +587,61 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_restart_with_existing_state_and_truncated_blo
    verify_integrity_hash<SNAPSHOT_SUITE>(*chain.control, *snap_chain.control);
 }
 
+BOOST_AUTO_TEST_CASE(test_parallel_snapshot_writer)
+{
+   tester chain;
+   const auto& db = chain.control->db();
+
+   auto add_rows = [&db]( uint64_t begin, uint64_t end ) -> snapshot_writer::section_function {
+      return [&db, begin, end]( auto& section ) {
+         for( uint64_t n = begin; n < end; ++n ) {
+            section.add_row(n, db);
+         }
+      };
+   };
+   auto write_sections = [&]( snapshot_writer& writer ) {
+      writer.write_section("first", add_rows(0, 10));
+      writer.write_section_parts("second", {add_rows(0, 1000), add_rows(1000, 1001), add_rows(1001, 1001), add_rows(1001, 5000)});
+      writer.write_section("empty", add_rows(0, 0));
+   };
+
+   std::ostringstream sequential_out;
+   auto sequential = std::make_shared<ostream_snapshot_writer>(sequential_out);
+   write_sections(*sequential);
+   sequential->finalize();
+
+   named_thread_pool thread_pool("snap", 2);
+   std::ostringstream parallel_out;
+   auto output = std::make_shared<ostream_snapshot_writer>(parallel_out);
+   auto parallel = std::make_shared<parallel_snapshot_writer>(output, thread_pool.get_executor(), 3);
+   write_sections(*parallel);
+   parallel->finalize();
+   output->finalize();
+
+   BOOST_REQUIRE(sequential_out.str() == parallel_out.str());
+
+   std::istringstream in(parallel_out.str());
+   auto reader = std::make_shared<istream_snapshot_reader>(in);
+   reader->validate();
+   reader->read_section("second", [&]( auto& section ) {
+      uint64_t expected = 0;
+      bool more = !section.empty();
+      while( more ) {
+         uint64_t row = 0;
+         more = section.read_row(row);
+         BOOST_REQUIRE_EQUAL(row, expected++);
+      }
+      BOOST_REQUIRE_EQUAL(expected, 5000u);
+   });
+   reader->read_section("empty", [&]( auto& section ) {
+      BOOST_REQUIRE(section.empty());
+   });
+   reader->read_section("first", [&]( auto& section ) {
+      uint64_t row = 0;
+      section.read_row(row);
+      BOOST_REQUIRE_EQUAL(row, 0u);
+   });
+   thread_pool.stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,7 +1,9 @@
 #include <array>
+#include <sstream>
 #include <utility>
 
 #include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/action_profiler.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/wasm_eosio_constraints.hpp>
@@ -156,6 +158,202 @@ BOOST_FIXTURE_TEST_CASE( prove_mem_reset, TESTER ) try {
 
 } FC_LOG_AND_RETHROW() /// prove_mem_reset
 
+/**
+ * Prove repeated executions of a contract reuse its instantiated module
+ */
+BOOST_FIXTURE_TEST_CASE( instantiation_cache_stats, TESTER ) try {
+   create_accounts( {N(asserter)} );
+   set_code(N(asserter), contracts::asserter_wasm());
+   produce_blocks(1);
+
+   const auto before = control->get_wasm_interface().get_instantiation_cache_stats();
+   for (int i = 0; i < 5; i++) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{N(asserter),config::active_name}},
+                                provereset {} );
+      set_transaction_headers(trx);
+      trx.sign( get_private_key( N(asserter), "active" ), control->get_chain_id() );
+      push_transaction( trx );
+   }
+   const auto after = control->get_wasm_interface().get_instantiation_cache_stats();
+
+   BOOST_CHECK_GE(after.misses, before.misses + 1);
+   BOOST_CHECK_GE(after.hits, before.hits + 4);
+   BOOST_CHECK_GE(after.modules, 1u);
+   BOOST_CHECK_GT(after.module_bytes, 0u);
+   BOOST_CHECK_EQUAL(after.max_module_bytes, config::default_wasm_instantiation_cache_size);
+
+} FC_LOG_AND_RETHROW() /// instantiation_cache_stats
+
+/**
+ * Prove a bounded instantiation cache releases the least executed modules, never the one executing, and
+ * instantiates a released module again when its contract executes
+ */
+BOOST_AUTO_TEST_CASE( instantiation_cache_eviction ) try {
+   // distinct code hashes, modules of about the same size
+   auto cache_wast = []( int n ) {
+      return std::string( R"=====((module
+ (export "apply" (func $apply))
+ (func $apply (param $0 i64) (param $1 i64) (param $2 i64)
+  (drop (i32.const )=====" ) + std::to_string( n ) + "))))";
+   };
+   const std::vector<account_name> contracts = { N(cachea), N(cacheb), N(cachec) };
+
+   auto deploy = [&]( tester& chain ) {
+      chain.create_accounts( contracts );
+      for( size_t i = 0; i < contracts.size(); ++i )
+         chain.set_code( contracts[i], cache_wast( i + 1 ).c_str() );
+      chain.produce_block();
+   };
+   uint32_t nonce = 0;
+   auto run = [&]( tester& chain, account_name contract ) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{contract, config::active_name}}, contract, N(go),
+                                fc::raw::pack( ++nonce ) );
+      chain.set_transaction_headers( trx );
+      trx.sign( chain.get_private_key( contract, "active" ), chain.control->get_chain_id() );
+      chain.push_transaction( trx );
+      return chain.control->get_wasm_interface().get_instantiation_cache_stats();
+   };
+
+   // size of each module, instantiated by an unbounded cache
+   std::vector<uint64_t> module_bytes;
+   {
+      fc::temp_directory tempdir;
+      tester chain( tempdir, []( controller::config& cfg ) { cfg.wasm_instantiation_cache_size = 0; }, true );
+      deploy( chain );
+      uint64_t total = chain.control->get_wasm_interface().get_instantiation_cache_stats().module_bytes;
+      for( auto contract : contracts ) {
+         const auto stats = run( chain, contract );
+         module_bytes.push_back( stats.module_bytes - total );
+         total = stats.module_bytes;
+         BOOST_REQUIRE_GT( module_bytes.back(), 0u );
+      }
+      BOOST_REQUIRE_EQUAL( chain.control->get_wasm_interface().get_instantiation_cache_stats().evictions, 0u );
+   }
+
+   // room for any two of the modules, not for the three of them
+   const uint64_t max_module_bytes = module_bytes[0] + module_bytes[1] + module_bytes[2] - 1;
+   fc::temp_directory tempdir;
+   tester chain( tempdir, [&]( controller::config& cfg ) { cfg.wasm_instantiation_cache_size = max_module_bytes; }, true );
+   deploy( chain );
+   auto check_bounded = [&]( const wasm_interface::instantiation_cache_stats& stats ) {
+      BOOST_REQUIRE_EQUAL( stats.max_module_bytes, max_module_bytes );
+      BOOST_REQUIRE_LE( stats.module_bytes, stats.max_module_bytes );
+   };
+
+   auto stats = run( chain, N(cachea) );
+   for( int i = 0; i < 2; ++i )
+      stats = run( chain, N(cachea) );
+   for( int i = 0; i < 2; ++i )
+      stats = run( chain, N(cacheb) );
+   BOOST_REQUIRE_EQUAL( stats.evictions, 0u );
+   BOOST_REQUIRE_EQUAL( stats.modules, 2u );
+   check_bounded( stats );
+
+   // cachec is the least executed but is executing, cacheb is executed less than cachea
+   auto before = stats;
+   stats = run( chain, N(cachec) );
+   BOOST_REQUIRE_EQUAL( stats.misses, before.misses + 1 );
+   BOOST_REQUIRE_EQUAL( stats.evictions, 1u );
+   BOOST_REQUIRE_EQUAL( stats.modules, 2u );
+   check_bounded( stats );
+
+   before = stats;
+   stats = run( chain, N(cachea) );
+   BOOST_REQUIRE_EQUAL( stats.hits, before.hits + 1 );
+   BOOST_REQUIRE_EQUAL( stats.misses, before.misses );
+
+   // the released module is instantiated again and releases cachec, now the least executed of the others
+   before = stats;
+   stats = run( chain, N(cacheb) );
+   BOOST_REQUIRE_EQUAL( stats.misses, before.misses + 1 );
+   BOOST_REQUIRE_EQUAL( stats.evictions, 2u );
+   BOOST_REQUIRE_EQUAL( stats.modules, 2u );
+   check_bounded( stats );
+
+   before = stats;
+   stats = run( chain, N(cacheb) );
+   BOOST_REQUIRE_EQUAL( stats.hits, before.hits + 1 );
+   before = stats;
+   stats = run( chain, N(cachec) );
+   BOOST_REQUIRE_EQUAL( stats.misses, before.misses + 1 );
+   check_bounded( stats );
+
+   chain.produce_block();
+   for( auto contract : contracts )
+      run( chain, contract );
+   check_bounded( chain.control->get_wasm_interface().get_instantiation_cache_stats() );
+
+} FC_LOG_AND_RETHROW() /// instantiation_cache_eviction
+
+/**
+ * Prove action profiling aggregates executions per receiver and action
+ */
+BOOST_FIXTURE_TEST_CASE( action_profiling, TESTER ) try {
+   create_accounts( {N(asserter)} );
+   set_code(N(asserter), contracts::asserter_wasm());
+   produce_blocks(1);
+
+   BOOST_REQUIRE(control->get_action_profiler() == nullptr);
+   control->set_action_profiling(true);
+   BOOST_REQUIRE(control->get_action_profiler() != nullptr);
+
+   for (int i = 0; i < 3; i++) {
+      signed_transaction trx;
+      trx.actions.emplace_back( vector<permission_level>{{N(asserter),config::active_name}},
+                                provereset {} );
+      set_transaction_headers(trx);
+      trx.sign( get_private_key( N(asserter), "active" ), control->get_chain_id() );
+      push_transaction( trx );
+   }
+
+   const auto actions = control->get_action_profiler()->get_actions();
+   auto it = std::find_if(actions.begin(), actions.end(), [](const auto& a) { return a.receiver == N(asserter); });
+   BOOST_REQUIRE(it != actions.end());
+   BOOST_CHECK_EQUAL(it->account, N(asserter));
+   BOOST_CHECK_EQUAL(it->action, N(provereset));
+   BOOST_CHECK_EQUAL(it->executions, 3u);
+   BOOST_CHECK_GT(it->time_ns, 0u);
+
+   std::ostringstream folded;
+   control->get_action_profiler()->write_folded_stacks(folded);
+   BOOST_CHECK(folded.str().find("asserter;asserter::provereset;self ") != std::string::npos);
+
+   control->set_action_profiling(false);
+   BOOST_REQUIRE(control->get_action_profiler() == nullptr);
+
+} FC_LOG_AND_RETHROW() /// action_profiling
+
+/**
+ * Prove action profiling aggregates the actions beyond its limit in a single entry
+ */
+BOOST_AUTO_TEST_CASE( action_profiling_limit ) try {
+   action_profiler profiler(2);
+   const action_profiler::host_function_times no_host_functions;
+   profiler.record( N(alice), N(alice), N(first), std::chrono::nanoseconds(10), no_host_functions );
+   profiler.record( N(alice), N(alice), N(second), std::chrono::nanoseconds(15), no_host_functions );
+   profiler.record( N(bob), N(bob), N(third), std::chrono::nanoseconds(30), no_host_functions );
+   profiler.record( N(carol), N(carol), N(fourth), std::chrono::nanoseconds(40), no_host_functions );
+   // actions tracked before the limit was reached keep their entry
+   profiler.record( N(alice), N(alice), N(first), std::chrono::nanoseconds(10), no_host_functions );
+
+   const auto actions = profiler.get_actions();
+   BOOST_REQUIRE_EQUAL(actions.size(), 3u);
+   BOOST_CHECK(actions[0].receiver.empty());
+   BOOST_CHECK(actions[0].action.empty());
+   BOOST_CHECK_EQUAL(actions[0].executions, 2u);
+   BOOST_CHECK_EQUAL(actions[0].time_ns, 70u);
+   BOOST_CHECK_EQUAL(actions[1].action, N(first));
+   BOOST_CHECK_EQUAL(actions[1].executions, 2u);
+   BOOST_CHECK_EQUAL(actions[2].action, N(second));
+
+   std::ostringstream folded;
+   profiler.write_folded_stacks(folded);
+   BOOST_CHECK(folded.str().find("other;self 70\n") != std::string::npos);
+
+} FC_LOG_AND_RETHROW() /// action_profiling_limit
+
 /**
  * Prove the modifications to global variables are wiped between runs
  */